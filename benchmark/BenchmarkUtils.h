@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file BenchmarkUtils.h
+ *
+ * Test data and reporting helpers shared by the benchmarks.
+ */
+
+#ifndef NimbleDSP_BenchmarkUtils_h
+#define NimbleDSP_BenchmarkUtils_h
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <stdint.h>
+#include <type_traits>
+#include <algorithm>
+#include "benchmark/benchmark.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Converts "val", which is roughly in [-1, 1], to type T.  Integer types are scaled up so that they aren't
+ *      all zero but can still be multiplied and accumulated without overflowing.
+ */
+template <class T>
+T benchmarkValue(double val) {
+    return std::is_floating_point<T>::value ? (T) val : (T) std::floor(val * 32);
+}
+
+/**
+ * \brief Returns "len" samples of a two tone test signal.
+ */
+template <class T>
+std::vector<T> benchmarkSignal(unsigned len) {
+    std::vector<T> signal(len);
+    for (unsigned i=0; i<len; i++) {
+        signal[i] = benchmarkValue<T>(0.6 * sin(0.07 * i) + 0.3 * cos(1.9 * i));
+    }
+    return signal;
+}
+
+/**
+ * \brief Returns "len" complex samples of a two tone test signal.
+ */
+template <class T>
+std::vector< std::complex<T> > benchmarkComplexSignal(unsigned len) {
+    std::vector< std::complex<T> > signal(len);
+    for (unsigned i=0; i<len; i++) {
+        signal[i] = std::complex<T>((T) (0.6 * sin(0.07 * i)), (T) (0.3 * cos(1.9 * i)));
+    }
+    return signal;
+}
+
+/**
+ * \brief Returns "numTaps" lowpass filter taps.
+ */
+template <class T>
+std::vector<T> benchmarkTaps(unsigned numTaps) {
+    std::vector<T> taps(numTaps);
+    for (unsigned i=0; i<numTaps; i++) {
+        double x = i - (numTaps - 1) / 2.0;
+        double window = 0.54 - 0.46 * cos(2 * M_PI * i / std::max(numTaps - 1, 1u));
+        taps[i] = benchmarkValue<T>((x == 0 ? 0.5 : sin(0.5 * M_PI * x) / (M_PI * x)) * window);
+    }
+    return taps;
+}
+
+/**
+ * \brief Reports throughput as samples/second (items) and bytes/second for "samplesPerIteration" samples of type U
+ *      processed on every iteration.
+ */
+template <class U>
+void setThroughput(benchmark::State & state, int64_t samplesPerIteration) {
+    state.SetItemsProcessed(state.iterations() * samplesPerIteration);
+    state.SetBytesProcessed(state.iterations() * samplesPerIteration * (int64_t) sizeof(U));
+}
+
+};
+
+/*
+ * Registers a benchmark template for each of the element types that the filters and vectors support.
+ */
+#define NIMBLEDSP_BENCHMARK_ALL_TYPES(func, args) \
+    BENCHMARK_TEMPLATE(func, float)->args; \
+    BENCHMARK_TEMPLATE(func, double)->args; \
+    BENCHMARK_TEMPLATE(func, int16_t)->args; \
+    BENCHMARK_TEMPLATE(func, int32_t)->args
+
+/*
+ * Registers a benchmark template for the floating point types.
+ */
+#define NIMBLEDSP_BENCHMARK_FLOAT_TYPES(func, args) \
+    BENCHMARK_TEMPLATE(func, float)->args; \
+    BENCHMARK_TEMPLATE(func, double)->args
+
+#endif
@@ -0,0 +1,154 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include "RealVector.h"
+#include "ComplexVector.h"
+#include "Goertzel.h"
+#include "SlidingDft.h"
+#include "WelchPsd.h"
+#include "BenchmarkUtils.h"
+
+using namespace NimbleDSP;
+
+
+// Powers of two plus one mixed radix size.  The FFT sizes are limited to the floating point types.
+#define FFT_ARGS RangeMultiplier(4)->Range(64, 65536)->Arg(1000)
+
+// The transforms are in place, so the input is copied back in on every iteration.  The copy is small compared to
+// the FFT itself.
+template <class T>
+static void ComplexVectorFft(benchmark::State & state) {
+    unsigned len = state.range(0);
+    std::vector< std::complex<T> > input = benchmarkComplexSignal<T>(len);
+    ComplexVector<T> buf(len);
+    for (auto _ : state) {
+        std::copy(input.begin(), input.end(), buf.vec.begin());
+        buf.domain = TIME_DOMAIN;
+        buf.fft();
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(buf.vec));
+    }
+    setThroughput< std::complex<T> >(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(ComplexVectorFft, FFT_ARGS);
+
+template <class T>
+static void ComplexVectorIfft(benchmark::State & state) {
+    unsigned len = state.range(0);
+    std::vector< std::complex<T> > input = benchmarkComplexSignal<T>(len);
+    ComplexVector<T> buf(len);
+    for (auto _ : state) {
+        std::copy(input.begin(), input.end(), buf.vec.begin());
+        buf.domain = FREQUENCY_DOMAIN;
+        buf.ifft();
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(buf.vec));
+    }
+    setThroughput< std::complex<T> >(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(ComplexVectorIfft, FFT_ARGS);
+
+// Reports real input samples per second.
+template <class T>
+static void RealVectorFft(benchmark::State & state) {
+    unsigned len = state.range(0);
+    RealVector<T> input(benchmarkSignal<T>(len));
+    ComplexVector<T> spectrum(len / 2 + 1);
+    for (auto _ : state) {
+        input.fft(spectrum);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(spectrum.vec));
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(RealVectorFft, FFT_ARGS);
+
+// Reports real output samples per second.
+template <class T>
+static void RealVectorIfft(benchmark::State & state) {
+    unsigned len = state.range(0);
+    RealVector<T> input(benchmarkSignal<T>(len));
+    ComplexVector<T> spectrum(len / 2 + 1);
+    input.fft(spectrum);
+    RealVector<T> output(len);
+    for (auto _ : state) {
+        output.ifft(spectrum, len);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output.vec));
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(RealVectorIfft, FFT_ARGS);
+
+// Number of bins and block length.  Compare with RealVectorFft for the cost of getting the same bins from an FFT.
+template <class T>
+static void GoertzelBins(benchmark::State & state) {
+    unsigned numBins = state.range(0), blockLen = state.range(1);
+    std::vector<double> bins(numBins);
+    for (unsigned bin=0; bin<numBins; bin++) {
+        bins[bin] = 3 + 5 * bin;
+    }
+    Goertzel<T> detector(blockLen, bins);
+    std::vector<T> input = benchmarkSignal<T>(blockLen);
+    for (auto _ : state) {
+        detector.process(VECTOR_TO_ARRAY(input), blockLen);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(detector.spectrum));
+    }
+    setThroughput<T>(state, blockLen);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(GoertzelBins, ArgsProduct({{8, 16}, {256, 4096}}));
+
+// Number of bins and window length.  The spectrum is updated after every sample.
+template <class T>
+static void SlidingDftBins(benchmark::State & state) {
+    unsigned numBins = state.range(0), windowLen = state.range(1);
+    std::vector<double> bins(numBins);
+    for (unsigned bin=0; bin<numBins; bin++) {
+        bins[bin] = 3 + 5 * bin;
+    }
+    SlidingDft<T> sdft(windowLen, bins);
+    std::vector<T> input = benchmarkSignal<T>(4096);
+    for (auto _ : state) {
+        sdft.process(VECTOR_TO_ARRAY(input), (unsigned) input.size());
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(sdft.spectrum));
+    }
+    setThroughput<T>(state, input.size());
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(SlidingDftBins, ArgsProduct({{8, 16}, {256, 4096}}));
+
+// FFT size and overlap percentage.  Writes every frame to a spectrogram buffer as well as averaging them.
+template <class T>
+static void WelchPsdSpectrogram(benchmark::State & state) {
+    unsigned fftLen = state.range(0), overlap = fftLen * state.range(1) / 100;
+    unsigned len = 65536;
+    std::vector<T> window(fftLen);
+    for (unsigned i=0; i<fftLen; i++) {
+        window[i] = (T) (0.5 - 0.5 * cos(2 * M_PI * i / fftLen));
+    }
+    WelchPsd<T> psd(window, overlap);
+    std::vector<T> input = benchmarkSignal<T>(len);
+    std::vector<T> frames((len / (fftLen - overlap) + 1) * psd.numBins());
+    for (auto _ : state) {
+        psd.process(VECTOR_TO_ARRAY(input), len, VECTOR_TO_ARRAY(frames),
+                    (unsigned) frames.size() / psd.numBins());
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(frames));
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(WelchPsdSpectrogram, ArgsProduct({{256, 4096}, {0, 50, 75}}));
@@ -0,0 +1,263 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "RealFirFilter.h"
+#include "ComplexFirFilter.h"
+#include "RealIirFilter.h"
+#include "RealSosFilter.h"
+#include "RealMultichannelSosFilter.h"
+#include "PolyphaseChannelizer.h"
+#include "FixedPtFirFilter.h"
+#include "BenchmarkUtils.h"
+
+using namespace NimbleDSP;
+
+
+// Tap counts and block lengths.  Every filter benchmark reports input samples per second.
+#define FIR_ARGS ArgsProduct({{16, 64, 256}, {256, 4096, 65536}})
+
+// Tap counts, block lengths and rates.
+#define FIR_RATE_ARGS ArgsProduct({{16, 64, 256}, {256, 4096, 65536}, {2, 8}})
+
+template <class T>
+static void RealFirConvStreaming(benchmark::State & state) {
+    unsigned numTaps = state.range(0), blockLen = state.range(1);
+    RealFirFilter<T> filter(benchmarkTaps<T>(numTaps));
+    std::vector<T> input = benchmarkSignal<T>(blockLen);
+    std::vector<T> output(filter.convOutputLength(blockLen));
+    for (auto _ : state) {
+        filter.conv(VECTOR_TO_ARRAY(input), blockLen, VECTOR_TO_ARRAY(output), (unsigned) output.size());
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output));
+    }
+    setThroughput<T>(state, blockLen);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealFirConvStreaming, FIR_ARGS);
+
+template <class T>
+static void RealFirConvOneShot(benchmark::State & state) {
+    unsigned numTaps = state.range(0), blockLen = state.range(1);
+    RealFirFilter<T> filter(benchmarkTaps<T>(numTaps), ONE_SHOT_RETURN_ALL_RESULTS);
+    std::vector<T> input = benchmarkSignal<T>(blockLen);
+    std::vector<T> output(filter.convOutputLength(blockLen));
+    for (auto _ : state) {
+        filter.conv(VECTOR_TO_ARRAY(input), blockLen, VECTOR_TO_ARRAY(output), (unsigned) output.size());
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output));
+    }
+    setThroughput<T>(state, blockLen);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealFirConvOneShot, FIR_ARGS);
+
+template <class T>
+static void RealFirDecimate(benchmark::State & state) {
+    unsigned numTaps = state.range(0), blockLen = state.range(1);
+    int rate = (int) state.range(2);
+    RealFirFilter<T> filter(benchmarkTaps<T>(numTaps));
+    std::vector<T> input = benchmarkSignal<T>(blockLen);
+    std::vector<T> output(filter.decimateOutputLength(blockLen, rate) + 1);
+    for (auto _ : state) {
+        filter.decimate(VECTOR_TO_ARRAY(input), blockLen, VECTOR_TO_ARRAY(output), (unsigned) output.size(), rate);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output));
+    }
+    setThroughput<T>(state, blockLen);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealFirDecimate, FIR_RATE_ARGS);
+
+template <class T>
+static void RealFirInterp(benchmark::State & state) {
+    unsigned numTaps = state.range(0), blockLen = state.range(1);
+    int rate = (int) state.range(2);
+    RealFirFilter<T> filter(benchmarkTaps<T>(numTaps));
+    std::vector<T> input = benchmarkSignal<T>(blockLen);
+    std::vector<T> output(filter.interpOutputLength(blockLen, rate));
+    for (auto _ : state) {
+        filter.interp(VECTOR_TO_ARRAY(input), blockLen, VECTOR_TO_ARRAY(output), (unsigned) output.size(), rate);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output));
+    }
+    setThroughput<T>(state, blockLen);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealFirInterp, FIR_RATE_ARGS);
+
+// Tap count, block length, interpolation rate and decimation rate.
+template <class T>
+static void RealFirResample(benchmark::State & state) {
+    unsigned numTaps = state.range(0), blockLen = state.range(1);
+    int interpRate = (int) state.range(2), decimateRate = (int) state.range(3);
+    RealFirFilter<T> filter(benchmarkTaps<T>(numTaps));
+    std::vector<T> input = benchmarkSignal<T>(blockLen);
+    std::vector<T> output(filter.resampleOutputLength(blockLen, interpRate, decimateRate));
+    for (auto _ : state) {
+        filter.resample(VECTOR_TO_ARRAY(input), blockLen, VECTOR_TO_ARRAY(output), (unsigned) output.size(),
+                        interpRate, decimateRate);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output));
+    }
+    setThroughput<T>(state, blockLen);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealFirResample, ArgsProduct({{16, 64, 256}, {256, 4096, 65536}, {3}, {2}})->Args({64, 4096, 5, 4})
+                                                   ->Args({64, 4096, 2, 3})->Args({256, 4096, 2, 3}));
+
+template <class T>
+static void RealFirConvComplexData(benchmark::State & state) {
+    unsigned numTaps = state.range(0), blockLen = state.range(1);
+    RealFirFilter<T> filter(benchmarkTaps<T>(numTaps));
+    std::vector< std::complex<T> > input = benchmarkComplexSignal<T>(blockLen);
+    std::vector< std::complex<T> > output(filter.convOutputLength(blockLen));
+    for (auto _ : state) {
+        filter.conv(VECTOR_TO_ARRAY(input), blockLen, VECTOR_TO_ARRAY(output), (unsigned) output.size());
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output));
+    }
+    setThroughput< std::complex<T> >(state, blockLen);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(RealFirConvComplexData, FIR_ARGS);
+
+// int16_t data and Q15 taps with an int32_t accumulator, to compare against RealFirConvStreaming<float>.
+static void FixedPtFirConvStreaming(benchmark::State & state) {
+    unsigned numTaps = state.range(0), blockLen = state.range(1);
+    FixedPtFirFilter<int16_t, int16_t, int32_t> filter;
+    filter.quantizeTaps(benchmarkTaps<double>(numTaps), 15);
+    std::vector<int16_t> input = benchmarkSignal<int16_t>(blockLen);
+    std::vector<int16_t> output(filter.convOutputLength(blockLen));
+    for (auto _ : state) {
+        filter.conv(VECTOR_TO_ARRAY(input), blockLen, VECTOR_TO_ARRAY(output), (unsigned) output.size());
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output));
+    }
+    setThroughput<int16_t>(state, blockLen);
+}
+BENCHMARK(FixedPtFirConvStreaming)->FIR_ARGS;
+
+// Decimation of int16_t IQ data, to compare against RealFirConvComplexData and ComplexFirDecimate.
+static void FixedPtFirDecimateIq(benchmark::State & state) {
+    unsigned numTaps = state.range(0), blockLen = state.range(1);
+    int rate = (int) state.range(2);
+    FixedPtFirFilter<int16_t, int16_t, int32_t> filter;
+    filter.quantizeTaps(benchmarkTaps<double>(numTaps), 15);
+    std::vector< std::complex<int16_t> > input(blockLen);
+    std::vector<int16_t> signal = benchmarkSignal<int16_t>(blockLen + 1);
+    for (unsigned i=0; i<blockLen; i++) {
+        input[i] = std::complex<int16_t>(signal[i], signal[i + 1]);
+    }
+    std::vector< std::complex<int16_t> > output(filter.decimateOutputLength(blockLen, rate) + 1);
+    for (auto _ : state) {
+        filter.decimate(VECTOR_TO_ARRAY(input), blockLen, VECTOR_TO_ARRAY(output), (unsigned) output.size(), rate);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output));
+    }
+    setThroughput< std::complex<int16_t> >(state, blockLen);
+}
+BENCHMARK(FixedPtFirDecimateIq)->FIR_RATE_ARGS;
+
+template <class T>
+static void ComplexFirConvStreaming(benchmark::State & state) {
+    unsigned numTaps = state.range(0), blockLen = state.range(1);
+    ComplexFirFilter<T> filter(benchmarkComplexSignal<T>(numTaps));
+    std::vector< std::complex<T> > input = benchmarkComplexSignal<T>(blockLen);
+    std::vector< std::complex<T> > output(filter.convOutputLength(blockLen));
+    for (auto _ : state) {
+        filter.conv(VECTOR_TO_ARRAY(input), blockLen, VECTOR_TO_ARRAY(output), (unsigned) output.size());
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output));
+    }
+    setThroughput< std::complex<T> >(state, blockLen);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(ComplexFirConvStreaming, FIR_ARGS);
+
+template <class T>
+static void ComplexFirDecimate(benchmark::State & state) {
+    unsigned numTaps = state.range(0), blockLen = state.range(1);
+    int rate = (int) state.range(2);
+    ComplexFirFilter<T> filter(benchmarkComplexSignal<T>(numTaps));
+    std::vector< std::complex<T> > input = benchmarkComplexSignal<T>(blockLen);
+    std::vector< std::complex<T> > output(filter.decimateOutputLength(blockLen, rate) + 1);
+    for (auto _ : state) {
+        filter.decimate(VECTOR_TO_ARRAY(input), blockLen, VECTOR_TO_ARRAY(output), (unsigned) output.size(), rate);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output));
+    }
+    setThroughput< std::complex<T> >(state, blockLen);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(ComplexFirDecimate, FIR_RATE_ARGS);
+
+// Filter order and block length.  The recursive filters are only benchmarked for the floating point types.
+template <class T>
+static void RealIirFilterDirectForm(benchmark::State & state) {
+    unsigned order = state.range(0), blockLen = state.range(1);
+    std::vector<T> num(order + 1, (T) 0.01);
+    std::vector<T> den(order + 1, 0);
+    den[0] = 1;
+    den[1] = (T) -0.5;
+    RealIirFilter<T> filter(VECTOR_TO_ARRAY(num), order + 1, VECTOR_TO_ARRAY(den), order + 1);
+    RealVector<T> buf(benchmarkSignal<T>(blockLen));
+    for (auto _ : state) {
+        filter.filter(buf);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(buf.vec));
+    }
+    setThroughput<T>(state, blockLen);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(RealIirFilterDirectForm, ArgsProduct({{2, 8}, {256, 4096, 65536}}));
+
+// A stable lowpass biquad, repeated for each section.
+template <class T>
+static std::vector< BiquadSection<T> > benchmarkSections(unsigned numSections) {
+    BiquadSection<T> section = {(T) 0.02, (T) 0.04, (T) 0.02, (T) -1.56, (T) 0.64};
+    return std::vector< BiquadSection<T> >(numSections, section);
+}
+
+// Number of sections and block length.
+template <class T>
+static void RealSosFilterSections(benchmark::State & state) {
+    unsigned numSections = state.range(0), blockLen = state.range(1);
+    RealSosFilter<T> filter(benchmarkSections<T>(numSections));
+    std::vector<T> buf = benchmarkSignal<T>(blockLen);
+    for (auto _ : state) {
+        filter.filter(VECTOR_TO_ARRAY(buf), blockLen, VECTOR_TO_ARRAY(buf));
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(buf));
+    }
+    setThroughput<T>(state, blockLen);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(RealSosFilterSections, ArgsProduct({{1, 4, 8}, {256, 4096, 65536}}));
+
+// Number of channels, number of sections and samples per channel.  Reports samples per second over all channels.
+template <class T>
+static void RealMultichannelSosFilterInterleaved(benchmark::State & state) {
+    unsigned numChannels = state.range(0), numSections = state.range(1), numSamples = state.range(2);
+    RealMultichannelSosFilter<T> filter(numChannels, benchmarkSections<T>(numSections));
+    std::vector<T> buf = benchmarkSignal<T>(numChannels * numSamples);
+    for (auto _ : state) {
+        filter.filterInterleaved(VECTOR_TO_ARRAY(buf), numSamples, VECTOR_TO_ARRAY(buf));
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(buf));
+    }
+    setThroughput<T>(state, (int64_t) numChannels * numSamples);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(RealMultichannelSosFilterInterleaved, ArgsProduct({{1, 4, 8}, {4}, {4096}}));
+
+// Number of channels and taps per channel.  Reports input samples per second.
+template <class T>
+static void PolyphaseChannelizerBlock(benchmark::State & state) {
+    unsigned numChannels = state.range(0), numTaps = state.range(0) * state.range(1);
+    unsigned blockLen = 65536;
+    PolyphaseChannelizer<T> channelizer(benchmarkTaps<T>(numTaps), numChannels);
+    std::vector< std::complex<T> > input = benchmarkComplexSignal<T>(blockLen);
+    std::vector< std::complex<T> > output(channelizer.outputLength(blockLen) * numChannels);
+    for (auto _ : state) {
+        channelizer.channelize(VECTOR_TO_ARRAY(input), blockLen, VECTOR_TO_ARRAY(output),
+                               (unsigned) output.size() / numChannels);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output));
+    }
+    setThroughput< std::complex<T> >(state, blockLen);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(PolyphaseChannelizerBlock, ArgsProduct({{8, 64, 256}, {8}}));
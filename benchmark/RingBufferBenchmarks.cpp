@@ -0,0 +1,69 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "RealVector.h"
+#include "RealFirFilter.h"
+#include "SpscRingBuffer.h"
+#include "MirroredRingBuffer.h"
+#include "BenchmarkUtils.h"
+
+using namespace NimbleDSP;
+
+
+// Block length.  Blocks are written to and filtered out of a ring buffer that holds 2.5 blocks, so most reads wrap.
+#define RING_BUFFER_ARGS Arg(256)->Arg(4096)->Arg(65536)
+
+// Reads each block out of an SpscRingBuffer into a RealVector and filters that.
+template <class T>
+static void SpscRingBufferCopyFilter(benchmark::State & state) {
+    unsigned len = state.range(0);
+    std::vector<T> input = benchmarkSignal<T>(len);
+    SpscRingBuffer<T> buf(len * 5 / 2);
+    RealFirFilter<T> filter(benchmarkTaps<T>(16));
+    RealVector<T> block(len);
+    for (auto _ : state) {
+        buf.write(VECTOR_TO_ARRAY(input), len);
+        buf.read(VECTOR_TO_ARRAY(block.vec), len);
+        filter.conv(block);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(block.vec));
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(SpscRingBufferCopyFilter, RING_BUFFER_ARGS);
+
+// Filters each block in place in a MirroredSpscRingBuffer.  Arg 1 is 1 for double mapping, 0 for the fallback.
+template <class T>
+static void MirroredRingBufferSpanFilter(benchmark::State & state) {
+    unsigned len = state.range(0);
+    std::vector<T> input = benchmarkSignal<T>(len);
+    MirroredSpscRingBuffer<T> buf(len * 5 / 2, state.range(1) != 0);
+    RealFirFilter<T> filter(benchmarkTaps<T>(16));
+    for (auto _ : state) {
+        buf.write(VECTOR_TO_ARRAY(input), len);
+        VectorView<T> block = buf.readSpan(len);
+        filter.conv(block);
+        benchmark::DoNotOptimize(block.data);
+        buf.consume(len);
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(MirroredRingBufferSpanFilter, ArgsProduct({{256, 4096, 65536}, {1, 0}}));
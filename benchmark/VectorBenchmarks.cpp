@@ -0,0 +1,244 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "RealVector.h"
+#include "ComplexVector.h"
+#include "FmModulator.h"
+#include "FmDemodulator.h"
+#include "BenchmarkUtils.h"
+
+using namespace NimbleDSP;
+
+
+// Vector lengths.  Every vector benchmark reports samples per second of each input.
+#define VECTOR_ARGS Arg(256)->Arg(4096)->Arg(65536)
+
+template <class T>
+static void RealVectorMultiplyAdd(benchmark::State & state) {
+    unsigned len = state.range(0);
+    RealVector<T> a(benchmarkSignal<T>(len)), b(benchmarkSignal<T>(len)), c(benchmarkSignal<T>(len));
+    RealVector<T> result(len);
+    for (auto _ : state) {
+        result = a * b + c;
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(result.vec));
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealVectorMultiplyAdd, VECTOR_ARGS);
+
+template <class T>
+static void RealVectorAddInPlace(benchmark::State & state) {
+    unsigned len = state.range(0);
+    RealVector<T> a(len), b(benchmarkSignal<T>(len));
+    for (auto _ : state) {
+        a += b;
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(a.vec));
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealVectorAddInPlace, VECTOR_ARGS);
+
+template <class T>
+static void RealVectorScale(benchmark::State & state) {
+    unsigned len = state.range(0);
+    RealVector<T> a(benchmarkSignal<T>(len));
+    for (auto _ : state) {
+        a *= (T) -1;
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(a.vec));
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealVectorScale, VECTOR_ARGS);
+
+template <class T>
+static void ComplexVectorMultiply(benchmark::State & state) {
+    unsigned len = state.range(0);
+    ComplexVector<T> a(benchmarkComplexSignal<T>(len)), b(benchmarkComplexSignal<T>(len));
+    ComplexVector<T> result(len);
+    for (auto _ : state) {
+        result = a * b;
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(result.vec));
+    }
+    setThroughput< std::complex<T> >(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(ComplexVectorMultiply, VECTOR_ARGS);
+
+template <class T>
+static void RealVectorSum(benchmark::State & state) {
+    unsigned len = state.range(0);
+    RealVector<T> a(benchmarkSignal<T>(len));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a.sum());
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealVectorSum, VECTOR_ARGS);
+
+template <class T>
+static void RealVectorMean(benchmark::State & state) {
+    unsigned len = state.range(0);
+    RealVector<T> a(benchmarkSignal<T>(len));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a.mean());
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealVectorMean, VECTOR_ARGS);
+
+template <class T>
+static void RealVectorVar(benchmark::State & state) {
+    unsigned len = state.range(0);
+    RealVector<T> a(benchmarkSignal<T>(len));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a.var());
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealVectorVar, VECTOR_ARGS);
+
+template <class T>
+static void RealVectorMax(benchmark::State & state) {
+    unsigned len = state.range(0);
+    RealVector<T> a(benchmarkSignal<T>(len));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a.max());
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealVectorMax, VECTOR_ARGS);
+
+template <class T>
+static void RealVectorMedian(benchmark::State & state) {
+    unsigned len = state.range(0);
+    RealVector<T> a(benchmarkSignal<T>(len));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a.median());
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_ALL_TYPES(RealVectorMedian, VECTOR_ARGS);
+
+// ComplexVector::modulate with std::cos and std::sin per sample, for comparison with the NCO.
+template <class T>
+static void ComplexVectorModulate(benchmark::State & state) {
+    unsigned len = state.range(0);
+    ComplexVector<T> a(benchmarkComplexSignal<T>(len));
+    T phase = 0;
+    for (auto _ : state) {
+        phase = a.modulate((T) 0.0123, (T) 1, phase);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(a.vec));
+    }
+    setThroughput< std::complex<T> >(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(ComplexVectorModulate, VECTOR_ARGS);
+
+// NCO type and vector length.
+template <class T>
+static void ComplexVectorModulateNco(benchmark::State & state) {
+    unsigned len = state.range(1);
+    ComplexVector<T> a(benchmarkComplexSignal<T>(len));
+    Nco<T> nco((T) 0.0123, (T) 1, (T) 0, (NcoType) state.range(0));
+    for (auto _ : state) {
+        a.modulate(nco);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(a.vec));
+    }
+    setThroughput< std::complex<T> >(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(ComplexVectorModulateNco, ArgsProduct({{NCO_LOOKUP_TABLE, NCO_ROTATOR, NCO_POLYNOMIAL},
+                                                                      {256, 4096, 65536}}));
+
+// FM modulation with separate scale, cumsum, and complex exponential passes, as in the NarrowbandFM example.
+template <class T>
+static void FmModulateUnfused(benchmark::State & state) {
+    unsigned len = state.range(0);
+    RealVector<T> input(benchmarkSignal<T>(len));
+    RealVector<T> phases;
+    ComplexVector<T> output;
+    T lastPhase = 0;
+    for (auto _ : state) {
+        phases = input;
+        phases *= (T) 0.3;
+        cumsum(phases, lastPhase);
+        lastPhase = phases[len - 1];
+        output = phases;
+        output *= std::complex<T>(0, 1);
+        exp(output);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output.vec));
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(FmModulateUnfused, VECTOR_ARGS);
+
+template <class T>
+static void FmModulateFused(benchmark::State & state) {
+    unsigned len = state.range(0);
+    RealVector<T> input(benchmarkSignal<T>(len));
+    ComplexVector<T> output;
+    FmModulator<T> modulator((T) 0.3 / (2 * (T) M_PI));
+    for (auto _ : state) {
+        modulator.modulate(input, output);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output.vec));
+    }
+    setThroughput<T>(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(FmModulateFused, VECTOR_ARGS);
+
+// FM demodulation with separate angle, diff, and unwrap passes, as in the NarrowbandFM example.
+template <class T>
+static void FmDemodulateUnfused(benchmark::State & state) {
+    unsigned len = state.range(0);
+    ComplexVector<T> input(benchmarkComplexSignal<T>(len));
+    ComplexVector<T> output;
+    std::complex<T> lastAngle = 0;
+    for (auto _ : state) {
+        output = input;
+        angle(output);
+        std::complex<T> nextLastAngle = output[len - 1];
+        diff(output, lastAngle);
+        lastAngle = nextLastAngle;
+        for (unsigned i=0; i<output.size(); i++) {
+            if (output[i].real() > M_PI) {
+                output[i] -= 2 * (T) M_PI;
+            }
+            else if (output[i].real() < -M_PI) {
+                output[i] += 2 * (T) M_PI;
+            }
+        }
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output.vec));
+    }
+    setThroughput< std::complex<T> >(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(FmDemodulateUnfused, VECTOR_ARGS);
+
+template <class T>
+static void FmDemodulateFused(benchmark::State & state) {
+    unsigned len = state.range(0);
+    ComplexVector<T> input(benchmarkComplexSignal<T>(len));
+    RealVector<T> output;
+    FmDemodulator<T> demodulator((T) 1);
+    for (auto _ : state) {
+        demodulator.demodulate(input, output);
+        benchmark::DoNotOptimize(VECTOR_TO_ARRAY(output.vec));
+    }
+    setThroughput< std::complex<T> >(state, len);
+}
+NIMBLEDSP_BENCHMARK_FLOAT_TYPES(FmDemodulateFused, VECTOR_ARGS);
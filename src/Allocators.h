@@ -0,0 +1,236 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file Allocators.h
+ *
+ * Definition of the AlignedAllocator and PoolAllocator classes, which can be used as the storage allocator
+ * of the vector and filter classes.
+ */
+
+#ifndef NimbleDSP_Allocators_h
+#define NimbleDSP_Allocators_h
+
+#include <cstddef>
+#include <cstdlib>
+#include <stdint.h>
+#include <new>
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Alignment in bytes of the memory returned by the NimbleDSP allocators.  Enough for AVX-512 loads.
+ */
+const std::size_t ALLOCATOR_ALIGNMENT = 64;
+
+/**
+ * \brief Smallest block size in bytes that PoolAllocator hands out.  Smaller requests get a block of this size.
+ */
+const std::size_t POOL_ALLOCATOR_MIN_BLOCK_SIZE = 64;
+
+/**
+ * \brief Largest block size in bytes that PoolAllocator recycles.  Larger requests go straight to the heap.
+ */
+const std::size_t POOL_ALLOCATOR_MAX_BLOCK_SIZE = 1 << 20;
+
+/**
+ * \brief Maximum number of free blocks of each size that a thread's pool holds on to.
+ */
+const unsigned POOL_ALLOCATOR_MAX_FREE_BLOCKS = 16;
+
+/**
+ * \brief Allocates "size" bytes aligned to "alignment" bytes, which must be a power of two.
+ *
+ * The memory must be released with \ref alignedFree.  Throws std::bad_alloc on failure.
+ */
+inline void *alignedMalloc(std::size_t size, std::size_t alignment = ALLOCATOR_ALIGNMENT) {
+    // Over-allocate, and store the pointer that malloc returned just before the aligned block.
+    void *raw = std::malloc(size + alignment - 1 + sizeof(void *));
+    if (raw == NULL)
+        throw std::bad_alloc();
+    uintptr_t aligned = ((uintptr_t) raw + sizeof(void *) + alignment - 1) & ~((uintptr_t) alignment - 1);
+    ((void **) aligned)[-1] = raw;
+    return (void *) aligned;
+}
+
+/**
+ * \brief Frees memory allocated by \ref alignedMalloc.
+ */
+inline void alignedFree(void *ptr) {
+    if (ptr != NULL)
+        std::free(((void **) ptr)[-1]);
+}
+
+/**
+ * \brief Standard allocator that aligns every allocation to ALLOCATOR_ALIGNMENT bytes.
+ *
+ * Use it as the Allocator parameter of the vector and filter classes so that the data can be loaded with
+ * aligned SIMD instructions, e.g. "RealVector<float, AlignedAllocator> buf(1024);".
+ */
+template <class T>
+class AlignedAllocator {
+ public:
+    typedef T value_type;
+    
+    AlignedAllocator() {}
+    template <class U> AlignedAllocator(const AlignedAllocator<U> &) {}
+    
+    /**
+     * \brief Allocates aligned storage for "n" elements.
+     */
+    T *allocate(std::size_t n) {return (T *) alignedMalloc(n * sizeof(T));}
+    
+    /**
+     * \brief Frees storage returned by \ref allocate.
+     */
+    void deallocate(T *ptr, std::size_t) {alignedFree(ptr);}
+    
+    template <class U> struct rebind {typedef AlignedAllocator<U> other;};
+};
+
+template <class T, class U>
+inline bool operator==(const AlignedAllocator<T> &, const AlignedAllocator<U> &) {return true;}
+
+template <class T, class U>
+inline bool operator!=(const AlignedAllocator<T> &, const AlignedAllocator<U> &) {return false;}
+
+/**
+ * \brief A thread's lists of free PoolAllocator blocks, one list per power of two block size.
+ */
+class PoolFreeLists {
+ public:
+    static const unsigned NUM_SIZES = 15;
+    
+    void *blocks[NUM_SIZES][POOL_ALLOCATOR_MAX_FREE_BLOCKS];
+    unsigned numBlocks[NUM_SIZES];
+    
+    PoolFreeLists() {
+        for (unsigned i=0; i<NUM_SIZES; i++) {
+            numBlocks[i] = 0;
+        }
+    }
+    
+    ~PoolFreeLists() {
+        for (unsigned i=0; i<NUM_SIZES; i++) {
+            for (unsigned j=0; j<numBlocks[i]; j++) {
+                alignedFree(blocks[i][j]);
+            }
+        }
+        current() = NULL;
+        finished() = true;
+    }
+    
+    /**
+     * \brief Returns the index of the smallest block size that holds "bytes", or NUM_SIZES if it's too big to pool.
+     */
+    static unsigned sizeIndex(std::size_t bytes) {
+        unsigned index = 0;
+        std::size_t blockSize = POOL_ALLOCATOR_MIN_BLOCK_SIZE;
+        while (blockSize < bytes && index < NUM_SIZES) {
+            blockSize <<= 1;
+            index++;
+        }
+        return index;
+    }
+    
+    /**
+     * \brief Returns the calling thread's free lists, or NULL if the thread is exiting and they're gone.
+     */
+    static PoolFreeLists *get() {
+        if (current() == NULL && !finished()) {
+            static thread_local PoolFreeLists lists;
+            current() = &lists;
+        }
+        return current();
+    }
+    
+ private:
+    // Plain pointers and flags have no destructor, so these are still safe to read while the thread's other
+    // objects (which may hold pool blocks) are being destroyed after the free lists are gone.
+    static PoolFreeLists *& current() {
+        static thread_local PoolFreeLists *lists = NULL;
+        return lists;
+    }
+    
+    static bool & finished() {
+        static thread_local bool done = false;
+        return done;
+    }
+};
+
+/**
+ * \brief Standard allocator that recycles blocks through a thread local pool.
+ *
+ * Requests are rounded up to a power of two size and blocks are kept on a per thread free list when they're
+ * released, so repeatedly creating and destroying temporary vectors of the same size doesn't go to the heap.
+ * No locking is needed.  Blocks may be released by a different thread than the one that allocated them; they
+ * simply join the releasing thread's pool.  Blocks bigger than POOL_ALLOCATOR_MAX_BLOCK_SIZE aren't pooled.
+ * Every block is aligned to ALLOCATOR_ALIGNMENT bytes.
+ */
+template <class T>
+class PoolAllocator {
+ public:
+    typedef T value_type;
+    
+    PoolAllocator() {}
+    template <class U> PoolAllocator(const PoolAllocator<U> &) {}
+    
+    /**
+     * \brief Allocates storage for "n" elements, reusing a free block if there is one.
+     */
+    T *allocate(std::size_t n) {
+        unsigned index = PoolFreeLists::sizeIndex(n * sizeof(T));
+        if (index >= PoolFreeLists::NUM_SIZES)
+            return (T *) alignedMalloc(n * sizeof(T));
+        
+        PoolFreeLists *pool = PoolFreeLists::get();
+        if (pool != NULL && pool->numBlocks[index] > 0)
+            return (T *) pool->blocks[index][--pool->numBlocks[index]];
+        return (T *) alignedMalloc(POOL_ALLOCATOR_MIN_BLOCK_SIZE << index);
+    }
+    
+    /**
+     * \brief Returns storage from \ref allocate to the pool, or frees it if the pool is full.
+     */
+    void deallocate(T *ptr, std::size_t n) {
+        unsigned index = PoolFreeLists::sizeIndex(n * sizeof(T));
+        PoolFreeLists *pool = (index < PoolFreeLists::NUM_SIZES) ? PoolFreeLists::get() : NULL;
+        if (pool != NULL && pool->numBlocks[index] < POOL_ALLOCATOR_MAX_FREE_BLOCKS)
+            pool->blocks[index][pool->numBlocks[index]++] = ptr;
+        else
+            alignedFree(ptr);
+    }
+    
+    template <class U> struct rebind {typedef PoolAllocator<U> other;};
+};
+
+template <class T, class U>
+inline bool operator==(const PoolAllocator<T> &, const PoolAllocator<U> &) {return true;}
+
+template <class T, class U>
+inline bool operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &) {return false;}
+
+};
+
+#endif
@@ -33,15 +33,22 @@ THE SOFTWARE.
 #include <complex>
 #include <math.h>
 #include "ComplexVector.h"
+#include "SimdKernels.h"
+#include "ParallelFor.h"
 
 
 namespace NimbleDSP {
     
 /**
  * \brief Class for complex FIR filters.
+ *
+ * A filter must not be used by more than one thread at a time, not even for one-shot filtering.  Besides the
+ * streaming state, filtering rewrites the cached polyphase copy of the taps.  Give each thread its own
+ * filter.  Setting \ref numThreads is fine: the cache is built on the calling thread before any worker
+ * starts, and the workers only read it.
  */
-template <class T>
-class ComplexFirFilter : public ComplexVector<T> {
+template <class T, template <class> class Allocator = std::allocator>
+class ComplexFirFilter : public ComplexVector<T, Allocator> {
  protected:
     /**
      * \brief Saved data that is used for stream filtering.
@@ -58,6 +65,119 @@ class ComplexFirFilter : public ComplexVector<T> {
      */
     int phase;
     
+    /**
+     * \brief The taps split into polyphase sub-filters for an interpolation rate of \ref polyphaseRate.
+     *
+     * Sub-filter p holds taps p, p + rate, p + 2*rate, etc. in reverse order, zero padded at the front to
+     * \ref polyphaseLen taps.  This lets every filter loop run forward through contiguous data and taps.  With
+     * a rate of 1 it is simply the taps in reverse order.  Kept current by \ref updatePolyphaseTaps.
+     */
+    std::vector< std::complex<T> > polyphaseTaps;
+    
+    /**
+     * \brief The taps' \ref generation when \ref polyphaseTaps was built.  Used to detect tap changes.
+     */
+    unsigned long long polyphaseGeneration;
+    
+    /**
+     * \brief The interpolation rate that \ref polyphaseTaps was built for.  0 if it hasn't been built.
+     */
+    int polyphaseRate;
+    
+    /**
+     * \brief Number of taps in each polyphase sub-filter.
+     */
+    int polyphaseLen;
+    
+    /**
+     * \brief Rebuilds \ref polyphaseTaps if the taps or the interpolation rate have changed.
+     *
+     * \param rate The interpolation rate.  1 for filtering without interpolation.
+     */
+    void updatePolyphaseTaps(int rate);
+    
+    /**
+     * \brief Calculates one filter output.
+     *
+     * Returns the sum of data[dataIndex + i] * taps[filterIndex - i*rate] for every i >= 0 where both indexes
+     * are in range, where "rate" is \ref polyphaseRate.  Uses the SIMD dot product kernels when they are
+     * available.  \ref polyphaseTaps must be current.
+     */
+    template <class U>
+    U filterPoint(const std::vector<U, Allocator<U> > & data, int dataIndex, int filterIndex) const {
+        assert(filterIndex >= 0 && filterIndex < (int) this->size());
+        int subFilterIndex = filterIndex / polyphaseRate;
+        int numPoints = std::min(subFilterIndex + 1, (int) data.size() - dataIndex);
+        if (numPoints <= 0)
+            return 0;
+        const std::complex<T> *subFilter = VECTOR_TO_ARRAY(polyphaseTaps) + (filterIndex % polyphaseRate) * polyphaseLen;
+        return dotProduct(VECTOR_TO_ARRAY(data) + dataIndex, subFilter + (polyphaseLen - 1 - subFilterIndex), numPoints);
+    }
+    
+    /**
+     * \brief Calculates results "begin" to "end" - 1 of a one-shot filter operation.
+     *
+     * Result k is point k*decimateRate + offset of the full convolution of the taps with "data" upsampled
+     * by \ref polyphaseRate.  Each result is calculated on its own, so the results don't depend on how
+     * the range is split up.  \ref polyphaseTaps must be current.
+     */
+    void oneShotPoints(const std::vector< std::complex<T>, Allocator< std::complex<T> > > & data, std::complex<T> *output, unsigned begin,
+                       unsigned end, int decimateRate, int offset) const {
+        for (unsigned resultIndex=begin; resultIndex<end; resultIndex++) {
+            int convIndex = resultIndex * decimateRate + offset;
+            int dataIndex = 0;
+            if (convIndex >= (int) this->size()) {
+                // Skip the data samples that the filter has already passed.
+                dataIndex = (convIndex - (int) this->size() + polyphaseRate) / polyphaseRate;
+            }
+            output[resultIndex] = filterPoint(data, dataIndex, convIndex - dataIndex * polyphaseRate);
+        }
+    }
+    
+    /**
+     * \brief Calculates all "outputLen" results of a one-shot filter operation, using up to \ref numThreads threads.
+     *
+     * See \ref oneShotPoints.
+     */
+    void oneShotFilter(const std::vector< std::complex<T>, Allocator< std::complex<T> > > & data, std::complex<T> *output, unsigned outputLen,
+                       int decimateRate, int offset) {
+        parallelFor(outputLen, numThreads, DEFAULT_PARALLEL_MIN_BLOCK_LEN,
+                    [&](unsigned begin, unsigned end) {oneShotPoints(data, output, begin, end, decimateRate, offset);});
+    }
+    
+    /**
+     * \brief Does the work of both \ref conv methods.
+     *
+     * "input" is copied into "dataTmp" before any results are written, so "input" and "output" may be the same buffer.
+     *
+     * \param dataTmp Working buffer.  Holds the saved samples followed by the input while filtering.
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.
+     * \param outputCapacity Number of samples that "output" can hold.
+     * \return The number of samples written to "output".
+     */
+    unsigned convData(std::vector< std::complex<T>, Allocator< std::complex<T> > > & dataTmp, const std::complex<T> *input, unsigned inputLen,
+                      std::complex<T> *output, unsigned outputCapacity);
+    
+    /**
+     * \brief Does the work of both decimate methods.  See \ref convData.
+     */
+    unsigned decimateData(std::vector< std::complex<T>, Allocator< std::complex<T> > > & dataTmp, const std::complex<T> *input, unsigned inputLen,
+                          std::complex<T> *output, unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Does the work of both interp methods.  See \ref convData.
+     */
+    unsigned interpData(std::vector< std::complex<T>, Allocator< std::complex<T> > > & dataTmp, const std::complex<T> *input, unsigned inputLen,
+                        std::complex<T> *output, unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Does the work of both resample methods.  See \ref convData.
+     */
+    unsigned resampleData(std::vector< std::complex<T>, Allocator< std::complex<T> > > & dataTmp, const std::complex<T> *input, unsigned inputLen,
+                          std::complex<T> *output, unsigned outputCapacity, int interpRate, int decimateRate);
+    
  public:
     /**
      * \brief Determines how the filter should filter.
@@ -68,6 +188,15 @@ class ComplexFirFilter : public ComplexVector<T> {
      *      filtered one continuous set of data.
      */
     FilterOperationType filtOperation;
+    
+    /**
+     * \brief Maximum number of threads that the one-shot filter operations can use.
+     *
+     * Long one-shot inputs are split into blocks that are filtered in parallel.  The results are identical to
+     * filtering on one thread.  Streaming operations always run on the calling thread.  Defaults to 1.  This
+     *      doesn't make the filter object itself safe to share between threads.
+     */
+    unsigned numThreads;
 
     /*****************************************************************************************
                                         Constructors
@@ -81,12 +210,13 @@ class ComplexFirFilter : public ComplexVector<T> {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
-    ComplexFirFilter<T>(unsigned size = DEFAULT_BUF_LEN, FilterOperationType operation = STREAMING, std::vector< std::complex<T> > *scratch = NULL) : ComplexVector<T>(size, scratch)
+    ComplexFirFilter<T, Allocator>(unsigned size = DEFAULT_BUF_LEN, FilterOperationType operation = STREAMING, std::vector< std::complex<T>, Allocator< std::complex<T> > > *scratch = NULL) : ComplexVector<T, Allocator>(size, scratch)
             {if (size > 0) {savedData.resize((size - 1) * sizeof(std::complex<T>)); numSavedSamples = size - 1;}
-             else {savedData.resize(0); numSavedSamples = 0;} phase = 0; filtOperation = operation;}
+             else {savedData.resize(0); numSavedSamples = 0;} phase = 0; filtOperation = operation;
+             polyphaseRate = 0; polyphaseGeneration = 0; numThreads = 1;}
     
     /**
      * \brief Vector constructor.
@@ -98,12 +228,13 @@ class ComplexFirFilter : public ComplexVector<T> {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
     template <typename U>
-    ComplexFirFilter<T>(std::vector<U> data, FilterOperationType operation = STREAMING, std::vector<T> *scratch = NULL) : ComplexVector<T>(data, scratch)
-            {savedData.resize((data.size() - 1) * sizeof(std::complex<T>)); numSavedSamples = data.size() - 1; phase = 0; filtOperation = operation;}
+    ComplexFirFilter<T, Allocator>(const std::vector<U> & data, FilterOperationType operation = STREAMING, std::vector< std::complex<T>, Allocator< std::complex<T> > > *scratch = NULL) : ComplexVector<T, Allocator>(data, NimbleDSP::TIME_DOMAIN, scratch)
+            {savedData.resize((data.size() - 1) * sizeof(std::complex<T>)); numSavedSamples = data.size() - 1; phase = 0; filtOperation = operation;
+             polyphaseRate = 0; polyphaseGeneration = 0; numThreads = 1;}
     
     /**
      * \brief Array constructor.
@@ -116,18 +247,37 @@ class ComplexFirFilter : public ComplexVector<T> {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
     template <typename U>
-    ComplexFirFilter<T>(U *data, unsigned dataLen, FilterOperationType operation = STREAMING, std::vector< std::complex<T> > *scratch = NULL) : ComplexVector<T>(data, dataLen, NimbleDSP::TIME_DOMAIN, scratch)
-            {savedData.resize((dataLen - 1) * sizeof(std::complex<T>)); numSavedSamples = dataLen - 1; phase = 0; filtOperation = operation;}
+    ComplexFirFilter<T, Allocator>(U *data, unsigned dataLen, FilterOperationType operation = STREAMING, std::vector< std::complex<T>, Allocator< std::complex<T> > > *scratch = NULL) : ComplexVector<T, Allocator>(data, dataLen, NimbleDSP::TIME_DOMAIN, scratch)
+            {savedData.resize((dataLen - 1) * sizeof(std::complex<T>)); numSavedSamples = dataLen - 1; phase = 0; filtOperation = operation;
+             polyphaseRate = 0; polyphaseGeneration = 0; numThreads = 1;}
+    
+    /**
+     * \brief Adopting vector constructor.
+     *
+     * Takes over the storage of "data" instead of copying it, e.g. "ComplexFirFilter<double> filt(std::move(taps));".
+     * \param data The filter taps.  It is left empty.
+     * \param operation Determines how the filter filters.  See \ref filtOperation.
+     * \param scratch Pointer to a scratch buffer.  See the basic constructor.
+     */
+    ComplexFirFilter<T, Allocator>(std::vector< std::complex<T>, Allocator< std::complex<T> > > && data, FilterOperationType operation = STREAMING, std::vector< std::complex<T>, Allocator< std::complex<T> > > *scratch = NULL) : ComplexVector<T, Allocator>(std::move(data), NimbleDSP::TIME_DOMAIN, scratch)
+            {savedData.resize((this->size() - 1) * sizeof(std::complex<T>)); numSavedSamples = this->size() - 1; phase = 0; filtOperation = operation;
+             polyphaseRate = 0; polyphaseGeneration = 0; numThreads = 1;}
     
     /**
      * \brief Copy constructor.
      */
-    ComplexFirFilter<T>(const ComplexFirFilter<T>& other) {this->vec = other.vec; savedData = other.savedData;
-            numSavedSamples = other.numSavedSamples; phase = other.phase; filtOperation = other.filtOperation;}
+    ComplexFirFilter<T, Allocator>(const ComplexFirFilter<T, Allocator>& other) {this->vec = other.vec; savedData = other.savedData;
+            numSavedSamples = other.numSavedSamples; phase = other.phase; filtOperation = other.filtOperation;
+            polyphaseRate = 0; polyphaseGeneration = 0; numThreads = other.numThreads;}
+    
+    /**
+     * \brief Move constructor.  Takes over the taps, the filter state, and the polyphase version of the taps from "other".
+     */
+    ComplexFirFilter<T, Allocator>(ComplexFirFilter<T, Allocator>&& other) = default;
     
     /*****************************************************************************************
                                             Operators
@@ -135,7 +285,17 @@ class ComplexFirFilter : public ComplexVector<T> {
     /**
      * \brief Assignment operator.
      */
-    ComplexFirFilter<T>& operator=(const Vector<T>& rhs) {this->vec = rhs.vec; savedData.resize(this->size() - 1); phase = 0; filtOperation = STREAMING; return *this;}
+    ComplexFirFilter<T, Allocator>& operator=(const Vector<T, Allocator>& rhs) {this->vec = rhs.vec; this->modified(); savedData.resize(this->size() - 1); phase = 0; filtOperation = STREAMING; return *this;}
+    
+    /**
+     * \brief Copy assignment operator.
+     */
+    ComplexFirFilter<T, Allocator>& operator=(const ComplexFirFilter<T, Allocator>& rhs) = default;
+    
+    /**
+     * \brief Move assignment operator.  Takes over the taps and the filter state from "rhs".
+     */
+    ComplexFirFilter<T, Allocator>& operator=(ComplexFirFilter<T, Allocator>&& rhs) = default;
     
     /*****************************************************************************************
                                             Methods
@@ -148,7 +308,7 @@ class ComplexFirFilter : public ComplexVector<T> {
      *      \ref filtOperation is set.
      * \return Reference to "data", which holds the result of the convolution.
      */
-    virtual ComplexVector<T> & conv(ComplexVector<T> & data, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & conv(ComplexVector<T, Allocator> & data, bool trimTails = false);
     
     /**
      * \brief Decimate method.
@@ -162,7 +322,7 @@ class ComplexFirFilter : public ComplexVector<T> {
      *      \ref filtOperation is set.
      * \return Reference to "data", which holds the result of the decimation.
      */
-    virtual ComplexVector<T> & decimate(ComplexVector<T> & data, int rate, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & decimate(ComplexVector<T, Allocator> & data, int rate, bool trimTails = false);
     
     /**
      * \brief Interpolation method.
@@ -175,7 +335,7 @@ class ComplexFirFilter : public ComplexVector<T> {
      *      \ref filtOperation is set.
      * \return Reference to "data", which holds the result of the interpolation.
      */
-    virtual ComplexVector<T> & interp(ComplexVector<T> & data, int rate, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & interp(ComplexVector<T, Allocator> & data, int rate, bool trimTails = false);
     
     /**
      * \brief Resample method.
@@ -190,7 +350,97 @@ class ComplexFirFilter : public ComplexVector<T> {
      *      \ref filtOperation is set.
      * \return Reference to "data", which holds the result of the resampling.
      */
-    virtual ComplexVector<T> & resample(ComplexVector<T> & data, int interpRate, int decimateRate, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & resample(ComplexVector<T, Allocator> & data, int interpRate, int decimateRate, bool trimTails = false);
+    
+    /**
+     * \brief Convolution method that reads from "input" and writes the results to "output".
+     *
+     * Filters the same way as the in-place \ref conv method, but no memory is allocated once the
+     * thread's scratch buffers (see ScratchArena.h) have grown to their working size.  Use \ref convOutputLength to
+     * find out how big "output" needs to be.
+     *
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.  It may be the same buffer as "input".
+     * \param outputCapacity Number of samples that "output" can hold.
+     * \return The number of samples written to "output".
+     */
+    unsigned conv(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output, unsigned outputCapacity);
+    
+    /**
+     * \brief Convolution method that filters the samples that "data" refers to in place.
+     *
+     * A view can't be resized, so only the operations that produce one result per input sample
+     * (NimbleDSP::STREAMING and NimbleDSP::ONE_SHOT_TRIM_TAILS) can be used.
+     *
+     * \param data The data to filter.
+     * \return "data", which refers to the results.
+     */
+    VectorView< std::complex<T> > conv(VectorView< std::complex<T> > data);
+    
+    /**
+     * \brief Decimate method that reads from "input" and writes the results to "output".
+     *
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.  It may be the same buffer as "input".
+     * \param outputCapacity Number of samples that "output" can hold.  See \ref decimateOutputLength.
+     * \param rate Indicates how much to downsample.
+     * \return The number of samples written to "output".
+     */
+    unsigned decimate(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                      unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Interpolation method that reads from "input" and writes the results to "output".
+     *
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.  It may be the same buffer as "input".
+     * \param outputCapacity Number of samples that "output" can hold.  See \ref interpOutputLength.
+     * \param rate Indicates how much to upsample.
+     * \return The number of samples written to "output".
+     */
+    unsigned interp(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                    unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Resample method that reads from "input" and writes the results to "output".
+     *
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.  It may be the same buffer as "input".
+     * \param outputCapacity Number of samples that "output" can hold.  See \ref resampleOutputLength.
+     * \param interpRate Indicates how much to upsample.
+     * \param decimateRate Indicates how much to downsample.
+     * \return The number of samples written to "output".
+     */
+    unsigned resample(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                      unsigned outputCapacity, int interpRate, int decimateRate);
+    
+    /**
+     * \brief Returns the number of results the next call to \ref conv will produce for "inputLen" samples.
+     */
+    unsigned convOutputLength(unsigned inputLen) const;
+    
+    /**
+     * \brief Returns the number of results the next call to \ref decimate will produce for "inputLen" samples.
+     */
+    unsigned decimateOutputLength(unsigned inputLen, int rate) const;
+    
+    /**
+     * \brief Returns the maximum number of results the next call to \ref interp can produce for "inputLen" samples.
+     *
+     * When streaming, the first call can produce fewer results than this.
+     */
+    unsigned interpOutputLength(unsigned inputLen, int rate) const;
+    
+    /**
+     * \brief Returns the maximum number of results the next call to \ref resample can produce for "inputLen" samples.
+     *
+     * When streaming, the exact number depends on the filter phase.
+     */
+    unsigned resampleOutputLength(unsigned inputLen, int interpRate, int decimateRate) const;
 
     /**
      * \brief Correlation method.
@@ -198,240 +448,207 @@ class ComplexFirFilter : public ComplexVector<T> {
      * \param data The buffer that will be correlated.
      * \return Reference to "data", which holds the result of the convolution.
      */
-    virtual ComplexVector<T> & corr(ComplexVector<T> & data);
+    virtual ComplexVector<T, Allocator> & corr(ComplexVector<T, Allocator> & data);
 };
 
 
-template <class T>
-ComplexVector<T> & ComplexFirFilter<T>::conv(ComplexVector<T> & data, bool trimTails) {
-    int resultIndex;
-    int filterIndex;
-    int dataIndex;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    std::complex<T> *savedDataArray = (std::complex<T> *) VECTOR_TO_ARRAY(savedData);
+template <class T, template <class> class Allocator>
+void ComplexFirFilter<T, Allocator>::updatePolyphaseTaps(int rate) {
+    assert(rate > 0);
+    if (rate == polyphaseRate && polyphaseGeneration == this->generation)
+        return;
     
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
+    polyphaseRate = rate;
+    polyphaseGeneration = this->generation;
+    polyphaseLen = (this->size() + rate - 1) / rate;
+    polyphaseTaps.assign(rate * polyphaseLen, 0);
+    for (int subFilter=0; subFilter<rate; subFilter++) {
+        std::complex<T> *subFilterTaps = VECTOR_TO_ARRAY(polyphaseTaps) + subFilter * polyphaseLen;
+        for (int tap=0; subFilter + tap*rate < (int) this->size(); tap++) {
+            subFilterTaps[polyphaseLen - 1 - tap] = this->vec[subFilter + tap*rate];
+        }
     }
-    else {
-        dataTmp = data.scratchBuf;
+}
+
+template <class T, template <class> class Allocator>
+unsigned ComplexFirFilter<T, Allocator>::convOutputLength(unsigned inputLen) const {
+    if (filtOperation == ONE_SHOT_RETURN_ALL_RESULTS)
+        return inputLen + this->size() - 1;
+    return inputLen;
+}
+
+template <class T, template <class> class Allocator>
+unsigned ComplexFirFilter<T, Allocator>::decimateOutputLength(unsigned inputLen, int rate) const {
+    switch (filtOperation) {
+    case STREAMING:
+        return (inputLen + numSavedSamples - (this->size() - 1) + rate - 1) / rate;
+    case ONE_SHOT_RETURN_ALL_RESULTS:
+        return ((inputLen + this->size() - 1) + (rate - 1)) / rate;
+    default:
+        return (inputLen + rate - 1) / rate;
     }
+}
+
+template <class T, template <class> class Allocator>
+unsigned ComplexFirFilter<T, Allocator>::interpOutputLength(unsigned inputLen, int rate) const {
+    if (filtOperation == ONE_SHOT_RETURN_ALL_RESULTS)
+        return inputLen * rate + this->size() - 1 - (rate - 1);
+    return inputLen * rate;
+}
+
+template <class T, template <class> class Allocator>
+unsigned ComplexFirFilter<T, Allocator>::resampleOutputLength(unsigned inputLen, int interpRate, int decimateRate) const {
+    unsigned interpLen = interpOutputLength(inputLen, interpRate);
+    return (interpLen + decimateRate - 1) / decimateRate;
+}
+
+template <class T, template <class> class Allocator>
+unsigned ComplexFirFilter<T, Allocator>::convData(std::vector< std::complex<T>, Allocator< std::complex<T> > > & dataTmp, const std::complex<T> *input,
+        unsigned inputLen, std::complex<T> *output, unsigned outputCapacity) {
+    int resultIndex;
+    std::complex<T> *savedDataArray = (std::complex<T> *) VECTOR_TO_ARRAY(savedData);
+    unsigned outputLen = convOutputLength(inputLen);
+    
+    assert(outputCapacity >= outputLen);
+    updatePolyphaseTaps(1);
 
     switch (filtOperation) {
 
     case STREAMING:
-        dataTmp->resize((this->size() - 1) + data.size());
+        dataTmp.resize((this->size() - 1) + inputLen);
         for (int i=0; i<this->size()-1; i++) {
-            (*dataTmp)[i] = savedDataArray[i];
+            dataTmp[i] = savedDataArray[i];
         }
-        for (int i=0; i<data.size(); i++) {
-            (*dataTmp)[i + this->size() - 1] = data[i];
+        for (int i=0; i<inputLen; i++) {
+            dataTmp[i + this->size() - 1] = input[i];
         }
         
-        for (resultIndex=0; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex, filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
+        for (resultIndex=0; resultIndex<(int)outputLen; resultIndex++) {
+            output[resultIndex] = filterPoint(dataTmp, resultIndex, this->size()-1);
         }
         for (int i=0; i<this->size()-1; i++) {
-            savedDataArray[i] = (*dataTmp)[i + data.size()];
+            savedDataArray[i] = dataTmp[i + inputLen];
         }
         break;
 
     case ONE_SHOT_RETURN_ALL_RESULTS:
-        *dataTmp = data.vec;
-        data.resize(data.size() + this->size() - 1);
-        
-        // Initial partial overlap
-        for (resultIndex=0; resultIndex<(int)this->size()-1; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=resultIndex; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<(int)dataTmp->size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex - (this->size()-1), filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex - (this->size()-1), filterIndex=this->size()-1;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, 1, 0);
         break;
 
     case ONE_SHOT_TRIM_TAILS:
-        *dataTmp = data.vec;
-
-        // Initial partial overlap
-        int initialTrim = (this->size() - 1) / 2;
-        for (resultIndex=0; resultIndex<((int)this->size()-1) - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=initialTrim + resultIndex; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<(int)dataTmp->size() - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, 1, (this->size() - 1) / 2);
         break;
     }
+    return outputLen;
+}
+
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexFirFilter<T, Allocator>::conv(ComplexVector<T, Allocator> & data, bool trimTails) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size() + this->size());
+    unsigned inputLen = data.size();
+    
+    data.resize(std::max(inputLen, convOutputLength(inputLen)));
+    data.resize(convData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size()));
     return data;
 }
 
-template <class T>
-ComplexVector<T> & ComplexFirFilter<T>::decimate(ComplexVector<T> & data, int rate, bool trimTails) {
+template <class T, template <class> class Allocator>
+unsigned ComplexFirFilter<T, Allocator>::conv(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                                 unsigned outputCapacity) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(NULL, inputLen + this->size());
+    return convData(*dataTmp, input, inputLen, output, outputCapacity);
+}
+
+template <class T, template <class> class Allocator>
+VectorView< std::complex<T> > ComplexFirFilter<T, Allocator>::conv(VectorView< std::complex<T> > data) {
+    assert(convOutputLength(data.size()) == data.size());
+    processContiguous(data, [this](std::complex<T> *samples, unsigned len) {this->conv(samples, len, samples, len);});
+    return data;
+}
+
+/**
+ * \brief Convolution function that filters the samples that "data" refers to in place.  See ComplexFirFilter::conv.
+ */
+template <class T, template <class> class Allocator>
+inline VectorView< std::complex<T> > conv(VectorView< std::complex<T> > data, ComplexFirFilter<T, Allocator> & filter) {
+    return filter.conv(data);
+}
+
+template <class T, template <class> class Allocator>
+unsigned ComplexFirFilter<T, Allocator>::decimateData(std::vector< std::complex<T>, Allocator< std::complex<T> > > & dataTmp, const std::complex<T> *input,
+        unsigned inputLen, std::complex<T> *output, unsigned outputCapacity, int rate) {
     int resultIndex;
-    int filterIndex;
-    int dataIndex;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
     std::complex<T> *savedDataArray = (std::complex<T> *) VECTOR_TO_ARRAY(savedData);
+    unsigned outputLen = decimateOutputLength(inputLen, rate);
     
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    assert(outputCapacity >= outputLen);
+    updatePolyphaseTaps(1);
 
     switch (filtOperation) {
 
     case STREAMING: {
-        dataTmp->resize(numSavedSamples + data.size());
+        dataTmp.resize(numSavedSamples + inputLen);
         for (int i=0; i<numSavedSamples; i++) {
-            (*dataTmp)[i] = savedDataArray[i];
+            dataTmp[i] = savedDataArray[i];
         }
-        for (int i=0; i<data.size(); i++) {
-            (*dataTmp)[i + numSavedSamples] = data[i];
+        for (int i=0; i<inputLen; i++) {
+            dataTmp[i + numSavedSamples] = input[i];
         }
         
-        data.resize((data.size() + numSavedSamples - (this->size() - 1) + rate - 1)/rate);
-        for (resultIndex=0; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate, filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
+        for (resultIndex=0; resultIndex<(int)outputLen; resultIndex++) {
+            output[resultIndex] = filterPoint(dataTmp, resultIndex*rate, this->size()-1);
         }
         int nextResultDataPoint = resultIndex * rate;
-        numSavedSamples = ((int) dataTmp->size()) - nextResultDataPoint;
+        numSavedSamples = ((int) dataTmp.size()) - nextResultDataPoint;
 
         for (int i=0; i<numSavedSamples; i++) {
-            savedDataArray[i] = (*dataTmp)[i + nextResultDataPoint];
+            savedDataArray[i] = dataTmp[i + nextResultDataPoint];
         }
         }
         break;
 
     case ONE_SHOT_RETURN_ALL_RESULTS:
-        *dataTmp = data.vec;
-        data.resize(((data.size() + this->size() - 1) + (rate - 1)) / rate);
-        
-        // Initial partial overlap
-        for (resultIndex=0; resultIndex<((int)this->size()-1+rate-1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=resultIndex*rate; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<((int)dataTmp->size()+rate-1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate - (this->size()-1), filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate - (this->size()-1), filterIndex=this->size()-1;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, rate, 0);
         break;
 
     case ONE_SHOT_TRIM_TAILS:
-        *dataTmp = data.vec;
-        data.resize((data.size() + rate - 1) / rate);
-        
-        // Initial partial overlap
-        int initialTrim = (this->size() - 1) / 2;
-        for (resultIndex=0; resultIndex<(((int)this->size()-1) - initialTrim + rate - 1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=initialTrim + resultIndex*rate; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<((int)dataTmp->size() - initialTrim + rate - 1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, rate, (this->size() - 1) / 2);
         break;
     }
+    return outputLen;
+}
+
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexFirFilter<T, Allocator>::decimate(ComplexVector<T, Allocator> & data, int rate, bool trimTails) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size() + this->size());
+    unsigned inputLen = data.size();
+    
+    data.resize(std::max(inputLen, decimateOutputLength(inputLen, rate)));
+    data.resize(decimateData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size(), rate));
     return data;
 }
 
-template <class T>
-ComplexVector<T> & ComplexFirFilter<T>::interp(ComplexVector<T> & data, int rate, bool trimTails) {
+template <class T, template <class> class Allocator>
+unsigned ComplexFirFilter<T, Allocator>::decimate(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                                 unsigned outputCapacity, int rate) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(NULL, inputLen + this->size());
+    return decimateData(*dataTmp, input, inputLen, output, outputCapacity, rate);
+}
+
+template <class T, template <class> class Allocator>
+unsigned ComplexFirFilter<T, Allocator>::interpData(std::vector< std::complex<T>, Allocator< std::complex<T> > > & dataTmp, const std::complex<T> *input,
+        unsigned inputLen, std::complex<T> *output, unsigned outputCapacity, int rate) {
     int resultIndex;
-    int filterIndex;
-    int dataIndex;
     int dataStart, filterStart;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
     std::complex<T> *savedDataArray = (std::complex<T> *) VECTOR_TO_ARRAY(savedData);
+    unsigned outputLen = interpOutputLength(inputLen, rate);
     
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    assert(outputCapacity >= outputLen);
+    updatePolyphaseTaps(rate);
 
     switch (filtOperation) {
 
@@ -443,184 +660,107 @@ ComplexVector<T> & ComplexFirFilter<T>::interp(ComplexVector<T> & data, int rate
             phase = (numTaps - 1) * rate;
         }
         
-        dataTmp->resize(numSavedSamples + data.size());
+        dataTmp.resize(numSavedSamples + inputLen);
         for (int i=0; i<numSavedSamples; i++) {
-            (*dataTmp)[i] = savedDataArray[i];
+            dataTmp[i] = savedDataArray[i];
         }
-        for (int i=0; i<data.size(); i++) {
-            (*dataTmp)[i + numSavedSamples] = data[i];
+        for (int i=0; i<inputLen; i++) {
+            dataTmp[i + numSavedSamples] = input[i];
         }
         
-        data.resize((unsigned) dataTmp->size() * rate);
         bool keepGoing = true;
         for (resultIndex=0, dataStart=0, filterStart=phase; keepGoing; ++resultIndex) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
+            assert(resultIndex < (int) outputCapacity);
+            output[resultIndex] = filterPoint(dataTmp, dataStart, filterStart);
             ++filterStart;
             if (filterStart >= (int)this->size()) {
                 // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
                 // increment the data index and decrement the filter index.
                 filterStart -= rate;
                 ++dataStart;
-                if (dataTmp->size() - dataStart == numSavedSamples) {
+                if (dataTmp.size() - dataStart == numSavedSamples) {
                     keepGoing = false;
                     phase = filterStart;
                 }
             }
         }
-        data.resize(resultIndex);
+        outputLen = resultIndex;
 
         int i;
-        for (i=0; dataStart<dataTmp->size(); i++, dataStart++) {
-            savedDataArray[i] = (*dataTmp)[dataStart];
+        for (i=0; dataStart<dataTmp.size(); i++, dataStart++) {
+            savedDataArray[i] = dataTmp[dataStart];
         }
         numSavedSamples = i;
         }
         break;
 
     case ONE_SHOT_RETURN_ALL_RESULTS:
-        *dataTmp = data.vec;
-        data.resize(data.size() * rate + this->size() - 1 - (rate - 1));
-        
-        // Initial partial overlap
-        for (resultIndex=0, dataStart=0; resultIndex<(int)this->size()-1; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=resultIndex; filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (dataStart=0, filterStart=resultIndex; resultIndex<(int)dataTmp->size()*rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int) this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, 1, 0);
         break;
 
     case ONE_SHOT_TRIM_TAILS:
-        *dataTmp = data.vec;
-        data.resize(data.size() * rate);
-
-        // Initial partial overlap
-        int initialTrim = (this->size() - 1) / 2;
-        for (resultIndex=0, dataStart=0; resultIndex<(int)this->size()-1 - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=initialTrim + resultIndex; filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-       
-        // Middle full overlap
-        for (dataStart=0, filterStart=(int)this->size()-1; resultIndex<(int)dataTmp->size()*rate - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, 1, (this->size() - 1) / 2);
         break;
     }
+    return outputLen;
+}
+
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexFirFilter<T, Allocator>::interp(ComplexVector<T, Allocator> & data, int rate, bool trimTails) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size() + this->size());
+    unsigned inputLen = data.size();
+    
+    data.resize(std::max(inputLen, interpOutputLength(inputLen, rate)));
+    data.resize(interpData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size(), rate));
     return data;
 }
 
-template <class T>
-ComplexVector<T> & ComplexFirFilter<T>::resample(ComplexVector<T> & data, int interpRate, int decimateRate, bool trimTails) {
+template <class T, template <class> class Allocator>
+unsigned ComplexFirFilter<T, Allocator>::interp(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                                 unsigned outputCapacity, int rate) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(NULL, inputLen + this->size());
+    return interpData(*dataTmp, input, inputLen, output, outputCapacity, rate);
+}
+
+template <class T, template <class> class Allocator>
+unsigned ComplexFirFilter<T, Allocator>::resampleData(std::vector< std::complex<T>, Allocator< std::complex<T> > > & dataTmp, const std::complex<T> *input,
+        unsigned inputLen, std::complex<T> *output, unsigned outputCapacity, int interpRate, int decimateRate) {
     int resultIndex;
-    int filterIndex;
-    int dataIndex;
     int dataStart, filterStart;
-    int interpLen, resampLen;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
     std::complex<T> *savedDataArray = (std::complex<T> *) VECTOR_TO_ARRAY(savedData);
+    unsigned outputLen = resampleOutputLength(inputLen, interpRate, decimateRate);
     
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    assert(outputCapacity >= outputLen);
+    updatePolyphaseTaps(interpRate);
 
     switch (filtOperation) {
 
     case STREAMING: {
         int numTaps = (this->size() + interpRate - 1) / interpRate;
-        if (numSavedSamples >= numTaps) {
-            // First call to interp, have too many "saved" (really just the initial zeros) samples
+        if (numSavedSamples >= numTaps || (phase == 0 && numSavedSamples == numTaps - 1)) {
+            // First call to resample, have too many "saved" (really just the initial zeros) samples.  With an
+            // interpolation rate of 1 the number is right, but the phase still has to be set.
             numSavedSamples = numTaps - 1;
             phase = (numTaps - 1) * interpRate;
         }
         
-        dataTmp->resize(numSavedSamples + data.size());
+        dataTmp.resize(numSavedSamples + inputLen);
         for (int i=0; i<numSavedSamples; i++) {
-            (*dataTmp)[i] = savedDataArray[i];
+            dataTmp[i] = savedDataArray[i];
         }
-        for (int i=0; i<data.size(); i++) {
-            (*dataTmp)[i + numSavedSamples] = data[i];
+        for (int i=0; i<inputLen; i++) {
+            dataTmp[i + numSavedSamples] = input[i];
         }
         
-        interpLen = (unsigned) dataTmp->size() * interpRate;
-        resampLen = (interpLen + decimateRate - 1) / decimateRate;
-        data.resize(resampLen);
-        bool keepGoing = true;
-        for (resultIndex=0, dataStart=0, filterStart=phase; keepGoing; ++resultIndex) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
+        // Calculate every result whose newest data sample has arrived.  When decimateRate > interpRate a result
+        // can skip over several data samples, so the loop tests for the data it needs rather than for a particular
+        // number of samples left over.
+        for (resultIndex=0, dataStart=0, filterStart=phase;
+             dataStart + filterStart / interpRate < (int) dataTmp.size() && resultIndex < (int) outputCapacity;
+             ++resultIndex) {
+            output[resultIndex] = filterPoint(dataTmp, dataStart, filterStart);
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
                 // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
@@ -628,136 +768,51 @@ ComplexVector<T> & ComplexFirFilter<T>::resample(ComplexVector<T> & data, int in
                 filterStart -= interpRate;
                 ++dataStart;
             }
-            if (dataTmp->size() - dataStart == numSavedSamples) {
-                keepGoing = false;
-                phase = filterStart;
-            }
         }
-        data.resize(resultIndex);
+        assert(dataStart + filterStart / interpRate >= (int) dataTmp.size());
+        phase = filterStart;
+        outputLen = resultIndex;
         
         int i;
-        for (i=0; dataStart<dataTmp->size(); i++, dataStart++) {
-            savedDataArray[i] = (*dataTmp)[dataStart];
+        for (i=0; dataStart<dataTmp.size(); i++, dataStart++) {
+            savedDataArray[i] = dataTmp[dataStart];
         }
         numSavedSamples = i;
         }
         break;
 
     case ONE_SHOT_RETURN_ALL_RESULTS:
-        *dataTmp = data.vec;
-        interpLen = data.size() * interpRate + this->size() - 1 - (interpRate - 1);
-        resampLen = (interpLen + decimateRate - 1) / decimateRate;
-        data.resize(resampLen);
-        
-        // Initial partial overlap
-        for (resultIndex=0, dataStart=0, filterStart=0; resultIndex<((int)this->size()-1+decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=filterStart; filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<((int)dataTmp->size()*interpRate + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, decimateRate, 0);
         break;
 
     case ONE_SHOT_TRIM_TAILS:
-        *dataTmp = data.vec;
-        interpLen = data.size() * interpRate;
-        resampLen = (interpLen + decimateRate - 1) / decimateRate;
-        data.resize(resampLen);
-
-        // Initial partial overlap
-        int initialTrim = (this->size() - 1) / 2;
-        for (resultIndex=0, dataStart=0, filterStart=initialTrim;
-             resultIndex<((int)this->size()-1 - initialTrim + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=filterStart; filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<((int)dataTmp->size()*interpRate - initialTrim + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, decimateRate, (this->size() - 1) / 2);
         break;
     }
+    return outputLen;
+}
+
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexFirFilter<T, Allocator>::resample(ComplexVector<T, Allocator> & data, int interpRate, int decimateRate, bool trimTails) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size() + this->size());
+    unsigned inputLen = data.size();
+    
+    data.resize(std::max(inputLen, resampleOutputLength(inputLen, interpRate, decimateRate)));
+    data.resize(resampleData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size(), interpRate, decimateRate));
     return data;
 }
 
-template <class T>
-ComplexVector<T> & ComplexFirFilter<T>::corr(ComplexVector<T> & data) {
+template <class T, template <class> class Allocator>
+unsigned ComplexFirFilter<T, Allocator>::resample(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                                 unsigned outputCapacity, int interpRate, int decimateRate) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(NULL, inputLen + this->size());
+    return resampleData(*dataTmp, input, inputLen, output, outputCapacity, interpRate, decimateRate);
+}
+
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexFirFilter<T, Allocator>::corr(ComplexVector<T, Allocator> & data) {
 	this->conj();
 	this->reverse();
 	this->conv(data);
@@ -777,8 +832,8 @@ ComplexVector<T> & ComplexFirFilter<T>::corr(ComplexVector<T> & data) {
  *      the convolution.
  * \return Reference to "data", which holds the result of the convolution.
  */
-template <class T>
-inline ComplexVector<T> & corr(ComplexVector<T> & data, ComplexFirFilter<T> & filter) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & corr(ComplexVector<T, Allocator> & data, ComplexFirFilter<T, Allocator> & filter) {
     return filter.corr(data);
 }
 
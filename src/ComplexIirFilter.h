@@ -33,6 +33,7 @@ THE SOFTWARE.
 
 #include <vector>
 #include "ComplexVector.h"
+#include "VectorView.h"
 
 
 namespace NimbleDSP {
@@ -54,6 +55,14 @@ class ComplexIirFilter {
     template <class U>
     void initArray(U *num, unsigned numLen, U *den, unsigned denLen);
     
+    /**
+     * \brief Filters "data", which can be anything that has size() and operator[], in place.
+     *
+     * "U" is the sample type.
+     */
+    template <class U, class Samples>
+    void filterSamples(Samples & data);
+    
  public:
     std::vector< std::complex<T> > numerator;
     std::vector< std::complex<T> > denominator;
@@ -123,8 +132,17 @@ class ComplexIirFilter {
      *      the convolution.
      * \return Reference to "data", which holds the result of the convolution.
      */
+    template <class U, template <class> class UAllocator>
+    ComplexVector<U, UAllocator> & filter(ComplexVector<U, UAllocator> & data);
+    
+    /**
+     * \brief Filters the samples that "data" refers to in place.
+     *
+     * \param data The samples that will be filtered.
+     * \return "data", which refers to the filtered data.
+     */
     template <class U>
-    ComplexVector<U> & filter(ComplexVector<U> & data);
+    VectorView< std::complex<U> > filter(VectorView< std::complex<U> > data);
     
 };
 
@@ -146,10 +164,10 @@ void ComplexIirFilter<T>::initArray(U *num, unsigned numLen, U *den, unsigned de
 }
 
 template <class T>
-template <class U>
-ComplexVector<U> & ComplexIirFilter<T>::filter(ComplexVector<U> & data) {
+template <class U, class Samples>
+void ComplexIirFilter<T>::filterSamples(Samples & data) {
     unsigned resultIndex, i;
-    std::complex<U> newState0;
+    U newState0;
     
     for (resultIndex=0; resultIndex<data.size(); resultIndex++) {
         newState0 = data[resultIndex];
@@ -171,11 +189,29 @@ ComplexVector<U> & ComplexIirFilter<T>::filter(ComplexVector<U> & data) {
             data[resultIndex] += numerator[i] * state[i];
         }
     }
+}
+
+template <class T>
+template <class U, template <class> class UAllocator>
+ComplexVector<U, UAllocator> & ComplexIirFilter<T>::filter(ComplexVector<U, UAllocator> & data) {
+    filterSamples< std::complex<U> >(data);
+    return data;
+}
+
+template <class T>
+template <class U>
+VectorView< std::complex<U> > ComplexIirFilter<T>::filter(VectorView< std::complex<U> > data) {
+    filterSamples< std::complex<U> >(data);
     return data;
 }
 
+template <class T, class U, template <class> class UAllocator>
+ComplexVector<U, UAllocator> & filter(ComplexVector<U, UAllocator> & data, ComplexIirFilter<T> & filt) {
+    return filt.filter(data);
+}
+
 template <class T, class U>
-ComplexVector<U> & filter(ComplexVector<U> & data, ComplexIirFilter<T> & filt) {
+VectorView< std::complex<U> > filter(VectorView< std::complex<U> > data, ComplexIirFilter<T> & filt) {
     return filt.filter(data);
 }
 
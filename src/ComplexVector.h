@@ -32,7 +32,10 @@ THE SOFTWARE.
 
 #include <complex>
 #include "Vector.h"
-#include "kissfft.hh"
+#include "VectorExpression.h"
+#include "VectorView.h"
+#include "FftPlanCache.h"
+#include "Nco.h"
 
 
 
@@ -47,10 +50,10 @@ enum DomainType {TIME_DOMAIN, FREQUENCY_DOMAIN};
  * or your own custom complex class.  The object will automatically convert the buffer type to
  * std::complex<POD_type> for you.
  */
-template <class T>
-class ComplexVector : public Vector< std::complex<T> > {
+template <class T, template <class> class Allocator = std::allocator>
+class ComplexVector : public Vector< std::complex<T>, Allocator > {
  public:
-    template <class U> friend class ComplexFirFilter;
+    template <class U, template <class> class A> friend class ComplexFirFilter;
 
     /**
      * \brief Indicates whether the data in \ref buf is time domain data or frequency domain.
@@ -63,17 +66,17 @@ class ComplexVector : public Vector< std::complex<T> > {
     /**
      * \brief Basic constructor.
      *
-     * Sets \ref domain to NimbleDSP::TIME_DOMAIN and calls Vector<T>::Vector(size, scratch).
+     * Sets \ref domain to NimbleDSP::TIME_DOMAIN and calls Vector<T, Allocator>::Vector(size, scratch).
      * \param size Size of \ref buf.
      * \param scratch Pointer to a scratch buffer.  The scratch buffer can be shared by multiple
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
-    ComplexVector<T>(unsigned size = DEFAULT_BUF_LEN, std::vector< std::complex<T> > *scratch = NULL) :
-            Vector< std::complex<T> >(size, scratch) {domain = TIME_DOMAIN;}
+    ComplexVector<T, Allocator>(unsigned size = DEFAULT_BUF_LEN, std::vector< std::complex<T>, Allocator< std::complex<T> > > *scratch = NULL) :
+            Vector< std::complex<T>, Allocator >(size, scratch) {domain = TIME_DOMAIN;}
             
     /**
      * \brief Vector constructor.
@@ -85,14 +88,26 @@ class ComplexVector : public Vector< std::complex<T> > {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      * \param dataDomain Indicates whether the data is time domain data or frequency domain.
      *      Valid values are NimbleDSP::TIME_DOMAIN and NimbleDSP::FREQUENCY_DOMAIN.
      */
     template <typename U>
-    ComplexVector<T>(std::vector<U> data, DomainType dataDomain=TIME_DOMAIN,
-                std::vector< std::complex<T> > *scratch = NULL) : Vector< std::complex<T> >(data, scratch)
+    ComplexVector<T, Allocator>(const std::vector<U> & data, DomainType dataDomain=TIME_DOMAIN,
+                std::vector< std::complex<T>, Allocator< std::complex<T> > > *scratch = NULL) : Vector< std::complex<T>, Allocator >(data, scratch)
+                    {domain = dataDomain;}
+    
+    /**
+     * \brief Adopting vector constructor.
+     *
+     * Takes over the storage of "data" instead of copying it, e.g. "ComplexVector<double> v(std::move(stdVector));".
+     * \param data Vector that \ref vec will take the place of.  It is left empty.
+     * \param dataDomain Indicates whether the data is time domain data or frequency domain.
+     * \param scratch Pointer to a scratch buffer.  See the basic constructor.
+     */
+    ComplexVector<T, Allocator>(std::vector< std::complex<T>, Allocator< std::complex<T> > > && data, DomainType dataDomain=TIME_DOMAIN,
+                std::vector< std::complex<T>, Allocator< std::complex<T> > > *scratch = NULL) : Vector< std::complex<T>, Allocator >(std::move(data), scratch)
                     {domain = dataDomain;}
     
     /**
@@ -106,21 +121,35 @@ class ComplexVector : public Vector< std::complex<T> > {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      * \param dataDomain Indicates whether the data is time domain data or frequency domain.
      *      Valid values are NimbleDSP::TIME_DOMAIN and NimbleDSP::FREQUENCY_DOMAIN.
      */
     template <typename U>
-    ComplexVector<T>(U *data, unsigned dataLen, DomainType dataDomain=TIME_DOMAIN,
-                std::vector< std::complex<T> > *scratch = NULL) : Vector< std::complex<T> >(data, dataLen, scratch)
+    ComplexVector<T, Allocator>(U *data, unsigned dataLen, DomainType dataDomain=TIME_DOMAIN,
+                std::vector< std::complex<T>, Allocator< std::complex<T> > > *scratch = NULL) : Vector< std::complex<T>, Allocator >(data, dataLen, scratch)
                     {domain = dataDomain;}
     
     /**
      * \brief Copy constructor.
      */
-    ComplexVector<T>(const ComplexVector<T>& other)
-            {this->vec = other.vec; domain = other.domain; this->scratchBuf = other.scratchBuf;}
+    ComplexVector<T, Allocator>(const ComplexVector<T, Allocator>& other)
+            {this->vec = other.vec; domain = other.domain; this->scratchBuf = other.scratchBuf; this->generation = other.generation;}
+    
+    /**
+     * \brief Move constructor.  Takes over the storage of "other", which is left empty.
+     */
+    ComplexVector<T, Allocator>(ComplexVector<T, Allocator>&& other) : Vector< std::complex<T>, Allocator >(std::move(other)) {domain = other.domain;}
+    
+    /**
+     * \brief Expression constructor.
+     *
+     * Evaluates an expression built from the arithmetic operators, e.g. "ComplexVector<double> c = a*b + d;",
+     * in a single pass.  Sets \ref domain to NimbleDSP::TIME_DOMAIN.
+     */
+    template <class E>
+    ComplexVector<T, Allocator>(const VectorExpression<E>& expr) {evaluateExpression(this->vec, expr); domain = TIME_DOMAIN;}
     
     /*****************************************************************************************
                                             Operators
@@ -129,71 +158,116 @@ class ComplexVector : public Vector< std::complex<T> > {
      * \brief Assignment operator from ComplexVector.
      * \return Reference to "this".
      */
-    ComplexVector<T>& operator=(const ComplexVector<T>& rhs);
+    ComplexVector<T, Allocator>& operator=(const ComplexVector<T, Allocator>& rhs);
+    
+    /**
+     * \brief Move assignment operator.  Takes over the storage of "rhs", which is left empty.
+     * \return Reference to "this".
+     */
+    ComplexVector<T, Allocator>& operator=(ComplexVector<T, Allocator>&& rhs) {this->vec = std::move(rhs.vec); domain = rhs.domain;
+            this->generation = std::max(this->generation, rhs.generation) + 1; rhs.modified(); return *this;}
     
     /**
      * \brief Assignment operator from Vector.
      * \return Reference to "this".
      */
-    ComplexVector<T>& operator=(const Vector<T>& rhs);
+    ComplexVector<T, Allocator>& operator=(const Vector<T, Allocator>& rhs);
+    
+    /**
+     * \brief Assignment operator from an expression.
+     *
+     * Evaluates the expression directly into \ref vec, so no memory is allocated if \ref vec is already big enough.
+     *      \ref domain is left unchanged.
+     * \return Reference to "this".
+     */
+    template <class E>
+    ComplexVector<T, Allocator>& operator=(const VectorExpression<E>& rhs) {evaluateExpression(this->vec, rhs); this->modified(); return *this;}
     
     /**
      * \brief Unary minus (negation) operator.
      * \return Reference to "this".
      */
-    ComplexVector<T> & operator-();
+    ComplexVector<T, Allocator> & operator-();
     
     /**
      * \brief Add Buffer/Assignment operator.
      * \return Reference to "this".
      */
-    template <class U>
-    ComplexVector<T> & operator+=(const Vector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    ComplexVector<T, Allocator> & operator+=(const Vector<U, UAllocator> &rhs);
     
     /**
      * \brief Add Scalar/Assignment operator.
      * \return Reference to "this".
      */
-    ComplexVector<T> & operator+=(const std::complex<T> &rhs);
+    ComplexVector<T, Allocator> & operator+=(const std::complex<T> &rhs);
+    
+    /**
+     * \brief Add Expression/Assignment operator.
+     * \return Reference to "this".
+     */
+    template <class E>
+    ComplexVector<T, Allocator> & operator+=(const VectorExpression<E> &rhs);
     
     /**
      * \brief Subtract Buffer/Assignment operator.
      * \return Reference to "this".
      */
-    template <class U>
-    ComplexVector<T> & operator-=(const Vector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    ComplexVector<T, Allocator> & operator-=(const Vector<U, UAllocator> &rhs);
     
     /**
      * \brief Subtract Scalar/Assignment operator.
      * \return Reference to "this".
      */
-    ComplexVector<T> & operator-=(const std::complex<T> &rhs);
+    ComplexVector<T, Allocator> & operator-=(const std::complex<T> &rhs);
+    
+    /**
+     * \brief Subtract Expression/Assignment operator.
+     * \return Reference to "this".
+     */
+    template <class E>
+    ComplexVector<T, Allocator> & operator-=(const VectorExpression<E> &rhs);
     
     /**
      * \brief Multiply Buffer/Assignment operator.
      * \return Reference to "this".
      */
-    template <class U>
-    ComplexVector<T> & operator*=(const Vector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    ComplexVector<T, Allocator> & operator*=(const Vector<U, UAllocator> &rhs);
     
     /**
      * \brief Multiply Scalar/Assignment operator.
      * \return Reference to "this".
      */
-    ComplexVector<T> & operator*=(const std::complex<T> &rhs);
+    ComplexVector<T, Allocator> & operator*=(const std::complex<T> &rhs);
+    
+    /**
+     * \brief Multiply Expression/Assignment operator.
+     * \return Reference to "this".
+     */
+    template <class E>
+    ComplexVector<T, Allocator> & operator*=(const VectorExpression<E> &rhs);
     
     /**
      * \brief Divide Buffer/Assignment operator.
      * \return Reference to "this".
      */
-    template <class U>
-    ComplexVector<T> & operator/=(const Vector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    ComplexVector<T, Allocator> & operator/=(const Vector<U, UAllocator> &rhs);
     
     /**
      * \brief Divide Scalar/Assignment operator.
      * \return Reference to "this".
      */
-    ComplexVector<T> & operator/=(const std::complex<T> &rhs);
+    ComplexVector<T, Allocator> & operator/=(const std::complex<T> &rhs);
+    
+    /**
+     * \brief Divide Expression/Assignment operator.
+     * \return Reference to "this".
+     */
+    template <class E>
+    ComplexVector<T, Allocator> & operator/=(const VectorExpression<E> &rhs);
     
     /*****************************************************************************************
                                             Methods
@@ -203,7 +277,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      *
      * \return Reference to "this".
      */
-    //virtual Vector< std::complex<T> > & exp();
+    //virtual Vector< std::complex<T>, Allocator > & exp();
     
     /**
      * \brief Sets each element of \ref buf equal to its value to the power of "exponent".
@@ -211,7 +285,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      * \param exponent Exponent to use.
      * \return Reference to "this".
      */
-    ComplexVector<T> & pow(const std::complex<SLICKDSP_FLOAT_TYPE> & exponent);
+    ComplexVector<T, Allocator> & pow(const std::complex<SLICKDSP_FLOAT_TYPE> & exponent);
 
     /**
      * \brief Returns the element with the maximum real component in \ref buf.
@@ -247,37 +321,37 @@ class ComplexVector : public Vector< std::complex<T> > {
      *      independently on the real and imaginary elements of \ref buf.
      * \return Reference to "this".
      */
-    ComplexVector<T> & saturate(const std::complex<T> & val);
+    ComplexVector<T, Allocator> & saturate(const std::complex<T> & val);
 
     /**
      * \brief Does a "ceil" operation on \ref buf.
      * \return Reference to "this".
      */
-    ComplexVector<T> & ceil(void);
+    ComplexVector<T, Allocator> & ceil(void);
 
     /**
      * \brief Does a "ceil" operation on \ref buf.
      * \return Reference to "this".
      */
-    ComplexVector<T> & floor(void);
+    ComplexVector<T, Allocator> & floor(void);
 
     /**
      * \brief Does a "ceil" operation on \ref buf.
      * \return Reference to "this".
      */
-    ComplexVector<T> & round(void);
+    ComplexVector<T, Allocator> & round(void);
     
     /**
      * \brief Conjugates the data in \ref buf.
      * \return Reference to "this".
      */
-    ComplexVector<T> & conj();
+    ComplexVector<T, Allocator> & conj();
     
     /**
      * \brief Sets each element of \ref buf equal to its magnitude squared.
      * \return Reference to "this".
      */
-    ComplexVector<T> & magSq();
+    ComplexVector<T, Allocator> & magSq();
     
     /**
      * \brief Sets each element of \ref buf equal to its angle.
@@ -285,7 +359,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      * The angle is held in the real portion of \ref buf.
      * \return Reference to "this".
      */
-    ComplexVector<T> & angle();
+    ComplexVector<T, Allocator> & angle();
     
     /**
      * \brief Sets \ref buf equal to the FFT of the data in \ref buf.
@@ -293,7 +367,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      * Sets \ref domain equal to NimbleDSP::FREQUENCY_DOMAIN.
      * \return Reference to "this".
      */
-    ComplexVector<T> & fft();
+    ComplexVector<T, Allocator> & fft();
     
     /**
      * \brief Sets \ref buf equal to the inverse FFT of the data in \ref buf.
@@ -301,35 +375,35 @@ class ComplexVector : public Vector< std::complex<T> > {
      * Sets \ref domain equal to NimbleDSP::TIME_DOMAIN.
      * \return Reference to "this".
      */
-    ComplexVector<T> & ifft();
+    ComplexVector<T, Allocator> & ifft();
     
     /**
      * \brief Changes the elements of \ref vec to their absolute value.
      *
      * \return Reference to "this".
      */
-    ComplexVector<T> & abs();
+    ComplexVector<T, Allocator> & abs();
     
     /**
      * \brief Sets each element of \ref vec to e^(element).
      *
      * \return Reference to "this".
      */
-    ComplexVector<T> & exp();
+    ComplexVector<T, Allocator> & exp();
     
     /**
      * \brief Sets each element of \ref vec to the natural log of the element.
      *
      * \return Reference to "this".
      */
-    ComplexVector<T> & log();
+    ComplexVector<T, Allocator> & log();
     
     /**
      * \brief Sets each element of \ref vec to the base 10 log of the element.
      *
      * \return Reference to "this".
      */
-    ComplexVector<T> & log10();
+    ComplexVector<T, Allocator> & log10();
     
     /**
      * \brief Circular rotation.
@@ -340,14 +414,14 @@ class ComplexVector : public Vector< std::complex<T> > {
      *      the left, and negative values shift it to the right.
      * \return Reference to "this".
      */
-    ComplexVector<T> & rotate(int numToShift);
+    ComplexVector<T, Allocator> & rotate(int numToShift);
     
     /**
      * \brief Reverses the order of the elements in \ref vec.
      *
      * \return Reference to "this".
      */
-    ComplexVector<T> & reverse();
+    ComplexVector<T, Allocator> & reverse();
     
     /**
      * \brief Sets the length of \ref vec to "len".
@@ -358,7 +432,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      * \param val The value to set any new elements to.  Defaults to 0.
      * \return Reference to "this".
      */
-    ComplexVector<T> & resize(unsigned len, T val = (T) 0) {this->vec.resize(len, val); return *this;}
+    ComplexVector<T, Allocator> & resize(unsigned len, T val = (T) 0) {this->vec.resize(len, val); this->modified(); return *this;}
 
     /**
      * \brief Reserves "len" elements for \ref vec without actually resizing it.
@@ -366,7 +440,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      * \param len The number of elements to reserve for \ref vec.
      * \return Reference to "this".
      */
-    ComplexVector<T> & reserve(unsigned len) {this->vec.reserve(len); return *this;}
+    ComplexVector<T, Allocator> & reserve(unsigned len) {this->vec.reserve(len); return *this;}
     
     /**
      * \brief Lengthens \ref vec by "len" elements.
@@ -375,7 +449,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      * \param val The value to set the new elements to.  Defaults to 0.
      * \return Reference to "this".
      */
-    ComplexVector<T> & pad(unsigned len, T val = (T) 0) {this->vec.resize(this->size()+len, val); return *this;}
+    ComplexVector<T, Allocator> & pad(unsigned len, T val = (T) 0) {this->vec.resize(this->size()+len, val); this->modified(); return *this;}
 
     /**
      * \brief Copies the elements in the range "lower" to "upper" (inclusive) to "destination"
@@ -384,7 +458,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      * \param upper The last index to copy from.
      * \destination The vector to copy the vector slice to.
      */
-	void slice(unsigned lower, unsigned upper, ComplexVector<T> &destination);
+	void slice(unsigned lower, unsigned upper, ComplexVector<T, Allocator> &destination);
     
     /**
      * \brief Inserts rate-1 zeros between samples.
@@ -394,7 +468,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      *      after).  Valid values are 0 to "rate"-1.  Defaults to 0.
      * \return Reference to "this".
      */
-    ComplexVector<T> & upsample(int rate, int phase = 0);
+    ComplexVector<T, Allocator> & upsample(int rate, int phase = 0);
     
     /**
      * \brief Removes rate-1 samples out of every rate samples.
@@ -404,7 +478,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      *      are 0 to "rate"-1.  Defaults to 0.
      * \return Reference to "this".
      */
-    ComplexVector<T> & downsample(int rate, int phase = 0);
+    ComplexVector<T, Allocator> & downsample(int rate, int phase = 0);
     
     /**
      * \brief Replaces \ref vec with the cumulative sum of the samples in \ref vec.
@@ -412,7 +486,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      * \param initialVal Initializing value for the cumulative sum.  Defaults to zero.
      * \return Reference to "this".
      */
-	ComplexVector<T> & cumsum(T initialVal = 0);
+	ComplexVector<T, Allocator> & cumsum(T initialVal = 0);
     
     /**
      * \brief Replaces \ref vec with the difference between successive samples in vec.
@@ -420,7 +494,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      * The resulting \ref vec is one element shorter than it was previously.
      * \return Reference to "this".
      */
-	ComplexVector<T> & diff();
+	ComplexVector<T, Allocator> & diff();
     
     /**
      * \brief Replaces \ref vec with the difference between successive samples in vec.
@@ -430,7 +504,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      *      previous vec.
      * \return Reference to "this".
      */
-    ComplexVector<T> & diff(std::complex<T> & previousVal);
+    ComplexVector<T, Allocator> & diff(std::complex<T> & previousVal);
     
     /**
      * \brief Convolution method.
@@ -442,7 +516,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      *      the convolution.
      * \return Reference to "data", which holds the result of the convolution.
      */
-    virtual ComplexVector<T> & conv(ComplexVector<T> & data, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & conv(ComplexVector<T, Allocator> & data, bool trimTails = false);
     
     /**
      * \brief Decimate method.
@@ -457,7 +531,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      *      ends of the convolution.
      * \return Reference to "data", which holds the result of the decimation.
      */
-    virtual ComplexVector<T> & decimate(ComplexVector<T> & data, int rate, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & decimate(ComplexVector<T, Allocator> & data, int rate, bool trimTails = false);
     
     /**
      * \brief Interpolation method.
@@ -471,7 +545,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      *      ends of the convolution.
      * \return Reference to "data", which holds the result of the interpolation.
      */
-    virtual ComplexVector<T> & interp(ComplexVector<T> & data, int rate, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & interp(ComplexVector<T, Allocator> & data, int rate, bool trimTails = false);
     
     /**
      * \brief Resample method.
@@ -487,7 +561,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      *      ends of the convolution.
      * \return Reference to "data", which holds the result of the resampling.
      */
-    virtual ComplexVector<T> & resample(ComplexVector<T> & data, int interpRate, int decimateRate, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & resample(ComplexVector<T, Allocator> & data, int interpRate, int decimateRate, bool trimTails = false);
     
     /**
      * \brief Generates a complex tone.
@@ -510,41 +584,64 @@ class ComplexVector : public Vector< std::complex<T> > {
      * \return The next phase if the tone were to continue.
      */
     T modulate(T freq, T sampleFreq = 1.0, T phase = 0.0);
+    
+    /**
+     * \brief Generates a complex tone with an NCO.
+     *
+     * \param nco The oscillator.  The tone starts at its current phase, and it is left ready to continue the tone.
+     * \param numSamples The number of samples to generate.  "0" indicates to generate
+     *      this->size() samples.  Defaults to 0.
+     * \return Reference to "this".
+     */
+    ComplexVector<T, Allocator> & tone(Nco<T> & nco, unsigned numSamples = 0);
+    
+    /**
+     * \brief Modulates the data with a complex sinusoid from an NCO.
+     *
+     * \param nco The oscillator.  The tone starts at its current phase, and it is left ready to continue the tone.
+     * \return Reference to "this".
+     */
+    ComplexVector<T, Allocator> & modulate(Nco<T> & nco);
 };
 
 
-template <class T>
-ComplexVector<T>& ComplexVector<T>::operator=(const ComplexVector<T>& rhs)
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator>& ComplexVector<T, Allocator>::operator=(const ComplexVector<T, Allocator>& rhs)
 {
     this->vec = rhs.vec;
     domain = rhs.domain;
+    // Newer than both generations, like Vector::operator=.
+    this->generation = std::max(this->generation, rhs.generation) + 1;
     return *this;
 }
 
-template <class T>
-ComplexVector<T>& ComplexVector<T>::operator=(const Vector<T> & rhs)
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator>& ComplexVector<T, Allocator>::operator=(const Vector<T, Allocator> & rhs)
 {
     this->vec.resize(rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = std::complex<T>(rhs[i]);
     }
     domain = TIME_DOMAIN;
+    this->modified();
     return *this;
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::operator-()
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator-()
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = -(this->vec[i]);
     }
     return *this;
 }
 
-template <class T>
-template <class U>
-ComplexVector<T> & ComplexVector<T>::operator+=(const Vector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator+=(const Vector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] += rhs.vec[i];
@@ -552,39 +649,30 @@ ComplexVector<T> & ComplexVector<T>::operator+=(const Vector<U> &rhs)
     return *this;
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::operator+=(const std::complex<T> & rhs)
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator+=(const std::complex<T> & rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] += rhs;
     }
     return *this;
 }
 
-/**
- * \brief Buffer addition operator.
- */
-template <class T, class U>
-inline ComplexVector<T> operator+(ComplexVector<T> lhs, const Vector<U>& rhs)
+template <class T, template <class> class Allocator>
+template <class E>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator+=(const VectorExpression<E> &rhs)
 {
-    lhs += rhs;
-    return lhs;
-}
-
-/**
- * \brief Scalar addition operator.
- */
-template <class T>
-inline ComplexVector<T> operator+(ComplexVector<T> lhs, const std::complex<T> & rhs)
-{
-    lhs += rhs;
-    return lhs;
+    this->modified();
+    evaluateExpression(this->vec, *this + rhs);
+    return *this;
 }
 
-template <class T>
-template <class U>
-ComplexVector<T> & ComplexVector<T>::operator-=(const Vector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator-=(const Vector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] -= rhs.vec[i];
@@ -592,39 +680,30 @@ ComplexVector<T> & ComplexVector<T>::operator-=(const Vector<U> &rhs)
     return *this;
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::operator-=(const std::complex<T> &rhs)
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator-=(const std::complex<T> &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] -= rhs;
     }
     return *this;
 }
 
-/**
- * \brief Buffer subtraction operator.
- */
-template <class T, class U>
-inline ComplexVector<T> operator-(ComplexVector<T> lhs, const Vector<U>& rhs)
-{
-    lhs -= rhs;
-    return lhs;
-}
-
-/**
- * \brief Scalar subtraction operator.
- */
-template <class T>
-inline ComplexVector<T> operator-(ComplexVector<T> lhs, const std::complex<T> & rhs)
+template <class T, template <class> class Allocator>
+template <class E>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator-=(const VectorExpression<E> &rhs)
 {
-    lhs -= rhs;
-    return lhs;
+    this->modified();
+    evaluateExpression(this->vec, *this - rhs);
+    return *this;
 }
 
-template <class T>
-template <class U>
-ComplexVector<T> & ComplexVector<T>::operator*=(const Vector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator*=(const Vector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] *= rhs.vec[i];
@@ -632,39 +711,30 @@ ComplexVector<T> & ComplexVector<T>::operator*=(const Vector<U> &rhs)
     return *this;
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::operator*=(const std::complex<T> &rhs)
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator*=(const std::complex<T> &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] *= rhs;
     }
     return *this;
 }
 
-/**
- * \brief Buffer multiplication operator.
- */
-template <class T, class U>
-inline ComplexVector<T> operator*(ComplexVector<T> lhs, const Vector<U>& rhs)
-{
-    lhs *= rhs;
-    return lhs;
-}
-
-/**
- * \brief Scalar multiplication operator.
- */
-template <class T>
-inline ComplexVector<T> operator*(ComplexVector<T> lhs, const std::complex<T> & rhs)
+template <class T, template <class> class Allocator>
+template <class E>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator*=(const VectorExpression<E> &rhs)
 {
-    lhs *= rhs;
-    return lhs;
+    this->modified();
+    evaluateExpression(this->vec, *this * rhs);
+    return *this;
 }
 
-template <class T>
-template <class U>
-ComplexVector<T> & ComplexVector<T>::operator/=(const Vector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator/=(const Vector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] /= rhs.vec[i];
@@ -672,45 +742,38 @@ ComplexVector<T> & ComplexVector<T>::operator/=(const Vector<U> &rhs)
     return *this;
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::operator/=(const std::complex<T> &rhs)
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator/=(const std::complex<T> &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] /= rhs;
     }
     return *this;
 }
 
-/**
- * \brief Buffer division operator.
- */
-template <class T, class U>
-inline ComplexVector<T> operator/(ComplexVector<T> lhs, const Vector<U> & rhs)
+template <class T, template <class> class Allocator>
+template <class E>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::operator/=(const VectorExpression<E> &rhs)
 {
-    lhs /= rhs;
-    return lhs;
+    this->modified();
+    evaluateExpression(this->vec, *this / rhs);
+    return *this;
 }
 
-/**
- * \brief Scalar division operator.
- */
-template <class T>
-inline ComplexVector<T> operator/(ComplexVector<T> lhs, const std::complex<T> & rhs)
-{
-    lhs /= rhs;
-    return lhs;
-}
  /*
-template <class T>
-Vector< std::complex<T> > & ComplexVector<T>::exp() {
+template <class T, template <class> class Allocator>
+Vector< std::complex<T>, Allocator > & ComplexVector<T, Allocator>::exp() {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = std::exp(this->vec[i]);
     }
     return *this;
 }
    */
-template <class T>
-ComplexVector<T> & ComplexVector<T>::pow(const std::complex<SLICKDSP_FLOAT_TYPE> & exponent) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::pow(const std::complex<SLICKDSP_FLOAT_TYPE> & exponent) {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = std::pow(this->vec[i], exponent);
     }
@@ -724,13 +787,13 @@ ComplexVector<T> & ComplexVector<T>::pow(const std::complex<SLICKDSP_FLOAT_TYPE>
  * \param exponent Exponent to use.
  * \return Reference to "buffer".
  */
-template <class T>
-inline ComplexVector<T> & pow(ComplexVector<T> & buffer, const std::complex<SLICKDSP_FLOAT_TYPE> exponent) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & pow(ComplexVector<T, Allocator> & buffer, const std::complex<SLICKDSP_FLOAT_TYPE> exponent) {
     return buffer.pow(exponent);
 }
 
-template <class T>
-const std::complex<SLICKDSP_FLOAT_TYPE> ComplexVector<T>::mean() const {
+template <class T, template <class> class Allocator>
+const std::complex<SLICKDSP_FLOAT_TYPE> ComplexVector<T, Allocator>::mean() const {
     assert(this->size() > 0);
     std::complex<SLICKDSP_FLOAT_TYPE> sum = 0;
     for (unsigned i=0; i<this->size(); i++) {
@@ -739,8 +802,8 @@ const std::complex<SLICKDSP_FLOAT_TYPE> ComplexVector<T>::mean() const {
     return sum / ((SLICKDSP_FLOAT_TYPE) this->size());
 }
 
-template <class T>
-const T ComplexVector<T>::max(unsigned *maxLoc) const {
+template <class T, template <class> class Allocator>
+const T ComplexVector<T, Allocator>::max(unsigned *maxLoc) const {
     assert(this->size() > 0);
     T maxVal = this->vec[0].real();
     unsigned maxIndex = 0;
@@ -760,13 +823,13 @@ const T ComplexVector<T>::max(unsigned *maxLoc) const {
 /**
  * \brief Returns the mean (average) of the data in "buffer".
  */
-template <class T>
-inline const std::complex<SLICKDSP_FLOAT_TYPE> mean(ComplexVector<T> & buffer) {
+template <class T, template <class> class Allocator>
+inline const std::complex<SLICKDSP_FLOAT_TYPE> mean(ComplexVector<T, Allocator> & buffer) {
     return buffer.mean();
 }
 
-template <class T>
-const SLICKDSP_FLOAT_TYPE ComplexVector<T>::var() const {
+template <class T, template <class> class Allocator>
+const SLICKDSP_FLOAT_TYPE ComplexVector<T, Allocator>::var() const {
     assert(this->size() > 1);
     std::complex<SLICKDSP_FLOAT_TYPE> meanVal = this->mean();
     std::complex<SLICKDSP_FLOAT_TYPE> sum = 0;
@@ -780,21 +843,22 @@ const SLICKDSP_FLOAT_TYPE ComplexVector<T>::var() const {
 /**
  * \brief Returns the variance of the data in "buffer".
  */
-template <class T>
-inline const SLICKDSP_FLOAT_TYPE var(ComplexVector<T> & buffer) {
+template <class T, template <class> class Allocator>
+inline const SLICKDSP_FLOAT_TYPE var(ComplexVector<T, Allocator> & buffer) {
     return buffer.var();
 }
 
 /**
  * \brief Returns the standard deviation of the data in "buffer".
  */
-template <class T>
-inline const SLICKDSP_FLOAT_TYPE stdDev(ComplexVector<T> & buffer) {
+template <class T, template <class> class Allocator>
+inline const SLICKDSP_FLOAT_TYPE stdDev(ComplexVector<T, Allocator> & buffer) {
     return buffer.stdDev();
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::saturate(const std::complex<T> & val) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::saturate(const std::complex<T> & val) {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         if (this->vec[i].real() > val.real())
             this->vec[i].real(val.real());
@@ -818,23 +882,19 @@ ComplexVector<T> & ComplexVector<T>::saturate(const std::complex<T> & val) {
  *      independently on the real and imaginary elements of "vector".
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & saturate(ComplexVector<T> & vector, const std::complex<T> & val) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & saturate(ComplexVector<T, Allocator> & vector, const std::complex<T> & val) {
     return vector.saturate(val);
 }
     
-template <class T>
-ComplexVector<T> & ComplexVector<T>::fft() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::fft() {
+    this->modified();
     #ifdef NIMBLEDSP_DOMAIN_CHECKS
     assert(domain == TIME_DOMAIN);
     #endif
     
-    kissfft<T> fftEngine = kissfft<T>(this->size(), false);
-    std::vector< std::complex<T> > fftResults(this->size());
-    
-    fftEngine.transform((typename kissfft_utils::traits<T>::cpx_type *) VECTOR_TO_ARRAY(this->vec),
-                        (typename kissfft_utils::traits<T>::cpx_type *) VECTOR_TO_ARRAY(fftResults));
-    this->vec = fftResults;
+    getFftPlan<T>(this->size(), false).transformInPlace(this->vec);
     domain = FREQUENCY_DOMAIN;
     return *this;
 }
@@ -846,13 +906,14 @@ ComplexVector<T> & ComplexVector<T>::fft() {
  * \param buffer Buffer to operate on.
  * \return Reference to "buffer".
  */
-template <class T>
-inline ComplexVector<T> & fft(ComplexVector<T> &buffer) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & fft(ComplexVector<T, Allocator> &buffer) {
     return buffer.fft();
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::conj() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::conj() {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i].imag(-this->vec[i].imag());
     }
@@ -863,8 +924,8 @@ ComplexVector<T> & ComplexVector<T>::conj() {
  * \brief Conjugates the data in "buffer".
  * \return Reference to "buffer".
  */
-template <class T>
-inline ComplexVector<T> & conj(ComplexVector<T> & buffer) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & conj(ComplexVector<T, Allocator> & buffer) {
     return buffer.conj();
 }
 
@@ -876,8 +937,9 @@ inline T magSq(const std::complex<T> &val) {
     return val.real() * val.real() + val.imag() * val.imag();
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::magSq() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::magSq() {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i].real(NimbleDSP::magSq(this->vec[i]));
         this->vec[i].imag(0);
@@ -889,23 +951,19 @@ ComplexVector<T> & ComplexVector<T>::magSq() {
  * \brief Sets each element of "buffer" equal to its magnitude squared.
  * \return Reference to "buffer".
  */
-template <class T>
-inline ComplexVector<T> & magSq(ComplexVector<T> & buffer) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & magSq(ComplexVector<T, Allocator> & buffer) {
     return buffer.magSq();
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::ifft() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::ifft() {
+    this->modified();
     #ifdef NIMBLEDSP_DOMAIN_CHECKS
     assert(domain == FREQUENCY_DOMAIN);
     #endif
     
-    kissfft<T> fftEngine = kissfft<T>(this->size(), true);
-    std::vector< std::complex<T> > fftResults(this->size());
-    
-    fftEngine.transform((typename kissfft_utils::traits<T>::cpx_type *) VECTOR_TO_ARRAY(this->vec),
-                        (typename kissfft_utils::traits<T>::cpx_type *) VECTOR_TO_ARRAY(fftResults));
-    this->vec = fftResults;
+    getFftPlan<T>(this->size(), true).transformInPlace(this->vec);
     domain = TIME_DOMAIN;
     return *this;
 }
@@ -917,13 +975,14 @@ ComplexVector<T> & ComplexVector<T>::ifft() {
  * \param buffer Buffer to operate on.
  * \return Reference to "buffer".
  */
-template <class T>
-inline ComplexVector<T> & ifft(ComplexVector<T> &buffer) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & ifft(ComplexVector<T, Allocator> &buffer) {
     return buffer.ifft();
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::angle() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::angle() {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i].real(std::arg(this->vec[i]));
         this->vec[i].imag(0);
@@ -937,8 +996,8 @@ ComplexVector<T> & ComplexVector<T>::angle() {
  * The angle is held in the real portion of "buffer".
  * \return Reference to "buffer".
  */
-template <class T>
-inline ComplexVector<T> & angle(ComplexVector<T> & buffer) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & angle(ComplexVector<T, Allocator> & buffer) {
     return buffer.angle();
 }
 
@@ -952,8 +1011,9 @@ inline T angle(std::complex<T> &val) {
     return std::arg(val);
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::abs() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::abs() {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = (T) std::abs(this->vec[i]);
     }
@@ -966,13 +1026,14 @@ ComplexVector<T> & ComplexVector<T>::abs() {
  * \param vector Buffer to operate on.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & abs(ComplexVector<T> & vector) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & abs(ComplexVector<T, Allocator> & vector) {
     return vector.abs();
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::exp() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::exp() {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = (std::complex<T>) std::exp(this->vec[i]);
     }
@@ -985,13 +1046,14 @@ ComplexVector<T> & ComplexVector<T>::exp() {
  * \param vector Buffer to operate on.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & exp(ComplexVector<T> & vector) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & exp(ComplexVector<T, Allocator> & vector) {
     return vector.exp();
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::log() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::log() {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
 		this->vec[i] = (std::complex<T>) std::log(this->vec[i]);
     }
@@ -1004,13 +1066,14 @@ ComplexVector<T> & ComplexVector<T>::log() {
  * \param vector Buffer to operate on.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & log(ComplexVector<T> & vector) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & log(ComplexVector<T, Allocator> & vector) {
     return vector.log();
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::log10() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::log10() {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
 		this->vec[i] = (std::complex<T>) std::log10(this->vec[i]);
     }
@@ -1023,13 +1086,14 @@ ComplexVector<T> & ComplexVector<T>::log10() {
  * \param vector Buffer to operate on.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & log10(ComplexVector<T> & vector) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & log10(ComplexVector<T, Allocator> & vector) {
     return vector.log10();
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::rotate(int numToShift) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::rotate(int numToShift) {
+    this->modified();
     while (numToShift < 0)
         numToShift += this->size();
     
@@ -1053,13 +1117,14 @@ ComplexVector<T> & ComplexVector<T>::rotate(int numToShift) {
  *      the left, and negative values shift it to the right.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & rotate(ComplexVector<T> & vector, int numToShift) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & rotate(ComplexVector<T, Allocator> & vector, int numToShift) {
     return vector.rotate(numToShift);
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::reverse() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::reverse() {
+    this->modified();
     std::reverse(this->vec.begin(), this->vec.end());
     return *this;
 }
@@ -1070,8 +1135,8 @@ ComplexVector<T> & ComplexVector<T>::reverse() {
  * \param vector Buffer to operate on.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & reverse(ComplexVector<T> & vector) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & reverse(ComplexVector<T, Allocator> & vector) {
     return vector.reverse();
 }
 
@@ -1085,8 +1150,8 @@ ComplexVector<T> & reverse(ComplexVector<T> & vector) {
  * \param val The value to set any new elements to.  Defaults to 0.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & resize(ComplexVector<T> & vector, int len, T val = 0) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & resize(ComplexVector<T, Allocator> & vector, int len, T val = 0) {
     return vector.resize(len, val);
 }
 
@@ -1098,13 +1163,14 @@ ComplexVector<T> & resize(ComplexVector<T> & vector, int len, T val = 0) {
  * \param val The value to set the new elements to.  Defaults to 0.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & pad(ComplexVector<T> & vector, int len, T val = 0) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & pad(ComplexVector<T, Allocator> & vector, int len, T val = 0) {
     return vector.pad(len, val);
 }
     
-template <class T>
-ComplexVector<T> & ComplexVector<T>::upsample(int rate, int phase) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::upsample(int rate, int phase) {
+	this->modified();
 	assert(rate > 0);
 	assert(phase >= 0 && phase < rate);
 	if (rate == 1)
@@ -1129,13 +1195,14 @@ ComplexVector<T> & ComplexVector<T>::upsample(int rate, int phase) {
  *      after).  Valid values are 0 to "rate"-1.  Defaults to 0.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & upsample(ComplexVector<T> & vector, int rate, int phase = 0) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & upsample(ComplexVector<T, Allocator> & vector, int rate, int phase = 0) {
     return vector.upsample(rate, phase);
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::downsample(int rate, int phase) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::downsample(int rate, int phase) {
+	this->modified();
 	assert(rate > 0);
 	assert(phase >= 0 && phase < rate);
 	if (rate == 1)
@@ -1159,13 +1226,14 @@ ComplexVector<T> & ComplexVector<T>::downsample(int rate, int phase) {
  *      are 0 to "rate"-1.  Defaults to 0.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & downsample(ComplexVector<T> & vector, int rate, int phase = 0) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & downsample(ComplexVector<T, Allocator> & vector, int rate, int phase = 0) {
     return vector.downsample(rate, phase);
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::cumsum(T initialVal) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::cumsum(T initialVal) {
+    this->modified();
     T sum = initialVal;
     for (unsigned i=0; i<this->size(); i++) {
         sum += this->vec[i];
@@ -1181,13 +1249,14 @@ ComplexVector<T> & ComplexVector<T>::cumsum(T initialVal) {
  * \param initialVal Initializing value for the cumulative sum.  Defaults to zero.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & cumsum(ComplexVector<T> & vector, T initialVal = 0) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & cumsum(ComplexVector<T, Allocator> & vector, T initialVal = 0) {
     return vector.cumsum(initialVal);
 }
     
-template <class T>
-ComplexVector<T> & ComplexVector<T>::diff() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::diff() {
+	this->modified();
 	assert(this->size() > 1);
 	for (unsigned i=0; i<(this->size()-1); i++) {
 		this->vec[i] = this->vec[i + 1] - this->vec[i];
@@ -1203,13 +1272,14 @@ ComplexVector<T> & ComplexVector<T>::diff() {
  * \param vector Buffer to operate on.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & diff(ComplexVector<T> & vector) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & diff(ComplexVector<T, Allocator> & vector) {
     return vector.diff();
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::diff(std::complex<T> & previousVal) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::diff(std::complex<T> & previousVal) {
+	this->modified();
 	assert(this->size() > 0);
     std::complex<T> nextPreviousVal = this->vec[this->size()-1];
 	for (unsigned i=this->size()-1; i>0; i--) {
@@ -1229,52 +1299,44 @@ ComplexVector<T> & ComplexVector<T>::diff(std::complex<T> & previousVal) {
  *      previous vec.
  * \return Reference to "vector".
  */
-template <class T>
-ComplexVector<T> & diff(ComplexVector<T> & vector, std::complex<T> & previousVal) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & diff(ComplexVector<T, Allocator> & vector, std::complex<T> & previousVal) {
     return vector.diff(previousVal);
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::conv(ComplexVector<T> & data, bool trimTails) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::conv(ComplexVector<T, Allocator> & data, bool trimTails) {
     int resultIndex;
     int filterIndex;
     int dataIndex;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size());
     *dataTmp = data.vec;
     
     if (trimTails) {
         // Initial partial overlap
         int initialTrim = (this->size() - 1) / 2;
         for (resultIndex=0; resultIndex<((int)this->size()-1) - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=initialTrim + resultIndex; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (; resultIndex<(int)dataTmp->size() - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
                  filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
     }
@@ -1283,30 +1345,31 @@ ComplexVector<T> & ComplexVector<T>::conv(ComplexVector<T> & data, bool trimTail
         
         // Initial partial overlap
         for (resultIndex=0; resultIndex<(int)this->size()-1; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=resultIndex; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (; resultIndex<(int)dataTmp->size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex - (this->size()-1), filterIndex=this->size()-1;
                  filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex - (this->size()-1), filterIndex=this->size()-1;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
     }
+    data.modified();
     return data;
 }
 
@@ -1321,25 +1384,17 @@ ComplexVector<T> & ComplexVector<T>::conv(ComplexVector<T> & data, bool trimTail
  *      the convolution.
  * \return Reference to "data", which holds the result of the convolution.
  */
-template <class T>
-inline ComplexVector<T> & conv(ComplexVector<T> & data, ComplexVector<T> & filter, bool trimTails = false) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & conv(ComplexVector<T, Allocator> & data, ComplexVector<T, Allocator> & filter, bool trimTails = false) {
     return filter.conv(data, trimTails);
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::decimate(ComplexVector<T> & data, int rate, bool trimTails) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::decimate(ComplexVector<T, Allocator> & data, int rate, bool trimTails) {
     int resultIndex;
     int filterIndex;
     int dataIndex;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size());
     *dataTmp = data.vec;
     
     if (trimTails) {
@@ -1348,27 +1403,27 @@ ComplexVector<T> & ComplexVector<T>::decimate(ComplexVector<T> & data, int rate,
         // Initial partial overlap
         int initialTrim = (this->size() - 1) / 2;
         for (resultIndex=0; resultIndex<(((int)this->size()-1) - initialTrim + rate - 1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=initialTrim + resultIndex*rate; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (; resultIndex<((int)dataTmp->size() - initialTrim + rate - 1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex*rate - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
                  filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex*rate - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
     }
@@ -1377,30 +1432,31 @@ ComplexVector<T> & ComplexVector<T>::decimate(ComplexVector<T> & data, int rate,
         
         // Initial partial overlap
         for (resultIndex=0; resultIndex<((int)this->size()-1+rate-1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=resultIndex*rate; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (; resultIndex<((int)dataTmp->size()+rate-1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex*rate - (this->size()-1), filterIndex=this->size()-1;
                  filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex*rate - (this->size()-1), filterIndex=this->size()-1;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
     }
+    data.modified();
     return data;
 }
 
@@ -1418,26 +1474,18 @@ ComplexVector<T> & ComplexVector<T>::decimate(ComplexVector<T> & data, int rate,
  *      ends of the convolution.
  * \return Reference to "data", which holds the result of the decimation.
  */
-template <class T>
-inline ComplexVector<T> & decimate(ComplexVector<T> & data, int rate, ComplexVector<T> & filter, bool trimTails = false) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & decimate(ComplexVector<T, Allocator> & data, int rate, ComplexVector<T, Allocator> & filter, bool trimTails = false) {
     return filter.decimate(data, rate, trimTails);
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::interp(ComplexVector<T> & data, int rate, bool trimTails) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::interp(ComplexVector<T, Allocator> & data, int rate, bool trimTails) {
     int resultIndex;
     int filterIndex;
     int dataIndex;
     int dataStart, filterStart;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size());
     *dataTmp = data.vec;
     
     if (trimTails) {
@@ -1446,18 +1494,18 @@ ComplexVector<T> & ComplexVector<T>::interp(ComplexVector<T> & data, int rate, b
         // Initial partial overlap
         int initialTrim = (this->size() - 1) / 2;
         for (resultIndex=0, dataStart=0; resultIndex<(int)this->size()-1 - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=initialTrim + resultIndex; filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
        
         // Middle full overlap
         for (dataStart=0, filterStart=(int)this->size()-1; resultIndex<(int)dataTmp->size()*rate - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             ++filterStart;
             if (filterStart >= (int)this->size()) {
@@ -1470,10 +1518,10 @@ ComplexVector<T> & ComplexVector<T>::interp(ComplexVector<T> & data, int rate, b
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             ++filterStart;
             if (filterStart >= (int)this->size()) {
@@ -1489,18 +1537,18 @@ ComplexVector<T> & ComplexVector<T>::interp(ComplexVector<T> & data, int rate, b
         
         // Initial partial overlap
         for (resultIndex=0, dataStart=0; resultIndex<(int)this->size()-1; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=resultIndex; filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (dataStart=0, filterStart=resultIndex; resultIndex<(int)dataTmp->size()*rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             ++filterStart;
             if (filterStart >= (int)this->size()) {
@@ -1513,10 +1561,10 @@ ComplexVector<T> & ComplexVector<T>::interp(ComplexVector<T> & data, int rate, b
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             ++filterStart;
             if (filterStart >= (int) this->size()) {
@@ -1527,6 +1575,7 @@ ComplexVector<T> & ComplexVector<T>::interp(ComplexVector<T> & data, int rate, b
             }
         }
     }
+    data.modified();
     return data;
 }
 
@@ -1543,26 +1592,18 @@ ComplexVector<T> & ComplexVector<T>::interp(ComplexVector<T> & data, int rate, b
  *      ends of the convolution.
  * \return Reference to "data", which holds the result of the interpolation.
  */
-template <class T>
-inline ComplexVector<T> & interp(ComplexVector<T> & data, int rate, ComplexVector<T> & filter, bool trimTails = false) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & interp(ComplexVector<T, Allocator> & data, int rate, ComplexVector<T, Allocator> & filter, bool trimTails = false) {
     return filter.interp(data, rate, trimTails);
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::resample(ComplexVector<T> & data, int interpRate, int decimateRate,  bool trimTails) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::resample(ComplexVector<T, Allocator> & data, int interpRate, int decimateRate,  bool trimTails) {
     int resultIndex;
     int filterIndex;
     int dataIndex;
     int dataStart, filterStart;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size());
     *dataTmp = data.vec;
     
     if (trimTails) {
@@ -1574,9 +1615,9 @@ ComplexVector<T> & ComplexVector<T>::resample(ComplexVector<T> & data, int inter
         int initialTrim = (this->size() - 1) / 2;
         for (resultIndex=0, dataStart=0, filterStart=initialTrim;
              resultIndex<((int)this->size()-1 - initialTrim + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=filterStart; filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1589,10 +1630,10 @@ ComplexVector<T> & ComplexVector<T>::resample(ComplexVector<T> & data, int inter
         
         // Middle full overlap
         for (; resultIndex<((int)dataTmp->size()*interpRate - initialTrim + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1605,10 +1646,10 @@ ComplexVector<T> & ComplexVector<T>::resample(ComplexVector<T> & data, int inter
         
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1626,9 +1667,9 @@ ComplexVector<T> & ComplexVector<T>::resample(ComplexVector<T> & data, int inter
         
         // Initial partial overlap
         for (resultIndex=0, dataStart=0, filterStart=0; resultIndex<((int)this->size()-1+decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=filterStart; filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1641,10 +1682,10 @@ ComplexVector<T> & ComplexVector<T>::resample(ComplexVector<T> & data, int inter
         
         // Middle full overlap
         for (; resultIndex<((int)dataTmp->size()*interpRate + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1657,10 +1698,10 @@ ComplexVector<T> & ComplexVector<T>::resample(ComplexVector<T> & data, int inter
         
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1671,6 +1712,7 @@ ComplexVector<T> & ComplexVector<T>::resample(ComplexVector<T> & data, int inter
             }
         }
     }
+    data.modified();
     return data;
 }
 
@@ -1689,14 +1731,15 @@ ComplexVector<T> & ComplexVector<T>::resample(ComplexVector<T> & data, int inter
  *      ends of the convolution.
  * \return Reference to "data", which holds the result of the resampling.
  */
-template <class T>
-inline ComplexVector<T> & resample(ComplexVector<T> & data, int interpRate, int decimateRate,
-            ComplexVector<T> & filter, bool trimTails = false) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & resample(ComplexVector<T, Allocator> & data, int interpRate, int decimateRate,
+            ComplexVector<T, Allocator> & filter, bool trimTails = false) {
     return filter.resample(data, interpRate, decimateRate, trimTails);
 }
 
-template <class T>
-T ComplexVector<T>::tone(T freq, T sampleFreq, T phase, unsigned numSamples) {
+template <class T, template <class> class Allocator>
+T ComplexVector<T, Allocator>::tone(T freq, T sampleFreq, T phase, unsigned numSamples) {
+    this->modified();
     assert(sampleFreq > 0.0);
     
     if (numSamples && numSamples != this->size()) {
@@ -1723,13 +1766,14 @@ T ComplexVector<T>::tone(T freq, T sampleFreq, T phase, unsigned numSamples) {
  *      this->size() samples.  Defaults to 0.
  * \return Reference to "this".
  */
-template <class T>
-T tone(ComplexVector<T> & vec, T freq, T sampleFreq = 1.0, T phase = 0.0, unsigned numSamples = 0) {
+template <class T, template <class> class Allocator>
+T tone(ComplexVector<T, Allocator> & vec, T freq, T sampleFreq = 1.0, T phase = 0.0, unsigned numSamples = 0) {
     return vec.tone(freq, sampleFreq, phase, numSamples);
 }
 
-template <class T>
-T ComplexVector<T>::modulate(T freq, T sampleFreq, T phase) {
+template <class T, template <class> class Allocator>
+T ComplexVector<T, Allocator>::modulate(T freq, T sampleFreq, T phase) {
+    this->modified();
     assert(sampleFreq > 0.0);
     
     T phaseInc = (freq / sampleFreq) * 2 * M_PI;
@@ -1748,13 +1792,58 @@ T ComplexVector<T>::modulate(T freq, T sampleFreq, T phase) {
  * \param phase The modulating tone's starting phase, in radians.  Defaults to 0.
  * \return The next phase if the tone were to continue.
  */
-template <class T>
-T modulate(ComplexVector<T> &data, T freq, T sampleFreq, T phase) {
+template <class T, template <class> class Allocator>
+T modulate(ComplexVector<T, Allocator> &data, T freq, T sampleFreq, T phase) {
     return data.modulate(freq, sampleFreq, phase);
 }
 
-template <class T>
-void ComplexVector<T>::slice(unsigned lower, unsigned upper, ComplexVector<T> &destination) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::tone(Nco<T> & nco, unsigned numSamples) {
+    this->modified();
+    if (numSamples && numSamples != this->size()) {
+        this->resize(numSamples);
+    }
+    if (this->size() > 0)
+        nco.tone(VECTOR_TO_ARRAY(this->vec), this->size());
+    return *this;
+}
+
+/**
+ * \brief Generates a complex tone with an NCO.
+ *
+ * \param vec The vector to put the tone in.
+ * \param nco The oscillator.  The tone starts at its current phase, and it is left ready to continue the tone.
+ * \param numSamples The number of samples to generate.  "0" indicates to generate
+ *      vec.size() samples.  Defaults to 0.
+ * \return Reference to "vec".
+ */
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & tone(ComplexVector<T, Allocator> & vec, Nco<T> & nco, unsigned numSamples = 0) {
+    return vec.tone(nco, numSamples);
+}
+
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::modulate(Nco<T> & nco) {
+    this->modified();
+    if (this->size() > 0)
+        nco.modulate(VECTOR_TO_ARRAY(this->vec), this->size());
+    return *this;
+}
+
+/**
+ * \brief Modulates the data with a complex sinusoid from an NCO.
+ *
+ * \param data The data to modulate.
+ * \param nco The oscillator.  The tone starts at its current phase, and it is left ready to continue the tone.
+ * \return Reference to "data".
+ */
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & modulate(ComplexVector<T, Allocator> & data, Nco<T> & nco) {
+    return data.modulate(nco);
+}
+
+template <class T, template <class> class Allocator>
+void ComplexVector<T, Allocator>::slice(unsigned lower, unsigned upper, ComplexVector<T, Allocator> &destination) {
 	assert(lower <= upper);
 	assert(upper < this->size());
 
@@ -1764,8 +1853,9 @@ void ComplexVector<T>::slice(unsigned lower, unsigned upper, ComplexVector<T> &d
 	}
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::ceil() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::ceil() {
+	this->modified();
 	for (int index=0; index<this->size(); index++) {
 		this->vec[index].real(std::ceil(this->vec[index].real()));
 		this->vec[index].imag(std::ceil(this->vec[index].imag()));
@@ -1773,8 +1863,9 @@ ComplexVector<T> & ComplexVector<T>::ceil() {
 	return *this;
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::floor() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::floor() {
+	this->modified();
 	for (int index=0; index<this->size(); index++) {
 		this->vec[index].real(std::floor(this->vec[index].real()));
 		this->vec[index].imag(std::floor(this->vec[index].imag()));
@@ -1782,8 +1873,9 @@ ComplexVector<T> & ComplexVector<T>::floor() {
 	return *this;
 }
 
-template <class T>
-ComplexVector<T> & ComplexVector<T>::round() {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & ComplexVector<T, Allocator>::round() {
+	this->modified();
 	for (int index=0; index<this->size(); index++) {
 		this->vec[index].real(std::round(this->vec[index].real()));
 		this->vec[index].imag(std::round(this->vec[index].imag()));
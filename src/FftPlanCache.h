@@ -0,0 +1,295 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file FftPlanCache.h
+ *
+ * Definition of the FftPlan and RealFftPlan classes and the FFT plan caches.
+ */
+
+#ifndef NimbleDSP_FftPlanCache_h
+#define NimbleDSP_FftPlanCache_h
+
+#include <complex>
+#include <vector>
+#include <map>
+#include <utility>
+#include "Vector.h"
+#include "kissfft.hh"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief An FFT engine of a given size and direction, plus a work buffer of the same size.
+ *
+ * Creating a kissfft engine computes its twiddle factors, so FftPlan objects are meant to be
+ * created once and reused.  Use \ref getFftPlan rather than creating them directly.
+ */
+template <class T>
+class FftPlan {
+ public:
+    /**
+     * \brief The FFT engine.
+     */
+    kissfft<T> engine;
+
+    /**
+     * \brief Work buffer with the same number of points as the FFT.
+     *
+     * kissfft's C++ engine only transforms out of place (and kiss_fft's own in-place mode copies through a
+     *      temporary buffer too), so results are written here and then copied into place.
+     */
+    std::vector< std::complex<T> > buf;
+
+    /**
+     * \brief Constructor.
+     *
+     * \param nfft Number of points in the FFT.
+     * \param inverse Set to true for an inverse FFT.
+     */
+    FftPlan<T>(unsigned nfft, bool inverse) : engine(nfft, inverse), buf(nfft) {}
+
+    /**
+     * \brief FFTs "data" and puts the results in \ref buf.
+     *
+     * \param data Data to transform.  Must have the same number of points as the FFT.
+     */
+    void transform(const std::complex<T> *data) {
+        engine.transform((const typename kissfft_utils::traits<T>::cpx_type *) data,
+                         (typename kissfft_utils::traits<T>::cpx_type *) VECTOR_TO_ARRAY(buf));
+    }
+
+    /**
+     * \brief FFTs "data" and puts the results in "results".
+     *
+     * \param data Data to transform.  Must have the same number of points as the FFT.
+     * \param results Buffer to put the results in.  It may not overlap "data".
+     */
+    void transform(const std::complex<T> *data, std::complex<T> *results) {
+        engine.transform((const typename kissfft_utils::traits<T>::cpx_type *) data,
+                         (typename kissfft_utils::traits<T>::cpx_type *) results);
+    }
+
+    /**
+     * \brief FFTs "data" in place.
+     *
+     * The results are calculated into \ref buf and then copied back into "data", so "data" keeps its storage
+     *      (pointers and views into it stay valid) and no memory is allocated.  The copy back is one linear
+     *      pass over the points (16 bytes per point for double), small next to the O(n log n) transform, and
+     *      is the same copy kiss_fft itself makes when asked to transform in place.
+     * \param data Data to transform.  Must have the same number of points as the FFT.
+     */
+    template <class Allocator>
+    void transformInPlace(std::vector< std::complex<T>, Allocator > &data) {
+        assert(data.size() == buf.size());
+        transform(VECTOR_TO_ARRAY(data));
+        std::copy(buf.begin(), buf.end(), data.begin());
+    }
+};
+
+/**
+ * \brief An FFT plan for real time domain data.
+ *
+ * A forward plan transforms "nfft" real points into the nfft/2 + 1 bin half spectrum, and an inverse plan
+ * transforms the half spectrum back into "nfft" real points.  For even sizes the real data is packed into
+ * a complex FFT of half the size and the results are separated with a twiddle pass, which is roughly
+ * half the work of a full complex FFT.  Odd sizes fall back to a full size complex FFT.  Use
+ * \ref getRealFftPlan rather than creating these directly.
+ */
+template <class T>
+class RealFftPlan {
+ public:
+    /**
+     * \brief Number of real points in the FFT.
+     */
+    unsigned nfft;
+    
+    /**
+     * \brief True for an inverse FFT.
+     */
+    bool inverse;
+    
+    /**
+     * \brief The complex FFT that does most of the work.  It has nfft/2 points for even sizes, and nfft otherwise.
+     */
+    FftPlan<T> complexPlan;
+    
+    /**
+     * \brief exp(-/+j*2*pi*k/nfft) for k = 0 to nfft/2 - 1.  The sign is positive for inverse plans.
+     */
+    std::vector< std::complex<T> > twiddles;
+    
+    /**
+     * \brief Buffer for the input to \ref complexPlan.
+     */
+    std::vector< std::complex<T> > buf;
+    
+    /**
+     * \brief Constructor.
+     *
+     * \param nfft Number of real points in the FFT.
+     * \param inverse Set to true for an inverse FFT.
+     */
+    RealFftPlan<T>(unsigned nfft, bool inverse) : nfft(nfft), inverse(inverse),
+            complexPlan((nfft % 2 == 0) ? nfft / 2 : nfft, inverse), buf((nfft % 2 == 0) ? nfft / 2 : nfft) {
+        if (nfft % 2 == 0) {
+            T sign = inverse ? 1 : -1;
+            twiddles.resize(nfft / 2);
+            for (unsigned k=0; k<twiddles.size(); k++) {
+                twiddles[k] = std::polar((T) 1, sign * 2 * (T) M_PI * k / nfft);
+            }
+        }
+    }
+    
+    /**
+     * \brief Forward FFT.
+     *
+     * \param data "nfft" real points to transform.
+     * \param results Buffer to put the nfft/2 + 1 bin half spectrum in.
+     */
+    void transform(const T *data, std::complex<T> *results);
+    
+    /**
+     * \brief Inverse FFT.  Like the complex inverse FFT, the results are not scaled by 1/nfft.
+     *
+     * \param halfSpectrum The nfft/2 + 1 bin half spectrum to transform.
+     * \param results Buffer to put the "nfft" real points in.
+     */
+    void transform(const std::complex<T> *halfSpectrum, T *results);
+};
+
+template <class T>
+void RealFftPlan<T>::transform(const T *data, std::complex<T> *results) {
+    assert(!inverse);
+    
+    if (nfft % 2 != 0) {
+        for (unsigned i=0; i<nfft; i++) {
+            buf[i] = data[i];
+        }
+        complexPlan.transform(VECTOR_TO_ARRAY(buf));
+        for (unsigned i=0; i<=nfft/2; i++) {
+            results[i] = complexPlan.buf[i];
+        }
+        return;
+    }
+    
+    // Even samples go in the real part and odd samples in the imaginary part.
+    unsigned halfLen = nfft / 2;
+    for (unsigned i=0; i<halfLen; i++) {
+        buf[i] = std::complex<T>(data[2*i], data[2*i + 1]);
+    }
+    complexPlan.transform(VECTOR_TO_ARRAY(buf));
+    std::vector< std::complex<T> > &packed = complexPlan.buf;
+    
+    // Separate the FFTs of the even and odd samples and combine them.
+    results[0] = std::complex<T>(packed[0].real() + packed[0].imag(), 0);
+    results[halfLen] = std::complex<T>(packed[0].real() - packed[0].imag(), 0);
+    for (unsigned k=1; k<halfLen; k++) {
+        std::complex<T> packedConj = std::conj(packed[halfLen - k]);
+        std::complex<T> even = (packed[k] + packedConj) * (T) 0.5;
+        std::complex<T> odd = (packed[k] - packedConj) * std::complex<T>(0, -0.5);
+        results[k] = even + twiddles[k] * odd;
+    }
+}
+
+template <class T>
+void RealFftPlan<T>::transform(const std::complex<T> *halfSpectrum, T *results) {
+    assert(inverse);
+    
+    if (nfft % 2 != 0) {
+        buf[0] = halfSpectrum[0];
+        for (unsigned i=1; i<=nfft/2; i++) {
+            buf[i] = halfSpectrum[i];
+            buf[nfft - i] = std::conj(halfSpectrum[i]);
+        }
+        complexPlan.transform(VECTOR_TO_ARRAY(buf));
+        for (unsigned i=0; i<nfft; i++) {
+            results[i] = complexPlan.buf[i].real();
+        }
+        return;
+    }
+    
+    // Rebuild the FFTs of the even and odd samples, and pack them so that the inverse puts the even
+    // samples in the real part and the odd samples in the imaginary part.
+    unsigned halfLen = nfft / 2;
+    for (unsigned k=0; k<halfLen; k++) {
+        std::complex<T> spectrumConj = std::conj(halfSpectrum[halfLen - k]);
+        std::complex<T> even = halfSpectrum[k] + spectrumConj;
+        std::complex<T> odd = (halfSpectrum[k] - spectrumConj) * twiddles[k];
+        buf[k] = even + std::complex<T>(0, 1) * odd;
+    }
+    complexPlan.transform(VECTOR_TO_ARRAY(buf));
+    for (unsigned i=0; i<halfLen; i++) {
+        results[2*i] = complexPlan.buf[i].real();
+        results[2*i + 1] = complexPlan.buf[i].imag();
+    }
+}
+
+/**
+ * \brief Returns the cached FFT plan for the given size and direction, creating it if necessary.
+ *
+ * Plans are cached per thread, so the returned plan can be used without any locking.  Because
+ * plans hold a work buffer they should not be shared between threads.  The cache keeps one plan
+ * for each (size, direction, type) combination that has been used by the thread.
+ *
+ * \param nfft Number of points in the FFT.
+ * \param inverse Set to true for an inverse FFT.
+ * \return Reference to the plan.  It remains valid for the life of the calling thread.
+ */
+template <class T>
+FftPlan<T> & getFftPlan(unsigned nfft, bool inverse) {
+    static thread_local std::map< std::pair<unsigned, bool>, FftPlan<T> > plans;
+
+    std::pair<unsigned, bool> key(nfft, inverse);
+    typename std::map< std::pair<unsigned, bool>, FftPlan<T> >::iterator plan = plans.find(key);
+    if (plan == plans.end()) {
+        plan = plans.insert(std::make_pair(key, FftPlan<T>(nfft, inverse))).first;
+    }
+    return plan->second;
+}
+
+/**
+ * \brief Returns the cached real FFT plan for the given size and direction, creating it if necessary.
+ *
+ * Plans are cached per thread, in the same way as \ref getFftPlan.
+ *
+ * \param nfft Number of real points in the FFT.
+ * \param inverse Set to true for an inverse FFT.
+ * \return Reference to the plan.  It remains valid for the life of the calling thread.
+ */
+template <class T>
+RealFftPlan<T> & getRealFftPlan(unsigned nfft, bool inverse) {
+    static thread_local std::map< std::pair<unsigned, bool>, RealFftPlan<T> > plans;
+
+    std::pair<unsigned, bool> key(nfft, inverse);
+    typename std::map< std::pair<unsigned, bool>, RealFftPlan<T> >::iterator plan = plans.find(key);
+    if (plan == plans.end()) {
+        plan = plans.insert(std::make_pair(key, RealFftPlan<T>(nfft, inverse))).first;
+    }
+    return plan->second;
+}
+
+};
+
+#endif
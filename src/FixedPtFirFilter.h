@@ -0,0 +1,628 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file FixedPtFirFilter.h
+ *
+ * Definition of the template class FixedPtFirFilter.
+ */
+
+#ifndef NimbleDSP_FixedPtFirFilter_h
+#define NimbleDSP_FixedPtFirFilter_h
+
+#include <complex>
+#include <limits>
+#include <math.h>
+#include "RealFixedPtVector.h"
+#include "SimdKernels.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Class for fixed point FIR filters.
+ *
+ * RealFirFilter accumulates in the data type, so e.g. int16_t data times int16_t taps overflows almost
+ * immediately.  This class multiplies and accumulates in a wider type, and then scales each result back down to
+ * the data type with a configurable shift, rounding, and saturation.  It filters real and complex (e.g. int16_t IQ)
+ * data.  int16_t data and taps with an int32_t accumulator use the SIMD kernels in SimdKernels.h.
+ *
+ * \tparam T Type of the data, e.g. int16_t.
+ * \tparam TapType Type of the taps, e.g. int16_t or int32_t.
+ * \tparam AccumType Type that the products are summed in, e.g. int32_t or int64_t.  It has to hold the sum of
+ *      the products without overflowing, so for long filters and full scale data use int64_t.
+ */
+template <class T, class TapType, class AccumType, template <class> class Allocator = std::allocator>
+class FixedPtFirFilter : public RealFixedPtVector<TapType, Allocator> {
+ protected:
+    /**
+     * \brief Saved data that is used for stream filtering.  Sized for complex data.
+     */
+    std::vector<char> savedData;
+    
+    /**
+     * \brief Indicates how many samples are in \ref savedData.  Used for stream filtering.
+     */
+    int numSavedSamples;
+    
+    /**
+     * \brief Number of upcoming input samples that a streaming decimation has to skip before its next result.
+     *
+     * Only non-zero when the decimation rate is larger than the number of taps.
+     */
+    int numSkipSamples;
+    
+    /**
+     * \brief The taps split into polyphase sub-filters for an interpolation rate of \ref polyphaseRate.
+     *
+     * Laid out the same way as RealFirFilter's polyphase taps: sub-filter p holds taps p, p + rate, p + 2*rate,
+     * etc. in reverse order, zero padded at the front to \ref polyphaseLen taps.
+     */
+    std::vector<TapType> polyphaseTaps;
+    
+    /**
+     * \brief The taps' \ref generation when \ref polyphaseTaps was built.  Used to detect tap changes.
+     */
+    unsigned long long polyphaseGeneration;
+    
+    /**
+     * \brief The interpolation rate that \ref polyphaseTaps was built for.  0 if it hasn't been built.
+     */
+    int polyphaseRate;
+    
+    /**
+     * \brief Number of taps in each polyphase sub-filter.
+     */
+    int polyphaseLen;
+    
+    /**
+     * \brief Rebuilds \ref polyphaseTaps if the taps or the interpolation rate have changed.
+     *
+     * \param rate The interpolation rate.  1 for filtering without interpolation.
+     */
+    void updatePolyphaseTaps(int rate);
+    
+    /**
+     * \brief Scales an accumulated result down to the data type.  See \ref outputShift, \ref rounding, and
+     *      \ref saturation.
+     */
+    T scaleResult(AccumType acc) const;
+    
+    /**
+     * \brief Scales an accumulated complex result down to the data type.
+     */
+    std::complex<T> scaleResult(const std::complex<AccumType> & acc) const {
+        return std::complex<T>(scaleResult(acc.real()), scaleResult(acc.imag()));
+    }
+    
+    /**
+     * \brief Calculates one filter output from "data" and one polyphase sub-filter.
+     *
+     * \param data The \ref polyphaseLen samples that the sub-filter overlaps, oldest first.
+     * \param subFilter The sub-filter's taps.
+     */
+    template <class U>
+    U filterPoint(const U *data, const TapType *subFilter) const {
+        return scaleResult(dotProductWide<AccumType>(data, subFilter, polyphaseLen));
+    }
+    
+    /**
+     * \brief Does the work of the conv and decimate methods.  "U" is T for real data and std::complex<T> for
+     *      complex data.  conv is decimation by 1.
+     *
+     * "input" is copied into "dataTmp" before any results are written, so "input" and "output" may be the same buffer.
+     *
+     * \param dataTmp Working buffer.  Holds the saved samples followed by the input while filtering.
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.
+     * \param outputCapacity Number of samples that "output" can hold.
+     * \param rate Indicates how much to downsample.
+     * \return The number of samples written to "output".
+     */
+    template <class U>
+    unsigned decimateData(std::vector<U, Allocator<U> > & dataTmp, const U *input, unsigned inputLen, U *output,
+                          unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Does the work of the interp methods.  See \ref decimateData.
+     */
+    template <class U>
+    unsigned interpData(std::vector<U, Allocator<U> > & dataTmp, const U *input, unsigned inputLen, U *output,
+                        unsigned outputCapacity, int rate);
+    
+ public:
+    /**
+     * \brief Determines how the filter should filter.  See RealFirFilter::filtOperation.
+     *
+     * A stream should stick to one of conv, decimate, or interp (and one rate) from call to call.
+     */
+    FilterOperationType filtOperation;
+    
+    /**
+     * \brief Number of bits that each accumulated result is shifted right by to get back to the data type.
+     *
+     * For Q15 data and Q15 taps this is 15.  Defaults to 0.
+     */
+    unsigned outputShift;
+    
+    /**
+     * \brief Set to true to round results to the nearest integer when \ref outputShift drops bits, or false to
+     *      truncate (round towards minus infinity).  Defaults to true.
+     */
+    bool rounding;
+    
+    /**
+     * \brief Set to true to clamp results that don't fit in the data type to its minimum or maximum, or false to
+     *      let them wrap.  Defaults to true.
+     */
+    bool saturation;
+
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Basic constructor.
+     *
+     * \param size Number of taps.
+     * \param shift Number of bits to shift the results right by.  See \ref outputShift.
+     * \param operation Determines how the filter filters.  See \ref filtOperation.
+     * \param scratch Pointer to a scratch buffer for the taps.  See RealFixedPtVector's basic constructor.
+     */
+    FixedPtFirFilter<T, TapType, AccumType, Allocator>(unsigned size = DEFAULT_BUF_LEN, unsigned shift = 0,
+            FilterOperationType operation = STREAMING, std::vector<TapType, Allocator<TapType> > *scratch = NULL) :
+            RealFixedPtVector<TapType, Allocator>(size, scratch)
+            {filtOperation = operation; outputShift = shift; rounding = true; saturation = true; polyphaseRate = 0; polyphaseGeneration = 0; reset();}
+    
+    /**
+     * \brief Vector constructor.
+     *
+     * \param data The filter taps.
+     * \param shift Number of bits to shift the results right by.  See \ref outputShift.
+     * \param operation Determines how the filter filters.  See \ref filtOperation.
+     * \param scratch Pointer to a scratch buffer for the taps.  See RealFixedPtVector's basic constructor.
+     */
+    template <typename U>
+    FixedPtFirFilter<T, TapType, AccumType, Allocator>(const std::vector<U> & data, unsigned shift = 0,
+            FilterOperationType operation = STREAMING, std::vector<TapType, Allocator<TapType> > *scratch = NULL) :
+            RealFixedPtVector<TapType, Allocator>(data, scratch)
+            {filtOperation = operation; outputShift = shift; rounding = true; saturation = true; polyphaseRate = 0; polyphaseGeneration = 0; reset();}
+    
+    /**
+     * \brief Array constructor.
+     *
+     * \param data The filter taps.
+     * \param dataLen Number of taps in "data".
+     * \param shift Number of bits to shift the results right by.  See \ref outputShift.
+     * \param operation Determines how the filter filters.  See \ref filtOperation.
+     * \param scratch Pointer to a scratch buffer for the taps.  See RealFixedPtVector's basic constructor.
+     */
+    template <typename U>
+    FixedPtFirFilter<T, TapType, AccumType, Allocator>(U *data, unsigned dataLen, unsigned shift = 0,
+            FilterOperationType operation = STREAMING, std::vector<TapType, Allocator<TapType> > *scratch = NULL) :
+            RealFixedPtVector<TapType, Allocator>(data, dataLen, scratch)
+            {filtOperation = operation; outputShift = shift; rounding = true; saturation = true; polyphaseRate = 0; polyphaseGeneration = 0; reset();}
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Clears the streaming state, as if no data had been filtered yet.
+     *
+     * Call it after changing the number of taps.
+     */
+    void reset();
+    
+    /**
+     * \brief Sets the taps to floating point "taps" scaled by 2^fractionalBits, and sets \ref outputShift to
+     *      "fractionalBits" so that the results have the same scaling as the input.
+     *
+     * Taps are rounded to the nearest integer and clamped to the range of TapType.  Also calls \ref reset.
+     * \param taps The floating point taps.
+     * \param fractionalBits Number of fractional bits in the fixed point taps, e.g. 15 for Q15 int16_t taps.
+     */
+    template <typename U>
+    void quantizeTaps(const std::vector<U> & taps, unsigned fractionalBits);
+    
+    /**
+     * \brief Convolution method.
+     *
+     * \param data The buffer that will be filtered.
+     * \return Reference to "data", which holds the result of the convolution.
+     */
+    RealFixedPtVector<T, Allocator> & conv(RealFixedPtVector<T, Allocator> & data);
+    
+    /**
+     * \brief Decimate method.
+     *
+     * Equivalent to filtering with the \ref conv method and keeping every rate'th result, but much more efficient.
+     *
+     * \param data The buffer that will be filtered.
+     * \param rate Indicates how much to downsample.
+     * \return Reference to "data", which holds the result of the decimation.
+     */
+    RealFixedPtVector<T, Allocator> & decimate(RealFixedPtVector<T, Allocator> & data, int rate);
+    
+    /**
+     * \brief Interpolation method.
+     *
+     * Equivalent to upsampling "data" by "rate" and filtering with the \ref conv method, but much more efficient.
+     *
+     * \param data The buffer that will be filtered.
+     * \param rate Indicates how much to upsample.
+     * \return Reference to "data", which holds the result of the interpolation.
+     */
+    RealFixedPtVector<T, Allocator> & interp(RealFixedPtVector<T, Allocator> & data, int rate);
+    
+    /**
+     * \brief Convolution method for raw buffers.
+     *
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.  It may be the same buffer as "input".
+     * \param outputCapacity Number of samples that "output" can hold.  See \ref convOutputLength.
+     * \return The number of samples written to "output".
+     */
+    unsigned conv(const T *input, unsigned inputLen, T *output, unsigned outputCapacity);
+    
+    /**
+     * \brief Convolution method for raw buffers of complex (e.g. IQ) data.  See the real version.
+     */
+    unsigned conv(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output, unsigned outputCapacity);
+    
+    /**
+     * \brief Decimate method for raw buffers.
+     *
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.  It may be the same buffer as "input".
+     * \param outputCapacity Number of samples that "output" can hold.  See \ref decimateOutputLength.
+     * \param rate Indicates how much to downsample.
+     * \return The number of samples written to "output".
+     */
+    unsigned decimate(const T *input, unsigned inputLen, T *output, unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Decimate method for raw buffers of complex (e.g. IQ) data.  See the real version.
+     */
+    unsigned decimate(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                      unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Interpolation method for raw buffers.
+     *
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.  It may start at the same address as "input".
+     * \param outputCapacity Number of samples that "output" can hold.  See \ref interpOutputLength.
+     * \param rate Indicates how much to upsample.
+     * \return The number of samples written to "output".
+     */
+    unsigned interp(const T *input, unsigned inputLen, T *output, unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Interpolation method for raw buffers of complex (e.g. IQ) data.  See the real version.
+     */
+    unsigned interp(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                    unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Returns the number of results that \ref conv will produce for "inputLen" input samples.
+     */
+    unsigned convOutputLength(unsigned inputLen) const {return decimateOutputLength(inputLen, 1);}
+    
+    /**
+     * \brief Returns the number of results that \ref decimate will produce for "inputLen" input samples, given the
+     *      current filter state.
+     */
+    unsigned decimateOutputLength(unsigned inputLen, int rate) const;
+    
+    /**
+     * \brief Returns the number of results that \ref interp will produce for "inputLen" input samples.
+     */
+    unsigned interpOutputLength(unsigned inputLen, int rate) const;
+};
+
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+void FixedPtFirFilter<T, TapType, AccumType, Allocator>::reset() {
+    numSavedSamples = (this->size() > 0) ? this->size() - 1 : 0;
+    numSkipSamples = 0;
+    savedData.assign(numSavedSamples * sizeof(std::complex<T>), 0);
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+template <typename U>
+void FixedPtFirFilter<T, TapType, AccumType, Allocator>::quantizeTaps(const std::vector<U> & taps, unsigned fractionalBits) {
+    double scale = ldexp(1.0, fractionalBits);
+    double minTap = (double) std::numeric_limits<TapType>::min();
+    double maxTap = (double) std::numeric_limits<TapType>::max();
+    
+    this->resize(taps.size());
+    this->modified();
+    for (unsigned i=0; i<taps.size(); i++) {
+        double tap = floor(taps[i] * scale + 0.5);
+        this->vec[i] = (TapType) std::min(std::max(tap, minTap), maxTap);
+    }
+    outputShift = fractionalBits;
+    reset();
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+void FixedPtFirFilter<T, TapType, AccumType, Allocator>::updatePolyphaseTaps(int rate) {
+    assert(rate > 0);
+    if (rate == polyphaseRate && polyphaseGeneration == this->generation)
+        return;
+    
+    polyphaseRate = rate;
+    polyphaseGeneration = this->generation;
+    polyphaseLen = (this->size() + rate - 1) / rate;
+    polyphaseTaps.assign(rate * polyphaseLen, 0);
+    for (int subFilter=0; subFilter<rate; subFilter++) {
+        TapType *subFilterTaps = VECTOR_TO_ARRAY(polyphaseTaps) + subFilter * polyphaseLen;
+        for (int tap=0; subFilter + tap*rate < (int) this->size(); tap++) {
+            subFilterTaps[polyphaseLen - 1 - tap] = this->vec[subFilter + tap*rate];
+        }
+    }
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+T FixedPtFirFilter<T, TapType, AccumType, Allocator>::scaleResult(AccumType acc) const {
+    if (outputShift > 0) {
+        if (rounding)
+            acc += (AccumType) 1 << (outputShift - 1);
+        acc >>= outputShift;
+    }
+    if (saturation) {
+        if (acc > (AccumType) std::numeric_limits<T>::max())
+            return std::numeric_limits<T>::max();
+        if (acc < (AccumType) std::numeric_limits<T>::min())
+            return std::numeric_limits<T>::min();
+    }
+    return (T) acc;
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+unsigned FixedPtFirFilter<T, TapType, AccumType, Allocator>::decimateOutputLength(unsigned inputLen, int rate) const {
+    switch (filtOperation) {
+    case STREAMING: {
+        int available = numSavedSamples + (int) inputLen - numSkipSamples - (int) this->size();
+        if (available < 0)
+            return 0;
+        return available / rate + 1;
+        }
+    case ONE_SHOT_RETURN_ALL_RESULTS:
+        return ((inputLen + this->size() - 1) + (rate - 1)) / rate;
+    default:
+        return (inputLen + rate - 1) / rate;
+    }
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+unsigned FixedPtFirFilter<T, TapType, AccumType, Allocator>::interpOutputLength(unsigned inputLen, int rate) const {
+    if (filtOperation == ONE_SHOT_RETURN_ALL_RESULTS)
+        return inputLen * rate + this->size() - 1 - (rate - 1);
+    return inputLen * rate;
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+template <class U>
+unsigned FixedPtFirFilter<T, TapType, AccumType, Allocator>::decimateData(std::vector<U, Allocator<U> > & dataTmp,
+        const U *input, unsigned inputLen, U *output, unsigned outputCapacity, int rate) {
+    int numTaps = this->size();
+    unsigned outputLen = decimateOutputLength(inputLen, rate);
+    
+    assert(numTaps > 0);
+    assert(outputCapacity >= outputLen);
+    updatePolyphaseTaps(1);
+    const TapType *taps = VECTOR_TO_ARRAY(polyphaseTaps);
+
+    switch (filtOperation) {
+
+    case STREAMING: {
+        U *savedDataArray = (U *) savedData.data();
+        dataTmp.resize(numSavedSamples + inputLen);
+        std::copy(savedDataArray, savedDataArray + numSavedSamples, dataTmp.begin());
+        std::copy(input, input + inputLen, dataTmp.begin() + numSavedSamples);
+        
+        const U *data = VECTOR_TO_ARRAY(dataTmp) + numSkipSamples;
+        for (unsigned resultIndex=0; resultIndex<outputLen; resultIndex++) {
+            output[resultIndex] = filterPoint(data + resultIndex*rate, taps);
+        }
+        
+        int nextResultDataPoint = numSkipSamples + outputLen * rate;
+        if (nextResultDataPoint >= (int) dataTmp.size()) {
+            numSkipSamples = nextResultDataPoint - (int) dataTmp.size();
+            numSavedSamples = 0;
+        }
+        else {
+            numSkipSamples = 0;
+            numSavedSamples = (int) dataTmp.size() - nextResultDataPoint;
+            std::copy(dataTmp.begin() + nextResultDataPoint, dataTmp.end(), savedDataArray);
+        }
+        }
+        break;
+
+    default: {
+        // Zero pad both ends so that every point of the full convolution lines up with a full set of samples.
+        int offset = (filtOperation == ONE_SHOT_TRIM_TAILS) ? (numTaps - 1) / 2 : 0;
+        dataTmp.assign(numTaps - 1, 0);
+        dataTmp.insert(dataTmp.end(), input, input + inputLen);
+        dataTmp.insert(dataTmp.end(), numTaps - 1, 0);
+        for (unsigned resultIndex=0; resultIndex<outputLen; resultIndex++) {
+            output[resultIndex] = filterPoint(VECTOR_TO_ARRAY(dataTmp) + resultIndex*rate + offset, taps);
+        }
+        }
+        break;
+    }
+    return outputLen;
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+template <class U>
+unsigned FixedPtFirFilter<T, TapType, AccumType, Allocator>::interpData(std::vector<U, Allocator<U> > & dataTmp,
+        const U *input, unsigned inputLen, U *output, unsigned outputCapacity, int rate) {
+    unsigned outputLen = interpOutputLength(inputLen, rate);
+    
+    assert(this->size() > 0);
+    assert(outputCapacity >= outputLen);
+    updatePolyphaseTaps(rate);
+
+    switch (filtOperation) {
+
+    case STREAMING: {
+        U *savedDataArray = (U *) savedData.data();
+        if (numSavedSamples > polyphaseLen - 1) {
+            // First call to interp.  Only the newest polyphaseLen - 1 of the initial zeros are needed.
+            std::copy(savedDataArray + numSavedSamples - (polyphaseLen - 1), savedDataArray + numSavedSamples,
+                      savedDataArray);
+            numSavedSamples = polyphaseLen - 1;
+        }
+        
+        dataTmp.resize(numSavedSamples + inputLen);
+        std::copy(savedDataArray, savedDataArray + numSavedSamples, dataTmp.begin());
+        std::copy(input, input + inputLen, dataTmp.begin() + numSavedSamples);
+        
+        for (unsigned i=0; i<inputLen; i++) {
+            for (int subFilter=0; subFilter<rate; subFilter++) {
+                output[i*rate + subFilter] = filterPoint(VECTOR_TO_ARRAY(dataTmp) + i,
+                        VECTOR_TO_ARRAY(polyphaseTaps) + subFilter * polyphaseLen);
+            }
+        }
+        std::copy(dataTmp.end() - numSavedSamples, dataTmp.end(), savedDataArray);
+        }
+        break;
+
+    default: {
+        // Result j of the full convolution is sub-filter j % rate applied to the samples ending at input j / rate.
+        int offset = (filtOperation == ONE_SHOT_TRIM_TAILS) ? (this->size() - 1) / 2 : 0;
+        dataTmp.assign(polyphaseLen - 1, 0);
+        dataTmp.insert(dataTmp.end(), input, input + inputLen);
+        dataTmp.insert(dataTmp.end(), polyphaseLen, 0);
+        for (unsigned resultIndex=0; resultIndex<outputLen; resultIndex++) {
+            int convIndex = resultIndex + offset;
+            output[resultIndex] = filterPoint(VECTOR_TO_ARRAY(dataTmp) + convIndex / rate,
+                    VECTOR_TO_ARRAY(polyphaseTaps) + (convIndex % rate) * polyphaseLen);
+        }
+        }
+        break;
+    }
+    return outputLen;
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> & FixedPtFirFilter<T, TapType, AccumType, Allocator>::conv(RealFixedPtVector<T, Allocator> & data) {
+    return decimate(data, 1);
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> & FixedPtFirFilter<T, TapType, AccumType, Allocator>::decimate(RealFixedPtVector<T, Allocator> & data, int rate) {
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(data.scratchBuf, data.size() + 2*this->size());
+    unsigned inputLen = data.size();
+    
+    // The input is copied into dataTmp before any results are written, so the filtering can be done in place.
+    data.resize(std::max(inputLen, decimateOutputLength(inputLen, rate)));
+    data.resize(decimateData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size(), rate));
+    return data;
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> & FixedPtFirFilter<T, TapType, AccumType, Allocator>::interp(RealFixedPtVector<T, Allocator> & data, int rate) {
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(data.scratchBuf, data.size() + 2*this->size());
+    unsigned inputLen = data.size();
+    
+    data.resize(std::max(inputLen, interpOutputLength(inputLen, rate)));
+    data.resize(interpData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size(), rate));
+    return data;
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+unsigned FixedPtFirFilter<T, TapType, AccumType, Allocator>::conv(const T *input, unsigned inputLen, T *output,
+                                                                  unsigned outputCapacity) {
+    return decimate(input, inputLen, output, outputCapacity, 1);
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+unsigned FixedPtFirFilter<T, TapType, AccumType, Allocator>::conv(const std::complex<T> *input, unsigned inputLen,
+                                                                  std::complex<T> *output, unsigned outputCapacity) {
+    return decimate(input, inputLen, output, outputCapacity, 1);
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+unsigned FixedPtFirFilter<T, TapType, AccumType, Allocator>::decimate(const T *input, unsigned inputLen, T *output,
+                                                                      unsigned outputCapacity, int rate) {
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(NULL, inputLen + 2*this->size());
+    return decimateData(*dataTmp, input, inputLen, output, outputCapacity, rate);
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+unsigned FixedPtFirFilter<T, TapType, AccumType, Allocator>::decimate(const std::complex<T> *input, unsigned inputLen,
+        std::complex<T> *output, unsigned outputCapacity, int rate) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(NULL, inputLen + 2*this->size());
+    return decimateData(*dataTmp, input, inputLen, output, outputCapacity, rate);
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+unsigned FixedPtFirFilter<T, TapType, AccumType, Allocator>::interp(const T *input, unsigned inputLen, T *output,
+                                                                    unsigned outputCapacity, int rate) {
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(NULL, inputLen + 2*this->size());
+    return interpData(*dataTmp, input, inputLen, output, outputCapacity, rate);
+}
+
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+unsigned FixedPtFirFilter<T, TapType, AccumType, Allocator>::interp(const std::complex<T> *input, unsigned inputLen,
+        std::complex<T> *output, unsigned outputCapacity, int rate) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(NULL, inputLen + 2*this->size());
+    return interpData(*dataTmp, input, inputLen, output, outputCapacity, rate);
+}
+
+/**
+ * \brief Convolution function.  See FixedPtFirFilter::conv.
+ */
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+inline RealFixedPtVector<T, Allocator> & conv(RealFixedPtVector<T, Allocator> & data,
+                                              FixedPtFirFilter<T, TapType, AccumType, Allocator> & filter) {
+    return filter.conv(data);
+}
+
+/**
+ * \brief Decimate function.  See FixedPtFirFilter::decimate.
+ */
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+inline RealFixedPtVector<T, Allocator> & decimate(RealFixedPtVector<T, Allocator> & data, int rate,
+                                                  FixedPtFirFilter<T, TapType, AccumType, Allocator> & filter) {
+    return filter.decimate(data, rate);
+}
+
+/**
+ * \brief Interpolation function.  See FixedPtFirFilter::interp.
+ */
+template <class T, class TapType, class AccumType, template <class> class Allocator>
+inline RealFixedPtVector<T, Allocator> & interp(RealFixedPtVector<T, Allocator> & data, int rate,
+                                                FixedPtFirFilter<T, TapType, AccumType, Allocator> & filter) {
+    return filter.interp(data, rate);
+}
+
+};
+
+#endif
@@ -0,0 +1,150 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file FmDemodulator.h
+ *
+ * Definition of the template class FmDemodulator.
+ */
+
+
+#ifndef NimbleDSP_FmDemodulator_h
+#define NimbleDSP_FmDemodulator_h
+
+#include <vector>
+#include <complex>
+#include <math.h>
+#include "RealVector.h"
+#include "ComplexVector.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Streaming frequency discriminator.
+ *
+ * Each output sample is the phase difference between consecutive input samples, found as the angle of
+ * input[i]*conj(input[i - 1]), and scaled so that it undoes FmModulator with the same parameters.  The angle of
+ * the product is already in (-pi, pi], so no unwrapping pass is needed, and the whole calculation is a single
+ * pass over the data.  The last input sample is carried over to the next block.
+ */
+template <class T>
+class FmDemodulator {
+ protected:
+    /**
+     * \brief The last input sample of the previous block.
+     */
+    std::complex<T> lastSample;
+    
+    /**
+     * \brief Converts a phase difference in radians to output units, i.e. sampleFreq/(2*pi*maxDeviation).
+     */
+    T gain;
+    
+ public:
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Constructor.
+     *
+     * \param maxDeviation The frequency deviation that produces an output of 1.
+     * \param sampleFreq The sample frequency.  Defaults to 1 Hz.
+     */
+    FmDemodulator<T>(T maxDeviation, T sampleFreq = 1.0) {
+        assert(maxDeviation != 0);
+        gain = (T) (sampleFreq / (2 * M_PI * maxDeviation));
+        reset();
+    }
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Demodulates "input" and puts the results in "output".
+     *
+     * \param input The frequency modulated signal.
+     * \param len Number of samples in "input".
+     * \param output Buffer for the "len" results.
+     * \return The number of samples written to "output".
+     */
+    unsigned demodulate(const std::complex<T> *input, unsigned len, T *output);
+    
+    /**
+     * \brief Demodulates "input" and puts the results in "output".
+     *
+     * \param input The frequency modulated signal.
+     * \param output Resized to input.size() and set to the demodulated signal.
+     * \return Reference to "output".
+     */
+    template <template <class> class Allocator>
+    RealVector<T, Allocator> & demodulate(const ComplexVector<T, Allocator> & input, RealVector<T, Allocator> & output);
+    
+    /**
+     * \brief Sets the previous sample to 1, i.e. a phase of 0, which is where FmModulator starts by default.
+     */
+    void reset() {lastSample = std::complex<T>(1, 0);}
+};
+
+
+template <class T>
+unsigned FmDemodulator<T>::demodulate(const std::complex<T> *input, unsigned len, T *output) {
+    // The conjugate multiply is written out because std::complex's operator* checks for infinities and NaNs.
+    T lastReal = lastSample.real(), lastImag = lastSample.imag();
+    for (unsigned i=0; i<len; i++) {
+        T real = input[i].real(), imag = input[i].imag();
+        output[i] = gain * std::atan2(imag * lastReal - real * lastImag, real * lastReal + imag * lastImag);
+        lastReal = real;
+        lastImag = imag;
+    }
+    lastSample = std::complex<T>(lastReal, lastImag);
+    return len;
+}
+
+template <class T>
+template <template <class> class Allocator>
+RealVector<T, Allocator> & FmDemodulator<T>::demodulate(const ComplexVector<T, Allocator> & input,
+                                                       RealVector<T, Allocator> & output) {
+    output.resize(input.size());
+    if (input.size() > 0)
+        demodulate(VECTOR_TO_ARRAY(input.vec), input.size(), VECTOR_TO_ARRAY(output.vec));
+    return output;
+}
+
+/**
+ * \brief Demodulates "input" and puts the results in "output".
+ *
+ * \param input The frequency modulated signal.
+ * \param output Resized to input.size() and set to the demodulated signal.
+ * \param demodulator The demodulator.
+ * \return Reference to "output".
+ */
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & demodulate(const ComplexVector<T, Allocator> & input, RealVector<T, Allocator> & output,
+                                      FmDemodulator<T> & demodulator) {
+    return demodulator.demodulate(input, output);
+}
+
+};
+
+#endif
@@ -0,0 +1,162 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file FmModulator.h
+ *
+ * Definition of the template class FmModulator.
+ */
+
+
+#ifndef NimbleDSP_FmModulator_h
+#define NimbleDSP_FmModulator_h
+
+#include <vector>
+#include <complex>
+#include <math.h>
+#include <stdint.h>
+#include "RealVector.h"
+#include "ComplexVector.h"
+#include "Nco.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Streaming frequency modulator.
+ *
+ * Turns each real input sample into a phase increment, accumulates it and generates exp(j*phase) in a single pass
+ * over the data.  The phase is kept in a 32-bit accumulator, like Nco, so it wraps exactly, and it carries over
+ * from one block to the next so the modulated signal is continuous.
+ */
+template <class T>
+class FmModulator {
+ protected:
+    /**
+     * \brief The current phase.  2^32 is a full cycle.
+     */
+    uint32_t phaseAccumulator;
+    
+    /**
+     * \brief Phase accumulator units per unit of input, i.e. maxDeviation/sampleFreq*2^32.
+     */
+    double accumulatorScale;
+    
+ public:
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Constructor.
+     *
+     * \param maxDeviation The frequency deviation for an input of 1.  Inputs times maxDeviation must stay
+     *      below sampleFreq/2 in magnitude.
+     * \param sampleFreq The sample frequency.  Defaults to 1 Hz.
+     * \param phase The starting phase, in radians.  Defaults to 0.
+     */
+    FmModulator<T>(T maxDeviation, T sampleFreq = 1.0, T phase = 0.0) {
+        assert(sampleFreq > 0);
+        accumulatorScale = (double) maxDeviation / sampleFreq * 4294967296.0;
+        setPhase(phase);
+    }
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Sets the phase of the next output sample, before that sample's phase increment, in radians.
+     */
+    void setPhase(T phase) {
+        double cycles = phase / (2 * M_PI);
+        phaseAccumulator = (uint32_t) (uint64_t) floor((cycles - floor(cycles)) * 4294967296.0 + 0.5);
+    }
+    
+    /**
+     * \brief Returns the current phase, in radians, in the range [0, 2*pi).
+     */
+    T getPhase() const {return (T) (phaseAccumulator * (2 * M_PI / 4294967296.0));}
+    
+    /**
+     * \brief Frequency modulates "input" and puts the results in "output".
+     *
+     * Output sample "i" is exp(j*phase), where phase is the previous phase plus 2*pi*maxDeviation/sampleFreq*input[i].
+     * \param input The modulating signal.
+     * \param len Number of samples in "input".
+     * \param output Buffer for the "len" results.
+     * \return The number of samples written to "output".
+     */
+    template <class U>
+    unsigned modulate(const U *input, unsigned len, std::complex<T> *output);
+    
+    /**
+     * \brief Frequency modulates "input" and puts the results in "output".
+     *
+     * \param input The modulating signal.
+     * \param output Resized to input.size() and set to the modulated signal.
+     * \return Reference to "output".
+     */
+    template <template <class> class Allocator>
+    ComplexVector<T, Allocator> & modulate(const RealVector<T, Allocator> & input, ComplexVector<T, Allocator> & output);
+};
+
+
+template <class T>
+template <class U>
+unsigned FmModulator<T>::modulate(const U *input, unsigned len, std::complex<T> *output) {
+    uint32_t phase = phaseAccumulator;
+    T scale = (T) accumulatorScale;
+    for (unsigned i=0; i<len; i++) {
+        phase += (uint32_t) (int32_t) (input[i] * scale);
+        output[i] = Nco<T>::polynomialExp(phase);
+    }
+    phaseAccumulator = phase;
+    return len;
+}
+
+template <class T>
+template <template <class> class Allocator>
+ComplexVector<T, Allocator> & FmModulator<T>::modulate(const RealVector<T, Allocator> & input,
+                                                      ComplexVector<T, Allocator> & output) {
+    output.resize(input.size());
+    if (input.size() > 0)
+        modulate(VECTOR_TO_ARRAY(input.vec), input.size(), VECTOR_TO_ARRAY(output.vec));
+    return output;
+}
+
+/**
+ * \brief Frequency modulates "input" and puts the results in "output".
+ *
+ * \param input The modulating signal.
+ * \param output Resized to input.size() and set to the modulated signal.
+ * \param modulator The modulator.
+ * \return Reference to "output".
+ */
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & modulate(const RealVector<T, Allocator> & input, ComplexVector<T, Allocator> & output,
+                                       FmModulator<T> & modulator) {
+    return modulator.modulate(input, output);
+}
+
+};
+
+#endif
@@ -0,0 +1,259 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file Goertzel.h
+ *
+ * Definition of the template class Goertzel.
+ */
+
+
+#ifndef NimbleDSP_Goertzel_h
+#define NimbleDSP_Goertzel_h
+
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <math.h>
+#include "Vector.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Streaming Goertzel detector that calculates a handful of DFT bins of consecutive blocks of real data.
+ *
+ * Each bin costs one multiply and two adds per sample, so when only a few bins are needed this is much cheaper
+ * than an FFT of every block.  Like the FIR filters' STREAMING mode, the per-bin state is kept between calls, so
+ * the data can be passed in chunks of any size and the blocks don't have to line up with the chunks.  T should
+ * be a floating point type.
+ */
+template <class T>
+class Goertzel {
+ protected:
+    /**
+     * \brief 2*cos(w) for each bin, where w is the bin's frequency in radians per sample.
+     */
+    std::vector<T> coeffs;
+    
+    /**
+     * \brief exp(-j*w) for each bin.
+     */
+    std::vector< std::complex<T> > rotations;
+    
+    /**
+     * \brief exp(-j*w*(blockLen - 1)) for each bin.  Corrects the phase of the final result so that it matches the DFT.
+     */
+    std::vector< std::complex<T> > outputRotations;
+    
+    /**
+     * \brief Two state variables per bin.
+     */
+    std::vector<T> state;
+    
+    /**
+     * \brief Number of samples of the current block that have been processed.
+     */
+    unsigned blockIndex;
+    
+ public:
+    /**
+     * \brief The DFT bins to calculate.  Bin "k" is at k/blockLen cycles per sample.  They don't have to be integers.
+     */
+    std::vector<double> bins;
+    
+    /**
+     * \brief Number of samples in each block.
+     */
+    unsigned blockLen;
+    
+    /**
+     * \brief The DFT bins of the last completed block, in the same order as \ref bins.  Zero until a block has
+     *      been completed.
+     */
+    std::vector< std::complex<T> > spectrum;
+    
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Constructor.
+     *
+     * \param blockLen Number of samples in each block, i.e. the size of the DFT.
+     * \param bins The DFT bins to calculate.
+     */
+    Goertzel<T>(unsigned blockLen, const std::vector<double> & bins);
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns the number of bins.
+     */
+    unsigned numBins() const {return (unsigned) bins.size();}
+    
+    /**
+     * \brief Processes "len" samples of "input".
+     *
+     * \param input The data to process.
+     * \param len Number of samples in "input".
+     * \param output Optional buffer for the \ref spectrum of every block completed by this call.  The spectrum of the
+     *      "n"th completed block is at output[n*numBins()].  It must hold numBins() times the number of blocks
+     *      completed, which is at most (len + blockLen - 1)/blockLen.
+     * \return The number of blocks completed by this call.
+     */
+    template <class U>
+    unsigned process(const U *input, unsigned len, std::complex<T> *output = NULL);
+    
+    /**
+     * \brief Processes the samples in "data".
+     *
+     * \param data The data to process.
+     * \return The number of blocks completed by this call.  \ref spectrum holds the results of the last one.
+     */
+    template <class U, template <class> class UAllocator>
+    unsigned process(const Vector<U, UAllocator> & data);
+    
+    /**
+     * \brief Returns the power, i.e. the squared magnitude, of each bin of \ref spectrum.
+     */
+    std::vector<T> power() const;
+    
+    /**
+     * \brief Discards the partially processed block and sets \ref spectrum to zero.
+     */
+    void reset();
+};
+
+
+template <class T>
+Goertzel<T>::Goertzel(unsigned blockLen, const std::vector<double> & bins) : bins(bins), blockLen(blockLen) {
+    assert(blockLen > 0);
+    
+    coeffs.resize(bins.size());
+    rotations.resize(bins.size());
+    outputRotations.resize(bins.size());
+    for (unsigned bin=0; bin<bins.size(); bin++) {
+        double w = 2 * M_PI * bins[bin] / blockLen;
+        coeffs[bin] = (T) (2 * cos(w));
+        rotations[bin] = std::complex<T>((T) cos(w), (T) -sin(w));
+        outputRotations[bin] = std::complex<T>((T) cos(w * (blockLen - 1)), (T) -sin(w * (blockLen - 1)));
+    }
+    reset();
+}
+
+template <class T>
+template <class U>
+unsigned Goertzel<T>::process(const U *input, unsigned len, std::complex<T> *output) {
+    unsigned numBlocks = 0;
+    
+    while (len > 0) {
+        unsigned chunkLen = std::min(len, blockLen - blockIndex);
+        
+        // Run the whole chunk through four bins at a time so that their state stays in registers.  Each bin's
+        // recursion is a serial dependency chain, so interleaving independent bins keeps the pipeline full.
+        unsigned bin = 0;
+        for (; bin + 4 <= bins.size(); bin += 4) {
+            T coeff0 = coeffs[bin], coeff1 = coeffs[bin + 1], coeff2 = coeffs[bin + 2], coeff3 = coeffs[bin + 3];
+            T s10 = state[2*bin], s11 = state[2*bin + 2], s12 = state[2*bin + 4], s13 = state[2*bin + 6];
+            T s20 = state[2*bin + 1], s21 = state[2*bin + 3], s22 = state[2*bin + 5], s23 = state[2*bin + 7];
+            for (unsigned i=0; i<chunkLen; i++) {
+                T x = (T) input[i];
+                T s00 = x + coeff0 * s10 - s20;
+                T s01 = x + coeff1 * s11 - s21;
+                T s02 = x + coeff2 * s12 - s22;
+                T s03 = x + coeff3 * s13 - s23;
+                s20 = s10; s21 = s11; s22 = s12; s23 = s13;
+                s10 = s00; s11 = s01; s12 = s02; s13 = s03;
+            }
+            state[2*bin] = s10; state[2*bin + 2] = s11; state[2*bin + 4] = s12; state[2*bin + 6] = s13;
+            state[2*bin + 1] = s20; state[2*bin + 3] = s21; state[2*bin + 5] = s22; state[2*bin + 7] = s23;
+        }
+        for (; bin<bins.size(); bin++) {
+            T coeff = coeffs[bin];
+            T s1 = state[2*bin];
+            T s2 = state[2*bin + 1];
+            for (unsigned i=0; i<chunkLen; i++) {
+                T s0 = (T) input[i] + coeff * s1 - s2;
+                s2 = s1;
+                s1 = s0;
+            }
+            state[2*bin] = s1;
+            state[2*bin + 1] = s2;
+        }
+        input += chunkLen;
+        len -= chunkLen;
+        blockIndex += chunkLen;
+        
+        if (blockIndex == blockLen) {
+            for (unsigned bin=0; bin<bins.size(); bin++) {
+                spectrum[bin] = outputRotations[bin] * (state[2*bin] - rotations[bin] * state[2*bin + 1]);
+            }
+            if (output != NULL) {
+                std::copy(spectrum.begin(), spectrum.end(), output + numBlocks * bins.size());
+            }
+            state.assign(state.size(), 0);
+            blockIndex = 0;
+            ++numBlocks;
+        }
+    }
+    return numBlocks;
+}
+
+template <class T>
+template <class U, template <class> class UAllocator>
+unsigned Goertzel<T>::process(const Vector<U, UAllocator> & data) {
+    return process(VECTOR_TO_ARRAY(data.vec), data.size());
+}
+
+/**
+ * \brief Processes the samples in "data" with "detector".
+ *
+ * \param data The data to process.
+ * \param detector The detector to process it with.
+ * \return The number of blocks completed.  detector.spectrum holds the results of the last one.
+ */
+template <class T, class U, template <class> class UAllocator>
+unsigned process(const Vector<U, UAllocator> & data, Goertzel<T> & detector) {
+    return detector.process(data);
+}
+
+template <class T>
+std::vector<T> Goertzel<T>::power() const {
+    std::vector<T> binPower(spectrum.size());
+    for (unsigned bin=0; bin<spectrum.size(); bin++) {
+        binPower[bin] = std::norm(spectrum[bin]);
+    }
+    return binPower;
+}
+
+template <class T>
+void Goertzel<T>::reset() {
+    state.assign(2 * bins.size(), 0);
+    spectrum.assign(bins.size(), 0);
+    blockIndex = 0;
+}
+
+};
+
+#endif
@@ -0,0 +1,594 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file MirroredRingBuffer.h
+ *
+ * Definition of the MirroredMemory, MirroredSpscRingBuffer and MirroredMpmcRingBuffer classes, ring buffers whose
+ * contents can always be read as one contiguous span.
+ */
+
+#ifndef NimbleDSP_MirroredRingBuffer_h
+#define NimbleDSP_MirroredRingBuffer_h
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <type_traits>
+#include <assert.h>
+#include "VectorView.h"
+#include "SpscRingBuffer.h"
+
+#if !defined(NIMBLEDSP_NO_MIRRORED_MEMORY) && defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifdef SYS_memfd_create
+#define NIMBLEDSP_MIRRORED_MEMORY
+#endif
+#endif
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Storage for a ring buffer where element i + capacity() is the same sample as element i.
+ *
+ * On Linux a memfd is mapped twice, back to back, so the mirror costs nothing: a span that runs off the end of the
+ * buffer simply continues into the second mapping, which is the start of the buffer again.  Elsewhere, or if the
+ * mapping fails, the storage is an ordinary array of twice the capacity and \ref mirror copies each write into the
+ * other half.  Either way a ring buffer built on it can hand out any run of up to capacity() samples as a single
+ * contiguous span, so the filters can work on it directly instead of on a copy.
+ *
+ * Define NIMBLEDSP_NO_MIRRORED_MEMORY to always use the copying fallback.  T has to be trivially copyable, since the
+ * mapped memory is never constructed or destroyed.
+ */
+template <class T>
+class MirroredMemory {
+ protected:
+    /**
+     * \brief Start of the 2 * \ref numSamples elements.
+     */
+    T *samples;
+    
+    /**
+     * \brief The capacity.
+     */
+    unsigned numSamples;
+    
+    /**
+     * \brief True if the memory is mapped twice, false if the copying fallback is in use.
+     */
+    bool doubleMapped;
+    
+    /**
+     * \brief Storage for the copying fallback.
+     */
+    std::vector<T> fallback;
+    
+    /**
+     * \brief Tries to map a memfd of "numSamples" samples twice.  Returns false if the memory couldn't be set up.
+     */
+    bool mapTwice();
+    
+ public:
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Constructor.
+     *
+     * \param minCapacity Minimum number of samples.  It's rounded up to a power of 2, and for double mapping to a
+     *      whole number of pages.
+     * \param allowDoubleMapping Set to false to use the copying fallback even where double mapping is available.
+     */
+    MirroredMemory<T>(unsigned minCapacity, bool allowDoubleMapping = true);
+    
+    ~MirroredMemory();
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns a pointer to the 2 * capacity() elements.
+     */
+    T *data() const {return samples;}
+    
+    /**
+     * \brief Returns the number of distinct samples.
+     */
+    unsigned capacity() const {return numSamples;}
+    
+    /**
+     * \brief Returns true if the memory is really mapped twice.
+     */
+    bool isDoubleMapped() const {return doubleMapped;}
+    
+    /**
+     * \brief Makes samples that were written to elements [start, start + len) visible through the other half too.
+     *
+     * Does nothing when the memory is double mapped.
+     * \param start First element that was written.  Must be less than 2 * capacity().
+     * \param len Number of elements that were written.  start + len must be at most 2 * capacity().
+     */
+    void mirror(unsigned start, unsigned len) {
+        if (doubleMapped || len == 0)
+            return;
+        unsigned end = start + len;
+        unsigned lowEnd = std::min(end, numSamples);
+        if (start < lowEnd) {
+            std::copy(samples + start, samples + lowEnd, samples + start + numSamples);
+        }
+        unsigned highStart = std::max(start, numSamples);
+        if (highStart < end) {
+            std::copy(samples + highStart, samples + end, samples + highStart - numSamples);
+        }
+    }
+    
+ private:
+    MirroredMemory<T>(const MirroredMemory<T> &);
+    MirroredMemory<T> & operator=(const MirroredMemory<T> &);
+};
+
+
+template <class T>
+MirroredMemory<T>::MirroredMemory(unsigned minCapacity, bool allowDoubleMapping) : samples(NULL), doubleMapped(false) {
+    static_assert(std::is_trivially_copyable<T>::value, "MirroredMemory needs a trivially copyable sample type");
+    assert(minCapacity > 0 && minCapacity <= (1u << 30));
+    numSamples = 1;
+    while (numSamples < minCapacity) {
+        numSamples <<= 1;
+    }
+    
+    if (allowDoubleMapping && mapTwice())
+        return;
+    fallback.resize(2 * numSamples);
+    samples = VECTOR_TO_ARRAY(fallback);
+}
+
+template <class T>
+bool MirroredMemory<T>::mapTwice() {
+#ifdef NIMBLEDSP_MIRRORED_MEMORY
+    // Each mapping has to be a whole number of pages.
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pageSize <= 0)
+        return false;
+    unsigned capacity = numSamples;
+    while ((capacity * sizeof(T)) % pageSize != 0) {
+        if (capacity >= (1u << 30))
+            return false;
+        capacity <<= 1;
+    }
+    size_t numBytes = capacity * sizeof(T);
+    
+    int fd = (int) syscall(SYS_memfd_create, "NimbleDSP ring buffer", 0);
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, numBytes) != 0) {
+        close(fd);
+        return false;
+    }
+    
+    // Reserve room for both mappings, then map the memfd over each half of it.
+    char *region = (char *) mmap(NULL, 2 * numBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    bool mapped = (region != MAP_FAILED);
+    for (unsigned half=0; mapped && half<2; half++) {
+        void *address = mmap(region + half * numBytes, numBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        mapped = (address == region + half * numBytes);
+    }
+    close(fd);
+    if (!mapped) {
+        if (region != MAP_FAILED)
+            munmap(region, 2 * numBytes);
+        return false;
+    }
+    
+    samples = (T *) region;
+    numSamples = capacity;
+    doubleMapped = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+template <class T>
+MirroredMemory<T>::~MirroredMemory() {
+#ifdef NIMBLEDSP_MIRRORED_MEMORY
+    if (doubleMapped) {
+        munmap(samples, 2 * (size_t) numSamples * sizeof(T));
+    }
+#endif
+}
+
+/**
+ * \brief A claimed run of samples in a MirroredMpmcRingBuffer.
+ */
+template <class T>
+struct RingBufferClaim {
+    /**
+     * \brief The claimed samples, which are contiguous.  Empty if nothing could be claimed.
+     */
+    VectorView<T> samples;
+    
+    /**
+     * \brief Position of the first sample in the stream.  Used to commit the claim in order.
+     */
+    unsigned position;
+    
+    /**
+     * \brief Constructor.  A view has to be constructed rather than assigned, since assigning copies samples.
+     */
+    RingBufferClaim<T>(T *data, unsigned len, unsigned position) : samples(data, len), position(position) {}
+};
+
+/**
+ * \brief Lock-free single producer, single consumer ring buffer whose readable and writable regions are contiguous.
+ *
+ * Works like SpscRingBuffer, but besides copying samples in and out with \ref write and \ref read, the producer
+ * can fill \ref writeSpan in place and the consumer can process \ref readSpan in place, e.g. with
+ * RealFirFilter::conv(VectorView<T>), without the samples ever being copied to a Vector.  Spans never wrap, because
+ * the storage is a MirroredMemory.
+ */
+template <class T>
+class MirroredSpscRingBuffer {
+ protected:
+    /**
+     * \brief The samples.
+     */
+    MirroredMemory<T> memory;
+    
+    /**
+     * \brief memory.capacity() - 1.
+     */
+    unsigned mask;
+    
+    char padding0[RING_BUFFER_CACHE_LINE_SIZE];
+    
+    /**
+     * \brief Total number of samples written.  Only the producer changes it.
+     */
+    std::atomic<unsigned> writeIndex;
+    
+    char padding1[RING_BUFFER_CACHE_LINE_SIZE];
+    
+    /**
+     * \brief Total number of samples read.  Only the consumer changes it.
+     */
+    std::atomic<unsigned> readIndex;
+    
+    /**
+     * \brief Set by the producer once it won't write any more.
+     */
+    std::atomic<bool> closed;
+    
+ public:
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Constructor.
+     *
+     * \param capacity Minimum number of samples the buffer can hold.  See MirroredMemory for how it's rounded up.
+     * \param allowDoubleMapping Set to false to use the copying fallback.  See MirroredMemory.
+     */
+    MirroredSpscRingBuffer<T>(unsigned capacity, bool allowDoubleMapping = true) : memory(capacity, allowDoubleMapping),
+            writeIndex(0), readIndex(0), closed(false) {
+        mask = memory.capacity() - 1;
+    }
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns the number of samples the buffer can hold.
+     */
+    unsigned capacity() const {return memory.capacity();}
+    
+    /**
+     * \brief Returns the number of samples waiting to be read.
+     */
+    unsigned size() const {return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);}
+    
+    /**
+     * \brief Returns true if the memory is really mapped twice rather than mirrored by copying.
+     */
+    bool isDoubleMapped() const {return memory.isDoubleMapped();}
+    
+    /**
+     * \brief Returns the free space as one contiguous span.  Producer only.
+     *
+     * Fill the start of it and then call \ref commitWrite.
+     */
+    VectorView<T> writeSpan() {
+        unsigned writeStart = writeIndex.load(std::memory_order_relaxed);
+        unsigned numFree = capacity() - (writeStart - readIndex.load(std::memory_order_acquire));
+        return VectorView<T>(memory.data() + (writeStart & mask), numFree);
+    }
+    
+    /**
+     * \brief Passes the first "len" samples of \ref writeSpan on to the consumer.  Producer only.
+     */
+    void commitWrite(unsigned len) {
+        unsigned writeStart = writeIndex.load(std::memory_order_relaxed);
+        memory.mirror(writeStart & mask, len);
+        writeIndex.store(writeStart + len, std::memory_order_release);
+    }
+    
+    /**
+     * \brief Copies up to "len" samples into the buffer.  Producer only.
+     *
+     * \return The number of samples written, which is less than "len" if the buffer fills up.
+     */
+    unsigned write(const T *data, unsigned len) {
+        VectorView<T> span = writeSpan();
+        len = std::min(len, span.len);
+        std::copy(data, data + len, span.data);
+        commitWrite(len);
+        return len;
+    }
+    
+    /**
+     * \brief Returns up to "maxLen" of the samples waiting to be read as one contiguous span.  Consumer only.
+     *
+     * The samples stay in the buffer until \ref consume is called.  They may be changed in place first, e.g. by
+     * filtering them, as long as every changed sample is then consumed.
+     */
+    VectorView<T> readSpan(unsigned maxLen = 0xFFFFFFFF) {
+        unsigned readStart = readIndex.load(std::memory_order_relaxed);
+        unsigned numAvailable = writeIndex.load(std::memory_order_acquire) - readStart;
+        return VectorView<T>(memory.data() + (readStart & mask), std::min(numAvailable, maxLen));
+    }
+    
+    /**
+     * \brief Releases the first "len" samples of \ref readSpan back to the producer.  Consumer only.
+     */
+    void consume(unsigned len) {
+        readIndex.store(readIndex.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    }
+    
+    /**
+     * \brief Copies up to "len" samples out of the buffer.  Consumer only.
+     *
+     * \return The number of samples read, which is less than "len" if the buffer runs out.
+     */
+    unsigned read(T *data, unsigned len) {
+        VectorView<T> span = readSpan(len);
+        std::copy(span.data, span.data + span.len, data);
+        consume(span.len);
+        return span.len;
+    }
+    
+    /**
+     * \brief Marks the end of the stream.  Producer only.
+     */
+    void close() {closed.store(true, std::memory_order_release);}
+    
+    /**
+     * \brief Returns true once the producer has closed the buffer.  See SpscRingBuffer::isClosed.
+     */
+    bool isClosed() const {return closed.load(std::memory_order_acquire);}
+};
+
+/**
+ * \brief Ring buffer with contiguous spans for any number of producers and consumers.
+ *
+ * A producer claims a span of free space with \ref claimWrite, fills it, and commits it with \ref commitWrite.  A
+ * consumer claims a span of samples with \ref claimRead, processes it in place, and commits it with
+ * \ref commitRead.  Claiming is lock-free, so producers fill their spans and consumers process theirs in
+ * parallel.  Commits are published in claim order, so a commit waits for the earlier claims on the same side to be
+ * committed, and a claim that is never committed stalls the buffer.  Each span holds consecutive samples of the
+ * stream, but consecutive spans go to whichever consumer asks first.
+ */
+template <class T>
+class MirroredMpmcRingBuffer {
+ protected:
+    /**
+     * \brief The samples.
+     */
+    MirroredMemory<T> memory;
+    
+    /**
+     * \brief memory.capacity() - 1.
+     */
+    unsigned mask;
+    
+    char padding0[RING_BUFFER_CACHE_LINE_SIZE];
+    
+    /**
+     * \brief Total number of samples claimed by producers.
+     */
+    std::atomic<unsigned> writeClaimIndex;
+    
+    /**
+     * \brief Total number of samples committed by producers.
+     */
+    std::atomic<unsigned> writeIndex;
+    
+    char padding1[RING_BUFFER_CACHE_LINE_SIZE];
+    
+    /**
+     * \brief Total number of samples claimed by consumers.
+     */
+    std::atomic<unsigned> readClaimIndex;
+    
+    /**
+     * \brief Total number of samples committed by consumers.
+     */
+    std::atomic<unsigned> readIndex;
+    
+    /**
+     * \brief Set once the stream has ended.
+     */
+    std::atomic<bool> closed;
+    
+    /**
+     * \brief Waits for "index" to reach "position" and then advances it by "len".
+     */
+    static void commitInOrder(std::atomic<unsigned> & index, unsigned position, unsigned len) {
+        while (index.load(std::memory_order_acquire) != position) {
+            std::this_thread::yield();
+        }
+        index.store(position + len, std::memory_order_release);
+    }
+    
+ public:
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Constructor.
+     *
+     * \param capacity Minimum number of samples the buffer can hold.  See MirroredMemory for how it's rounded up.
+     * \param allowDoubleMapping Set to false to use the copying fallback.  See MirroredMemory.
+     */
+    MirroredMpmcRingBuffer<T>(unsigned capacity, bool allowDoubleMapping = true) : memory(capacity, allowDoubleMapping),
+            writeClaimIndex(0), writeIndex(0), readClaimIndex(0), readIndex(0), closed(false) {
+        mask = memory.capacity() - 1;
+    }
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns the number of samples the buffer can hold.
+     */
+    unsigned capacity() const {return memory.capacity();}
+    
+    /**
+     * \brief Returns the number of committed samples that haven't been claimed by a consumer.  Only a snapshot.
+     */
+    unsigned size() const {
+        return writeIndex.load(std::memory_order_acquire) - readClaimIndex.load(std::memory_order_acquire);
+    }
+    
+    /**
+     * \brief Returns true if the memory is really mapped twice rather than mirrored by copying.
+     */
+    bool isDoubleMapped() const {return memory.isDoubleMapped();}
+    
+    /**
+     * \brief Claims up to "maxLen" samples of free space.
+     *
+     * \return The claim.  Its span is empty if the buffer is full.  Otherwise it must be passed to
+     *      \ref commitWrite once it's been filled.
+     */
+    RingBufferClaim<T> claimWrite(unsigned maxLen);
+    
+    /**
+     * \brief Passes a claim from \ref claimWrite on to the consumers, once all earlier write claims have been
+     *      committed.
+     */
+    void commitWrite(const RingBufferClaim<T> & claim) {
+        if (claim.samples.len == 0)
+            return;
+        memory.mirror(claim.position & mask, claim.samples.len);
+        commitInOrder(writeIndex, claim.position, claim.samples.len);
+    }
+    
+    /**
+     * \brief Claims up to "maxLen" of the samples waiting to be read.
+     *
+     * \return The claim.  Its span is empty if there's nothing to read.  Otherwise it must be passed to
+     *      \ref commitRead once it's been processed.  Samples may be changed in place before that.
+     */
+    RingBufferClaim<T> claimRead(unsigned maxLen);
+    
+    /**
+     * \brief Releases a claim from \ref claimRead back to the producers, once all earlier read claims have been
+     *      committed.
+     */
+    void commitRead(const RingBufferClaim<T> & claim) {
+        if (claim.samples.len == 0)
+            return;
+        commitInOrder(readIndex, claim.position, claim.samples.len);
+    }
+    
+    /**
+     * \brief Copies up to "len" samples into the buffer as a single claim.
+     *
+     * \return The number of samples written, which is less than "len" if the buffer fills up.
+     */
+    unsigned write(const T *data, unsigned len) {
+        RingBufferClaim<T> claim = claimWrite(len);
+        std::copy(data, data + claim.samples.len, claim.samples.data);
+        commitWrite(claim);
+        return claim.samples.len;
+    }
+    
+    /**
+     * \brief Copies up to "len" samples out of the buffer as a single claim.
+     *
+     * \return The number of samples read, which is less than "len" if the buffer runs out.
+     */
+    unsigned read(T *data, unsigned len) {
+        RingBufferClaim<T> claim = claimRead(len);
+        std::copy(claim.samples.data, claim.samples.data + claim.samples.len, data);
+        commitRead(claim);
+        return claim.samples.len;
+    }
+    
+    /**
+     * \brief Marks the end of the stream.  Call it after the producers' last commits.
+     */
+    void close() {closed.store(true, std::memory_order_release);}
+    
+    /**
+     * \brief Returns true once the buffer has been closed.  See SpscRingBuffer::isClosed.
+     */
+    bool isClosed() const {return closed.load(std::memory_order_acquire);}
+};
+
+
+template <class T>
+RingBufferClaim<T> MirroredMpmcRingBuffer<T>::claimWrite(unsigned maxLen) {
+    unsigned position = writeClaimIndex.load(std::memory_order_relaxed);
+    unsigned len;
+    do {
+        unsigned numFree = capacity() - (position - readIndex.load(std::memory_order_acquire));
+        len = std::min(maxLen, numFree);
+        if (len == 0)
+            break;
+    } while (!writeClaimIndex.compare_exchange_weak(position, position + len, std::memory_order_relaxed));
+    
+    return RingBufferClaim<T>(memory.data() + (position & mask), len, position);
+}
+
+template <class T>
+RingBufferClaim<T> MirroredMpmcRingBuffer<T>::claimRead(unsigned maxLen) {
+    unsigned position = readClaimIndex.load(std::memory_order_relaxed);
+    unsigned len;
+    do {
+        unsigned numAvailable = writeIndex.load(std::memory_order_acquire) - position;
+        len = std::min(maxLen, numAvailable);
+        if (len == 0)
+            break;
+    } while (!readClaimIndex.compare_exchange_weak(position, position + len, std::memory_order_relaxed));
+    
+    return RingBufferClaim<T>(memory.data() + (position & mask), len, position);
+}
+
+};
+
+#endif
@@ -0,0 +1,326 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file Nco.h
+ *
+ * Definition of the template class Nco.
+ */
+
+
+#ifndef NimbleDSP_Nco_h
+#define NimbleDSP_Nco_h
+
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include "NimbleDspCommon.h"
+#include "Vector.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Number of address bits of the NCO_LOOKUP_TABLE sine table, i.e. it has 2^NCO_TABLE_BITS entries per cycle.
+ *      With linear interpolation the worst case error is about 3e-7.
+ */
+const unsigned NCO_TABLE_BITS = 12;
+
+/**
+ * \brief Number of samples between the times that an NCO_ROTATOR's rotator is reset from the phase accumulator.
+ */
+const unsigned NCO_ROTATOR_RESYNC_INTERVAL = 256;
+
+/**
+ * \brief Numerically controlled oscillator.
+ *
+ * The phase is kept in a 32-bit accumulator, so it wraps exactly and doesn't drift no matter how long the
+ * oscillator runs, and the frequency resolution is sampleFreq/2^32.  The state carries over from one call to the
+ * next, so the tone is continuous across blocks.  There are three ways to turn the phase into sin and cos:
+ *
+ *   - NCO_LOOKUP_TABLE looks up a sine table with 2^NCO_TABLE_BITS entries and interpolates linearly.
+ *   - NCO_ROTATOR multiplies a complex rotator by a fixed step each sample, which is one complex multiply per
+ *     sample.  Every NCO_ROTATOR_RESYNC_INTERVAL samples the rotator is recalculated from the phase accumulator,
+ *     which removes the magnitude and phase error that the multiplies have built up.
+ *   - NCO_POLYNOMIAL folds the phase into [-pi/4, pi/4) and evaluates sin and cos polynomials.  It has no
+ *     branches or table lookups, so the compiler can vectorize it, and its error is below 2e-9.
+ *
+ * T should be a floating point type.
+ */
+template <class T>
+class Nco {
+ protected:
+    /**
+     * \brief The current phase.  2^32 is a full cycle.
+     */
+    uint32_t phaseAccumulator;
+    
+    /**
+     * \brief The amount that \ref phaseAccumulator advances each sample.
+     */
+    uint32_t phaseIncrement;
+    
+    /**
+     * \brief exp(j*phase) for NCO_ROTATOR.
+     */
+    std::complex<T> rotator;
+    
+    /**
+     * \brief exp(j*2*pi*phaseIncrement/2^32) for NCO_ROTATOR.
+     */
+    std::complex<T> rotatorStep;
+    
+    /**
+     * \brief Number of samples until \ref rotator is recalculated.
+     */
+    unsigned samplesUntilResync;
+    
+    /**
+     * \brief Returns the sine table, which has an extra entry at the end so that interpolation doesn't wrap.
+     */
+    static const std::vector<T> & sineTable();
+    
+    /**
+     * \brief Converts a phase in radians, or a frequency in radians per sample, to accumulator units.
+     */
+    static uint32_t toAccumulator(double radians);
+    
+    /**
+     * \brief Returns sin(phase) from the sine table.
+     */
+    static T tableSin(const T *table, uint32_t phase);
+    
+    /**
+     * \brief Recalculates \ref rotator from \ref phaseAccumulator.
+     */
+    void resyncRotator();
+    
+    /**
+     * \brief Calls operation(i, exp(j*phase)) for "len" samples, and advances the phase.
+     */
+    template <class Operation>
+    void generate(unsigned len, Operation operation);
+    
+ public:
+    /**
+     * \brief How sin and cos are calculated.
+     */
+    NcoType type;
+    
+    /**
+     * \brief Returns exp(j*2*pi*phase/2^32) from the NCO_POLYNOMIAL polynomials.
+     *
+     * Useful for oscillators that keep their own phase accumulator, like FmModulator.
+     */
+    static std::complex<T> polynomialExp(uint32_t phase);
+    
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Constructor.
+     *
+     * \param freq The tone frequency.  Negative frequencies are allowed.  Defaults to 0.
+     * \param sampleFreq The sample frequency.  Defaults to 1 Hz.
+     * \param phase The starting phase, in radians.  Defaults to 0.
+     * \param type How sin and cos are calculated.  Defaults to NCO_LOOKUP_TABLE.
+     */
+    Nco<T>(T freq = 0.0, T sampleFreq = 1.0, T phase = 0.0, NcoType type = NCO_LOOKUP_TABLE) : type(type)
+            {setFrequency(freq, sampleFreq); setPhase(phase);}
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Sets the frequency.  The phase is unchanged, so the tone stays continuous.
+     *
+     * \param freq The tone frequency.
+     * \param sampleFreq The sample frequency.  Defaults to 1 Hz.
+     */
+    void setFrequency(T freq, T sampleFreq = 1.0);
+    
+    /**
+     * \brief Returns the frequency, rounded to the accumulator's resolution, in the range [-sampleFreq/2, sampleFreq/2).
+     *
+     * \param sampleFreq The sample frequency.  Defaults to 1 Hz.
+     */
+    T getFrequency(T sampleFreq = 1.0) const {return (T) ((int32_t) phaseIncrement * (sampleFreq / 4294967296.0));}
+    
+    /**
+     * \brief Sets the phase of the next sample, in radians.
+     */
+    void setPhase(T phase) {phaseAccumulator = toAccumulator(phase); resyncRotator();}
+    
+    /**
+     * \brief Returns the phase of the next sample, in radians, in the range [0, 2*pi).
+     */
+    T getPhase() const {return (T) (phaseAccumulator * (2 * M_PI / 4294967296.0));}
+    
+    /**
+     * \brief Writes "len" samples of the complex tone exp(j*phase) to "output".
+     */
+    void tone(std::complex<T> *output, unsigned len)
+            {generate(len, [output](unsigned i, std::complex<T> value) {output[i] = value;});}
+    
+    /**
+     * \brief Writes "len" samples of the real tone sin(phase) to "output".
+     */
+    void tone(T *output, unsigned len)
+            {generate(len, [output](unsigned i, std::complex<T> value) {output[i] = value.imag();});}
+    
+    /**
+     * \brief Multiplies "len" samples of "data" by the complex tone exp(j*phase).
+     */
+    void modulate(std::complex<T> *data, unsigned len);
+    
+    /**
+     * \brief Multiplies "len" samples of "data" by the real tone sin(phase).
+     */
+    void modulate(T *data, unsigned len)
+            {generate(len, [data](unsigned i, std::complex<T> value) {data[i] *= value.imag();});}
+};
+
+
+template <class T>
+const std::vector<T> & Nco<T>::sineTable() {
+    static const std::vector<T> table = [] {
+        unsigned len = 1u << NCO_TABLE_BITS;
+        std::vector<T> values(len + 1);
+        for (unsigned i=0; i<=len; i++) {
+            values[i] = (T) sin(2 * M_PI * i / len);
+        }
+        return values;
+    }();
+    return table;
+}
+
+template <class T>
+uint32_t Nco<T>::toAccumulator(double radians) {
+    double cycles = radians / (2 * M_PI);
+    cycles -= floor(cycles);
+    return (uint32_t) (uint64_t) floor(cycles * 4294967296.0 + 0.5);
+}
+
+template <class T>
+inline T Nco<T>::tableSin(const T *table, uint32_t phase) {
+    const unsigned fractionBits = 32 - NCO_TABLE_BITS;
+    uint32_t index = phase >> fractionBits;
+    T fraction = (T) (phase & ((1u << fractionBits) - 1)) * (T) (1.0 / (1u << fractionBits));
+    return table[index] + fraction * (table[index + 1] - table[index]);
+}
+
+template <class T>
+inline std::complex<T> Nco<T>::polynomialExp(uint32_t phase) {
+    // Quadrant 0 is [-pi/4, pi/4), quadrant 1 is [pi/4, 3*pi/4), etc.
+    uint32_t quadrant = (phase + 0x20000000u) >> 30;
+    T x = (T) (int32_t) (phase - (quadrant << 30)) * (T) (2 * M_PI / 4294967296.0);
+    T x2 = x * x;
+    T s = x * (1 + x2 * ((T) (-1.0/6) + x2 * ((T) (1.0/120) + x2 * ((T) (-1.0/5040) + x2 * (T) (1.0/362880)))));
+    T c = 1 + x2 * ((T) -0.5 + x2 * ((T) (1.0/24) + x2 * ((T) (-1.0/720) + x2 * ((T) (1.0/40320) +
+            x2 * (T) (-1.0/3628800)))));
+    
+    // Rotate by quadrant*pi/2.
+    T cosVal = (quadrant & 1) ? s : c;
+    T sinVal = (quadrant & 1) ? c : s;
+    return std::complex<T>(((quadrant + 1) & 2) ? -cosVal : cosVal, (quadrant & 2) ? -sinVal : sinVal);
+}
+
+template <class T>
+void Nco<T>::resyncRotator() {
+    double phase = phaseAccumulator * (2 * M_PI / 4294967296.0);
+    rotator = std::complex<T>((T) cos(phase), (T) sin(phase));
+    samplesUntilResync = NCO_ROTATOR_RESYNC_INTERVAL;
+}
+
+template <class T>
+void Nco<T>::setFrequency(T freq, T sampleFreq) {
+    assert(sampleFreq > 0.0);
+    
+    phaseIncrement = toAccumulator(2 * M_PI * ((double) freq / sampleFreq));
+    double step = phaseIncrement * (2 * M_PI / 4294967296.0);
+    rotatorStep = std::complex<T>((T) cos(step), (T) sin(step));
+}
+
+template <class T>
+template <class Operation>
+void Nco<T>::generate(unsigned len, Operation operation) {
+    switch (type) {
+    case NCO_LOOKUP_TABLE: {
+        const T *table = VECTOR_TO_ARRAY(sineTable());
+        uint32_t phase = phaseAccumulator;
+        for (unsigned i=0; i<len; i++) {
+            operation(i, std::complex<T>(tableSin(table, phase + 0x40000000u), tableSin(table, phase)));
+            phase += phaseIncrement;
+        }
+        phaseAccumulator = phase;
+        }
+        break;
+        
+    case NCO_ROTATOR: {
+        // The multiply is written out because std::complex's operator* checks for infinities and NaNs.
+        T stepReal = rotatorStep.real(), stepImag = rotatorStep.imag();
+        unsigned i = 0;
+        while (i < len) {
+            unsigned chunkLen = std::min(len - i, samplesUntilResync);
+            T rotReal = rotator.real(), rotImag = rotator.imag();
+            for (unsigned chunkEnd=i+chunkLen; i<chunkEnd; i++) {
+                operation(i, std::complex<T>(rotReal, rotImag));
+                T nextReal = rotReal * stepReal - rotImag * stepImag;
+                rotImag = rotReal * stepImag + rotImag * stepReal;
+                rotReal = nextReal;
+            }
+            rotator = std::complex<T>(rotReal, rotImag);
+            phaseAccumulator += phaseIncrement * chunkLen;
+            samplesUntilResync -= chunkLen;
+            if (samplesUntilResync == 0)
+                resyncRotator();
+        }
+        }
+        break;
+        
+    case NCO_POLYNOMIAL: {
+        // Each sample's phase is calculated from the start of the block so that the samples are independent.
+        uint32_t phase = phaseAccumulator;
+        for (unsigned i=0; i<len; i++) {
+            operation(i, polynomialExp(phase + i * phaseIncrement));
+        }
+        phaseAccumulator = phase + len * phaseIncrement;
+        }
+        break;
+    }
+}
+
+template <class T>
+void Nco<T>::modulate(std::complex<T> *data, unsigned len) {
+    generate(len, [data](unsigned i, std::complex<T> value) {
+        T dataReal = data[i].real(), dataImag = data[i].imag();
+        data[i] = std::complex<T>(dataReal * value.real() - dataImag * value.imag(),
+                                  dataReal * value.imag() + dataImag * value.real());
+    });
+}
+
+};
+
+#endif
@@ -13,6 +13,11 @@ namespace NimbleDSP {
 
 enum FilterOperationType {STREAMING, ONE_SHOT_RETURN_ALL_RESULTS, ONE_SHOT_TRIM_TAILS};
 typedef enum ParksMcClellanFilterType {PASSBAND_FILTER = 1, DIFFERENTIATOR_FILTER, HILBERT_FILTER} ParksMcClellanFilterType;
+enum SpectrumAveragingType {MEAN_AVERAGE, EXPONENTIAL_AVERAGE, MAX_HOLD};
+enum NcoType {NCO_LOOKUP_TABLE, NCO_ROTATOR, NCO_POLYNOMIAL};
+enum PipelineScheduling {THREAD_PER_STAGE, WORK_STEALING_POOL};
+enum PipelineStepResult {STAGE_IDLE, STAGE_PROGRESS, STAGE_FINISHED};
+enum SampleFormat {SAMPLE_INT8, SAMPLE_INT16, SAMPLE_FLOAT32, SAMPLE_COMPLEX_INT8, SAMPLE_COMPLEX_INT16, SAMPLE_COMPLEX_FLOAT32};
 
 };
 
@@ -0,0 +1,82 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file ParallelFor.h
+ *
+ * Definition of the parallelFor function, which splits work across threads.
+ */
+
+#ifndef NimbleDSP_ParallelFor_h
+#define NimbleDSP_ParallelFor_h
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Default minimum number of results that each thread is given by the multithreaded one-shot filter methods.
+ *
+ * Starting a thread costs roughly as much as calculating a few thousand filter outputs, so there is no point
+ * in splitting up less work than this.
+ */
+const unsigned DEFAULT_PARALLEL_MIN_BLOCK_LEN = 4096;
+
+/**
+ * \brief Calls func(begin, end) on contiguous, non-overlapping sub-ranges that together cover [0, len).
+ *
+ * The range is split into at most "numThreads" blocks of at least "minBlockLen" elements (except for the
+ * last block).  The first block is processed on the calling thread and the others on new threads, and the
+ * function returns when all of them are done.  If there isn't enough work for two blocks then func(0, len)
+ * is simply called on the calling thread.
+ *
+ * \param len Length of the range.
+ * \param numThreads Maximum number of threads to use, including the calling thread.
+ * \param minBlockLen Minimum number of elements to give each thread.
+ * \param func Function object called with the "begin" and "end" of each block.
+ */
+template <class Func>
+void parallelFor(unsigned len, unsigned numThreads, unsigned minBlockLen, Func func) {
+    unsigned numBlocks = std::min(numThreads, len / std::max(minBlockLen, 1u));
+    if (numBlocks <= 1) {
+        func(0u, len);
+        return;
+    }
+    
+    unsigned blockLen = (len + numBlocks - 1) / numBlocks;
+    std::vector<std::thread> threads;
+    for (unsigned begin=blockLen; begin<len; begin+=blockLen) {
+        threads.push_back(std::thread(func, begin, std::min(begin + blockLen, len)));
+    }
+    func(0u, blockLen);
+    for (unsigned i=0; i<threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+};
+
+#endif
@@ -0,0 +1,764 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file Pipeline.h
+ *
+ * Definition of the Pipeline class and its stages, which run blocks of samples through a graph of processing steps
+ * on multiple threads.
+ */
+
+#ifndef NimbleDSP_Pipeline_h
+#define NimbleDSP_Pipeline_h
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+#include <assert.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "NimbleDspCommon.h"
+#include "Vector.h"
+#include "SpscRingBuffer.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Default number of samples in the queue between two stages.
+ */
+const unsigned DEFAULT_PIPELINE_QUEUE_LEN = 16384;
+
+/**
+ * \brief Number of times an idle worker thread yields before it starts sleeping between attempts.
+ */
+const unsigned PIPELINE_IDLE_SPINS = 64;
+
+/**
+ * \brief How long an idle worker thread sleeps between attempts once it's done spinning, in microseconds.
+ */
+const unsigned PIPELINE_IDLE_SLEEP_US = 50;
+
+/**
+ * \brief Snapshot of a stage's counters.  See \ref PipelineNode::getStats.
+ */
+struct PipelineStageStats {
+    /**
+     * \brief Number of times the stage's function has been called.
+     */
+    unsigned long long blocks;
+    
+    /**
+     * \brief Number of samples the stage has read from its input queue.
+     */
+    unsigned long long samplesIn;
+    
+    /**
+     * \brief Number of samples the stage's function has produced.
+     */
+    unsigned long long samplesOut;
+    
+    /**
+     * \brief Time spent in the stage's function, in seconds.
+     */
+    double busySeconds;
+    
+    /**
+     * \brief Input samples (output samples for a source) per second of busy time.
+     */
+    double throughput;
+    
+    /**
+     * \brief Number of samples waiting in the input queue.  Always 0 for a source.
+     */
+    unsigned queueDepth;
+    
+    /**
+     * \brief Capacity of the input queue.  Always 0 for a source.
+     */
+    unsigned queueCapacity;
+};
+
+/**
+ * \brief The sample type of a RealVector or ComplexVector buffer.
+ */
+template <class Buffer>
+struct PipelineSampleType {
+    typedef typename std::decay<decltype(std::declval<Buffer &>().vec[0])>::type type;
+};
+
+/**
+ * \brief Base class of the pipeline stages.  It's what the worker threads see.
+ */
+class PipelineNode {
+ public:
+    /**
+     * \brief Number of times the stage's function has been called.
+     */
+    std::atomic<unsigned long long> blocks;
+    
+    /**
+     * \brief Number of samples read from the input queue.
+     */
+    std::atomic<unsigned long long> samplesIn;
+    
+    /**
+     * \brief Number of samples produced by the stage's function.
+     */
+    std::atomic<unsigned long long> samplesOut;
+    
+    /**
+     * \brief Time spent in the stage's function, in nanoseconds.
+     */
+    std::atomic<unsigned long long> busyNanoseconds;
+    
+    /**
+     * \brief Held by the worker thread that is running the stage, so that a stage never runs on two threads at once.
+     */
+    std::atomic<bool> running;
+    
+    /**
+     * \brief Set once \ref step has returned STAGE_FINISHED.
+     */
+    std::atomic<bool> done;
+    
+    PipelineNode() : blocks(0), samplesIn(0), samplesOut(0), busyNanoseconds(0), running(false), done(false) {}
+    virtual ~PipelineNode() {}
+    
+    /**
+     * \brief Does one block's worth of work, if there is any.
+     *
+     * \return STAGE_PROGRESS if anything was done, STAGE_IDLE if the stage is waiting for input or for space in an
+     *      output queue, and STAGE_FINISHED once the end of the stream has been passed on.
+     */
+    virtual PipelineStepResult step() = 0;
+    
+    /**
+     * \brief Returns true if all of the stage's inputs and outputs have been connected.
+     */
+    virtual bool connected() const = 0;
+    
+    /**
+     * \brief Returns a snapshot of the stage's counters.  Can be called from any thread while the pipeline runs.
+     */
+    PipelineStageStats getStats() const {
+        PipelineStageStats stats;
+        stats.blocks = blocks.load(std::memory_order_relaxed);
+        stats.samplesIn = samplesIn.load(std::memory_order_relaxed);
+        stats.samplesOut = samplesOut.load(std::memory_order_relaxed);
+        stats.busySeconds = busyNanoseconds.load(std::memory_order_relaxed) * 1e-9;
+        unsigned long long samples = (stats.samplesIn > 0) ? stats.samplesIn : stats.samplesOut;
+        stats.throughput = (stats.busySeconds > 0) ? samples / stats.busySeconds : 0;
+        stats.queueDepth = queueDepth();
+        stats.queueCapacity = queueCapacity();
+        return stats;
+    }
+    
+ protected:
+    /**
+     * \brief Number of samples waiting in the input queue.
+     */
+    virtual unsigned queueDepth() const {return 0;}
+    
+    /**
+     * \brief Capacity of the input queue.
+     */
+    virtual unsigned queueCapacity() const {return 0;}
+    
+    /**
+     * \brief Updates the counters after the stage's function has been called.
+     */
+    void recordBlock(unsigned numIn, unsigned numOut, std::chrono::steady_clock::time_point startTime) {
+        std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - startTime;
+        blocks.fetch_add(1, std::memory_order_relaxed);
+        samplesIn.fetch_add(numIn, std::memory_order_relaxed);
+        samplesOut.fetch_add(numOut, std::memory_order_relaxed);
+        busyNanoseconds.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    }
+};
+
+/**
+ * \brief The input of a stage.  It owns the queue that feeds the stage.
+ */
+template <class T>
+class PipelineInputPort {
+ public:
+    /**
+     * \brief The queue from the upstream stage.  NULL until the port is connected.
+     */
+    std::unique_ptr< SpscRingBuffer<T> > queue;
+    
+    /**
+     * \brief Number of samples the stage processes at a time.
+     */
+    unsigned blockLen;
+    
+    PipelineInputPort<T>(unsigned blockLen) : blockLen(blockLen) {assert(blockLen > 0);}
+    
+ protected:
+    /**
+     * \brief Reads the next block into "buffer".
+     *
+     * Waits for a full block unless the upstream stage has finished, in which case the last block may be short.
+     * \return The number of samples read.  0 means there isn't a block available yet, or, if "finished" is set,
+     *      that the stream has ended.
+     */
+    template <class Buffer>
+    unsigned readBlock(Buffer & buffer, bool & finished) {
+        // The closed flag has to be read before the size.  See SpscRingBuffer::isClosed.
+        finished = queue->isClosed();
+        unsigned numAvailable = queue->size();
+        if (numAvailable == 0 || (numAvailable < blockLen && !finished)) {
+            return 0;
+        }
+        finished = false;
+        unsigned len = std::min(numAvailable, blockLen);
+        buffer.resize(len);
+        return queue->read(VECTOR_TO_ARRAY(buffer.vec), len);
+    }
+};
+
+/**
+ * \brief The output of a stage.  It can feed any number of downstream stages, each through its own queue.
+ */
+template <class T>
+class PipelineOutputPort {
+ public:
+    /**
+     * \brief The queues to the downstream stages.
+     */
+    std::vector< SpscRingBuffer<T> * > queues;
+    
+ protected:
+    /**
+     * \brief Number of samples of the pending block that each queue has taken.
+     */
+    std::vector<unsigned> queueOffsets;
+    
+    /**
+     * \brief Number of samples in the pending block.
+     */
+    unsigned pendingLen;
+    
+    PipelineOutputPort<T>() : pendingLen(0) {}
+    
+    /**
+     * \brief Writes as much of the pending block in "buffer" to the queues as they have room for.
+     *
+     * \param progress Set to true if any samples were written.
+     * \return True once every queue has taken the whole block.
+     */
+    template <class Buffer>
+    bool flush(const Buffer & buffer, bool & progress) {
+        bool flushed = true;
+        for (unsigned i=0; i<queues.size(); i++) {
+            if (queueOffsets[i] < pendingLen) {
+                unsigned numWritten = queues[i]->write(VECTOR_TO_ARRAY(buffer.vec) + queueOffsets[i],
+                                                        pendingLen - queueOffsets[i]);
+                queueOffsets[i] += numWritten;
+                progress = progress || numWritten > 0;
+                flushed = flushed && queueOffsets[i] == pendingLen;
+            }
+        }
+        if (flushed) {
+            pendingLen = 0;
+            std::fill(queueOffsets.begin(), queueOffsets.end(), 0);
+        }
+        return flushed;
+    }
+    
+    /**
+     * \brief Marks the end of the stream on every output queue.
+     */
+    void closeQueues() {
+        for (unsigned i=0; i<queues.size(); i++) {
+            queues[i]->close();
+        }
+    }
+    
+    friend class Pipeline;
+};
+
+/**
+ * \brief A stage that generates samples, e.g. by reading them from a file or a device.
+ *
+ * "func" is called as func(OutBuffer &output).  It puts the next block in "output", resizing it as necessary, and
+ * returns false once the stream has ended.  The block from the final call is still passed on.
+ */
+template <class OutBuffer, class Func>
+class PipelineSource : public PipelineNode, public PipelineOutputPort<typename PipelineSampleType<OutBuffer>::type> {
+ protected:
+    /**
+     * \brief Generates the blocks.
+     */
+    Func func;
+    
+    /**
+     * \brief The block that's being passed on.
+     */
+    OutBuffer outBuf;
+    
+    /**
+     * \brief Set once func has returned false.
+     */
+    bool endOfStream;
+    
+ public:
+    PipelineSource(Func func) : func(func), outBuf(0), endOfStream(false) {}
+    
+    virtual PipelineStepResult step() {
+        bool progress = false;
+        if (!this->flush(outBuf, progress)) {
+            return progress ? STAGE_PROGRESS : STAGE_IDLE;
+        }
+        if (endOfStream) {
+            this->closeQueues();
+            return STAGE_FINISHED;
+        }
+        
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        endOfStream = !func(outBuf);
+        recordBlock(0, outBuf.size(), startTime);
+        this->pendingLen = outBuf.size();
+        this->flush(outBuf, progress);
+        return STAGE_PROGRESS;
+    }
+    
+    virtual bool connected() const {return this->queues.size() > 0;}
+};
+
+/**
+ * \brief A stage that turns blocks of input samples into blocks of output samples, e.g. a filter or a resampler.
+ *
+ * "func" is called as func(InBuffer &input, OutBuffer &output), with "blockLen" samples in "input" (the last block
+ * may be shorter).  It puts its results in "output", resizing it as necessary.  It may also change "input".
+ */
+template <class InBuffer, class OutBuffer, class Func>
+class PipelineStage : public PipelineNode, public PipelineInputPort<typename PipelineSampleType<InBuffer>::type>,
+                      public PipelineOutputPort<typename PipelineSampleType<OutBuffer>::type> {
+ protected:
+    /**
+     * \brief Does the processing.
+     */
+    Func func;
+    
+    /**
+     * \brief The block that was read from the input queue.
+     */
+    InBuffer inBuf;
+    
+    /**
+     * \brief The block that's being passed on.
+     */
+    OutBuffer outBuf;
+    
+    virtual unsigned queueDepth() const {return this->queue ? this->queue->size() : 0;}
+    virtual unsigned queueCapacity() const {return this->queue ? this->queue->capacity() : 0;}
+    
+ public:
+    PipelineStage(Func func, unsigned blockLen) : PipelineInputPort<typename PipelineSampleType<InBuffer>::type>(blockLen),
+            func(func), inBuf(0), outBuf(0) {}
+    
+    virtual PipelineStepResult step() {
+        bool progress = false;
+        if (!this->flush(outBuf, progress)) {
+            return progress ? STAGE_PROGRESS : STAGE_IDLE;
+        }
+        
+        bool finished;
+        unsigned numRead = this->readBlock(inBuf, finished);
+        if (finished) {
+            this->closeQueues();
+            return STAGE_FINISHED;
+        }
+        if (numRead == 0) {
+            return STAGE_IDLE;
+        }
+        
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        func(inBuf, outBuf);
+        recordBlock(numRead, outBuf.size(), startTime);
+        this->pendingLen = outBuf.size();
+        this->flush(outBuf, progress);
+        return STAGE_PROGRESS;
+    }
+    
+    virtual bool connected() const {return this->queue && this->queues.size() > 0;}
+};
+
+/**
+ * \brief Adapts a function that processes a block in place, like most of the filter methods, to a PipelineStage.
+ */
+template <class Buffer, class Func>
+class PipelineInPlaceFunction {
+ public:
+    /**
+     * \brief The function, called as func(Buffer &data).
+     */
+    Func func;
+    
+    PipelineInPlaceFunction(Func func) : func(func) {}
+    
+    void operator()(Buffer & input, Buffer & output) {
+        // The previous output has been passed on by now, so its storage can be recycled as the next input.
+        input.vec.swap(output.vec);
+        input.modified();
+        output.modified();
+        func(output);
+    }
+};
+
+/**
+ * \brief A stage that consumes samples, e.g. by writing them to a file or a device.
+ *
+ * "func" is called as func(InBuffer &input), with "blockLen" samples in "input" (the last block may be shorter).
+ */
+template <class InBuffer, class Func>
+class PipelineSink : public PipelineNode, public PipelineInputPort<typename PipelineSampleType<InBuffer>::type> {
+ protected:
+    /**
+     * \brief Consumes the blocks.
+     */
+    Func func;
+    
+    /**
+     * \brief The block that was read from the input queue.
+     */
+    InBuffer inBuf;
+    
+    virtual unsigned queueDepth() const {return this->queue ? this->queue->size() : 0;}
+    virtual unsigned queueCapacity() const {return this->queue ? this->queue->capacity() : 0;}
+    
+ public:
+    PipelineSink(Func func, unsigned blockLen) : PipelineInputPort<typename PipelineSampleType<InBuffer>::type>(blockLen),
+            func(func), inBuf(0) {}
+    
+    virtual PipelineStepResult step() {
+        bool finished;
+        unsigned numRead = this->readBlock(inBuf, finished);
+        if (finished) {
+            return STAGE_FINISHED;
+        }
+        if (numRead == 0) {
+            return STAGE_IDLE;
+        }
+        
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        func(inBuf);
+        recordBlock(numRead, 0, startTime);
+        return STAGE_PROGRESS;
+    }
+    
+    virtual bool connected() const {return (bool) this->queue;}
+};
+
+/**
+ * \brief A graph of stages connected by lock-free queues, run on multiple threads.
+ *
+ * Stages are added with \ref addSource, \ref addStage, \ref addInPlaceStage and \ref addSink, which return
+ * references to them, and then wired together with \ref connect.  Each stage has at most one input, but an output
+ * can feed several stages.  Every queue has one producer and one consumer, so it's an SpscRingBuffer, and a
+ * stage that can't write its whole output waits for room, which throttles everything upstream of it.  When a
+ * source's function returns false the end of the stream propagates down the graph, and the pipeline finishes
+ * once every stage has seen it.
+ *
+ * For example, to interpolate and FM modulate audio:
+ * \code
+ * Pipeline pipeline;
+ * auto & source = pipeline.addSource< RealVector<float> >([&](RealVector<float> & out) {...; return moreData;});
+ * auto & interpolator = pipeline.addInPlaceStage< RealVector<float> >(
+ *         [&](RealVector<float> & buf) {interp(buf, 4, filt);}, 1024);
+ * auto & modulator = pipeline.addStage< RealVector<float>, ComplexVector<float> >(
+ *         [&](RealVector<float> & in, ComplexVector<float> & out) {fm.modulate(in, out);}, 4096);
+ * auto & sink = pipeline.addSink< ComplexVector<float> >([&](ComplexVector<float> & in) {...}, 4096);
+ * pipeline.connect(source, interpolator);
+ * pipeline.connect(interpolator, modulator);
+ * pipeline.connect(modulator, sink);
+ * pipeline.run();
+ * \endcode
+ */
+class Pipeline {
+ protected:
+    /**
+     * \brief The stages, in the order they were added.
+     */
+    std::vector< std::unique_ptr<PipelineNode> > nodes;
+    
+    /**
+     * \brief The worker threads.
+     */
+    std::vector<std::thread> threads;
+    
+    /**
+     * \brief Number of stages that have finished.
+     */
+    std::atomic<unsigned> numFinished;
+    
+    /**
+     * \brief Set by \ref stop.
+     */
+    std::atomic<bool> stopRequested;
+    
+    /**
+     * \brief Steps each of the unfinished, unclaimed stages in "stages" once.
+     *
+     * \return True if any of them made progress.
+     */
+    bool visit(const std::vector<PipelineNode *> & stages);
+    
+    /**
+     * \brief Worker thread function.  Runs "ownStages" until the pipeline finishes, and when they're all idle steps
+     *      "otherStages" instead.
+     */
+    void work(std::vector<PipelineNode *> ownStages, std::vector<PipelineNode *> otherStages);
+    
+    /**
+     * \brief Restricts "thread" to a single CPU.  Does nothing on platforms other than Linux.
+     */
+    static void pinThread(std::thread & thread, unsigned cpu);
+    
+ public:
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    Pipeline() : numFinished(0), stopRequested(false) {}
+    
+    /**
+     * \brief Destructor.  Stops the pipeline if it's still running.
+     */
+    ~Pipeline() {
+        stop();
+        wait();
+    }
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Adds a stage that generates blocks.  See \ref PipelineSource.
+     */
+    template <class OutBuffer, class Func>
+    PipelineSource<OutBuffer, Func> & addSource(Func func) {
+        PipelineSource<OutBuffer, Func> *stage = new PipelineSource<OutBuffer, Func>(func);
+        nodes.push_back(std::unique_ptr<PipelineNode>(stage));
+        return *stage;
+    }
+    
+    /**
+     * \brief Adds a stage that turns input blocks into output blocks.  See \ref PipelineStage.
+     *
+     * \param func The processing function.
+     * \param blockLen Number of samples to pass to "func" at a time.
+     */
+    template <class InBuffer, class OutBuffer, class Func>
+    PipelineStage<InBuffer, OutBuffer, Func> & addStage(Func func, unsigned blockLen) {
+        PipelineStage<InBuffer, OutBuffer, Func> *stage = new PipelineStage<InBuffer, OutBuffer, Func>(func, blockLen);
+        nodes.push_back(std::unique_ptr<PipelineNode>(stage));
+        return *stage;
+    }
+    
+    /**
+     * \brief Adds a stage that processes blocks in place, e.g. with one of the streaming filter methods.
+     *
+     * \param func The processing function, called as func(Buffer &data).
+     * \param blockLen Number of samples to pass to "func" at a time.
+     */
+    template <class Buffer, class Func>
+    PipelineStage<Buffer, Buffer, PipelineInPlaceFunction<Buffer, Func> > & addInPlaceStage(Func func, unsigned blockLen) {
+        return addStage< Buffer, Buffer, PipelineInPlaceFunction<Buffer, Func> >(PipelineInPlaceFunction<Buffer, Func>(func),
+                                                                                 blockLen);
+    }
+    
+    /**
+     * \brief Adds a stage that consumes blocks.  See \ref PipelineSink.
+     *
+     * \param func The consuming function.
+     * \param blockLen Number of samples to pass to "func" at a time.
+     */
+    template <class InBuffer, class Func>
+    PipelineSink<InBuffer, Func> & addSink(Func func, unsigned blockLen) {
+        PipelineSink<InBuffer, Func> *stage = new PipelineSink<InBuffer, Func>(func, blockLen);
+        nodes.push_back(std::unique_ptr<PipelineNode>(stage));
+        return *stage;
+    }
+    
+    /**
+     * \brief Feeds the output of "from" to the input of "to".
+     *
+     * \param from The upstream stage.
+     * \param to The downstream stage.  Its input must not already be connected.
+     * \param queueLen Minimum number of samples the queue between them holds.  It must be at least the block length
+     *      of "to".
+     */
+    template <class T>
+    void connect(PipelineOutputPort<T> & from, PipelineInputPort<T> & to, unsigned queueLen = DEFAULT_PIPELINE_QUEUE_LEN) {
+        assert(threads.empty());
+        assert(!to.queue);
+        assert(queueLen >= to.blockLen);
+        to.queue.reset(new SpscRingBuffer<T>(queueLen));
+        from.queues.push_back(to.queue.get());
+        from.queueOffsets.push_back(0);
+    }
+    
+    /**
+     * \brief Starts running the pipeline on worker threads and returns.
+     *
+     * \param scheduling THREAD_PER_STAGE gives every stage its own thread.  WORK_STEALING_POOL runs the stages on
+     *      "numThreads" threads.  Each of them owns every numThreads'th stage, and steps the other threads' stages
+     *      when its own are all idle.
+     * \param numThreads Number of threads for WORK_STEALING_POOL.  0 means one per CPU.
+     * \param pinThreads Set to true to pin each thread to its own CPU, round robin.
+     */
+    void start(PipelineScheduling scheduling = THREAD_PER_STAGE, unsigned numThreads = 0, bool pinThreads = false);
+    
+    /**
+     * \brief Waits for the worker threads to finish.
+     */
+    void wait() {
+        for (unsigned i=0; i<threads.size(); i++) {
+            threads[i].join();
+        }
+        threads.clear();
+    }
+    
+    /**
+     * \brief Runs the pipeline to completion.  See \ref start for the parameters.
+     */
+    void run(PipelineScheduling scheduling = THREAD_PER_STAGE, unsigned numThreads = 0, bool pinThreads = false) {
+        start(scheduling, numThreads, pinThreads);
+        wait();
+    }
+    
+    /**
+     * \brief Tells the worker threads to exit without waiting for the end of the stream.
+     */
+    void stop() {stopRequested.store(true);}
+    
+    /**
+     * \brief Returns true once every stage has finished.
+     */
+    bool finished() const {return numFinished.load() == nodes.size();}
+    
+    /**
+     * \brief Returns a snapshot of every stage's counters, in the order the stages were added.
+     */
+    std::vector<PipelineStageStats> getStats() const {
+        std::vector<PipelineStageStats> stats(nodes.size());
+        for (unsigned i=0; i<nodes.size(); i++) {
+            stats[i] = nodes[i]->getStats();
+        }
+        return stats;
+    }
+};
+
+
+inline bool Pipeline::visit(const std::vector<PipelineNode *> & stages) {
+    bool progress = false;
+    for (unsigned i=0; i<stages.size(); i++) {
+        PipelineNode *stage = stages[i];
+        if (stage->done.load(std::memory_order_acquire) || stage->running.exchange(true, std::memory_order_acquire)) {
+            continue;
+        }
+        if (!stage->done.load(std::memory_order_relaxed)) {
+            PipelineStepResult result = stage->step();
+            if (result == STAGE_FINISHED) {
+                stage->done.store(true, std::memory_order_relaxed);
+                numFinished.fetch_add(1);
+            }
+            progress = progress || result != STAGE_IDLE;
+        }
+        stage->running.store(false, std::memory_order_release);
+    }
+    return progress;
+}
+
+inline void Pipeline::work(std::vector<PipelineNode *> ownStages, std::vector<PipelineNode *> otherStages) {
+    unsigned numIdle = 0;
+    while (!stopRequested.load(std::memory_order_relaxed) && !finished()) {
+        if (visit(ownStages) || visit(otherStages)) {
+            numIdle = 0;
+        }
+        else if (numIdle < PIPELINE_IDLE_SPINS) {
+            numIdle++;
+            std::this_thread::yield();
+        }
+        else {
+            std::this_thread::sleep_for(std::chrono::microseconds(PIPELINE_IDLE_SLEEP_US));
+        }
+    }
+}
+
+inline void Pipeline::pinThread(std::thread & thread, unsigned cpu) {
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#endif
+}
+
+inline void Pipeline::start(PipelineScheduling scheduling, unsigned numThreads, bool pinThreads) {
+    assert(threads.empty() && nodes.size() > 0);
+    for (unsigned i=0; i<nodes.size(); i++) {
+        assert(nodes[i]->connected());
+    }
+    stopRequested.store(false);
+    
+    unsigned numCpus = std::max(std::thread::hardware_concurrency(), 1u);
+    if (scheduling == THREAD_PER_STAGE || numThreads > nodes.size()) {
+        numThreads = nodes.size();
+    }
+    else if (numThreads == 0) {
+        numThreads = std::min(numCpus, (unsigned) nodes.size());
+    }
+    
+    for (unsigned thread=0; thread<numThreads; thread++) {
+        // Thread "thread" owns stages thread, thread + numThreads, ...  It looks for other work starting with the
+        // next thread's stages, so that idle threads don't all pile onto the same stage.
+        std::vector<PipelineNode *> ownStages, otherStages;
+        for (unsigned i=0; i<nodes.size(); i++) {
+            unsigned index = (thread + i) % nodes.size();
+            if (index % numThreads == thread) {
+                ownStages.push_back(nodes[index].get());
+            }
+            else if (scheduling == WORK_STEALING_POOL) {
+                otherStages.push_back(nodes[index].get());
+            }
+        }
+        threads.push_back(std::thread(&Pipeline::work, this, ownStages, otherStages));
+        if (pinThreads) {
+            pinThread(threads.back(), thread % numCpus);
+        }
+    }
+}
+
+};
+
+#endif
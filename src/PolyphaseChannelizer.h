@@ -0,0 +1,266 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file PolyphaseChannelizer.h
+ *
+ * Definition of the template class PolyphaseChannelizer.
+ */
+
+
+#ifndef NimbleDSP_PolyphaseChannelizer_h
+#define NimbleDSP_PolyphaseChannelizer_h
+
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include "RealFirFilter.h"
+#include "ComplexVector.h"
+#include "FftPlanCache.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Critically sampled polyphase filter bank channelizer.
+ *
+ * Splits complex data into "numChannels" channels that are evenly spaced across the sample rate and decimates
+ * each of them by "numChannels".  Channel "k" is centered at k/numChannels cycles per sample.  The results are the
+ * same as running a STREAMING RealFirFilter with the prototype taps over data that has been modulated down by
+ * k/numChannels cycles per sample, and decimating by "numChannels", for each of the channels.  Instead of
+ * numChannels filters at the full rate, every output sample set costs one pass through the prototype taps plus
+ * one numChannels point FFT.
+ *
+ * Like the FIR filters' STREAMING mode, the data can be passed in blocks of any size.  The filter state and the
+ * position of the next output sample set carry over from one block to the next.
+ */
+template <class T>
+class PolyphaseChannelizer {
+ protected:
+    /**
+     * \brief The prototype taps in reverse order, padded with zeros to a multiple of \ref numChannels.
+     */
+    std::vector<T> reversedTaps;
+    
+    /**
+     * \brief Input samples that are still needed for future outputs.
+     */
+    std::vector< std::complex<T> > savedData;
+    
+    /**
+     * \brief Work buffer for the branch filter outputs, which is the input to the FFT.
+     */
+    std::vector< std::complex<T> > branchOutputs;
+    
+    /**
+     * \brief Sets up \ref reversedTaps and the state.
+     */
+    void initTaps(const T *taps, unsigned numTaps);
+    
+    /**
+     * \brief Calculates the output sample set for the prototype taps starting at "window".
+     */
+    void channelizePoint(const std::complex<T> *window, std::complex<T> *output);
+    
+ public:
+    /**
+     * \brief Number of channels, which is also the decimation rate.
+     */
+    unsigned numChannels;
+    
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Taps vector constructor.
+     *
+     * \param prototypeTaps Taps of the lowpass prototype filter.  Its bandwidth is normally 1/numChannels of the
+     *      sample rate, e.g. a passband edge a little less than 1/numChannels and a stopband edge a little more
+     *      (Nyquist = 1).
+     * \param numChannels Number of channels.
+     */
+    template <typename U>
+    PolyphaseChannelizer<T>(const std::vector<U> & prototypeTaps, unsigned numChannels) : numChannels(numChannels) {
+        std::vector<T> taps(prototypeTaps.begin(), prototypeTaps.end());
+        initTaps(VECTOR_TO_ARRAY(taps), (unsigned) taps.size());
+    }
+    
+    /**
+     * \brief Prototype filter constructor.
+     *
+     * \param prototype The lowpass prototype filter, e.g. designed with RealFirFilter::firpm.  Only its taps are
+     *      used.
+     * \param numChannels Number of channels.
+     */
+    template <template <class> class Allocator>
+    PolyphaseChannelizer<T>(const RealFirFilter<T, Allocator> & prototype, unsigned numChannels) : numChannels(numChannels)
+            {initTaps(VECTOR_TO_ARRAY(prototype.vec), prototype.size());}
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns the number of prototype taps in each polyphase branch.
+     */
+    unsigned tapsPerBranch() const {return (unsigned) reversedTaps.size() / numChannels;}
+    
+    /**
+     * \brief Returns the number of output sample sets that channelizing "inputLen" more samples will produce.
+     */
+    unsigned outputLength(unsigned inputLen) const;
+    
+    /**
+     * \brief Channelizes "input" and puts the results in "output".
+     *
+     * \param input The data to channelize.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer for the results.  Sample "m" of channel "k" is put at output[m*numChannels + k].
+     * \param outputCapacity Number of sample sets that "output" can hold, i.e. it holds outputCapacity*numChannels
+     *      values.  See \ref outputLength.
+     * \return The number of sample sets written to "output".
+     */
+    template <class U>
+    unsigned channelize(const U *input, unsigned inputLen, std::complex<T> *output, unsigned outputCapacity);
+    
+    /**
+     * \brief Channelizes "data" into separate vectors for each channel.
+     *
+     * \param data The data to channelize.
+     * \param channels Resized to \ref numChannels vectors.  channels[k] is set to the new samples of channel "k".
+     * \return Reference to "channels".
+     */
+    template <class U, template <class> class Allocator>
+    std::vector< ComplexVector<T, Allocator> > & channelize(const Vector<U, Allocator> & data,
+                                                            std::vector< ComplexVector<T, Allocator> > & channels);
+    
+    /**
+     * \brief Sets the filter state to zero, so that the next input sample completes an output sample set.
+     */
+    void reset() {savedData.assign(reversedTaps.size() - 1, 0);}
+};
+
+
+template <class T>
+void PolyphaseChannelizer<T>::initTaps(const T *taps, unsigned numTaps) {
+    assert(numChannels > 0 && numTaps > 0);
+    
+    // Zeros at the end don't change the filter.
+    unsigned numBranchTaps = (numTaps + numChannels - 1) / numChannels;
+    reversedTaps.assign(numBranchTaps * numChannels, 0);
+    for (unsigned i=0; i<numTaps; i++) {
+        reversedTaps[reversedTaps.size() - 1 - i] = taps[i];
+    }
+    branchOutputs.resize(numChannels);
+    reset();
+}
+
+template <class T>
+unsigned PolyphaseChannelizer<T>::outputLength(unsigned inputLen) const {
+    unsigned windowLen = (unsigned) reversedTaps.size();
+    unsigned availableLen = (unsigned) savedData.size() + inputLen;
+    if (availableLen < windowLen)
+        return 0;
+    return (availableLen - windowLen) / numChannels + 1;
+}
+
+template <class T>
+void PolyphaseChannelizer<T>::channelizePoint(const std::complex<T> *window, std::complex<T> *output) {
+    // window[reversedTaps.size() - 1] is the newest sample, so window[block + j] is multiplied by a tap of branch
+    // numChannels - 1 - j.  Accumulating one block of numChannels taps at a time keeps both the taps and the data
+    // contiguous.
+    const T *taps = VECTOR_TO_ARRAY(reversedTaps);
+    std::complex<T> *branches = VECTOR_TO_ARRAY(branchOutputs) + numChannels - 1;
+    for (unsigned j=0; j<numChannels; j++) {
+        branches[-(int) j] = window[j] * taps[j];
+    }
+    for (unsigned block=numChannels; block<reversedTaps.size(); block+=numChannels) {
+        for (unsigned j=0; j<numChannels; j++) {
+            branches[-(int) j] += window[block + j] * taps[block + j];
+        }
+    }
+    
+    // Channel k = sum over branches r of branch_r * exp(j*2*pi*k*r/numChannels), which is an unscaled inverse FFT.
+    getFftPlan<T>(numChannels, true).transform(VECTOR_TO_ARRAY(branchOutputs), output);
+}
+
+template <class T>
+template <class U>
+unsigned PolyphaseChannelizer<T>::channelize(const U *input, unsigned inputLen, std::complex<T> *output,
+                                             unsigned outputCapacity) {
+    unsigned outputLen = outputLength(inputLen);
+    assert(outputCapacity >= outputLen);
+    
+    ScratchBuffer< std::vector< std::complex<T> > > dataTmp(NULL, savedData.size() + inputLen);
+    std::vector< std::complex<T> > & data = *dataTmp;
+    data.resize(savedData.size() + inputLen);
+    std::copy(savedData.begin(), savedData.end(), data.begin());
+    for (unsigned i=0; i<inputLen; i++) {
+        data[savedData.size() + i] = std::complex<T>(input[i]);
+    }
+    
+    for (unsigned m=0; m<outputLen; m++) {
+        channelizePoint(VECTOR_TO_ARRAY(data) + m * numChannels, output + m * numChannels);
+    }
+    
+    // Keep everything from the start of the next output's window.
+    savedData.assign(data.begin() + outputLen * numChannels, data.end());
+    return outputLen;
+}
+
+template <class T>
+template <class U, template <class> class Allocator>
+std::vector< ComplexVector<T, Allocator> > & PolyphaseChannelizer<T>::channelize(const Vector<U, Allocator> & data,
+        std::vector< ComplexVector<T, Allocator> > & channels) {
+    unsigned outputLen = outputLength(data.size());
+    ScratchBuffer< std::vector< std::complex<T> > > results(NULL, outputLen * numChannels);
+    results->resize(outputLen * numChannels);
+    channelize(VECTOR_TO_ARRAY(data.vec), data.size(), VECTOR_TO_ARRAY(*results), outputLen);
+    
+    channels.resize(numChannels);
+    for (unsigned k=0; k<numChannels; k++) {
+        channels[k].vec.resize(outputLen);
+        channels[k].modified();
+        for (unsigned m=0; m<outputLen; m++) {
+            channels[k].vec[m] = (*results)[m * numChannels + k];
+        }
+    }
+    return channels;
+}
+
+/**
+ * \brief Channelizes "data" into separate vectors for each channel.
+ *
+ * \param data The data to channelize.
+ * \param channels Resized to channelizer.numChannels vectors.  channels[k] is set to the new samples of channel "k".
+ * \param channelizer The channelizer to use.
+ * \return Reference to "channels".
+ */
+template <class T, class U, template <class> class Allocator>
+std::vector< ComplexVector<T, Allocator> > & channelize(const Vector<U, Allocator> & data,
+        std::vector< ComplexVector<T, Allocator> > & channels, PolyphaseChannelizer<T> & channelizer) {
+    return channelizer.channelize(data, channels);
+}
+
+};
+
+#endif
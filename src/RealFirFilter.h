@@ -32,17 +32,31 @@ THE SOFTWARE.
 
 #include <complex>
 #include <math.h>
+#include <type_traits>
 #include "RealVector.h"
 #include "ParksMcClellan.h"
+#include "SimdKernels.h"
+#include "ParallelFor.h"
 
 
 namespace NimbleDSP {
 
+/**
+ * \brief Default number of taps at which RealFirFilter::conv switches to FFT-based filtering.
+ */
+const unsigned DEFAULT_FAST_CONV_THRESHOLD = 64;
+
 /**
  * \brief Class for real FIR filters.
+ *
+ * A filter must not be used by more than one thread at a time, not even for one-shot filtering.  Besides the
+ * streaming state, filtering rewrites the cached copies of the taps (the polyphase taps and the FFT of the
+ * taps used by overlap-save) and the overlap-save work buffers.  Give each thread its own filter.  Setting
+ * \ref numThreads is fine: the caches are built on the calling thread before any worker starts, and the
+ * workers only read them.
  */
-template <class T>
-class RealFirFilter : public RealVector<T> {
+template <class T, template <class> class Allocator = std::allocator>
+class RealFirFilter : public RealVector<T, Allocator> {
  protected:
     /**
      * \brief Saved data that is used for stream filtering.
@@ -59,11 +73,179 @@ class RealFirFilter : public RealVector<T> {
      */
     int phase;
     
+    /**
+     * \brief FFT of the zero-padded taps.  Used for FFT-based (overlap-save) filtering.
+     */
+    std::vector< std::complex<T> > fastConvTapsFreq;
+    
+    /**
+     * \brief The taps' \ref generation when \ref fastConvTapsFreq was calculated.  Used to detect tap changes.
+     */
+    unsigned long long fastConvGeneration;
+    
+    /**
+     * \brief Time and frequency domain work buffers for \ref overlapSave.
+     */
+    std::vector< std::complex<T> > fastConvTimeBuf, fastConvFreqBuf;
+    
+    /**
+     * \brief The taps split into polyphase sub-filters for an interpolation rate of \ref polyphaseRate.
+     *
+     * Sub-filter p holds taps p, p + rate, p + 2*rate, etc. in reverse order, zero padded at the front to
+     * \ref polyphaseLen taps.  This lets every filter loop run forward through contiguous data and taps.  With
+     * a rate of 1 it is simply the taps in reverse order.  Kept current by \ref updatePolyphaseTaps.
+     */
+    std::vector<T> polyphaseTaps;
+    
+    /**
+     * \brief The taps' \ref generation when \ref polyphaseTaps was built.  Used to detect tap changes.
+     */
+    unsigned long long polyphaseGeneration;
+    
+    /**
+     * \brief The interpolation rate that \ref polyphaseTaps was built for.  0 if it hasn't been built.
+     */
+    int polyphaseRate;
+    
+    /**
+     * \brief Number of taps in each polyphase sub-filter.
+     */
+    int polyphaseLen;
+    
+    /**
+     * \brief Rebuilds \ref polyphaseTaps if the taps or the interpolation rate have changed.
+     *
+     * \param rate The interpolation rate.  1 for filtering without interpolation.
+     */
+    void updatePolyphaseTaps(int rate);
+    
+    /**
+     * \brief Calculates one filter output.
+     *
+     * Returns the sum of data[dataIndex + i] * taps[filterIndex - i*rate] for every i >= 0 where both indexes
+     * are in range, where "rate" is \ref polyphaseRate.  Uses the SIMD dot product kernels when they are
+     * available.  \ref polyphaseTaps must be current.
+     */
+    template <class U>
+    U filterPoint(const std::vector<U, Allocator<U> > & data, int dataIndex, int filterIndex) const {
+        assert(filterIndex >= 0 && filterIndex < (int) this->size());
+        int subFilterIndex = filterIndex / polyphaseRate;
+        int numPoints = std::min(subFilterIndex + 1, (int) data.size() - dataIndex);
+        if (numPoints <= 0)
+            return 0;
+        const T *subFilter = VECTOR_TO_ARRAY(polyphaseTaps) + (filterIndex % polyphaseRate) * polyphaseLen;
+        return dotProduct(VECTOR_TO_ARRAY(data) + dataIndex, subFilter + (polyphaseLen - 1 - subFilterIndex), numPoints);
+    }
+    
     /**
      * \brief Applies a Hamming window on the current contents of "this".
      */
     void hamming(void);
     
+    /**
+     * \brief Indicates whether conv should use FFT-based filtering instead of direct-form.
+     */
+    template <class U>
+    bool useFastConv() const {return std::is_floating_point<U>::value && fastConvThreshold > 0 &&
+                                      this->size() >= fastConvThreshold;}
+    
+    /**
+     * \brief Filters "input" using FFT-based overlap-save.
+     *
+     * Calculates output[i] = sum(taps[k] * input[i + numTaps - 1 - k]) for i = 0 to outputLen - 1.
+     * Input samples past "inputLen" are treated as zeros.
+     *
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.  It may not overlap "input".
+     * \param outputLen Number of results to calculate.
+     * \param threads Maximum number of threads to split the work across.
+     */
+    void overlapSave(const T *input, unsigned inputLen, T *output, unsigned outputLen, unsigned threads, std::true_type);
+    
+    /**
+     * \brief Overlap-save is only supported for real floating point data, so this is never called.
+     */
+    template <class U>
+    void overlapSave(const U *input, unsigned inputLen, U *output, unsigned outputLen, unsigned threads, std::false_type) {}
+    
+    /**
+     * \brief Does the overlap-save filtering for pairs of blocks "firstBlockPair" to "lastBlockPair" - 1.
+     *
+     * \ref fastConvTapsFreq must be current.  "timeBuf" and "freqBuf" are working buffers.
+     */
+    void overlapSaveBlocks(const T *input, unsigned inputLen, T *output, unsigned outputLen, unsigned fftLen,
+                           unsigned firstBlockPair, unsigned lastBlockPair, std::vector< std::complex<T> > &timeBuf,
+                           std::vector< std::complex<T> > &freqBuf) const;
+    
+    /**
+     * \brief Calculates results "begin" to "end" - 1 of a one-shot filter operation.
+     *
+     * Result k is point k*decimateRate + offset of the full convolution of the taps with "data" upsampled
+     * by \ref polyphaseRate.  Each result is calculated on its own, so the results don't depend on how
+     * the range is split up.  \ref polyphaseTaps must be current.
+     */
+    template <class U>
+    void oneShotPoints(const std::vector<U, Allocator<U> > & data, U *output, unsigned begin, unsigned end,
+                       int decimateRate, int offset) const {
+        for (unsigned resultIndex=begin; resultIndex<end; resultIndex++) {
+            int convIndex = resultIndex * decimateRate + offset;
+            int dataIndex = 0;
+            if (convIndex >= (int) this->size()) {
+                // Skip the data samples that the filter has already passed.
+                dataIndex = (convIndex - (int) this->size() + polyphaseRate) / polyphaseRate;
+            }
+            output[resultIndex] = filterPoint(data, dataIndex, convIndex - dataIndex * polyphaseRate);
+        }
+    }
+    
+    /**
+     * \brief Calculates all "outputLen" results of a one-shot filter operation, using up to \ref numThreads threads.
+     *
+     * See \ref oneShotPoints.
+     */
+    template <class U>
+    void oneShotFilter(const std::vector<U, Allocator<U> > & data, U *output, unsigned outputLen, int decimateRate, int offset) {
+        parallelFor(outputLen, numThreads, DEFAULT_PARALLEL_MIN_BLOCK_LEN,
+                    [&](unsigned begin, unsigned end) {oneShotPoints(data, output, begin, end, decimateRate, offset);});
+    }
+    
+    /**
+     * \brief Does the work of both \ref conv methods.  "U" is T for real data and std::complex<T> for complex data.
+     *
+     * "input" is copied into "dataTmp" before any results are written, so "input" and "output" may be the same buffer.
+     *
+     * \param dataTmp Working buffer.  Holds the saved samples followed by the input while filtering.
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.
+     * \param outputCapacity Number of samples that "output" can hold.
+     * \return The number of samples written to "output".
+     */
+    template <class U>
+    unsigned convData(std::vector<U, Allocator<U> > & dataTmp, const U *input, unsigned inputLen, U *output, unsigned outputCapacity);
+    
+    /**
+     * \brief Does the work of the decimate methods.  See \ref convData.
+     */
+    template <class U>
+    unsigned decimateData(std::vector<U, Allocator<U> > & dataTmp, const U *input, unsigned inputLen, U *output,
+                          unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Does the work of the interp methods.  See \ref convData.
+     */
+    template <class U>
+    unsigned interpData(std::vector<U, Allocator<U> > & dataTmp, const U *input, unsigned inputLen, U *output,
+                        unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Does the work of the resample methods.  See \ref convData.
+     */
+    template <class U>
+    unsigned resampleData(std::vector<U, Allocator<U> > & dataTmp, const U *input, unsigned inputLen, U *output,
+                          unsigned outputCapacity, int interpRate, int decimateRate);
+    
  public:
     /**
      * \brief Determines how the filter should filter.
@@ -74,6 +256,24 @@ class RealFirFilter : public RealVector<T> {
      *      filtered one continuous set of data.
      */
     FilterOperationType filtOperation;
+    
+    /**
+     * \brief Number of taps at which \ref conv switches from direct-form to FFT-based filtering.
+     *
+     * FFT-based (overlap-save) filtering is much faster for long filters, and produces the same
+     * results to within floating point tolerance.  It is only used for floating point filters.
+     * Setting it to 0 disables FFT-based filtering.  Defaults to NimbleDSP::DEFAULT_FAST_CONV_THRESHOLD.
+     */
+    unsigned fastConvThreshold;
+    
+    /**
+     * \brief Maximum number of threads that the one-shot filter operations can use.
+     *
+     * Long one-shot inputs are split into blocks that are filtered in parallel.  The results are identical to
+     * filtering on one thread.  Streaming operations always run on the calling thread.  Defaults to 1.  This
+     *      doesn't make the filter object itself safe to share between threads.
+     */
+    unsigned numThreads;
 
     /*****************************************************************************************
                                         Constructors
@@ -87,12 +287,14 @@ class RealFirFilter : public RealVector<T> {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
-    RealFirFilter<T>(unsigned size = DEFAULT_BUF_LEN, FilterOperationType operation = STREAMING, std::vector<T> *scratch = NULL) : RealVector<T>(size, scratch)
+    RealFirFilter<T, Allocator>(unsigned size = DEFAULT_BUF_LEN, FilterOperationType operation = STREAMING, std::vector<T, Allocator<T> > *scratch = NULL) : RealVector<T, Allocator>(size, scratch)
             {if (size > 0) {savedData.resize((size - 1) * sizeof(std::complex<T>)); numSavedSamples = size - 1;}
-             else {savedData.resize(0); numSavedSamples = 0;} phase = 0; filtOperation = operation;}
+             else {savedData.resize(0); numSavedSamples = 0;} phase = 0; filtOperation = operation;
+             fastConvThreshold = DEFAULT_FAST_CONV_THRESHOLD;
+             polyphaseRate = 0; polyphaseGeneration = fastConvGeneration = 0; numThreads = 1;}
     
     /**
      * \brief Vector constructor.
@@ -104,12 +306,14 @@ class RealFirFilter : public RealVector<T> {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
     template <typename U>
-    RealFirFilter<T>(std::vector<U> data, FilterOperationType operation = STREAMING, std::vector<T> *scratch = NULL) : RealVector<T>(data, scratch)
-            {savedData.resize((data.size() - 1) * sizeof(std::complex<T>)); numSavedSamples = data.size() - 1; phase = 0; filtOperation = operation;}
+    RealFirFilter<T, Allocator>(const std::vector<U> & data, FilterOperationType operation = STREAMING, std::vector<T, Allocator<T> > *scratch = NULL) : RealVector<T, Allocator>(data, scratch)
+            {savedData.resize((data.size() - 1) * sizeof(std::complex<T>)); numSavedSamples = data.size() - 1; phase = 0; filtOperation = operation;
+             fastConvThreshold = DEFAULT_FAST_CONV_THRESHOLD;
+             polyphaseRate = 0; polyphaseGeneration = fastConvGeneration = 0; numThreads = 1;}
     
     /**
      * \brief Array constructor.
@@ -122,18 +326,42 @@ class RealFirFilter : public RealVector<T> {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
     template <typename U>
-    RealFirFilter<T>(U *data, unsigned dataLen, FilterOperationType operation = STREAMING, std::vector<T> *scratch = NULL) : RealVector<T>(data, dataLen, scratch)
-            {savedData.resize((dataLen - 1) * sizeof(std::complex<T>)); numSavedSamples = dataLen - 1; phase = 0; filtOperation = operation;}
+    RealFirFilter<T, Allocator>(U *data, unsigned dataLen, FilterOperationType operation = STREAMING, std::vector<T, Allocator<T> > *scratch = NULL) : RealVector<T, Allocator>(data, dataLen, scratch)
+            {savedData.resize((dataLen - 1) * sizeof(std::complex<T>)); numSavedSamples = dataLen - 1; phase = 0; filtOperation = operation;
+             fastConvThreshold = DEFAULT_FAST_CONV_THRESHOLD;
+             polyphaseRate = 0; polyphaseGeneration = fastConvGeneration = 0; numThreads = 1;}
+    
+    /**
+     * \brief Adopting vector constructor.
+     *
+     * Takes over the storage of "data" instead of copying it, e.g. "RealFirFilter<double> filt(std::move(taps));".
+     * \param data The filter taps.  It is left empty.
+     * \param operation Determines how the filter filters.  See \ref filtOperation.
+     * \param scratch Pointer to a scratch buffer.  See the basic constructor.
+     */
+    RealFirFilter<T, Allocator>(std::vector<T, Allocator<T> > && data, FilterOperationType operation = STREAMING, std::vector<T, Allocator<T> > *scratch = NULL) : RealVector<T, Allocator>(std::move(data), scratch)
+            {savedData.resize((this->size() - 1) * sizeof(std::complex<T>)); numSavedSamples = this->size() - 1; phase = 0; filtOperation = operation;
+             fastConvThreshold = DEFAULT_FAST_CONV_THRESHOLD;
+             polyphaseRate = 0; polyphaseGeneration = fastConvGeneration = 0; numThreads = 1;}
     
     /**
      * \brief Copy constructor.
      */
-    RealFirFilter<T>(const RealFirFilter<T>& other) {this->vec = other.vec; savedData = other.savedData;
-            numSavedSamples = other.numSavedSamples; phase = other.phase; filtOperation = other.filtOperation;}
+    RealFirFilter<T, Allocator>(const RealFirFilter<T, Allocator>& other) {this->vec = other.vec; savedData = other.savedData;
+            numSavedSamples = other.numSavedSamples; phase = other.phase; filtOperation = other.filtOperation;
+            fastConvThreshold = other.fastConvThreshold; polyphaseRate = 0;
+            polyphaseGeneration = fastConvGeneration = 0; numThreads = other.numThreads;}
+    
+    /**
+     * \brief Move constructor.
+     *
+     * Takes over the taps, the filter state, and the cached FFT and polyphase versions of the taps from "other".
+     */
+    RealFirFilter<T, Allocator>(RealFirFilter<T, Allocator>&& other) = default;
     
     /*****************************************************************************************
                                             Operators
@@ -141,7 +369,17 @@ class RealFirFilter : public RealVector<T> {
     /**
      * \brief Assignment operator.
      */
-    RealFirFilter<T>& operator=(const Vector<T>& rhs) {this->vec = rhs.vec; savedData.resize(this->size() - 1); phase = 0; filtOperation = STREAMING; return *this;}
+    RealFirFilter<T, Allocator>& operator=(const Vector<T, Allocator>& rhs) {this->vec = rhs.vec; this->modified(); savedData.resize(this->size() - 1); phase = 0; filtOperation = STREAMING; return *this;}
+    
+    /**
+     * \brief Copy assignment operator.
+     */
+    RealFirFilter<T, Allocator>& operator=(const RealFirFilter<T, Allocator>& rhs) = default;
+    
+    /**
+     * \brief Move assignment operator.  See the move constructor.
+     */
+    RealFirFilter<T, Allocator>& operator=(RealFirFilter<T, Allocator>&& rhs) = default;
     
     /*****************************************************************************************
                                             Methods
@@ -154,7 +392,7 @@ class RealFirFilter : public RealVector<T> {
      *      \ref filtOperation is set.
      * \return Reference to "data", which holds the result of the convolution.
      */
-    virtual RealVector<T> & conv(RealVector<T> & data, bool trimTails = false);
+    virtual RealVector<T, Allocator> & conv(RealVector<T, Allocator> & data, bool trimTails = false);
     
     /**
      * \brief Convolution method for complex data.
@@ -164,7 +402,7 @@ class RealFirFilter : public RealVector<T> {
      *      \ref filtOperation is set.
      * \return Reference to "data", which holds the result of the convolution.
      */
-    virtual ComplexVector<T> & convComplex(ComplexVector<T> & data, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & convComplex(ComplexVector<T, Allocator> & data, bool trimTails = false);
     
     /**
      * \brief Decimate method.
@@ -178,7 +416,7 @@ class RealFirFilter : public RealVector<T> {
      *      \ref filtOperation is set.
      * \return Reference to "data", which holds the result of the decimation.
      */
-    virtual RealVector<T> & decimate(RealVector<T> & data, int rate, bool trimTails = false);
+    virtual RealVector<T, Allocator> & decimate(RealVector<T, Allocator> & data, int rate, bool trimTails = false);
     
     /**
      * \brief Decimate method for complex data.
@@ -192,7 +430,7 @@ class RealFirFilter : public RealVector<T> {
      *      \ref filtOperation is set.
      * \return Reference to "data", which holds the result of the decimation.
      */
-    virtual ComplexVector<T> & decimateComplex(ComplexVector<T> & data, int rate, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & decimateComplex(ComplexVector<T, Allocator> & data, int rate, bool trimTails = false);
     
     /**
      * \brief Interpolation method.
@@ -205,7 +443,7 @@ class RealFirFilter : public RealVector<T> {
      *      \ref filtOperation is set.
      * \return Reference to "data", which holds the result of the interpolation.
      */
-    virtual RealVector<T> & interp(RealVector<T> & data, int rate, bool trimTails = false);
+    virtual RealVector<T, Allocator> & interp(RealVector<T, Allocator> & data, int rate, bool trimTails = false);
     
     /**
      * \brief Interpolation method for complex data.
@@ -218,7 +456,7 @@ class RealFirFilter : public RealVector<T> {
      *      \ref filtOperation is set.
      * \return Reference to "data", which holds the result of the interpolation.
      */
-    virtual ComplexVector<T> & interpComplex(ComplexVector<T> & data, int rate, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & interpComplex(ComplexVector<T, Allocator> & data, int rate, bool trimTails = false);
     
     /**
      * \brief Resample method.
@@ -233,7 +471,7 @@ class RealFirFilter : public RealVector<T> {
      *      \ref filtOperation is set.
      * \return Reference to "data", which holds the result of the resampling.
      */
-    virtual RealVector<T> & resample(RealVector<T> & data, int interpRate, int decimateRate, bool trimTails = false);
+    virtual RealVector<T, Allocator> & resample(RealVector<T, Allocator> & data, int interpRate, int decimateRate, bool trimTails = false);
     
     /**
      * \brief Resample method for complex data.
@@ -248,7 +486,127 @@ class RealFirFilter : public RealVector<T> {
      *      \ref filtOperation is set.
      * \return Reference to "data", which holds the result of the resampling.
      */
-    virtual ComplexVector<T> & resampleComplex(ComplexVector<T> & data, int interpRate, int decimateRate, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & resampleComplex(ComplexVector<T, Allocator> & data, int interpRate, int decimateRate, bool trimTails = false);
+    
+    /**
+     * \brief Convolution method that reads from "input" and writes the results to "output".
+     *
+     * Filters the same way as the in-place \ref conv method, but no memory is allocated once the
+     * thread's scratch buffers (see ScratchArena.h) have grown to their working size.  Use \ref convOutputLength to
+     * find out how big "output" needs to be.
+     *
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.  It may be the same buffer as "input".
+     * \param outputCapacity Number of samples that "output" can hold.
+     * \return The number of samples written to "output".
+     */
+    unsigned conv(const T *input, unsigned inputLen, T *output, unsigned outputCapacity);
+    
+    /**
+     * \brief Convolution method for complex data that reads from "input" and writes the results to "output".
+     *
+     * See the real data version of this method.
+     */
+    unsigned conv(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output, unsigned outputCapacity);
+    
+    /**
+     * \brief Convolution method that filters the samples that "data" refers to in place.
+     *
+     * A view can't be resized, so only the operations that produce one result per input sample
+     * (NimbleDSP::STREAMING and NimbleDSP::ONE_SHOT_TRIM_TAILS) can be used.
+     *
+     * \param data The data to filter.
+     * \return "data", which refers to the results.
+     */
+    VectorView<T> conv(VectorView<T> data);
+    
+    /**
+     * \brief Convolution method that filters the complex samples that "data" refers to in place.
+     *
+     * See the real data version of this method.
+     */
+    VectorView< std::complex<T> > conv(VectorView< std::complex<T> > data);
+    
+    /**
+     * \brief Decimate method that reads from "input" and writes the results to "output".
+     *
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.  It may be the same buffer as "input".
+     * \param outputCapacity Number of samples that "output" can hold.  See \ref decimateOutputLength.
+     * \param rate Indicates how much to downsample.
+     * \return The number of samples written to "output".
+     */
+    unsigned decimate(const T *input, unsigned inputLen, T *output, unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Decimate method for complex data that reads from "input" and writes the results to "output".
+     */
+    unsigned decimate(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                      unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Interpolation method that reads from "input" and writes the results to "output".
+     *
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.  It may be the same buffer as "input".
+     * \param outputCapacity Number of samples that "output" can hold.  See \ref interpOutputLength.
+     * \param rate Indicates how much to upsample.
+     * \return The number of samples written to "output".
+     */
+    unsigned interp(const T *input, unsigned inputLen, T *output, unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Interpolation method for complex data that reads from "input" and writes the results to "output".
+     */
+    unsigned interp(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                    unsigned outputCapacity, int rate);
+    
+    /**
+     * \brief Resample method that reads from "input" and writes the results to "output".
+     *
+     * \param input The data to filter.
+     * \param inputLen Number of samples in "input".
+     * \param output Buffer to put the results in.  It may be the same buffer as "input".
+     * \param outputCapacity Number of samples that "output" can hold.  See \ref resampleOutputLength.
+     * \param interpRate Indicates how much to upsample.
+     * \param decimateRate Indicates how much to downsample.
+     * \return The number of samples written to "output".
+     */
+    unsigned resample(const T *input, unsigned inputLen, T *output, unsigned outputCapacity,
+                      int interpRate, int decimateRate);
+    
+    /**
+     * \brief Resample method for complex data that reads from "input" and writes the results to "output".
+     */
+    unsigned resample(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                      unsigned outputCapacity, int interpRate, int decimateRate);
+    
+    /**
+     * \brief Returns the number of results the next call to \ref conv will produce for "inputLen" samples.
+     */
+    unsigned convOutputLength(unsigned inputLen) const;
+    
+    /**
+     * \brief Returns the number of results the next call to \ref decimate will produce for "inputLen" samples.
+     */
+    unsigned decimateOutputLength(unsigned inputLen, int rate) const;
+    
+    /**
+     * \brief Returns the maximum number of results the next call to \ref interp can produce for "inputLen" samples.
+     *
+     * When streaming, the first call can produce fewer results than this.
+     */
+    unsigned interpOutputLength(unsigned inputLen, int rate) const;
+    
+    /**
+     * \brief Returns the maximum number of results the next call to \ref resample can produce for "inputLen" samples.
+     *
+     * When streaming, the exact number depends on the filter phase.
+     */
+    unsigned resampleOutputLength(unsigned inputLen, int interpRate, int decimateRate) const;
     
     /**
      * \brief Parks-McClellan algorithm for generating equiripple FIR filter coefficients.
@@ -300,7 +658,7 @@ class RealFirFilter : public RealVector<T> {
      * \param data The buffer that will be correlated.
      * \return Reference to "data", which holds the result of the convolution.
      */
-    virtual RealVector<T> & corr(RealVector<T> & data);
+    virtual RealVector<T, Allocator> & corr(RealVector<T, Allocator> & data);
     
     /**
      * \brief Generates a Hamming window.
@@ -342,450 +700,355 @@ class RealFirFilter : public RealVector<T> {
 };
 
 
-template <class T>
-RealVector<T> & RealFirFilter<T>::conv(RealVector<T> & data, bool trimTails) {
-    int resultIndex;
-    int filterIndex;
-    int dataIndex;
-    std::vector<T> scratch;
-    std::vector<T> *dataTmp;
-    T *savedDataArray = (T *) VECTOR_TO_ARRAY(savedData);
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
+template <class T, template <class> class Allocator>
+void RealFirFilter<T, Allocator>::updatePolyphaseTaps(int rate) {
+    assert(rate > 0);
+    if (rate == polyphaseRate && polyphaseGeneration == this->generation)
+        return;
+    
+    polyphaseRate = rate;
+    polyphaseGeneration = this->generation;
+    polyphaseLen = (this->size() + rate - 1) / rate;
+    polyphaseTaps.assign(rate * polyphaseLen, 0);
+    for (int subFilter=0; subFilter<rate; subFilter++) {
+        T *subFilterTaps = VECTOR_TO_ARRAY(polyphaseTaps) + subFilter * polyphaseLen;
+        for (int tap=0; subFilter + tap*rate < (int) this->size(); tap++) {
+            subFilterTaps[polyphaseLen - 1 - tap] = this->vec[subFilter + tap*rate];
+        }
     }
-    else {
-        dataTmp = data.scratchBuf;
+}
+
+template <class T, template <class> class Allocator>
+unsigned RealFirFilter<T, Allocator>::convOutputLength(unsigned inputLen) const {
+    if (filtOperation == ONE_SHOT_RETURN_ALL_RESULTS)
+        return inputLen + this->size() - 1;
+    return inputLen;
+}
+
+template <class T, template <class> class Allocator>
+unsigned RealFirFilter<T, Allocator>::decimateOutputLength(unsigned inputLen, int rate) const {
+    switch (filtOperation) {
+    case STREAMING:
+        return (inputLen + numSavedSamples - (this->size() - 1) + rate - 1) / rate;
+    case ONE_SHOT_RETURN_ALL_RESULTS:
+        return ((inputLen + this->size() - 1) + (rate - 1)) / rate;
+    default:
+        return (inputLen + rate - 1) / rate;
     }
+}
+
+template <class T, template <class> class Allocator>
+unsigned RealFirFilter<T, Allocator>::interpOutputLength(unsigned inputLen, int rate) const {
+    if (filtOperation == ONE_SHOT_RETURN_ALL_RESULTS)
+        return inputLen * rate + this->size() - 1 - (rate - 1);
+    return inputLen * rate;
+}
+
+template <class T, template <class> class Allocator>
+unsigned RealFirFilter<T, Allocator>::resampleOutputLength(unsigned inputLen, int interpRate, int decimateRate) const {
+    unsigned interpLen = interpOutputLength(inputLen, interpRate);
+    return (interpLen + decimateRate - 1) / decimateRate;
+}
+
+template <class T, template <class> class Allocator>
+template <class U>
+unsigned RealFirFilter<T, Allocator>::convData(std::vector<U, Allocator<U> > & dataTmp, const U *input, unsigned inputLen,
+                                    U *output, unsigned outputCapacity) {
+    int resultIndex;
+    U *savedDataArray = (U *) VECTOR_TO_ARRAY(savedData);
+    unsigned outputLen = convOutputLength(inputLen);
+    
+    assert(outputCapacity >= outputLen);
+    updatePolyphaseTaps(1);
 
     switch (filtOperation) {
 
     case STREAMING:
-        dataTmp->resize((this->size() - 1) + data.size());
+        dataTmp.resize((this->size() - 1) + inputLen);
         for (int i=0; i<this->size()-1; i++) {
-            (*dataTmp)[i] = savedDataArray[i];
+            dataTmp[i] = savedDataArray[i];
         }
-        for (int i=0; i<data.size(); i++) {
-            (*dataTmp)[i + this->size() - 1] = data[i];
+        for (int i=0; i<inputLen; i++) {
+            dataTmp[i + this->size() - 1] = input[i];
         }
         
-        for (resultIndex=0; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex, filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+        if (useFastConv<U>()) {
+            overlapSave(VECTOR_TO_ARRAY(dataTmp), (unsigned) dataTmp.size(), output, outputLen, 1,
+                        typename std::is_floating_point<U>::type());
+        }
+        else {
+            for (resultIndex=0; resultIndex<(int)outputLen; resultIndex++) {
+                output[resultIndex] = filterPoint(dataTmp, resultIndex, this->size()-1);
             }
         }
         for (int i=0; i<this->size()-1; i++) {
-            savedDataArray[i] = (*dataTmp)[i + data.size()];
+            savedDataArray[i] = dataTmp[i + inputLen];
         }
         break;
 
     case ONE_SHOT_RETURN_ALL_RESULTS:
-        *dataTmp = data.vec;
-        data.resize(data.size() + this->size() - 1);
-        
-        // Initial partial overlap
-        for (resultIndex=0; resultIndex<(int)this->size()-1; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=resultIndex; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<(int)dataTmp->size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex - (this->size()-1), filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex - (this->size()-1), filterIndex=this->size()-1;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
+        if (useFastConv<U>()) {
+            // Prepend this->size()-1 zeros so that overlap-save produces the leading partial overlap too.
+            dataTmp.assign(this->size() - 1, 0);
+            dataTmp.insert(dataTmp.end(), input, input + inputLen);
+            overlapSave(VECTOR_TO_ARRAY(dataTmp), (unsigned) dataTmp.size(), output, outputLen, numThreads,
+                        typename std::is_floating_point<U>::type());
+            break;
+        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, 1, 0);
         break;
 
     case ONE_SHOT_TRIM_TAILS:
-        *dataTmp = data.vec;
-
-        // Initial partial overlap
         int initialTrim = (this->size() - 1) / 2;
-        for (resultIndex=0; resultIndex<((int)this->size()-1) - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=initialTrim + resultIndex; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<(int)dataTmp->size() - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
+        if (useFastConv<U>()) {
+            // Prepend zeros so that the first result is the one "initialTrim" samples into the full convolution.
+            dataTmp.assign(this->size() - 1 - initialTrim, 0);
+            dataTmp.insert(dataTmp.end(), input, input + inputLen);
+            overlapSave(VECTOR_TO_ARRAY(dataTmp), (unsigned) dataTmp.size(), output, outputLen, numThreads,
+                        typename std::is_floating_point<U>::type());
+            break;
+        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, 1, initialTrim);
         break;
     }
+    return outputLen;
+}
+
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealFirFilter<T, Allocator>::conv(RealVector<T, Allocator> & data, bool trimTails) {
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(data.scratchBuf, data.size() + this->size());
+    unsigned inputLen = data.size();
+    
+    // The input is copied into dataTmp before any results are written, so the filtering can be done in place.
+    data.resize(std::max(inputLen, convOutputLength(inputLen)));
+    data.resize(convData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size()));
     return data;
 }
 
-template <class T>
-ComplexVector<T> & RealFirFilter<T>::convComplex(ComplexVector<T> & data, bool trimTails) {
-    int resultIndex;
-    int filterIndex;
-    int dataIndex;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    std::complex<T> *savedDataArray = (std::complex<T> *) VECTOR_TO_ARRAY(savedData);
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & RealFirFilter<T, Allocator>::convComplex(ComplexVector<T, Allocator> & data, bool trimTails) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size() + this->size());
+    unsigned inputLen = data.size();
+    
+    data.resize(std::max(inputLen, convOutputLength(inputLen)));
+    data.resize(convData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size()));
+    return data;
+}
 
-    switch (filtOperation) {
+template <class T, template <class> class Allocator>
+unsigned RealFirFilter<T, Allocator>::conv(const T *input, unsigned inputLen, T *output, unsigned outputCapacity) {
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(NULL, inputLen + this->size());
+    return convData(*dataTmp, input, inputLen, output, outputCapacity);
+}
 
-    case STREAMING:
-        dataTmp->resize((this->size() - 1) + data.size());
-        for (int i=0; i<this->size()-1; i++) {
-            (*dataTmp)[i] = savedDataArray[i];
-        }
-        for (int i=0; i<data.size(); i++) {
-            (*dataTmp)[i + this->size() - 1] = data[i];
-        }
-        
-        for (resultIndex=0; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex, filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        for (int i=0; i<this->size()-1; i++) {
-            savedDataArray[i] = (*dataTmp)[i + data.size()];
-        }
-        break;
+template <class T, template <class> class Allocator>
+unsigned RealFirFilter<T, Allocator>::conv(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                                unsigned outputCapacity) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(NULL, inputLen + this->size());
+    return convData(*dataTmp, input, inputLen, output, outputCapacity);
+}
 
-    case ONE_SHOT_RETURN_ALL_RESULTS:
-        *dataTmp = data.vec;
-        data.resize(data.size() + this->size() - 1);
-        
-        // Initial partial overlap
-        for (resultIndex=0; resultIndex<(int)this->size()-1; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=resultIndex; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<(int)dataTmp->size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex - (this->size()-1), filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
+template <class T, template <class> class Allocator>
+VectorView<T> RealFirFilter<T, Allocator>::conv(VectorView<T> data) {
+    assert(convOutputLength(data.size()) == data.size());
+    processContiguous(data, [this](T *samples, unsigned len) {this->conv(samples, len, samples, len);});
+    return data;
+}
 
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex - (this->size()-1), filterIndex=this->size()-1;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        break;
+template <class T, template <class> class Allocator>
+VectorView< std::complex<T> > RealFirFilter<T, Allocator>::conv(VectorView< std::complex<T> > data) {
+    assert(convOutputLength(data.size()) == data.size());
+    processContiguous(data, [this](std::complex<T> *samples, unsigned len) {this->conv(samples, len, samples, len);});
+    return data;
+}
 
-    case ONE_SHOT_TRIM_TAILS:
-        *dataTmp = data.vec;
+/**
+ * \brief Convolution function that filters the samples that "data" refers to in place.  See RealFirFilter::conv.
+ */
+template <class T, template <class> class Allocator>
+inline VectorView<T> conv(VectorView<T> data, RealFirFilter<T, Allocator> & filter) {
+    return filter.conv(data);
+}
 
-        // Initial partial overlap
-        int initialTrim = (this->size() - 1) / 2;
-        for (resultIndex=0; resultIndex<((int)this->size()-1) - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=initialTrim + resultIndex; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<(int)dataTmp->size() - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
+/**
+ * \brief Convolution function that filters the complex samples that "data" refers to in place.
+ */
+template <class T, template <class> class Allocator>
+inline VectorView< std::complex<T> > conv(VectorView< std::complex<T> > data, RealFirFilter<T, Allocator> & filter) {
+    return filter.conv(data);
+}
+
+template <class T, template <class> class Allocator>
+void RealFirFilter<T, Allocator>::overlapSave(const T *input, unsigned inputLen, T *output, unsigned outputLen,
+                                   unsigned threads, std::true_type) {
+    unsigned numTaps = this->size();
+
+    // Use an FFT size of about 4 times the number of taps, unless there isn't that much data.
+    unsigned fftLen = 1;
+    while (fftLen < 4 * numTaps)
+        fftLen <<= 1;
+    while (fftLen / 2 >= outputLen + numTaps - 1 && fftLen / 2 >= numTaps)
+        fftLen >>= 1;
+    unsigned blockLen = fftLen - (numTaps - 1);
+
+    if (fastConvTapsFreq.size() != fftLen || fastConvGeneration != this->generation) {
+        fastConvGeneration = this->generation;
+        fastConvTapsFreq.assign(fftLen, 0);
+        for (unsigned i=0; i<numTaps; i++) {
+            fastConvTapsFreq[i] = this->vec[i];
+        }
+        getFftPlan<T>(fftLen, false).transformInPlace(fastConvTapsFreq);
+        // Fold the inverse FFT scaling into the taps
+        for (unsigned i=0; i<fftLen; i++) {
+            fastConvTapsFreq[i] /= (T) fftLen;
         }
+    }
 
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
+    unsigned numBlockPairs = (outputLen + 2*blockLen - 1) / (2*blockLen);
+    if (threads <= 1) {
+        overlapSaveBlocks(input, inputLen, output, outputLen, fftLen, 0, numBlockPairs, fastConvTimeBuf, fastConvFreqBuf);
+        return;
+    }
+    
+    // Every thread filters whole blocks, exactly as the single threaded loop would, so the results are identical.
+    parallelFor(numBlockPairs, threads, std::max(1u, DEFAULT_PARALLEL_MIN_BLOCK_LEN / (2*blockLen)),
+                [&](unsigned begin, unsigned end) {
+                    std::vector< std::complex<T> > timeBuf, freqBuf;
+                    overlapSaveBlocks(input, inputLen, output, outputLen, fftLen, begin, end, timeBuf, freqBuf);
+                });
+}
+
+template <class T, template <class> class Allocator>
+void RealFirFilter<T, Allocator>::overlapSaveBlocks(const T *input, unsigned inputLen, T *output, unsigned outputLen, unsigned fftLen,
+                                         unsigned firstBlockPair, unsigned lastBlockPair,
+                                         std::vector< std::complex<T> > &timeBuf,
+                                         std::vector< std::complex<T> > &freqBuf) const {
+    unsigned numTaps = this->size();
+    unsigned blockLen = fftLen - (numTaps - 1);
+    FftPlan<T> & fftPlan = getFftPlan<T>(fftLen, false);
+    FftPlan<T> & ifftPlan = getFftPlan<T>(fftLen, true);
+    timeBuf.resize(fftLen);
+    freqBuf.resize(fftLen);
+
+    // The taps are real, so two blocks are filtered at once by putting one in the real part of the FFT
+    // input and the other in the imaginary part.
+    for (unsigned blockPair=firstBlockPair; blockPair<lastBlockPair; blockPair++) {
+        unsigned outputStart = blockPair * 2*blockLen;
+        unsigned secondStart = outputStart + blockLen;
+        for (unsigned i=0; i<fftLen; i++) {
+            T re = (outputStart + i < inputLen) ? input[outputStart + i] : 0;
+            T im = (secondStart + i < inputLen) ? input[secondStart + i] : 0;
+            timeBuf[i] = std::complex<T>(re, im);
+        }
+        fftPlan.transform(VECTOR_TO_ARRAY(timeBuf), VECTOR_TO_ARRAY(freqBuf));
+        for (unsigned i=0; i<fftLen; i++) {
+            freqBuf[i] *= fastConvTapsFreq[i];
+        }
+        ifftPlan.transform(VECTOR_TO_ARRAY(freqBuf), VECTOR_TO_ARRAY(timeBuf));
+
+        // The first numTaps-1 results of each block are corrupted by circular wrap-around, so discard them.
+        for (unsigned i=0; i<blockLen && outputStart + i < outputLen; i++) {
+            output[outputStart + i] = timeBuf[numTaps - 1 + i].real();
+        }
+        for (unsigned i=0; i<blockLen && secondStart + i < outputLen; i++) {
+            output[secondStart + i] = timeBuf[numTaps - 1 + i].imag();
         }
-        break;
     }
-    return data;
 }
 
-template <class T>
-RealVector<T> & RealFirFilter<T>::decimate(RealVector<T> & data, int rate, bool trimTails) {
+template <class T, template <class> class Allocator>
+template <class U>
+unsigned RealFirFilter<T, Allocator>::decimateData(std::vector<U, Allocator<U> > & dataTmp, const U *input, unsigned inputLen,
+                                        U *output, unsigned outputCapacity, int rate) {
     int resultIndex;
-    int filterIndex;
-    int dataIndex;
-    std::vector<T> scratch;
-    std::vector<T> *dataTmp;
-    T *savedDataArray = (T *) VECTOR_TO_ARRAY(savedData);
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    U *savedDataArray = (U *) VECTOR_TO_ARRAY(savedData);
+    unsigned outputLen = decimateOutputLength(inputLen, rate);
+    
+    assert(outputCapacity >= outputLen);
+    updatePolyphaseTaps(1);
 
     switch (filtOperation) {
 
     case STREAMING: {
-        dataTmp->resize(numSavedSamples + data.size());
+        dataTmp.resize(numSavedSamples + inputLen);
         for (int i=0; i<numSavedSamples; i++) {
-            (*dataTmp)[i] = savedDataArray[i];
+            dataTmp[i] = savedDataArray[i];
         }
-        for (int i=0; i<data.size(); i++) {
-            (*dataTmp)[i + numSavedSamples] = data[i];
+        for (int i=0; i<inputLen; i++) {
+            dataTmp[i + numSavedSamples] = input[i];
         }
         
-        data.resize((data.size() + numSavedSamples - (this->size() - 1) + rate - 1)/rate);
-        for (resultIndex=0; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate, filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
+        for (resultIndex=0; resultIndex<(int)outputLen; resultIndex++) {
+            output[resultIndex] = filterPoint(dataTmp, resultIndex*rate, this->size()-1);
         }
         int nextResultDataPoint = resultIndex * rate;
-        numSavedSamples = (unsigned) dataTmp->size() - nextResultDataPoint;
+        numSavedSamples = (unsigned) dataTmp.size() - nextResultDataPoint;
 
         for (int i=0; i<numSavedSamples; i++) {
-            savedDataArray[i] = (*dataTmp)[i + nextResultDataPoint];
+            savedDataArray[i] = dataTmp[i + nextResultDataPoint];
         }
         }
         break;
 
     case ONE_SHOT_RETURN_ALL_RESULTS:
-        *dataTmp = data.vec;
-        data.resize(((data.size() + this->size() - 1) + (rate - 1)) / rate);
-        
-        // Initial partial overlap
-        for (resultIndex=0; resultIndex<((int)this->size()-1+rate-1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=resultIndex*rate; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<((int)dataTmp->size()+rate-1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate - (this->size()-1), filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate - (this->size()-1), filterIndex=this->size()-1;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, rate, 0);
         break;
 
     case ONE_SHOT_TRIM_TAILS:
-        *dataTmp = data.vec;
-        data.resize((data.size() + rate - 1) / rate);
-        
-        // Initial partial overlap
-        int initialTrim = (this->size() - 1) / 2;
-        for (resultIndex=0; resultIndex<(((int)this->size()-1) - initialTrim + rate - 1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=initialTrim + resultIndex*rate; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<((int)dataTmp->size() - initialTrim + rate - 1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, rate, (this->size() - 1) / 2);
         break;
     }
-    return data;
+    return outputLen;
 }
 
-template <class T>
-ComplexVector<T> & RealFirFilter<T>::decimateComplex(ComplexVector<T> & data, int rate, bool trimTails) {
-    int resultIndex;
-    int filterIndex;
-    int dataIndex;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    std::complex<T> *savedDataArray = (std::complex<T> *) VECTOR_TO_ARRAY(savedData);
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
-
-    switch (filtOperation) {
-
-    case STREAMING: {
-        dataTmp->resize(numSavedSamples + data.size());
-        for (int i=0; i<numSavedSamples; i++) {
-            (*dataTmp)[i] = savedDataArray[i];
-        }
-        for (int i=0; i<data.size(); i++) {
-            (*dataTmp)[i + numSavedSamples] = data[i];
-        }
-        
-        data.resize((data.size() + numSavedSamples - (this->size() - 1) + rate - 1)/rate);
-        for (resultIndex=0; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate, filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        int nextResultDataPoint = resultIndex * rate;
-        numSavedSamples = ((int) dataTmp->size()) - nextResultDataPoint;
-
-        for (int i=0; i<numSavedSamples; i++) {
-            savedDataArray[i] = (*dataTmp)[i + nextResultDataPoint];
-        }
-        }
-        break;
-
-    case ONE_SHOT_RETURN_ALL_RESULTS:
-        *dataTmp = data.vec;
-        data.resize(((data.size() + this->size() - 1) + (rate - 1)) / rate);
-        
-        // Initial partial overlap
-        for (resultIndex=0; resultIndex<((int)this->size()-1+rate-1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=resultIndex*rate; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<((int)dataTmp->size()+rate-1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate - (this->size()-1), filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealFirFilter<T, Allocator>::decimate(RealVector<T, Allocator> & data, int rate, bool trimTails) {
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(data.scratchBuf, data.size() + this->size());
+    unsigned inputLen = data.size();
+    
+    data.resize(std::max(inputLen, decimateOutputLength(inputLen, rate)));
+    data.resize(decimateData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size(), rate));
+    return data;
+}
 
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate - (this->size()-1), filterIndex=this->size()-1;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        break;
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & RealFirFilter<T, Allocator>::decimateComplex(ComplexVector<T, Allocator> & data, int rate, bool trimTails) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size() + this->size());
+    unsigned inputLen = data.size();
+    
+    data.resize(std::max(inputLen, decimateOutputLength(inputLen, rate)));
+    data.resize(decimateData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size(), rate));
+    return data;
+}
 
-    case ONE_SHOT_TRIM_TAILS:
-        *dataTmp = data.vec;
-        data.resize((data.size() + rate - 1) / rate);
-        
-        // Initial partial overlap
-        int initialTrim = (this->size() - 1) / 2;
-        for (resultIndex=0; resultIndex<(((int)this->size()-1) - initialTrim + rate - 1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=initialTrim + resultIndex*rate; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<((int)dataTmp->size() - initialTrim + rate - 1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
-                 filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
+template <class T, template <class> class Allocator>
+unsigned RealFirFilter<T, Allocator>::decimate(const T *input, unsigned inputLen, T *output, unsigned outputCapacity, int rate) {
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(NULL, inputLen + this->size());
+    return decimateData(*dataTmp, input, inputLen, output, outputCapacity, rate);
+}
 
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=resultIndex*rate - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        break;
-    }
-    return data;
+template <class T, template <class> class Allocator>
+unsigned RealFirFilter<T, Allocator>::decimate(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                                    unsigned outputCapacity, int rate) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(NULL, inputLen + this->size());
+    return decimateData(*dataTmp, input, inputLen, output, outputCapacity, rate);
 }
 
-template <class T>
-RealVector<T> & RealFirFilter<T>::interp(RealVector<T> & data, int rate, bool trimTails) {
+template <class T, template <class> class Allocator>
+template <class U>
+unsigned RealFirFilter<T, Allocator>::interpData(std::vector<U, Allocator<U> > & dataTmp, const U *input, unsigned inputLen,
+                                      U *output, unsigned outputCapacity, int rate) {
     int resultIndex;
-    int filterIndex;
-    int dataIndex;
     int dataStart, filterStart;
-    std::vector<T> scratch;
-    std::vector<T> *dataTmp;
-    T *savedDataArray = (T *) VECTOR_TO_ARRAY(savedData);
+    U *savedDataArray = (U *) VECTOR_TO_ARRAY(savedData);
+    unsigned outputLen = interpOutputLength(inputLen, rate);
     
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    assert(outputCapacity >= outputLen);
+    updatePolyphaseTaps(rate);
 
     switch (filtOperation) {
 
@@ -797,343 +1060,124 @@ RealVector<T> & RealFirFilter<T>::interp(RealVector<T> & data, int rate, bool tr
             phase = (numTaps - 1) * rate;
         }
         
-        dataTmp->resize(numSavedSamples + data.size());
+        dataTmp.resize(numSavedSamples + inputLen);
         for (int i=0; i<numSavedSamples; i++) {
-            (*dataTmp)[i] = savedDataArray[i];
+            dataTmp[i] = savedDataArray[i];
         }
-        for (int i=0; i<data.size(); i++) {
-            (*dataTmp)[i + numSavedSamples] = data[i];
+        for (int i=0; i<inputLen; i++) {
+            dataTmp[i + numSavedSamples] = input[i];
         }
         
-        data.resize((unsigned) dataTmp->size() * rate);
         bool keepGoing = true;
         for (resultIndex=0, dataStart=0, filterStart=phase; keepGoing; ++resultIndex) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
+            assert(resultIndex < (int) outputCapacity);
+            output[resultIndex] = filterPoint(dataTmp, dataStart, filterStart);
             ++filterStart;
             if (filterStart >= (int)this->size()) {
                 // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
                 // increment the data index and decrement the filter index.
                 filterStart -= rate;
                 ++dataStart;
-                if (dataTmp->size() - dataStart == numSavedSamples) {
+                if (dataTmp.size() - dataStart == numSavedSamples) {
                     keepGoing = false;
                     phase = filterStart;
                 }
             }
         }
-        data.resize(resultIndex);
+        outputLen = resultIndex;
 
         int i;
-        for (i=0; dataStart<dataTmp->size(); i++, dataStart++) {
-            savedDataArray[i] = (*dataTmp)[dataStart];
+        for (i=0; dataStart<dataTmp.size(); i++, dataStart++) {
+            savedDataArray[i] = dataTmp[dataStart];
         }
         numSavedSamples = i;
         }
         break;
 
     case ONE_SHOT_RETURN_ALL_RESULTS:
-        *dataTmp = data.vec;
-        data.resize(data.size() * rate + this->size() - 1 - (rate - 1));
-        
-        // Initial partial overlap
-        for (resultIndex=0, dataStart=0; resultIndex<(int)this->size()-1; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=resultIndex; filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (dataStart=0, filterStart=resultIndex; resultIndex<(int)dataTmp->size()*rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int) this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, 1, 0);
         break;
 
     case ONE_SHOT_TRIM_TAILS:
-        *dataTmp = data.vec;
-        data.resize(data.size() * rate);
-
-        // Initial partial overlap
-        int initialTrim = (this->size() - 1) / 2;
-        for (resultIndex=0, dataStart=0; resultIndex<(int)this->size()-1 - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=initialTrim + resultIndex; filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-       
-        // Middle full overlap
-        for (dataStart=0, filterStart=(int)this->size()-1; resultIndex<(int)dataTmp->size()*rate - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, 1, (this->size() - 1) / 2);
         break;
     }
-    return data;
+    return outputLen;
 }
 
-template <class T>
-ComplexVector<T> & RealFirFilter<T>::interpComplex(ComplexVector<T> & data, int rate, bool trimTails) {
-    int resultIndex;
-    int filterIndex;
-    int dataIndex;
-    int dataStart, filterStart;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    std::complex<T> *savedDataArray = (std::complex<T> *) VECTOR_TO_ARRAY(savedData);
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealFirFilter<T, Allocator>::interp(RealVector<T, Allocator> & data, int rate, bool trimTails) {
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(data.scratchBuf, data.size() + this->size());
+    unsigned inputLen = data.size();
     
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
-
-    switch (filtOperation) {
-
-    case STREAMING: {
-        int numTaps = (this->size() + rate - 1) / rate;
-        if (numSavedSamples >= numTaps) {
-            // First call to interp, have too many "saved" (really just the initial zeros) samples
-            numSavedSamples = numTaps - 1;
-            phase = (numTaps - 1) * rate;
-        }
-        
-        dataTmp->resize(numSavedSamples + data.size());
-        for (int i=0; i<numSavedSamples; i++) {
-            (*dataTmp)[i] = savedDataArray[i];
-        }
-        for (int i=0; i<data.size(); i++) {
-            (*dataTmp)[i + numSavedSamples] = data[i];
-        }
-        
-        data.resize((unsigned) dataTmp->size() * rate);
-        bool keepGoing = true;
-        for (resultIndex=0, dataStart=0, filterStart=phase; keepGoing; ++resultIndex) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-                if (dataTmp->size() - dataStart == numSavedSamples) {
-                    keepGoing = false;
-                    phase = filterStart;
-                }
-            }
-        }
-        data.resize(resultIndex);
-
-        int i;
-        for (i=0; dataStart<dataTmp->size(); i++, dataStart++) {
-            savedDataArray[i] = (*dataTmp)[dataStart];
-        }
-        numSavedSamples = i;
-        }
-        break;
-
-    case ONE_SHOT_RETURN_ALL_RESULTS:
-        *dataTmp = data.vec;
-        data.resize(data.size() * rate + this->size() - 1 - (rate - 1));
-        
-        // Initial partial overlap
-        for (resultIndex=0, dataStart=0; resultIndex<(int)this->size()-1; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=resultIndex; filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-        
-        // Middle full overlap
-        for (dataStart=0, filterStart=resultIndex; resultIndex<(int)dataTmp->size()*rate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-            }
-        }
-
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int) this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-            }
-        }
-        break;
+    data.resize(std::max(inputLen, interpOutputLength(inputLen, rate)));
+    data.resize(interpData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size(), rate));
+    return data;
+}
 
-    case ONE_SHOT_TRIM_TAILS:
-        *dataTmp = data.vec;
-        data.resize(data.size() * rate);
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & RealFirFilter<T, Allocator>::interpComplex(ComplexVector<T, Allocator> & data, int rate, bool trimTails) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size() + this->size());
+    unsigned inputLen = data.size();
+    
+    data.resize(std::max(inputLen, interpOutputLength(inputLen, rate)));
+    data.resize(interpData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size(), rate));
+    return data;
+}
 
-        // Initial partial overlap
-        int initialTrim = (this->size() - 1) / 2;
-        for (resultIndex=0, dataStart=0; resultIndex<(int)this->size()-1 - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=initialTrim + resultIndex; filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-        }
-       
-        // Middle full overlap
-        for (dataStart=0, filterStart=(int)this->size()-1; resultIndex<(int)dataTmp->size()*rate - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-            }
-        }
+template <class T, template <class> class Allocator>
+unsigned RealFirFilter<T, Allocator>::interp(const T *input, unsigned inputLen, T *output, unsigned outputCapacity, int rate) {
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(NULL, inputLen + this->size());
+    return interpData(*dataTmp, input, inputLen, output, outputCapacity, rate);
+}
 
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            ++filterStart;
-            if (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= rate;
-                ++dataStart;
-            }
-        }
-        break;
-    }
-    return data;
+template <class T, template <class> class Allocator>
+unsigned RealFirFilter<T, Allocator>::interp(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                                  unsigned outputCapacity, int rate) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(NULL, inputLen + this->size());
+    return interpData(*dataTmp, input, inputLen, output, outputCapacity, rate);
 }
 
-template <class T>
-RealVector<T> & RealFirFilter<T>::resample(RealVector<T> & data, int interpRate, int decimateRate, bool trimTails) {
+template <class T, template <class> class Allocator>
+template <class U>
+unsigned RealFirFilter<T, Allocator>::resampleData(std::vector<U, Allocator<U> > & dataTmp, const U *input, unsigned inputLen,
+                                        U *output, unsigned outputCapacity, int interpRate, int decimateRate) {
     int resultIndex;
-    int filterIndex;
-    int dataIndex;
     int dataStart, filterStart;
-    int interpLen, resampLen;
-    std::vector<T> scratch;
-    std::vector<T> *dataTmp;
-    T *savedDataArray = (T *) VECTOR_TO_ARRAY(savedData);
+    U *savedDataArray = (U *) VECTOR_TO_ARRAY(savedData);
+    unsigned outputLen = resampleOutputLength(inputLen, interpRate, decimateRate);
     
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    assert(outputCapacity >= outputLen);
+    updatePolyphaseTaps(interpRate);
 
     switch (filtOperation) {
 
     case STREAMING: {
         int numTaps = (this->size() + interpRate - 1) / interpRate;
-        if (numSavedSamples >= numTaps) {
-            // First call to interp, have too many "saved" (really just the initial zeros) samples
+        if (numSavedSamples >= numTaps || (phase == 0 && numSavedSamples == numTaps - 1)) {
+            // First call to resample, have too many "saved" (really just the initial zeros) samples.  With an
+            // interpolation rate of 1 the number is right, but the phase still has to be set.
             numSavedSamples = numTaps - 1;
             phase = (numTaps - 1) * interpRate;
         }
         
-        dataTmp->resize(numSavedSamples + data.size());
+        dataTmp.resize(numSavedSamples + inputLen);
         for (int i=0; i<numSavedSamples; i++) {
-            (*dataTmp)[i] = savedDataArray[i];
+            dataTmp[i] = savedDataArray[i];
         }
-        for (int i=0; i<data.size(); i++) {
-            (*dataTmp)[i + numSavedSamples] = data[i];
+        for (int i=0; i<inputLen; i++) {
+            dataTmp[i + numSavedSamples] = input[i];
         }
         
-        interpLen = (unsigned) dataTmp->size() * interpRate;
-        resampLen = (interpLen + decimateRate - 1) / decimateRate;
-        data.resize(resampLen);
-        bool keepGoing = true;
-        for (resultIndex=0, dataStart=0, filterStart=phase; keepGoing; ++resultIndex) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
+        // Calculate every result whose newest data sample has arrived.  When decimateRate > interpRate a result
+        // can skip over several data samples, so the loop tests for the data it needs rather than for a particular
+        // number of samples left over.
+        for (resultIndex=0, dataStart=0, filterStart=phase;
+             dataStart + filterStart / interpRate < (int) dataTmp.size() && resultIndex < (int) outputCapacity;
+             ++resultIndex) {
+            output[resultIndex] = filterPoint(dataTmp, dataStart, filterStart);
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
                 // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
@@ -1141,318 +1185,70 @@ RealVector<T> & RealFirFilter<T>::resample(RealVector<T> & data, int interpRate,
                 filterStart -= interpRate;
                 ++dataStart;
             }
-            if (dataTmp->size() - dataStart == numSavedSamples) {
-                keepGoing = false;
-                phase = filterStart;
-            }
         }
-        data.resize(resultIndex);
+        assert(dataStart + filterStart / interpRate >= (int) dataTmp.size());
+        phase = filterStart;
+        outputLen = resultIndex;
         
         int i;
-        for (i=0; dataStart<dataTmp->size(); i++, dataStart++) {
-            savedDataArray[i] = (*dataTmp)[dataStart];
+        for (i=0; dataStart<dataTmp.size(); i++, dataStart++) {
+            savedDataArray[i] = dataTmp[dataStart];
         }
         numSavedSamples = i;
         }
         break;
 
     case ONE_SHOT_RETURN_ALL_RESULTS:
-        *dataTmp = data.vec;
-        interpLen = data.size() * interpRate + this->size() - 1 - (interpRate - 1);
-        resampLen = (interpLen + decimateRate - 1) / decimateRate;
-        data.resize(resampLen);
-        
-        // Initial partial overlap
-        for (resultIndex=0, dataStart=0, filterStart=0; resultIndex<((int)this->size()-1+decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=filterStart; filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<((int)dataTmp->size()*interpRate + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, decimateRate, 0);
         break;
 
     case ONE_SHOT_TRIM_TAILS:
-        *dataTmp = data.vec;
-        interpLen = data.size() * interpRate;
-        resampLen = (interpLen + decimateRate - 1) / decimateRate;
-        data.resize(resampLen);
-
-        // Initial partial overlap
-        int initialTrim = (this->size() - 1) / 2;
-        for (resultIndex=0, dataStart=0, filterStart=initialTrim;
-             resultIndex<((int)this->size()-1 - initialTrim + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=filterStart; filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<((int)dataTmp->size()*interpRate - initialTrim + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
+        dataTmp.assign(input, input + inputLen);
+        oneShotFilter(dataTmp, output, outputLen, decimateRate, (this->size() - 1) / 2);
         break;
     }
-    return data;
+    return outputLen;
 }
 
-template <class T>
-ComplexVector<T> & RealFirFilter<T>::resampleComplex(ComplexVector<T> & data, int interpRate, int decimateRate, bool trimTails) {
-    int resultIndex;
-    int filterIndex;
-    int dataIndex;
-    int dataStart, filterStart;
-    int interpLen, resampLen;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    std::complex<T> *savedDataArray = (std::complex<T> *) VECTOR_TO_ARRAY(savedData);
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealFirFilter<T, Allocator>::resample(RealVector<T, Allocator> & data, int interpRate, int decimateRate, bool trimTails) {
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(data.scratchBuf, data.size() + this->size());
+    unsigned inputLen = data.size();
     
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
-
-    switch (filtOperation) {
-
-    case STREAMING: {
-        int numTaps = (this->size() + interpRate - 1) / interpRate;
-        if (numSavedSamples >= numTaps) {
-            // First call to interp, have too many "saved" (really just the initial zeros) samples
-            numSavedSamples = numTaps - 1;
-            phase = (numTaps - 1) * interpRate;
-        }
-        
-        dataTmp->resize(numSavedSamples + data.size());
-        for (int i=0; i<numSavedSamples; i++) {
-            (*dataTmp)[i] = savedDataArray[i];
-        }
-        for (int i=0; i<data.size(); i++) {
-            (*dataTmp)[i + numSavedSamples] = data[i];
-        }
-        
-        interpLen = (unsigned) dataTmp->size() * interpRate;
-        resampLen = (interpLen + decimateRate - 1) / decimateRate;
-        data.resize(resampLen);
-        bool keepGoing = true;
-        for (resultIndex=0, dataStart=0, filterStart=phase; keepGoing; ++resultIndex) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-            if (dataTmp->size() - dataStart == numSavedSamples) {
-                keepGoing = false;
-                phase = filterStart;
-            }
-        }
-        data.resize(resultIndex);
-        
-        int i;
-        for (i=0; dataStart<dataTmp->size(); i++, dataStart++) {
-            savedDataArray[i] = (*dataTmp)[dataStart];
-        }
-        numSavedSamples = i;
-        }
-        break;
-
-    case ONE_SHOT_RETURN_ALL_RESULTS:
-        *dataTmp = data.vec;
-        interpLen = data.size() * interpRate + this->size() - 1 - (interpRate - 1);
-        resampLen = (interpLen + decimateRate - 1) / decimateRate;
-        data.resize(resampLen);
-        
-        // Initial partial overlap
-        for (resultIndex=0, dataStart=0, filterStart=0; resultIndex<((int)this->size()-1+decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=filterStart; filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<((int)dataTmp->size()*interpRate + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        break;
-
-    case ONE_SHOT_TRIM_TAILS:
-        *dataTmp = data.vec;
-        interpLen = data.size() * interpRate;
-        resampLen = (interpLen + decimateRate - 1) / decimateRate;
-        data.resize(resampLen);
+    data.resize(std::max(inputLen, resampleOutputLength(inputLen, interpRate, decimateRate)));
+    data.resize(resampleData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size(),
+                             interpRate, decimateRate));
+    return data;
+}
 
-        // Initial partial overlap
-        int initialTrim = (this->size() - 1) / 2;
-        for (resultIndex=0, dataStart=0, filterStart=initialTrim;
-             resultIndex<((int)this->size()-1 - initialTrim + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=0, filterIndex=filterStart; filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        
-        // Middle full overlap
-        for (; resultIndex<((int)dataTmp->size()*interpRate - initialTrim + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        
-        // Final partial overlap
-        for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
-            for (dataIndex=dataStart, filterIndex=filterStart;
-                 dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
-            }
-            filterStart += decimateRate;
-            while (filterStart >= (int)this->size()) {
-                // Filter no longer overlaps with this data sample, so the first overlap sample is the next one.  We thus
-                // increment the data index and decrement the filter index.
-                filterStart -= interpRate;
-                ++dataStart;
-            }
-        }
-        break;
-    }
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & RealFirFilter<T, Allocator>::resampleComplex(ComplexVector<T, Allocator> & data, int interpRate, int decimateRate, bool trimTails) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size() + this->size());
+    unsigned inputLen = data.size();
+    
+    data.resize(std::max(inputLen, resampleOutputLength(inputLen, interpRate, decimateRate)));
+    data.resize(resampleData(*dataTmp, VECTOR_TO_ARRAY(data.vec), inputLen, VECTOR_TO_ARRAY(data.vec), data.size(),
+                             interpRate, decimateRate));
     return data;
 }
 
+template <class T, template <class> class Allocator>
+unsigned RealFirFilter<T, Allocator>::resample(const T *input, unsigned inputLen, T *output, unsigned outputCapacity,
+                                    int interpRate, int decimateRate) {
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(NULL, inputLen + this->size());
+    return resampleData(*dataTmp, input, inputLen, output, outputCapacity, interpRate, decimateRate);
+}
+
+template <class T, template <class> class Allocator>
+unsigned RealFirFilter<T, Allocator>::resample(const std::complex<T> *input, unsigned inputLen, std::complex<T> *output,
+                                    unsigned outputCapacity, int interpRate, int decimateRate) {
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(NULL, inputLen + this->size());
+    return resampleData(*dataTmp, input, inputLen, output, outputCapacity, interpRate, decimateRate);
+}
 
-template <class T>
-bool RealFirFilter<T>::firpm(int filterOrder, int numBands, double *freqPoints, double *desiredBandResponse,
+template <class T, template <class> class Allocator>
+bool RealFirFilter<T, Allocator>::firpm(int filterOrder, int numBands, double *freqPoints, double *desiredBandResponse,
                             double *weight, int lGrid) {
     bool converged;
     
@@ -1476,8 +1272,8 @@ bool RealFirFilter<T>::firpm(int filterOrder, int numBands, double *freqPoints,
 }
 
 
-template <class T>
-void RealFirFilter<T>::fractionalDelayFilter(int numTaps, double bandwidth, double delay) {
+template <class T, template <class> class Allocator>
+void RealFirFilter<T, Allocator>::fractionalDelayFilter(int numTaps, double bandwidth, double delay) {
     assert(bandwidth > 0 && bandwidth < 1.0);
     assert(numTaps > 0);
     
@@ -1508,8 +1304,8 @@ void RealFirFilter<T>::fractionalDelayFilter(int numTaps, double bandwidth, doub
     hamming();
 }
 
-template <class T>
-void RealFirFilter<T>::hamming() {
+template <class T, template <class> class Allocator>
+void RealFirFilter<T, Allocator>::hamming() {
     T phase = -M_PI;
     T phaseIncrement = 2 * M_PI / (this->size() - 1);
     T alpha = 0.54;
@@ -1523,8 +1319,8 @@ void RealFirFilter<T>::hamming() {
     }
 }
 
-template <class T>
-RealVector<T> & RealFirFilter<T>::corr(RealVector<T> & data) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealFirFilter<T, Allocator>::corr(RealVector<T, Allocator> & data) {
     this->reverse();
     this->conv(data);
     this->reverse();
@@ -1538,26 +1334,27 @@ RealVector<T> & RealFirFilter<T>::corr(RealVector<T> & data) {
  * \param filter The filter that will correlate with "data".
  * \return Reference to "data", which holds the result of the convolution.
  */
-template <class T>
-inline RealVector<T> & corr(RealVector<T> & data, RealFirFilter<T> & filter) {
+template <class T, template <class> class Allocator>
+inline RealVector<T, Allocator> & corr(RealVector<T, Allocator> & data, RealFirFilter<T, Allocator> & filter) {
     return filter.corr(data);
 }
 
-template <class T>
-void RealFirFilter<T>::hamming(unsigned len)
+template <class T, template <class> class Allocator>
+void RealFirFilter<T, Allocator>::hamming(unsigned len)
 {
     generalizedHamming(len, 0.54, 0.46);
 }
 
-template <class T>
-void RealFirFilter<T>::hann(unsigned len)
+template <class T, template <class> class Allocator>
+void RealFirFilter<T, Allocator>::hann(unsigned len)
 {
     generalizedHamming(len, 0.5, 0.5);
 }
 
-template <class T>
-void RealFirFilter<T>::generalizedHamming(unsigned len, double alpha, double beta)
+template <class T, template <class> class Allocator>
+void RealFirFilter<T, Allocator>::generalizedHamming(unsigned len, double alpha, double beta)
 {
+    this->modified();
     this->resize(len);
     double N = len - 1;
     for (unsigned index=0; index<len; index++) {
@@ -1565,9 +1362,10 @@ void RealFirFilter<T>::generalizedHamming(unsigned len, double alpha, double bet
     }
 }
 
-template <class T>
-void RealFirFilter<T>::blackman(unsigned len)
+template <class T, template <class> class Allocator>
+void RealFirFilter<T, Allocator>::blackman(unsigned len)
 {
+    this->modified();
     const double alpha[] = {0.42, 0.5, 0.08};
     
     this->resize(len);
@@ -1578,9 +1376,10 @@ void RealFirFilter<T>::blackman(unsigned len)
     }
 }
 
-template <class T>
-void RealFirFilter<T>::blackmanHarris(unsigned len)
+template <class T, template <class> class Allocator>
+void RealFirFilter<T, Allocator>::blackmanHarris(unsigned len)
 {
+    this->modified();
     const double alpha[] = {0.35875, 0.48829, 0.14128, 0.01168};
     
     this->resize(len);
@@ -40,8 +40,8 @@ namespace NimbleDSP {
 /**
  * \brief Vector class for real, fixed point (i.e. short's, int's, etc.) numbers.
  */
-template <class T>
-class RealFixedPtVector : public RealVector<T> {
+template <class T, template <class> class Allocator = std::allocator>
+class RealFixedPtVector : public RealVector<T, Allocator> {
  public:
     /*****************************************************************************************
                                         Constructors
@@ -55,11 +55,11 @@ class RealFixedPtVector : public RealVector<T> {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
-    RealFixedPtVector<T>(unsigned size = DEFAULT_BUF_LEN, std::vector<T> *scratch = NULL) :
-            RealVector<T>(size, scratch) {}
+    RealFixedPtVector<T, Allocator>(unsigned size = DEFAULT_BUF_LEN, std::vector<T, Allocator<T> > *scratch = NULL) :
+            RealVector<T, Allocator>(size, scratch) {}
             
     /**
      * \brief Vector constructor.
@@ -71,11 +71,17 @@ class RealFixedPtVector : public RealVector<T> {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
     template <typename U>
-    RealFixedPtVector<T>(std::vector<U> data, std::vector<T> *scratch = NULL) : RealVector<T>(data, scratch) {}
+    RealFixedPtVector<T, Allocator>(const std::vector<U> & data, std::vector<T, Allocator<T> > *scratch = NULL) : RealVector<T, Allocator>(data, scratch) {}
+    
+    /**
+     * \brief Adopting vector constructor.  Takes over the storage of "data", which is left empty.
+     */
+    RealFixedPtVector<T, Allocator>(std::vector<T, Allocator<T> > && data, std::vector<T, Allocator<T> > *scratch = NULL) :
+            RealVector<T, Allocator>(std::move(data), scratch) {}
     
     /**
      * \brief Array constructor.
@@ -88,17 +94,29 @@ class RealFixedPtVector : public RealVector<T> {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
     template <typename U>
-    RealFixedPtVector<T>(U *data, unsigned dataLen, std::vector<T> *scratch = NULL) :
-            RealVector<T>(data, dataLen, scratch) {}
+    RealFixedPtVector<T, Allocator>(U *data, unsigned dataLen, std::vector<T, Allocator<T> > *scratch = NULL) :
+            RealVector<T, Allocator>(data, dataLen, scratch) {}
     
     /**
      * \brief Copy constructor.
      */
-    RealFixedPtVector<T>(const RealFixedPtVector<T>& other) {this->vec = other.vec;}
+    RealFixedPtVector<T, Allocator>(const RealFixedPtVector<T, Allocator>& other) {this->vec = other.vec; this->generation = other.generation;}
+    
+    /**
+     * \brief Move constructor.  Takes over the storage of "other", which is left empty.
+     */
+    RealFixedPtVector<T, Allocator>(RealFixedPtVector<T, Allocator>&& other) {this->vec = std::move(other.vec);
+            this->generation = other.generation; other.modified();}
+    
+    /**
+     * \brief Expression constructor.
+     */
+    template <class E>
+    RealFixedPtVector<T, Allocator>(const VectorExpression<E>& expr) {evaluateExpression(this->vec, expr);}
     
     /*****************************************************************************************
                                             Operators
@@ -106,98 +124,114 @@ class RealFixedPtVector : public RealVector<T> {
     /**
      * \brief Assignment operator.
      */
-    RealFixedPtVector<T>& operator=(const Vector<T>& rhs);
+    RealFixedPtVector<T, Allocator>& operator=(const Vector<T, Allocator>& rhs);
+    
+    /**
+     * \brief Copy assignment operator.
+     */
+    RealFixedPtVector<T, Allocator>& operator=(const RealFixedPtVector<T, Allocator>& rhs) {Vector<T, Allocator>::operator=(rhs); return *this;}
+    
+    /**
+     * \brief Move assignment operator.  Takes over the storage of "rhs", which is left empty.
+     */
+    RealFixedPtVector<T, Allocator>& operator=(RealFixedPtVector<T, Allocator>&& rhs) {Vector<T, Allocator>::operator=(std::move(rhs)); return *this;}
+    
+    /**
+     * \brief Expression assignment operator.
+     */
+    template <class E>
+    RealFixedPtVector<T, Allocator>& operator=(const VectorExpression<E>& rhs) {evaluateExpression(this->vec, rhs); this->modified(); return *this;}
     
     /**
      * \brief Pre-increment operator.
      */
-    RealFixedPtVector<T> & operator++();
+    RealFixedPtVector<T, Allocator> & operator++();
     
     /**
      * \brief Post-increment operator.
      */
-    RealFixedPtVector<T> operator++(int);
+    RealFixedPtVector<T, Allocator> operator++(int);
     
     /**
      * \brief Pre-decrement operator.
      */
-    RealFixedPtVector<T> & operator--();
+    RealFixedPtVector<T, Allocator> & operator--();
     
     /**
      * \brief Post-decrement operator.
      */
-    RealFixedPtVector<T> operator--(int);
+    RealFixedPtVector<T, Allocator> operator--(int);
     
     /**
      * \brief Buffer modulo/assignment operator.
      */
-    template <class U>
-    RealFixedPtVector<T> & operator%=(const RealFixedPtVector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    RealFixedPtVector<T, Allocator> & operator%=(const RealFixedPtVector<U, UAllocator> &rhs);
     
     /**
      * \brief Scalar modulo/assignment operator.
      */
-    RealFixedPtVector<T> & operator%=(const T &rhs);
+    RealFixedPtVector<T, Allocator> & operator%=(const T &rhs);
     
     /**
      * \brief Bit-wise negation operator.
      */
-    RealFixedPtVector<T> & operator~();
+    RealFixedPtVector<T, Allocator> & operator~();
     
     /**
      * \brief Buffer bit-wise and/assignment operator.
      */
-    template <class U>
-    RealFixedPtVector<T> & operator&=(const RealFixedPtVector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    RealFixedPtVector<T, Allocator> & operator&=(const RealFixedPtVector<U, UAllocator> &rhs);
     
     /**
      * \brief Scalar bit-wise and/assignment operator.
      */
-    RealFixedPtVector<T> & operator&=(const T &rhs);
+    RealFixedPtVector<T, Allocator> & operator&=(const T &rhs);
     
     /**
      * \brief Buffer bit-wise or/assignment operator.
      */
-    template <class U>
-    RealFixedPtVector<T> & operator|=(const RealFixedPtVector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    RealFixedPtVector<T, Allocator> & operator|=(const RealFixedPtVector<U, UAllocator> &rhs);
     
     /**
      * \brief Scalar bit-wise or/assignment operator.
      */
-    RealFixedPtVector<T> & operator|=(const T &rhs);
+    RealFixedPtVector<T, Allocator> & operator|=(const T &rhs);
     
     /**
      * \brief Buffer bit-wise xor/assignment operator.
      */
-    template <class U>
-    RealFixedPtVector<T> & operator^=(const RealFixedPtVector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    RealFixedPtVector<T, Allocator> & operator^=(const RealFixedPtVector<U, UAllocator> &rhs);
     
     /**
      * \brief Scalar bit-wise xor/assignment operator.
      */
-    RealFixedPtVector<T> & operator^=(const T &rhs);
+    RealFixedPtVector<T, Allocator> & operator^=(const T &rhs);
     
     /**
      * \brief Buffer right shift/assignment operator.
      */
-    template <class U>
-    RealFixedPtVector<T> & operator>>=(const RealFixedPtVector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    RealFixedPtVector<T, Allocator> & operator>>=(const RealFixedPtVector<U, UAllocator> &rhs);
     
     /**
      * \brief Scalar right shift/assignment operator.
      */
-    RealFixedPtVector<T> & operator>>=(const T &rhs);
+    RealFixedPtVector<T, Allocator> & operator>>=(const T &rhs);
     
     /**
      * \brief Buffer left shift/assignment operator.
      */
-    template <class U>
-    RealFixedPtVector<T> & operator<<=(const RealFixedPtVector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    RealFixedPtVector<T, Allocator> & operator<<=(const RealFixedPtVector<U, UAllocator> &rhs);
     
     /**
      * \brief Scalar left shift/assignment operator.
      */
-    RealFixedPtVector<T> & operator<<=(const T &rhs);
+    RealFixedPtVector<T, Allocator> & operator<<=(const T &rhs);
     
     /*****************************************************************************************
                                              Methods
@@ -208,7 +242,7 @@ class RealFixedPtVector : public RealVector<T> {
      * \param exponent Exponent to use.
      * \return Reference to "this".
      */
-    RealVector<T> & pow(const SLICKDSP_FLOAT_TYPE exponent);
+    RealVector<T, Allocator> & pow(const SLICKDSP_FLOAT_TYPE exponent);
     
     /**
      * \brief Returns the mode of the data in \ref buf.
@@ -217,51 +251,55 @@ class RealFixedPtVector : public RealVector<T> {
 };
 
 
-template <class T>
-RealFixedPtVector<T>& RealFixedPtVector<T>::operator=(const Vector<T>& rhs)
+template <class T, template <class> class Allocator>
+RealFixedPtVector<T, Allocator>& RealFixedPtVector<T, Allocator>::operator=(const Vector<T, Allocator>& rhs)
 {
     this->vec = rhs.vec;
+    this->modified();
     return *this;
 }
 
-template <class T>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator++()
+template <class T, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator++()
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = this->vec[i] + 1;
     }
     return *this;
 }
 
-template <class T>
-RealFixedPtVector<T> RealFixedPtVector<T>::operator++(int)
+template <class T, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> RealFixedPtVector<T, Allocator>::operator++(int)
 {
-    RealFixedPtVector<T> tmp(*this);
+    RealFixedPtVector<T, Allocator> tmp(*this);
     operator++();
     return tmp;
 }
 
-template <class T>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator--()
+template <class T, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator--()
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = this->vec[i] - 1;
     }
     return *this;
 }
 
-template <class T>
-RealFixedPtVector<T> RealFixedPtVector<T>::operator--(int)
+template <class T, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> RealFixedPtVector<T, Allocator>::operator--(int)
 {
-    RealFixedPtVector<T> tmp(*this);
+    RealFixedPtVector<T, Allocator> tmp(*this);
     operator--();
     return tmp;
 }
 
-template <class T>
-template <class U>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator%=(const RealFixedPtVector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator%=(const RealFixedPtVector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] %= rhs.vec[i];
@@ -269,9 +307,10 @@ RealFixedPtVector<T> & RealFixedPtVector<T>::operator%=(const RealFixedPtVector<
     return *this;
 }
 
-template <class T>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator%=(const T &rhs)
+template <class T, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator%=(const T &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] %= rhs;
     }
@@ -281,8 +320,8 @@ RealFixedPtVector<T> & RealFixedPtVector<T>::operator%=(const T &rhs)
 /**
  * \brief Buffer modulo operator.
  */
-template <class T, class U>
-inline RealFixedPtVector<T> operator%(RealFixedPtVector<T> lhs, const RealFixedPtVector<U>& rhs)
+template <class T, class U, template <class> class Allocator, template <class> class UAllocator>
+inline RealFixedPtVector<T, Allocator> operator%(RealFixedPtVector<T, Allocator> lhs, const RealFixedPtVector<U, UAllocator>& rhs)
 {
     lhs %= rhs;
     return lhs;
@@ -291,26 +330,28 @@ inline RealFixedPtVector<T> operator%(RealFixedPtVector<T> lhs, const RealFixedP
 /**
  * \brief Scalar modulo operator.
  */
-template <class T>
-inline RealFixedPtVector<T> operator%(RealFixedPtVector<T> lhs, const T& rhs)
+template <class T, template <class> class Allocator>
+inline RealFixedPtVector<T, Allocator> operator%(RealFixedPtVector<T, Allocator> lhs, const T& rhs)
 {
     lhs %= rhs;
     return lhs;
 }
 
-template <class T>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator~()
+template <class T, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator~()
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = ~(this->vec[i]);
     }
     return *this;
 }
 
-template <class T>
-template <class U>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator&=(const RealFixedPtVector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator&=(const RealFixedPtVector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] &= rhs.vec[i];
@@ -318,9 +359,10 @@ RealFixedPtVector<T> & RealFixedPtVector<T>::operator&=(const RealFixedPtVector<
     return *this;
 }
 
-template <class T>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator&=(const T &rhs)
+template <class T, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator&=(const T &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] &= rhs;
     }
@@ -330,8 +372,8 @@ RealFixedPtVector<T> & RealFixedPtVector<T>::operator&=(const T &rhs)
 /**
  * \brief Buffer bit-wise and operator.
  */
-template <class T, class U>
-inline RealFixedPtVector<T> operator&(RealFixedPtVector<T> lhs, const RealFixedPtVector<U>& rhs)
+template <class T, class U, template <class> class Allocator, template <class> class UAllocator>
+inline RealFixedPtVector<T, Allocator> operator&(RealFixedPtVector<T, Allocator> lhs, const RealFixedPtVector<U, UAllocator>& rhs)
 {
     lhs &= rhs;
     return lhs;
@@ -340,17 +382,18 @@ inline RealFixedPtVector<T> operator&(RealFixedPtVector<T> lhs, const RealFixedP
 /**
  * \brief Scalar bit-wise and operator.
  */
-template <class T>
-inline RealFixedPtVector<T> operator&(RealFixedPtVector<T> lhs, const T& rhs)
+template <class T, template <class> class Allocator>
+inline RealFixedPtVector<T, Allocator> operator&(RealFixedPtVector<T, Allocator> lhs, const T& rhs)
 {
     lhs &= rhs;
     return lhs;
 }
 
-template <class T>
-template <class U>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator|=(const RealFixedPtVector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator|=(const RealFixedPtVector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] |= rhs.vec[i];
@@ -358,9 +401,10 @@ RealFixedPtVector<T> & RealFixedPtVector<T>::operator|=(const RealFixedPtVector<
     return *this;
 }
 
-template <class T>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator|=(const T &rhs)
+template <class T, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator|=(const T &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] |= rhs;
     }
@@ -370,8 +414,8 @@ RealFixedPtVector<T> & RealFixedPtVector<T>::operator|=(const T &rhs)
 /**
  * \brief Buffer bit-wise or operator.
  */
-template <class T, class U>
-inline RealFixedPtVector<T> operator|(RealFixedPtVector<T> lhs, const RealFixedPtVector<U>& rhs)
+template <class T, class U, template <class> class Allocator, template <class> class UAllocator>
+inline RealFixedPtVector<T, Allocator> operator|(RealFixedPtVector<T, Allocator> lhs, const RealFixedPtVector<U, UAllocator>& rhs)
 {
     lhs |= rhs;
     return lhs;
@@ -380,17 +424,18 @@ inline RealFixedPtVector<T> operator|(RealFixedPtVector<T> lhs, const RealFixedP
 /**
  * \brief Scalar bit-wise or operator.
  */
-template <class T>
-inline RealFixedPtVector<T> operator|(RealFixedPtVector<T> lhs, const T& rhs)
+template <class T, template <class> class Allocator>
+inline RealFixedPtVector<T, Allocator> operator|(RealFixedPtVector<T, Allocator> lhs, const T& rhs)
 {
     lhs |= rhs;
     return lhs;
 }
 
-template <class T>
-template <class U>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator^=(const RealFixedPtVector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator^=(const RealFixedPtVector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] ^= rhs.vec[i];
@@ -398,9 +443,10 @@ RealFixedPtVector<T> & RealFixedPtVector<T>::operator^=(const RealFixedPtVector<
     return *this;
 }
 
-template <class T>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator^=(const T &rhs)
+template <class T, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator^=(const T &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] ^= rhs;
     }
@@ -410,8 +456,8 @@ RealFixedPtVector<T> & RealFixedPtVector<T>::operator^=(const T &rhs)
 /**
  * \brief Buffer bit-wise xor operator.
  */
-template <class T, class U>
-inline RealFixedPtVector<T> operator^(RealFixedPtVector<T> lhs, const RealFixedPtVector<U>& rhs)
+template <class T, class U, template <class> class Allocator, template <class> class UAllocator>
+inline RealFixedPtVector<T, Allocator> operator^(RealFixedPtVector<T, Allocator> lhs, const RealFixedPtVector<U, UAllocator>& rhs)
 {
     lhs ^= rhs;
     return lhs;
@@ -420,17 +466,18 @@ inline RealFixedPtVector<T> operator^(RealFixedPtVector<T> lhs, const RealFixedP
 /**
  * \brief Scalar bit-wise xor operator.
  */
-template <class T>
-inline RealFixedPtVector<T> operator^(RealFixedPtVector<T> lhs, const T& rhs)
+template <class T, template <class> class Allocator>
+inline RealFixedPtVector<T, Allocator> operator^(RealFixedPtVector<T, Allocator> lhs, const T& rhs)
 {
     lhs ^= rhs;
     return lhs;
 }
 
-template <class T>
-template <class U>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator>>=(const RealFixedPtVector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator>>=(const RealFixedPtVector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] >>= rhs.vec[i];
@@ -438,9 +485,10 @@ RealFixedPtVector<T> & RealFixedPtVector<T>::operator>>=(const RealFixedPtVector
     return *this;
 }
 
-template <class T>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator>>=(const T &rhs)
+template <class T, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator>>=(const T &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] >>= rhs;
     }
@@ -450,8 +498,8 @@ RealFixedPtVector<T> & RealFixedPtVector<T>::operator>>=(const T &rhs)
 /**
  * \brief Buffer right shift operator.
  */
-template <class T, class U>
-inline RealFixedPtVector<T> operator>>(RealFixedPtVector<T> lhs, const RealFixedPtVector<U>& rhs)
+template <class T, class U, template <class> class Allocator, template <class> class UAllocator>
+inline RealFixedPtVector<T, Allocator> operator>>(RealFixedPtVector<T, Allocator> lhs, const RealFixedPtVector<U, UAllocator>& rhs)
 {
     lhs >>= rhs;
     return lhs;
@@ -460,17 +508,18 @@ inline RealFixedPtVector<T> operator>>(RealFixedPtVector<T> lhs, const RealFixed
 /**
  * \brief Scalar right shift operator.
  */
-template <class T>
-inline RealFixedPtVector<T> operator>>(RealFixedPtVector<T> lhs, const T& rhs)
+template <class T, template <class> class Allocator>
+inline RealFixedPtVector<T, Allocator> operator>>(RealFixedPtVector<T, Allocator> lhs, const T& rhs)
 {
     lhs >>= rhs;
     return lhs;
 }
 
-template <class T>
-template <class U>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator<<=(const RealFixedPtVector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator<<=(const RealFixedPtVector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] <<= rhs.vec[i];
@@ -478,9 +527,10 @@ RealFixedPtVector<T> & RealFixedPtVector<T>::operator<<=(const RealFixedPtVector
     return *this;
 }
 
-template <class T>
-RealFixedPtVector<T> & RealFixedPtVector<T>::operator<<=(const T &rhs)
+template <class T, template <class> class Allocator>
+RealFixedPtVector<T, Allocator> & RealFixedPtVector<T, Allocator>::operator<<=(const T &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] <<= rhs;
     }
@@ -490,8 +540,8 @@ RealFixedPtVector<T> & RealFixedPtVector<T>::operator<<=(const T &rhs)
 /**
  * \brief Buffer left shift operator.
  */
-template <class T, class U>
-inline RealFixedPtVector<T> operator<<(RealFixedPtVector<T> lhs, const RealFixedPtVector<U>& rhs)
+template <class T, class U, template <class> class Allocator, template <class> class UAllocator>
+inline RealFixedPtVector<T, Allocator> operator<<(RealFixedPtVector<T, Allocator> lhs, const RealFixedPtVector<U, UAllocator>& rhs)
 {
     lhs <<= rhs;
     return lhs;
@@ -500,33 +550,26 @@ inline RealFixedPtVector<T> operator<<(RealFixedPtVector<T> lhs, const RealFixed
 /**
  * \brief Scalar left shift operator.
  */
-template <class T>
-inline RealFixedPtVector<T> operator<<(RealFixedPtVector<T> lhs, const T& rhs)
+template <class T, template <class> class Allocator>
+inline RealFixedPtVector<T, Allocator> operator<<(RealFixedPtVector<T, Allocator> lhs, const T& rhs)
 {
     lhs <<= rhs;
     return lhs;
 }
 
-template <class T>
-RealVector<T> & RealFixedPtVector<T>::pow(const SLICKDSP_FLOAT_TYPE exponent) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealFixedPtVector<T, Allocator>::pow(const SLICKDSP_FLOAT_TYPE exponent) {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = (T) std::round(std::pow(this->vec[i], exponent));
     }
     return *this;
 }
     
-template <class T>
-const T RealFixedPtVector<T>::mode() {
+template <class T, template <class> class Allocator>
+const T RealFixedPtVector<T, Allocator>::mode() {
     assert(this->size() > 0);
-    std::vector<T> tempScratch;
-    std::vector<T> *scratch;
-
-    if (this->scratchBuf == NULL) {
-        scratch = &tempScratch;
-    }
-    else {
-        scratch = this->scratchBuf;
-    }
+    ScratchBuffer< std::vector<T, Allocator<T> > > scratch(this->scratchBuf, this->size());
     *scratch = this->vec;
     std::sort(scratch->begin(), scratch->end());
     
@@ -558,8 +601,8 @@ const T RealFixedPtVector<T>::mode() {
 /**
  * \brief Returns the mode of the data in \ref buf.
  */
-template <class T>
-const T mode(RealFixedPtVector<T> & buffer) {
+template <class T, template <class> class Allocator>
+const T mode(RealFixedPtVector<T, Allocator> & buffer) {
     return buffer.mode();
 }
 
@@ -33,6 +33,7 @@ THE SOFTWARE.
 
 #include <vector>
 #include "Vector.h"
+#include "VectorView.h"
 
 
 namespace NimbleDSP {
@@ -54,6 +55,14 @@ class RealIirFilter {
     template <class U>
     void initArray(U *num, unsigned numLen, U *den, unsigned denLen);
     
+    /**
+     * \brief Filters "data", which can be anything that has size() and operator[], in place.
+     *
+     * "U" is the sample type.
+     */
+    template <class U, class Samples>
+    void filterSamples(Samples & data);
+    
  public:
     std::vector<T> numerator;
     std::vector<T> denominator;
@@ -123,8 +132,17 @@ class RealIirFilter {
      *      the convolution.
      * \return Reference to "data", which holds the result of the convolution.
      */
+    template <class U, template <class> class UAllocator>
+    Vector<U, UAllocator> & filter(Vector<U, UAllocator> & data);
+    
+    /**
+     * \brief Filters the samples that "data" refers to in place.
+     *
+     * \param data The samples that will be filtered.
+     * \return "data", which refers to the filtered data.
+     */
     template <class U>
-    Vector<U> & filter(Vector<U> & data);
+    VectorView<U> filter(VectorView<U> data);
     
 };
 
@@ -146,8 +164,8 @@ void RealIirFilter<T>::initArray(U *num, unsigned numLen, U *den, unsigned denLe
 }
 
 template <class T>
-template <class U>
-Vector<U> & RealIirFilter<T>::filter(Vector<U> & data) {
+template <class U, class Samples>
+void RealIirFilter<T>::filterSamples(Samples & data) {
     unsigned resultIndex, i;
     U newState0;
     
@@ -171,11 +189,29 @@ Vector<U> & RealIirFilter<T>::filter(Vector<U> & data) {
             data[resultIndex] += numerator[i] * state[i];
         }
     }
+}
+
+template <class T>
+template <class U, template <class> class UAllocator>
+Vector<U, UAllocator> & RealIirFilter<T>::filter(Vector<U, UAllocator> & data) {
+    filterSamples<U>(data);
+    return data;
+}
+
+template <class T>
+template <class U>
+VectorView<U> RealIirFilter<T>::filter(VectorView<U> data) {
+    filterSamples<U>(data);
     return data;
 }
 
+template <class T, class U, template <class> class UAllocator>
+Vector<U, UAllocator> & filter(Vector<U, UAllocator> & data, RealIirFilter<T> & filt) {
+    return filt.filter(data);
+}
+
 template <class T, class U>
-Vector<U> & filter(Vector<U> & data, RealIirFilter<T> & filt) {
+VectorView<U> filter(VectorView<U> data, RealIirFilter<T> & filt) {
     return filt.filter(data);
 }
 
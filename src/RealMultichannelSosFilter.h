@@ -0,0 +1,272 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file RealMultichannelSosFilter.h
+ *
+ * Definition of the template class RealMultichannelSosFilter.
+ */
+
+
+#ifndef NimbleDSP_RealMultichannelSosFilter_h
+#define NimbleDSP_RealMultichannelSosFilter_h
+
+#include <vector>
+#include <algorithm>
+#include "Vector.h"
+#include "RealSosFilter.h"
+#include "VectorView.h"
+#include "SimdKernels.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Number of samples per channel that RealMultichannelSosFilter runs through all of its sections at a time.
+ */
+const unsigned MULTICHANNEL_SOS_BLOCK_LEN = 256;
+
+/**
+ * \brief Class for filtering many channels of real data with the same cascade of second-order sections.
+ *
+ * Each channel has its own state, and is filtered exactly as a \ref RealSosFilter would filter it.  The IIR
+ * recursion can't be vectorized within a channel, so instead float and double data is filtered a full SIMD
+ * register of channels at a time.  Data can be sample interleaved (sample "i" of channel "c" at
+ * data[i*numChannels + c]) or planar (data[c*numSamples + i]).  Interleaved data is filtered directly; planar
+ * data is interleaved in blocks first.  Complex data can be filtered by treating the real and imaginary parts as
+ * separate channels.
+ */
+template <class T>
+class RealMultichannelSosFilter {
+ protected:
+    /**
+     * \brief Number of channels.
+     */
+    unsigned numChannels;
+    
+    /**
+     * \brief The state for every channel.  Section "s" has its first state variables for all channels at
+     *      state[2*s*numChannels] and its second state variables right after them.
+     */
+    std::vector<T> state;
+    
+    /**
+     * \brief Interleaved copy of a block of planar data.
+     */
+    std::vector<T> scratchBuf;
+    
+    /**
+     * \brief Runs "numSamples" samples of interleaved data through all of the sections.
+     */
+    void filterBlock(const T *input, unsigned numSamples, T *output);
+    
+ public:
+    /**
+     * \brief The second-order sections, in the order they are applied.
+     */
+    std::vector< BiquadSection<T> > sections;
+    
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Sections constructor.
+     *
+     * \param channels Number of channels.
+     * \param sectionCoeffs The second-order sections, in the order they should be applied.
+     */
+    RealMultichannelSosFilter<T>(unsigned channels, const std::vector< BiquadSection<T> > & sectionCoeffs =
+            std::vector< BiquadSection<T> >()) {numChannels = channels; sections = sectionCoeffs; reset();}
+    
+    /**
+     * \brief Transfer function constructor.  The sections are built as in \ref RealSosFilter.
+     *
+     * \param channels Number of channels.
+     * \param num Numerator coefficients.  num[0] must not be zero.
+     * \param den Denominator coefficients.  den[0] must not be zero.
+     */
+    template <typename U>
+    RealMultichannelSosFilter<T>(unsigned channels, const std::vector<U> & num, const std::vector<U> & den)
+            {numChannels = channels; sections = RealSosFilter<T>(num, den).sections; reset();}
+    
+    /**
+     * \brief Single channel filter constructor.  Every channel is filtered with the sections of "filt".
+     *
+     * \param channels Number of channels.
+     * \param filt The filter to apply to every channel.
+     */
+    template <typename U>
+    RealMultichannelSosFilter<T>(unsigned channels, const RealSosFilter<U> & filt);
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns the number of channels.
+     */
+    unsigned getNumChannels() const {return numChannels;}
+    
+    /**
+     * \brief Filters sample interleaved data.
+     *
+     * \param input The data to filter.  Sample "i" of channel "c" is at input[i*numChannels + c].
+     * \param numSamples Number of samples per channel.
+     * \param output Buffer for the results, with the same layout as "input".  It may be the same buffer as "input".
+     * \return The number of samples per channel written to "output".
+     */
+    unsigned filterInterleaved(const T *input, unsigned numSamples, T *output);
+    
+    /**
+     * \brief Filters planar data.
+     *
+     * \param input The data to filter.  Sample "i" of channel "c" is at input[c*numSamples + i].
+     * \param numSamples Number of samples per channel.
+     * \param output Buffer for the results, with the same layout as "input".  It may be the same buffer as "input".
+     * \return The number of samples per channel written to "output".
+     */
+    unsigned filterPlanar(const T *input, unsigned numSamples, T *output);
+    
+    /**
+     * \brief Filters sample interleaved data in place.
+     *
+     * \param data The data to filter.  Its size must be a multiple of the number of channels.
+     * \return Reference to "data", which holds the filtered data.
+     */
+    template <template <class> class Allocator>
+    Vector<T, Allocator> & filter(Vector<T, Allocator> & data);
+    
+    /**
+     * \brief Filters the sample interleaved data that "data" refers to in place.
+     *
+     * \param data The data to filter.  Its size must be a multiple of the number of channels.
+     * \return "data", which refers to the filtered data.
+     */
+    VectorView<T> filter(VectorView<T> data);
+    
+    /**
+     * \brief Sets the state of every channel to zero.
+     */
+    void reset() {state.assign(2 * sections.size() * numChannels, 0);}
+};
+
+
+template <class T>
+template <typename U>
+RealMultichannelSosFilter<T>::RealMultichannelSosFilter(unsigned channels, const RealSosFilter<U> & filt) {
+    numChannels = channels;
+    sections.resize(filt.sections.size());
+    for (unsigned i=0; i<sections.size(); i++) {
+        BiquadSection<T> section = {(T) filt.sections[i].b0, (T) filt.sections[i].b1, (T) filt.sections[i].b2,
+                                    (T) filt.sections[i].a1, (T) filt.sections[i].a2};
+        sections[i] = section;
+    }
+    reset();
+}
+
+template <class T>
+void RealMultichannelSosFilter<T>::filterBlock(const T *input, unsigned numSamples, T *output) {
+    const T *sectionInput = input;
+    for (unsigned section=0; section<sections.size(); section++) {
+        T coeffs[] = {sections[section].b0, sections[section].b1, sections[section].b2,
+                      sections[section].a1, sections[section].a2};
+        T *z1 = VECTOR_TO_ARRAY(state) + 2*section*numChannels;
+        biquadChannels(coeffs, z1, z1 + numChannels, sectionInput, output, numSamples, numChannels, numChannels);
+        sectionInput = output;
+    }
+}
+
+template <class T>
+unsigned RealMultichannelSosFilter<T>::filterInterleaved(const T *input, unsigned numSamples, T *output) {
+    if (sections.size() == 0 || numChannels == 0) {
+        std::copy(input, input + numSamples * numChannels, output);
+        return numSamples;
+    }
+    
+    // Run a block at a time through all of the sections so that the block stays in the cache.
+    for (unsigned start=0; start<numSamples; start+=MULTICHANNEL_SOS_BLOCK_LEN) {
+        unsigned blockLen = std::min(MULTICHANNEL_SOS_BLOCK_LEN, numSamples - start);
+        filterBlock(input + start*numChannels, blockLen, output + start*numChannels);
+    }
+    return numSamples;
+}
+
+template <class T>
+unsigned RealMultichannelSosFilter<T>::filterPlanar(const T *input, unsigned numSamples, T *output) {
+    if (sections.size() == 0 || numChannels == 0) {
+        std::copy(input, input + numSamples * numChannels, output);
+        return numSamples;
+    }
+    
+    scratchBuf.resize(MULTICHANNEL_SOS_BLOCK_LEN * numChannels);
+    T *buf = VECTOR_TO_ARRAY(scratchBuf);
+    for (unsigned start=0; start<numSamples; start+=MULTICHANNEL_SOS_BLOCK_LEN) {
+        unsigned blockLen = std::min(MULTICHANNEL_SOS_BLOCK_LEN, numSamples - start);
+        for (unsigned channel=0; channel<numChannels; channel++) {
+            const T *in = input + channel*numSamples + start;
+            for (unsigned i=0; i<blockLen; i++) {
+                buf[i*numChannels + channel] = in[i];
+            }
+        }
+        filterBlock(buf, blockLen, buf);
+        for (unsigned channel=0; channel<numChannels; channel++) {
+            T *out = output + channel*numSamples + start;
+            for (unsigned i=0; i<blockLen; i++) {
+                out[i] = buf[i*numChannels + channel];
+            }
+        }
+    }
+    return numSamples;
+}
+
+template <class T>
+template <template <class> class Allocator>
+Vector<T, Allocator> & RealMultichannelSosFilter<T>::filter(Vector<T, Allocator> & data) {
+    assert(numChannels > 0 && data.size() % numChannels == 0);
+    if (data.size() > 0)
+        filterInterleaved(VECTOR_TO_ARRAY(data.vec), data.size() / numChannels, VECTOR_TO_ARRAY(data.vec));
+    data.modified();
+    return data;
+}
+
+template <class T, template <class> class Allocator>
+Vector<T, Allocator> & filter(Vector<T, Allocator> & data, RealMultichannelSosFilter<T> & filt) {
+    return filt.filter(data);
+}
+
+template <class T>
+VectorView<T> RealMultichannelSosFilter<T>::filter(VectorView<T> data) {
+    assert(numChannels > 0 && data.size() % numChannels == 0);
+    processContiguous(data, [this](T *samples, unsigned len) {
+        this->filterInterleaved(samples, len / this->numChannels, samples);
+    });
+    return data;
+}
+
+template <class T>
+VectorView<T> filter(VectorView<T> data, RealMultichannelSosFilter<T> & filt) {
+    return filt.filter(data);
+}
+
+};
+
+#endif
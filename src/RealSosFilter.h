@@ -0,0 +1,410 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file RealSosFilter.h
+ *
+ * Definition of the template class RealSosFilter.
+ */
+
+
+#ifndef NimbleDSP_RealSosFilter_h
+#define NimbleDSP_RealSosFilter_h
+
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <math.h>
+#include "Vector.h"
+#include "VectorView.h"
+#include "RealIirFilter.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Coefficients of one second-order section.
+ *
+ * The section's transfer function is (b0 + b1*z^-1 + b2*z^-2) / (1 + a1*z^-1 + a2*z^-2).
+ */
+template <class T>
+struct BiquadSection {
+    T b0, b1, b2, a1, a2;
+};
+
+/**
+ * \brief Finds the roots of a polynomial.
+ *
+ * Uses the Durand-Kerner method, which finds all of the roots at once, and then polishes each root with Newton's
+ * method.
+ *
+ * \param coeffs Polynomial coefficients, highest power first.  coeffs[0] must not be zero.
+ * \return The coeffs.size() - 1 roots.
+ */
+inline std::vector< std::complex<double> > polynomialRoots(const std::vector<double> & coeffs) {
+    unsigned order = (unsigned) coeffs.size() - 1;
+    std::vector< std::complex<double> > roots(order);
+    if (order == 0)
+        return roots;
+    
+    // The initial guesses just need to be distinct and not symmetric about the real axis.
+    std::complex<double> seed(0.4, 0.9);
+    roots[0] = 1;
+    for (unsigned i=1; i<order; i++) {
+        roots[i] = roots[i - 1] * seed;
+    }
+    
+    for (int iteration=0; iteration<1000; iteration++) {
+        double maxChange = 0;
+        for (unsigned i=0; i<order; i++) {
+            std::complex<double> value = coeffs[0];
+            for (unsigned j=1; j<=order; j++) {
+                value = value * roots[i] + coeffs[j];
+            }
+            std::complex<double> denominator = coeffs[0];
+            for (unsigned j=0; j<order; j++) {
+                if (j != i)
+                    denominator *= roots[i] - roots[j];
+            }
+            std::complex<double> change = value / denominator;
+            roots[i] -= change;
+            maxChange = std::max(maxChange, std::abs(change) / (1 + std::abs(roots[i])));
+        }
+        if (maxChange < 1e-15)
+            break;
+    }
+    
+    // Durand-Kerner converges slowly for clustered roots, so finish each root off with a few Newton iterations.
+    for (unsigned i=0; i<order; i++) {
+        for (int iteration=0; iteration<5; iteration++) {
+            std::complex<double> value = coeffs[0];
+            std::complex<double> derivative = 0;
+            for (unsigned j=1; j<=order; j++) {
+                derivative = derivative * roots[i] + value;
+                value = value * roots[i] + coeffs[j];
+            }
+            if (derivative == std::complex<double>(0, 0))
+                break;
+            roots[i] -= value / derivative;
+        }
+    }
+    return roots;
+}
+
+/**
+ * \brief Class for real IIR filters implemented as a cascade of second-order sections (biquads).
+ *
+ * Each section is implemented in transposed direct form II.  A cascade of biquads is much less sensitive to
+ * coefficient rounding than a single high order direct form filter, which makes high order filters usable
+ * in single precision.  The filter state is kept from call to call, so a stream of data can be filtered in
+ * blocks.
+ */
+template <class T>
+class RealSosFilter {
+ protected:
+    /**
+     * \brief Two state variables per section.
+     */
+    std::vector<T> state;
+    
+    /**
+     * \brief Pairs up roots into the polynomials of second-order sections.
+     *
+     * Complex roots are paired with their conjugates, and real roots are paired with each other in order of
+     * decreasing magnitude.  If there is an odd number of real roots then the last one gets a first-order
+     * polynomial.  Each polynomial is returned as (1, c1, c2), meaning 1 + c1*z^-1 + c2*z^-2, along with its
+     * largest root.
+     */
+    static void pairRoots(std::vector< std::complex<double> > roots, std::vector<double> & c1,
+                          std::vector<double> & c2, std::vector< std::complex<double> > & largestRoots);
+    
+    /**
+     * \brief Sets \ref sections from the transfer function's numerator and denominator.
+     */
+    void initTransferFunction(const std::vector<double> & num, const std::vector<double> & den);
+    
+    /**
+     * \brief Filters "len" samples through "section", in place or from "input" to "output".
+     *
+     * The section's state is held in local variables for the whole block.
+     */
+    template <class U>
+    static void filterSection(const BiquadSection<T> & section, T & z1, T & z2, const U *input, U *output, unsigned len);
+    
+ public:
+    /**
+     * \brief The second-order sections, in the order they are applied.
+     */
+    std::vector< BiquadSection<T> > sections;
+    
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Sections constructor.
+     *
+     * \param sectionCoeffs The second-order sections, in the order they should be applied.
+     */
+    RealSosFilter<T>(const std::vector< BiquadSection<T> > & sectionCoeffs = std::vector< BiquadSection<T> >())
+            {sections = sectionCoeffs; state.assign(2 * sections.size(), 0);}
+    
+    /**
+     * \brief Transfer function vector constructor.
+     *
+     * Factors the numerator and denominator polynomials and groups the zeros and poles into second-order
+     * sections.  The poles closest to the unit circle are put in the last sections, each paired with the
+     * zeros closest to it, and the overall gain is put in the first section.  The factoring is done in
+     * double precision.
+     *
+     * \param num Numerator coefficients.  num[0] must not be zero.
+     * \param den Denominator coefficients.  den[0] must not be zero.
+     */
+    template <typename U>
+    RealSosFilter<T>(const std::vector<U> & num, const std::vector<U> & den)
+            {initTransferFunction(std::vector<double>(num.begin(), num.end()), std::vector<double>(den.begin(), den.end()));}
+    
+    /**
+     * \brief Transfer function array constructor.  See the transfer function vector constructor.
+     *
+     * \param num Numerator coefficients.
+     * \param numLen Number of elements in "num".
+     * \param den Denominator coefficients.
+     * \param denLen Number of elements in "den".
+     */
+    template <typename U>
+    RealSosFilter<T>(const U *num, unsigned numLen, const U *den, unsigned denLen)
+            {initTransferFunction(std::vector<double>(num, num + numLen), std::vector<double>(den, den + denLen));}
+    
+    /**
+     * \brief Converts a direct form filter into second-order sections.  See the transfer function vector constructor.
+     */
+    template <typename U>
+    RealSosFilter<T>(const RealIirFilter<U> & filt)
+            {initTransferFunction(std::vector<double>(filt.numerator.begin(), filt.numerator.end()),
+                                  std::vector<double>(filt.denominator.begin(), filt.denominator.end()));}
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Filters "data" in place.
+     *
+     * \param data The vector that will be filtered.
+     * \return Reference to "data", which holds the filtered data.
+     */
+    template <class U, template <class> class UAllocator>
+    Vector<U, UAllocator> & filter(Vector<U, UAllocator> & data);
+    
+    /**
+     * \brief Filters the samples that "data" refers to in place.
+     *
+     * \param data The samples that will be filtered.
+     * \return "data", which refers to the filtered data.
+     */
+    template <class U>
+    VectorView<U> filter(VectorView<U> data);
+    
+    /**
+     * \brief Filters "input" and puts the results in "output".
+     *
+     * \param input The data to filter.
+     * \param len Number of samples in "input".
+     * \param output Buffer for the "len" results.  It may be the same buffer as "input".
+     * \return The number of samples written to "output".
+     */
+    template <class U>
+    unsigned filter(const U *input, unsigned len, U *output);
+    
+    /**
+     * \brief Sets the filter state to zero.
+     */
+    void reset() {state.assign(2 * sections.size(), 0);}
+};
+
+
+template <class T>
+void RealSosFilter<T>::pairRoots(std::vector< std::complex<double> > roots, std::vector<double> & c1,
+                                 std::vector<double> & c2, std::vector< std::complex<double> > & largestRoots) {
+    std::vector<double> realRoots;
+    
+    c1.clear();
+    c2.clear();
+    largestRoots.clear();
+    for (unsigned i=0; i<roots.size(); i++) {
+        if (fabs(roots[i].imag()) <= 1e-9 * (1 + std::abs(roots[i]))) {
+            realRoots.push_back(roots[i].real());
+        }
+        else if (roots[i].imag() > 0) {
+            // The conjugate is the other root of the pair, so the negative imaginary roots can be ignored.
+            c1.push_back(-2 * roots[i].real());
+            c2.push_back(std::norm(roots[i]));
+            largestRoots.push_back(roots[i]);
+        }
+    }
+    
+    std::sort(realRoots.begin(), realRoots.end());
+    std::vector<double> byMagnitude;
+    for (unsigned i=0; i<realRoots.size(); i++) {
+        byMagnitude.push_back(fabs(realRoots[i]));
+    }
+    while (!realRoots.empty()) {
+        unsigned largest = (unsigned) (std::max_element(byMagnitude.begin(), byMagnitude.end()) - byMagnitude.begin());
+        double root = realRoots[largest];
+        realRoots.erase(realRoots.begin() + largest);
+        byMagnitude.erase(byMagnitude.begin() + largest);
+        largestRoots.push_back(root);
+        if (realRoots.empty()) {
+            c1.push_back(-root);
+            c2.push_back(0);
+            break;
+        }
+        unsigned next = (unsigned) (std::max_element(byMagnitude.begin(), byMagnitude.end()) - byMagnitude.begin());
+        c1.push_back(-(root + realRoots[next]));
+        c2.push_back(root * realRoots[next]);
+        realRoots.erase(realRoots.begin() + next);
+        byMagnitude.erase(byMagnitude.begin() + next);
+    }
+}
+
+template <class T>
+void RealSosFilter<T>::initTransferFunction(const std::vector<double> & num, const std::vector<double> & den) {
+    assert(num.size() > 0 && num[0] != 0);
+    assert(den.size() > 0 && den[0] != 0);
+    
+    std::vector<double> zeroC1, zeroC2, poleC1, poleC2;
+    std::vector< std::complex<double> > zeroRoots, poleRoots;
+    pairRoots(polynomialRoots(num), zeroC1, zeroC2, zeroRoots);
+    pairRoots(polynomialRoots(den), poleC1, poleC2, poleRoots);
+    
+    // Handle the pole pairs from closest to the unit circle to farthest, giving each the closest remaining
+    // zero pair.  Sections without zeros (or poles) get a numerator (or denominator) of 1.
+    unsigned numSections = (unsigned) std::max(zeroC1.size(), poleC1.size());
+    std::vector<bool> poleUsed(poleC1.size(), false), zeroUsed(zeroC1.size(), false);
+    sections.resize(numSections);
+    for (unsigned section=numSections; section>0; section--) {
+        BiquadSection<T> & sos = sections[section - 1];
+        sos.b0 = 1;
+        sos.b1 = sos.b2 = sos.a1 = sos.a2 = 0;
+        
+        int pole = -1;
+        for (unsigned i=0; i<poleC1.size(); i++) {
+            if (!poleUsed[i] && (pole < 0 || std::abs(poleRoots[i]) > std::abs(poleRoots[pole])))
+                pole = i;
+        }
+        int zero = -1;
+        for (unsigned i=0; i<zeroC1.size(); i++) {
+            if (zeroUsed[i])
+                continue;
+            if (pole < 0) {
+                zero = i;
+                break;
+            }
+            if (zero < 0 || std::abs(zeroRoots[i] - poleRoots[pole]) < std::abs(zeroRoots[zero] - poleRoots[pole]))
+                zero = i;
+        }
+        
+        if (pole >= 0) {
+            poleUsed[pole] = true;
+            sos.a1 = (T) poleC1[pole];
+            sos.a2 = (T) poleC2[pole];
+        }
+        if (zero >= 0) {
+            zeroUsed[zero] = true;
+            sos.b1 = (T) zeroC1[zero];
+            sos.b2 = (T) zeroC2[zero];
+        }
+    }
+    
+    if (numSections > 0) {
+        T gain = (T) (num[0] / den[0]);
+        sections[0].b0 *= gain;
+        sections[0].b1 *= gain;
+        sections[0].b2 *= gain;
+    }
+    state.assign(2 * sections.size(), 0);
+}
+
+template <class T>
+template <class U>
+void RealSosFilter<T>::filterSection(const BiquadSection<T> & section, T & z1, T & z2, const U *input, U *output,
+                                     unsigned len) {
+    T b0 = section.b0, b1 = section.b1, b2 = section.b2, a1 = section.a1, a2 = section.a2;
+    T s1 = z1, s2 = z2;
+    
+    for (unsigned i=0; i<len; i++) {
+        T x = (T) input[i];
+        T y = b0 * x + s1;
+        s1 = b1 * x - a1 * y + s2;
+        s2 = b2 * x - a2 * y;
+        output[i] = (U) y;
+    }
+    z1 = s1;
+    z2 = s2;
+}
+
+template <class T>
+template <class U>
+unsigned RealSosFilter<T>::filter(const U *input, unsigned len, U *output) {
+    if (sections.size() == 0) {
+        std::copy(input, input + len, output);
+        return len;
+    }
+    
+    // Run the whole block through one section at a time, so that each section's coefficients and state stay
+    // in registers.
+    filterSection(sections[0], state[0], state[1], input, output, len);
+    for (unsigned section=1; section<sections.size(); section++) {
+        filterSection(sections[section], state[2*section], state[2*section + 1], output, output, len);
+    }
+    return len;
+}
+
+template <class T>
+template <class U, template <class> class UAllocator>
+Vector<U, UAllocator> & RealSosFilter<T>::filter(Vector<U, UAllocator> & data) {
+    if (data.size() > 0)
+        filter(VECTOR_TO_ARRAY(data.vec), data.size(), VECTOR_TO_ARRAY(data.vec));
+    data.modified();
+    return data;
+}
+
+template <class T, class U, template <class> class UAllocator>
+Vector<U, UAllocator> & filter(Vector<U, UAllocator> & data, RealSosFilter<T> & filt) {
+    return filt.filter(data);
+}
+
+template <class T>
+template <class U>
+VectorView<U> RealSosFilter<T>::filter(VectorView<U> data) {
+    processContiguous(data, [this](U *samples, unsigned len) {this->filter(samples, len, samples);});
+    return data;
+}
+
+template <class T, class U>
+VectorView<U> filter(VectorView<U> data, RealSosFilter<T> & filt) {
+    return filt.filter(data);
+}
+
+};
+
+#endif
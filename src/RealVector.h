@@ -31,6 +31,8 @@ THE SOFTWARE.
 #define NimbleDSP_RealVector_h
 
 #include "Vector.h"
+#include "VectorExpression.h"
+#include "VectorView.h"
 #include "ComplexVector.h"
 
 
@@ -39,8 +41,8 @@ namespace NimbleDSP {
 /**
  * \brief Vector class for real numbers.
  */
-template <class T>
-class RealVector : public Vector<T> {
+template <class T, template <class> class Allocator = std::allocator>
+class RealVector : public Vector<T, Allocator> {
  public:
     /*****************************************************************************************
                                         Constructors
@@ -54,10 +56,10 @@ class RealVector : public Vector<T> {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
-    RealVector<T>(unsigned size = DEFAULT_BUF_LEN, std::vector<T> *scratch = NULL) : Vector<T>(size, scratch) {}
+    RealVector<T, Allocator>(unsigned size = DEFAULT_BUF_LEN, std::vector<T, Allocator<T> > *scratch = NULL) : Vector<T, Allocator>(size, scratch) {}
     
     /**
      * \brief Vector constructor.
@@ -69,11 +71,20 @@ class RealVector : public Vector<T> {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
     template <typename U>
-    RealVector<T>(std::vector<U> data, std::vector<T> *scratch = NULL) : Vector<T>(data, scratch) {}
+    RealVector<T, Allocator>(const std::vector<U> & data, std::vector<T, Allocator<T> > *scratch = NULL) : Vector<T, Allocator>(data, scratch) {}
+    
+    /**
+     * \brief Adopting vector constructor.
+     *
+     * Takes over the storage of "data" instead of copying it, e.g. "RealVector<double> v(std::move(stdVector));".
+     * \param data Vector that \ref vec will take the place of.  It is left empty.
+     * \param scratch Pointer to a scratch buffer.  See the basic constructor.
+     */
+    RealVector<T, Allocator>(std::vector<T, Allocator<T> > && data, std::vector<T, Allocator<T> > *scratch = NULL) : Vector<T, Allocator>(std::move(data), scratch) {}
     
     /**
      * \brief Array constructor.
@@ -86,16 +97,31 @@ class RealVector : public Vector<T> {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
     template <typename U>
-    RealVector<T>(U *data, unsigned dataLen, std::vector<T> *scratch = NULL) : Vector<T>(data, dataLen, scratch) {}
+    RealVector<T, Allocator>(U *data, unsigned dataLen, std::vector<T, Allocator<T> > *scratch = NULL) : Vector<T, Allocator>(data, dataLen, scratch) {}
     
     /**
      * \brief Copy constructor.
      */
-    RealVector<T>(const RealVector<T>& other) {this->vec = other.vec;}
+    RealVector<T, Allocator>(const RealVector<T, Allocator>& other) {this->vec = other.vec; this->generation = other.generation;}
+    
+    /**
+     * \brief Move constructor.  Takes over the storage of "other", which is left empty.
+     */
+    RealVector<T, Allocator>(RealVector<T, Allocator>&& other) {this->vec = std::move(other.vec);
+            this->generation = other.generation; other.modified();}
+    
+    /**
+     * \brief Expression constructor.
+     *
+     * Evaluates an expression built from the arithmetic operators, e.g. "RealVector<double> c = a*b + 2.0;",
+     * in a single pass.
+     */
+    template <class E>
+    RealVector<T, Allocator>(const VectorExpression<E>& expr) {evaluateExpression(this->vec, expr);}
     
     /*****************************************************************************************
                                             Operators
@@ -103,56 +129,103 @@ class RealVector : public Vector<T> {
     /**
      * \brief Assignment operator.
      */
-    RealVector<T>& operator=(const Vector<T>& rhs) {this->vec = rhs.vec; return *this;}
+    RealVector<T, Allocator>& operator=(const Vector<T, Allocator>& rhs) {this->vec = rhs.vec; this->modified(); return *this;}
+    
+    /**
+     * \brief Copy assignment operator.
+     */
+    RealVector<T, Allocator>& operator=(const RealVector<T, Allocator>& rhs) {Vector<T, Allocator>::operator=(rhs); return *this;}
+    
+    /**
+     * \brief Move assignment operator.  Takes over the storage of "rhs", which is left empty.
+     */
+    RealVector<T, Allocator>& operator=(Vector<T, Allocator>&& rhs) {this->vec = std::move(rhs.vec); this->modified(); rhs.modified(); return *this;}
+    
+    /**
+     * \brief Move assignment operator.  Takes over the storage of "rhs", which is left empty.
+     */
+    RealVector<T, Allocator>& operator=(RealVector<T, Allocator>&& rhs) {Vector<T, Allocator>::operator=(std::move(rhs)); return *this;}
+    
+    /**
+     * \brief Expression assignment operator.
+     *
+     * Evaluates the expression directly into \ref vec, so no memory is allocated if \ref vec is already big enough.
+     */
+    template <class E>
+    RealVector<T, Allocator>& operator=(const VectorExpression<E>& rhs) {evaluateExpression(this->vec, rhs); this->modified(); return *this;}
     
     /**
      * \brief Unary minus (negation) operator.
      */
-    RealVector<T> & operator-();
+    RealVector<T, Allocator> & operator-();
     
     /**
      * \brief Add Buffer/Assignment operator.
      */
-    template <class U>
-    RealVector<T> & operator+=(const Vector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    RealVector<T, Allocator> & operator+=(const Vector<U, UAllocator> &rhs);
     
     /**
      * \brief Add Scalar/Assignment operator.
      */
-    RealVector<T> & operator+=(const T &rhs);
+    RealVector<T, Allocator> & operator+=(const T &rhs);
+    
+    /**
+     * \brief Add Expression/Assignment operator.
+     */
+    template <class E>
+    RealVector<T, Allocator> & operator+=(const VectorExpression<E> &rhs);
     
     /**
      * \brief Subtract Buffer/Assignment operator.
      */
-    template <class U>
-    RealVector<T> & operator-=(const Vector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    RealVector<T, Allocator> & operator-=(const Vector<U, UAllocator> &rhs);
     
     /**
      * \brief Subtract Scalar/Assignment operator.
      */
-    RealVector<T> & operator-=(const T &rhs);
+    RealVector<T, Allocator> & operator-=(const T &rhs);
+    
+    /**
+     * \brief Subtract Expression/Assignment operator.
+     */
+    template <class E>
+    RealVector<T, Allocator> & operator-=(const VectorExpression<E> &rhs);
     
     /**
      * \brief Multiply Buffer/Assignment operator.
      */
-    template <class U>
-    RealVector<T> & operator*=(const Vector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    RealVector<T, Allocator> & operator*=(const Vector<U, UAllocator> &rhs);
     
     /**
      * \brief Multiply Scalar/Assignment operator.
      */
-    RealVector<T> & operator*=(const T &rhs);
+    RealVector<T, Allocator> & operator*=(const T &rhs);
+    
+    /**
+     * \brief Multiply Expression/Assignment operator.
+     */
+    template <class E>
+    RealVector<T, Allocator> & operator*=(const VectorExpression<E> &rhs);
 
     /**
      * \brief Divide Buffer/Assignment operator.
      */
-    template <class U>
-    RealVector<T> & operator/=(const Vector<U> &rhs);
+    template <class U, template <class> class UAllocator>
+    RealVector<T, Allocator> & operator/=(const Vector<U, UAllocator> &rhs);
     
     /**
      * \brief Divide Scalar/Assignment operator.
      */
-    RealVector<T> & operator/=(const T &rhs);
+    RealVector<T, Allocator> & operator/=(const T &rhs);
+    
+    /**
+     * \brief Divide Expression/Assignment operator.
+     */
+    template <class E>
+    RealVector<T, Allocator> & operator/=(const VectorExpression<E> &rhs);
     
     /*****************************************************************************************
                                              Methods
@@ -163,7 +236,7 @@ class RealVector : public Vector<T> {
      * \param exponent Exponent to use.
      * \return Reference to "this".
      */
-    RealVector<T> & pow(const SLICKDSP_FLOAT_TYPE exponent);
+    RealVector<T, Allocator> & pow(const SLICKDSP_FLOAT_TYPE exponent);
     
     /**
      * \brief Returns the mean (average) of the data in \ref buf.
@@ -213,25 +286,25 @@ class RealVector : public Vector<T> {
      *      any that are less than -val are made equal to -val.
      * \return Reference to "this".
      */
-    RealVector<T> & saturate(T val);
+    RealVector<T, Allocator> & saturate(T val);
 
     /**
      * \brief Does a "ceil" operation on \ref buf.
      * \return Reference to "this".
      */
-    RealVector<T> & ceil(void);
+    RealVector<T, Allocator> & ceil(void);
 
     /**
      * \brief Does a "ceil" operation on \ref buf.
      * \return Reference to "this".
      */
-    RealVector<T> & floor(void);
+    RealVector<T, Allocator> & floor(void);
 
     /**
      * \brief Does a "ceil" operation on \ref buf.
      * \return Reference to "this".
      */
-    RealVector<T> & round(void);
+    RealVector<T, Allocator> & round(void);
 
     /**
      * \brief Convolution method for complex data.
@@ -243,7 +316,7 @@ class RealVector : public Vector<T> {
      *      the convolution.
      * \return Reference to "data", which holds the result of the convolution.
      */
-    virtual ComplexVector<T> & convComplex(ComplexVector<T> & data, bool trimTails);
+    virtual ComplexVector<T, Allocator> & convComplex(ComplexVector<T, Allocator> & data, bool trimTails);
     
     /**
      * \brief Decimate method for complex data.
@@ -258,7 +331,7 @@ class RealVector : public Vector<T> {
      *      ends of the convolution.
      * \return Reference to "data", which holds the result of the decimation.
      */
-    virtual ComplexVector<T> & decimateComplex(ComplexVector<T> & data, int rate, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & decimateComplex(ComplexVector<T, Allocator> & data, int rate, bool trimTails = false);
     
     /**
      * \brief Interpolation method for complex data.
@@ -272,7 +345,7 @@ class RealVector : public Vector<T> {
      *      ends of the convolution.
      * \return Reference to "data", which holds the result of the interpolation.
      */
-    virtual ComplexVector<T> & interpComplex(ComplexVector<T> & data, int rate, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & interpComplex(ComplexVector<T, Allocator> & data, int rate, bool trimTails = false);
     
     /**
      * \brief Resample method for complex data.
@@ -288,35 +361,35 @@ class RealVector : public Vector<T> {
      *      ends of the convolution.
      * \return Reference to "data", which holds the result of the resampling.
      */
-    virtual ComplexVector<T> & resampleComplex(ComplexVector<T> & data, int interpRate, int decimateRate, bool trimTails = false);
+    virtual ComplexVector<T, Allocator> & resampleComplex(ComplexVector<T, Allocator> & data, int interpRate, int decimateRate, bool trimTails = false);
     
     /**
      * \brief Changes the elements of \ref vec to their absolute value.
      *
      * \return Reference to "this".
      */
-    RealVector<T> & abs();
+    RealVector<T, Allocator> & abs();
     
     /**
      * \brief Sets each element of \ref vec to e^(element).
      *
      * \return Reference to "this".
      */
-    RealVector<T> & exp();
+    RealVector<T, Allocator> & exp();
     
     /**
      * \brief Sets each element of \ref vec to the natural log of the element.
      *
      * \return Reference to "this".
      */
-    RealVector<T> & log();
+    RealVector<T, Allocator> & log();
     
     /**
      * \brief Sets each element of \ref vec to the base 10 log of the element.
      *
      * \return Reference to "this".
      */
-    RealVector<T> & log10();
+    RealVector<T, Allocator> & log10();
 
     /**
      * \brief Circular rotation.
@@ -327,14 +400,14 @@ class RealVector : public Vector<T> {
      *      the left, and negative values shift it to the right.
      * \return Reference to "this".
      */
-    RealVector<T> & rotate(int numToShift);
+    RealVector<T, Allocator> & rotate(int numToShift);
     
     /**
      * \brief Reverses the order of the elements in \ref vec.
      *
      * \return Reference to "this".
      */
-    RealVector<T> & reverse();
+    RealVector<T, Allocator> & reverse();
 
     /**
      * \brief Sets the length of \ref vec to "len".
@@ -345,7 +418,7 @@ class RealVector : public Vector<T> {
      * \param val The value to set any new elements to.  Defaults to 0.
      * \return Reference to "this".
      */
-    RealVector<T> & resize(unsigned len, T val = (T) 0) {this->vec.resize(len, val); return *this;}
+    RealVector<T, Allocator> & resize(unsigned len, T val = (T) 0) {this->vec.resize(len, val); this->modified(); return *this;}
     
     /**
      * \brief Lengthens \ref vec by "len" elements.
@@ -354,7 +427,7 @@ class RealVector : public Vector<T> {
      * \param val The value to set the new elements to.  Defaults to 0.
      * \return Reference to "this".
      */
-    RealVector<T> & pad(unsigned len, T val = (T) 0) {this->vec.resize(this->size()+len, val); return *this;}
+    RealVector<T, Allocator> & pad(unsigned len, T val = (T) 0) {this->vec.resize(this->size()+len, val); this->modified(); return *this;}
     
     /**
      * \brief Inserts rate-1 zeros between samples.
@@ -364,7 +437,7 @@ class RealVector : public Vector<T> {
      *      after).  Valid values are 0 to "rate"-1.  Defaults to 0.
      * \return Reference to "this".
      */
-    RealVector<T> & upsample(int rate, int phase = 0);
+    RealVector<T, Allocator> & upsample(int rate, int phase = 0);
     
     /**
      * \brief Removes rate-1 samples out of every rate samples.
@@ -374,7 +447,7 @@ class RealVector : public Vector<T> {
      *      are 0 to "rate"-1.  Defaults to 0.
      * \return Reference to "this".
      */
-    RealVector<T> & downsample(int rate, int phase = 0);
+    RealVector<T, Allocator> & downsample(int rate, int phase = 0);
     
     /**
      * \brief Replaces \ref vec with the cumulative sum of the samples in \ref vec.
@@ -382,7 +455,7 @@ class RealVector : public Vector<T> {
      * \param initialVal Initializing value for the cumulative sum.  Defaults to zero.
      * \return Reference to "this".
      */
-	RealVector<T> & cumsum(T initialVal = 0);
+	RealVector<T, Allocator> & cumsum(T initialVal = 0);
     
     /**
      * \brief Replaces \ref vec with the difference between successive samples in vec.
@@ -390,7 +463,7 @@ class RealVector : public Vector<T> {
      * The resulting \ref vec is one element shorter than it was previously.
      * \return Reference to "this".
      */
-	RealVector<T> & diff();
+	RealVector<T, Allocator> & diff();
     
     /**
      * \brief Replaces \ref vec with the difference between successive samples in vec.
@@ -400,7 +473,7 @@ class RealVector : public Vector<T> {
      *      previous vec.
      * \return Reference to "this".
      */
-    RealVector<T> & diff(T & previousVal);
+    RealVector<T, Allocator> & diff(T & previousVal);
     
     /**
      * \brief Convolution method.
@@ -412,7 +485,7 @@ class RealVector : public Vector<T> {
      *      the convolution.
      * \return Reference to "data", which holds the result of the convolution.
      */
-    virtual RealVector<T> & conv(RealVector<T> & data, bool trimTails = false);
+    virtual RealVector<T, Allocator> & conv(RealVector<T, Allocator> & data, bool trimTails = false);
     
     /**
      * \brief Decimate method.
@@ -427,7 +500,7 @@ class RealVector : public Vector<T> {
      *      ends of the convolution.
      * \return Reference to "data", which holds the result of the decimation.
      */
-    virtual RealVector<T> & decimate(RealVector<T> & data, int rate, bool trimTails = false);
+    virtual RealVector<T, Allocator> & decimate(RealVector<T, Allocator> & data, int rate, bool trimTails = false);
     
     /**
      * \brief Interpolation method.
@@ -441,7 +514,7 @@ class RealVector : public Vector<T> {
      *      ends of the convolution.
      * \return Reference to "data", which holds the result of the interpolation.
      */
-    virtual RealVector<T> & interp(RealVector<T> & data, int rate, bool trimTails = false);
+    virtual RealVector<T, Allocator> & interp(RealVector<T, Allocator> & data, int rate, bool trimTails = false);
     
     /**
      * \brief Resample method.
@@ -457,7 +530,7 @@ class RealVector : public Vector<T> {
      *      ends of the convolution.
      * \return Reference to "data", which holds the result of the resampling.
      */
-    virtual RealVector<T> & resample(RealVector<T> & data, int interpRate, int decimateRate, bool trimTails = false);
+    virtual RealVector<T, Allocator> & resample(RealVector<T, Allocator> & data, int interpRate, int decimateRate, bool trimTails = false);
     
     /**
      * \brief Generates a complex tone.
@@ -480,10 +553,50 @@ class RealVector : public Vector<T> {
      * \return The next phase if the tone were to continue.
      */
     T modulate(T freq, T sampleFreq = 1.0, T phase = 0.0);
+    
+    /**
+     * \brief Generates a real tone, sin(phase), with an NCO.
+     *
+     * \param nco The oscillator.  The tone starts at its current phase, and it is left ready to continue the tone.
+     * \param numSamples The number of samples to generate.  "0" indicates to generate
+     *      this->size() samples.  Defaults to 0.
+     * \return Reference to "this".
+     */
+    RealVector<T, Allocator> & tone(Nco<T> & nco, unsigned numSamples = 0);
+    
+    /**
+     * \brief Modulates the data with a real sinusoid, sin(phase), from an NCO.
+     *
+     * \param nco The oscillator.  The tone starts at its current phase, and it is left ready to continue the tone.
+     * \return Reference to "this".
+     */
+    RealVector<T, Allocator> & modulate(Nco<T> & nco);
+    
+    /**
+     * \brief Calculates the FFT of \ref vec.
+     *
+     * Because the data is real its spectrum is conjugate symmetric, so only the size()/2 + 1 non-redundant
+     * bins are calculated.  This takes roughly half the time and memory of a full complex FFT.
+     * \param results Buffer to put the half spectrum in.  Its \ref domain is set to NimbleDSP::FREQUENCY_DOMAIN.
+     * \return Reference to "results".
+     */
+    ComplexVector<T, Allocator> & fft(ComplexVector<T, Allocator> & results);
+    
+    /**
+     * \brief Sets \ref vec equal to the inverse FFT of a half spectrum.
+     *
+     * This is the inverse of \ref fft.  Like ComplexVector::ifft the results are not scaled by 1/size().
+     * \param halfSpectrum The len/2 + 1 bin half spectrum, as produced by \ref fft.
+     * \param len Number of real points to produce.  Must be 2*(halfSpectrum.size() - 1) or
+     *      2*(halfSpectrum.size() - 1) + 1.  "0" indicates 2*(halfSpectrum.size() - 1).  Defaults to 0.
+     * \return Reference to "this".
+     */
+    RealVector<T, Allocator> & ifft(const ComplexVector<T, Allocator> & halfSpectrum, unsigned len = 0);
 };
 
-template <class T>
-RealVector<T> & RealVector<T>::pow(const SLICKDSP_FLOAT_TYPE exponent) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::pow(const SLICKDSP_FLOAT_TYPE exponent) {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = (T) std::pow(this->vec[i], exponent);
     }
@@ -497,13 +610,13 @@ RealVector<T> & RealVector<T>::pow(const SLICKDSP_FLOAT_TYPE exponent) {
  * \param exponent Exponent to use.
  * \return Reference to "buffer".
  */
-template <class T>
-RealVector<T> & pow(RealVector<T> & buffer, const SLICKDSP_FLOAT_TYPE exponent) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & pow(RealVector<T, Allocator> & buffer, const SLICKDSP_FLOAT_TYPE exponent) {
     return buffer.pow(exponent);
 }
 
-template <class T>
-const SLICKDSP_FLOAT_TYPE RealVector<T>::mean() const {
+template <class T, template <class> class Allocator>
+const SLICKDSP_FLOAT_TYPE RealVector<T, Allocator>::mean() const {
     assert(this->size() > 0);
     SLICKDSP_FLOAT_TYPE sum = 0;
     for (unsigned i=0; i<this->size(); i++) {
@@ -516,13 +629,13 @@ const SLICKDSP_FLOAT_TYPE RealVector<T>::mean() const {
  * \brief Returns the mean (average) of the data in "buffer".
  * \param buffer The buffer to operate on.
  */
-template <class T>
-const SLICKDSP_FLOAT_TYPE mean(RealVector<T> & buffer) {
+template <class T, template <class> class Allocator>
+const SLICKDSP_FLOAT_TYPE mean(RealVector<T, Allocator> & buffer) {
     return buffer.mean();
 }
 
-template <class T>
-const SLICKDSP_FLOAT_TYPE RealVector<T>::var() const {
+template <class T, template <class> class Allocator>
+const SLICKDSP_FLOAT_TYPE RealVector<T, Allocator>::var() const {
     assert(this->size() > 1);
     SLICKDSP_FLOAT_TYPE meanVal = mean();
     SLICKDSP_FLOAT_TYPE sum = 0;
@@ -537,8 +650,8 @@ const SLICKDSP_FLOAT_TYPE RealVector<T>::var() const {
  * \brief Returns the variance of the data in "buffer".
  * \param buffer The buffer to operate on.
  */
-template <class T>
-const SLICKDSP_FLOAT_TYPE var(RealVector<T> & buffer) {
+template <class T, template <class> class Allocator>
+const SLICKDSP_FLOAT_TYPE var(RealVector<T, Allocator> & buffer) {
     return buffer.var();
 }
 
@@ -546,24 +659,25 @@ const SLICKDSP_FLOAT_TYPE var(RealVector<T> & buffer) {
  * \brief Returns the standard deviation of the data in "buffer".
  * \param buffer The buffer to operate on.
  */
-template <class T>
-const SLICKDSP_FLOAT_TYPE stdDev(RealVector<T> & buffer) {
+template <class T, template <class> class Allocator>
+const SLICKDSP_FLOAT_TYPE stdDev(RealVector<T, Allocator> & buffer) {
     return buffer.stdDev();
 }
 
-template <class T>
-const T RealVector<T>::median() {
+template <class T, template <class> class Allocator>
+const T RealVector<T, Allocator>::median() {
     assert(this->size() > 0);
-    std::vector<T> scratchBuf = this->vec;
-    std::sort(scratchBuf.begin(), scratchBuf.end());
+    ScratchBuffer< std::vector<T, Allocator<T> > > sorted(this->scratchBuf, this->size());
+    *sorted = this->vec;
+    std::sort(sorted->begin(), sorted->end());
     if (this->size() & 1) {
         // Odd number of samples
-        return scratchBuf[this->size()/2];
+        return (*sorted)[this->size()/2];
     }
     else {
         // Even number of samples.  Average the two in the middle.
         unsigned topHalfIndex = this->size()/2;
-        return (scratchBuf[topHalfIndex] + scratchBuf[topHalfIndex-1]) / ((T) 2);
+        return ((*sorted)[topHalfIndex] + (*sorted)[topHalfIndex-1]) / ((T) 2);
     }
 }
 
@@ -571,13 +685,13 @@ const T RealVector<T>::median() {
  * \brief Returns the median element of "buffer".
  * \param buffer The buffer to operate on.
  */
-template <class T>
-const T median(RealVector<T> & buffer) {
+template <class T, template <class> class Allocator>
+const T median(RealVector<T, Allocator> & buffer) {
     return buffer.median();
 }
 
-template <class T>
-const T RealVector<T>::max(unsigned *maxLoc) const {
+template <class T, template <class> class Allocator>
+const T RealVector<T, Allocator>::max(unsigned *maxLoc) const {
     assert(this->size() > 0);
     T maxVal = this->vec[0];
     unsigned maxIndex = 0;
@@ -604,13 +718,13 @@ const T RealVector<T>::max(unsigned *maxLoc) const {
  *      to the maximum value the index of the first will be returned.
  *      Defaults to NULL.
  */
-template <class T>
-const T max(RealVector<T> & buffer, unsigned *maxLoc = NULL) {
+template <class T, template <class> class Allocator>
+const T max(RealVector<T, Allocator> & buffer, unsigned *maxLoc = NULL) {
     return buffer.max(maxLoc);
 }
 
-template <class T>
-const T RealVector<T>::min(unsigned *minLoc) const {
+template <class T, template <class> class Allocator>
+const T RealVector<T, Allocator>::min(unsigned *minLoc) const {
     assert(this->size() > 0);
     T minVal = this->vec[0];
     unsigned minIndex = 0;
@@ -636,13 +750,14 @@ const T RealVector<T>::min(unsigned *minLoc) const {
  *      to the minimum value the index of the first will be returned.
  *      Defaults to NULL.
  */
-template <class T>
-const T min(RealVector<T> & buffer, unsigned *minLoc = NULL) {
+template <class T, template <class> class Allocator>
+const T min(RealVector<T, Allocator> & buffer, unsigned *minLoc = NULL) {
     return buffer.min(minLoc);
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::saturate(T val) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::saturate(T val) {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         if (this->vec[i] > val)
             this->vec[i] = val;
@@ -661,52 +776,44 @@ RealVector<T> & RealVector<T>::saturate(T val) {
  *      any that are less than -val are made equal to -val.
  * \return Reference to "buffer".
  */
-template <class T>
-RealVector<T> & saturate(RealVector<T> & buffer, T val) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & saturate(RealVector<T, Allocator> & buffer, T val) {
     return buffer.saturate(val);
 }
 
-template <class T>
-ComplexVector<T> & RealVector<T>::convComplex(ComplexVector<T> & data, bool trimTails) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & RealVector<T, Allocator>::convComplex(ComplexVector<T, Allocator> & data, bool trimTails) {
     int resultIndex;
     int filterIndex;
     int dataIndex;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size());
     *dataTmp = data.vec;
     
     if (trimTails) {
         // Initial partial overlap
         int initialTrim = (this->size() - 1) / 2;
         for (resultIndex=0; resultIndex<((int)this->size()-1) - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=initialTrim + resultIndex; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (; resultIndex<(int)dataTmp->size() - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
                  filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
     }
@@ -715,30 +822,31 @@ ComplexVector<T> & RealVector<T>::convComplex(ComplexVector<T> & data, bool trim
         
         // Initial partial overlap
         for (resultIndex=0; resultIndex<(int)this->size()-1; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=resultIndex; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (; resultIndex<(int)dataTmp->size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex - (this->size()-1), filterIndex=this->size()-1;
                  filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex - (this->size()-1), filterIndex=this->size()-1;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
     }
+    data.modified();
     return data;
 }
 
@@ -753,25 +861,17 @@ ComplexVector<T> & RealVector<T>::convComplex(ComplexVector<T> & data, bool trim
  *      the convolution.
  * \return Reference to "data", which holds the result of the convolution.
  */
-template <class T>
-inline ComplexVector<T> & conv(ComplexVector<T> & data, RealVector<T> & filter, bool trimTails = false) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & conv(ComplexVector<T, Allocator> & data, RealVector<T, Allocator> & filter, bool trimTails = false) {
     return filter.convComplex(data, trimTails);
 }
 
-template <class T>
-ComplexVector<T> & RealVector<T>::decimateComplex(ComplexVector<T> & data, int rate, bool trimTails) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & RealVector<T, Allocator>::decimateComplex(ComplexVector<T, Allocator> & data, int rate, bool trimTails) {
     int resultIndex;
     int filterIndex;
     int dataIndex;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size());
     *dataTmp = data.vec;
     
     if (trimTails) {
@@ -780,27 +880,27 @@ ComplexVector<T> & RealVector<T>::decimateComplex(ComplexVector<T> & data, int r
         // Initial partial overlap
         int initialTrim = (this->size() - 1) / 2;
         for (resultIndex=0; resultIndex<(((int)this->size()-1) - initialTrim + rate - 1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=initialTrim + resultIndex*rate; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (; resultIndex<((int)dataTmp->size() - initialTrim + rate - 1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex*rate - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
                  filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex*rate - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
     }
@@ -809,30 +909,31 @@ ComplexVector<T> & RealVector<T>::decimateComplex(ComplexVector<T> & data, int r
         
         // Initial partial overlap
         for (resultIndex=0; resultIndex<((int)this->size()-1+rate-1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=resultIndex*rate; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (; resultIndex<((int)dataTmp->size()+rate-1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex*rate - (this->size()-1), filterIndex=this->size()-1;
                  filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex*rate - (this->size()-1), filterIndex=this->size()-1;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
     }
+    data.modified();
     return data;
 }
 
@@ -850,26 +951,18 @@ ComplexVector<T> & RealVector<T>::decimateComplex(ComplexVector<T> & data, int r
  *      ends of the convolution.
  * \return Reference to "data", which holds the result of the decimation.
  */
-template <class T>
-inline ComplexVector<T> & decimate(ComplexVector<T> & data, int rate, RealVector<T> & filter, bool trimTails = false) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & decimate(ComplexVector<T, Allocator> & data, int rate, RealVector<T, Allocator> & filter, bool trimTails = false) {
     return filter.decimateComplex(data, rate, trimTails);
 }
 
-template <class T>
-ComplexVector<T> & RealVector<T>::interpComplex(ComplexVector<T> & data, int rate, bool trimTails) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & RealVector<T, Allocator>::interpComplex(ComplexVector<T, Allocator> & data, int rate, bool trimTails) {
     int resultIndex;
     int filterIndex;
     int dataIndex;
     int dataStart, filterStart;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size());
     *dataTmp = data.vec;
     
     if (trimTails) {
@@ -878,18 +971,18 @@ ComplexVector<T> & RealVector<T>::interpComplex(ComplexVector<T> & data, int rat
         // Initial partial overlap
         int initialTrim = (this->size() - 1) / 2;
         for (resultIndex=0, dataStart=0; resultIndex<(int)this->size()-1 - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=initialTrim + resultIndex; filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
        
         // Middle full overlap
         for (dataStart=0, filterStart=(int)this->size()-1; resultIndex<(int)dataTmp->size()*rate - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             ++filterStart;
             if (filterStart >= (int)this->size()) {
@@ -902,10 +995,10 @@ ComplexVector<T> & RealVector<T>::interpComplex(ComplexVector<T> & data, int rat
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             ++filterStart;
             if (filterStart >= (int)this->size()) {
@@ -921,18 +1014,18 @@ ComplexVector<T> & RealVector<T>::interpComplex(ComplexVector<T> & data, int rat
         
         // Initial partial overlap
         for (resultIndex=0, dataStart=0; resultIndex<(int)this->size()-1; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=resultIndex; filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (dataStart=0, filterStart=resultIndex; resultIndex<(int)dataTmp->size()*rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             ++filterStart;
             if (filterStart >= (int)this->size()) {
@@ -945,10 +1038,10 @@ ComplexVector<T> & RealVector<T>::interpComplex(ComplexVector<T> & data, int rat
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             ++filterStart;
             if (filterStart >= (int) this->size()) {
@@ -959,6 +1052,7 @@ ComplexVector<T> & RealVector<T>::interpComplex(ComplexVector<T> & data, int rat
             }
         }
     }
+    data.modified();
     return data;
 }
 
@@ -975,26 +1069,18 @@ ComplexVector<T> & RealVector<T>::interpComplex(ComplexVector<T> & data, int rat
  *      ends of the convolution.
  * \return Reference to "data", which holds the result of the interpolation.
  */
-template <class T>
-inline ComplexVector<T> & interp(ComplexVector<T> & data, int rate, RealVector<T> & filter, bool trimTails = false) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & interp(ComplexVector<T, Allocator> & data, int rate, RealVector<T, Allocator> & filter, bool trimTails = false) {
     return filter.interpComplex(data, rate, trimTails);
 }
 
-template <class T>
-ComplexVector<T> & RealVector<T>::resampleComplex(ComplexVector<T> & data, int interpRate, int decimateRate,  bool trimTails) {
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & RealVector<T, Allocator>::resampleComplex(ComplexVector<T, Allocator> & data, int interpRate, int decimateRate,  bool trimTails) {
     int resultIndex;
     int filterIndex;
     int dataIndex;
     int dataStart, filterStart;
-    std::vector< std::complex<T> > scratch;
-    std::vector< std::complex<T> > *dataTmp;
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    ScratchBuffer< std::vector< std::complex<T>, Allocator< std::complex<T> > > > dataTmp(data.scratchBuf, data.size());
     *dataTmp = data.vec;
     
     if (trimTails) {
@@ -1006,9 +1092,9 @@ ComplexVector<T> & RealVector<T>::resampleComplex(ComplexVector<T> & data, int i
         int initialTrim = (this->size() - 1) / 2;
         for (resultIndex=0, dataStart=0, filterStart=initialTrim;
              resultIndex<((int)this->size()-1 - initialTrim + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=filterStart; filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1021,10 +1107,10 @@ ComplexVector<T> & RealVector<T>::resampleComplex(ComplexVector<T> & data, int i
         
         // Middle full overlap
         for (; resultIndex<((int)dataTmp->size()*interpRate - initialTrim + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1037,10 +1123,10 @@ ComplexVector<T> & RealVector<T>::resampleComplex(ComplexVector<T> & data, int i
         
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1058,9 +1144,9 @@ ComplexVector<T> & RealVector<T>::resampleComplex(ComplexVector<T> & data, int i
         
         // Initial partial overlap
         for (resultIndex=0, dataStart=0, filterStart=0; resultIndex<((int)this->size()-1+decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=filterStart; filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1073,10 +1159,10 @@ ComplexVector<T> & RealVector<T>::resampleComplex(ComplexVector<T> & data, int i
         
         // Middle full overlap
         for (; resultIndex<((int)dataTmp->size()*interpRate + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1089,10 +1175,10 @@ ComplexVector<T> & RealVector<T>::resampleComplex(ComplexVector<T> & data, int i
         
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1103,6 +1189,7 @@ ComplexVector<T> & RealVector<T>::resampleComplex(ComplexVector<T> & data, int i
             }
         }
     }
+    data.modified();
     return data;
 }
 
@@ -1121,14 +1208,15 @@ ComplexVector<T> & RealVector<T>::resampleComplex(ComplexVector<T> & data, int i
  *      ends of the convolution.
  * \return Reference to "data", which holds the result of the resampling.
  */
-template <class T>
-inline ComplexVector<T> & resample(ComplexVector<T> & data, int interpRate, int decimateRate,
-            RealVector<T> & filter, bool trimTails = false) {
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & resample(ComplexVector<T, Allocator> & data, int interpRate, int decimateRate,
+            RealVector<T, Allocator> & filter, bool trimTails = false) {
     return filter.resampleComplex(data, interpRate, decimateRate, trimTails);
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::abs() {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::abs() {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = (T) std::abs(this->vec[i]);
     }
@@ -1141,13 +1229,14 @@ RealVector<T> & RealVector<T>::abs() {
  * \param vector Buffer to operate on.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & abs(RealVector<T> & vector) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & abs(RealVector<T, Allocator> & vector) {
     return vector.abs();
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::exp() {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::exp() {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = (T) std::exp(this->vec[i]);
     }
@@ -1160,13 +1249,14 @@ RealVector<T> & RealVector<T>::exp() {
  * \param vector Buffer to operate on.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & exp(RealVector<T> & vector) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & exp(RealVector<T, Allocator> & vector) {
     return vector.exp();
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::log() {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::log() {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
 		this->vec[i] = (T) std::log(this->vec[i]);
     }
@@ -1179,13 +1269,14 @@ RealVector<T> & RealVector<T>::log() {
  * \param vector Buffer to operate on.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & log(RealVector<T> & vector) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & log(RealVector<T, Allocator> & vector) {
     return vector.log();
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::log10() {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::log10() {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
 		this->vec[i] = (T) std::log10(this->vec[i]);
     }
@@ -1198,13 +1289,14 @@ RealVector<T> & RealVector<T>::log10() {
  * \param vector Buffer to operate on.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & log10(RealVector<T> & vector) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & log10(RealVector<T, Allocator> & vector) {
     return vector.log10();
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::rotate(int numToShift) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::rotate(int numToShift) {
+    this->modified();
     while (numToShift < 0)
         numToShift += this->size();
     
@@ -1228,13 +1320,14 @@ RealVector<T> & RealVector<T>::rotate(int numToShift) {
  *      the left, and negative values shift it to the right.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & rotate(RealVector<T> & vector, int numToShift) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & rotate(RealVector<T, Allocator> & vector, int numToShift) {
     return vector.rotate(numToShift);
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::reverse() {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::reverse() {
+    this->modified();
     std::reverse(this->vec.begin(), this->vec.end());
     return *this;
 }
@@ -1245,8 +1338,8 @@ RealVector<T> & RealVector<T>::reverse() {
  * \param vector Buffer to operate on.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & reverse(RealVector<T> & vector) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & reverse(RealVector<T, Allocator> & vector) {
     return vector.reverse();
 }
 
@@ -1260,8 +1353,8 @@ RealVector<T> & reverse(RealVector<T> & vector) {
  * \param val The value to set any new elements to.  Defaults to 0.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & resize(RealVector<T> & vector, int len, T val = 0) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & resize(RealVector<T, Allocator> & vector, int len, T val = 0) {
     return vector.resize(len, val);
 }
 
@@ -1273,13 +1366,14 @@ RealVector<T> & resize(RealVector<T> & vector, int len, T val = 0) {
  * \param val The value to set the new elements to.  Defaults to 0.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & pad(RealVector<T> & vector, int len, T val = 0) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & pad(RealVector<T, Allocator> & vector, int len, T val = 0) {
     return vector.pad(len, val);
 }
     
-template <class T>
-RealVector<T> & RealVector<T>::upsample(int rate, int phase) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::upsample(int rate, int phase) {
+	this->modified();
 	assert(rate > 0);
 	assert(phase >= 0 && phase < rate);
 	if (rate == 1)
@@ -1304,13 +1398,14 @@ RealVector<T> & RealVector<T>::upsample(int rate, int phase) {
  *      after).  Valid values are 0 to "rate"-1.  Defaults to 0.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & upsample(RealVector<T> & vector, int rate, int phase = 0) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & upsample(RealVector<T, Allocator> & vector, int rate, int phase = 0) {
     return vector.upsample(rate, phase);
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::downsample(int rate, int phase) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::downsample(int rate, int phase) {
+	this->modified();
 	assert(rate > 0);
 	assert(phase >= 0 && phase < rate);
 	if (rate == 1)
@@ -1334,13 +1429,14 @@ RealVector<T> & RealVector<T>::downsample(int rate, int phase) {
  *      are 0 to "rate"-1.  Defaults to 0.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & downsample(RealVector<T> & vector, int rate, int phase = 0) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & downsample(RealVector<T, Allocator> & vector, int rate, int phase = 0) {
     return vector.downsample(rate, phase);
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::cumsum(T initialVal) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::cumsum(T initialVal) {
+    this->modified();
     T sum = initialVal;
     for (unsigned i=0; i<this->size(); i++) {
         sum += this->vec[i];
@@ -1356,13 +1452,14 @@ RealVector<T> & RealVector<T>::cumsum(T initialVal) {
  * \param initialVal Initializing value for the cumulative sum.  Defaults to zero.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & cumsum(RealVector<T> & vector, T initialVal = 0) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & cumsum(RealVector<T, Allocator> & vector, T initialVal = 0) {
     return vector.cumsum(initialVal);
 }
     
-template <class T>
-RealVector<T> & RealVector<T>::diff() {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::diff() {
+	this->modified();
 	assert(this->size() > 1);
 	for (unsigned i=0; i<(this->size()-1); i++) {
 		this->vec[i] = this->vec[i + 1] - this->vec[i];
@@ -1378,13 +1475,14 @@ RealVector<T> & RealVector<T>::diff() {
  * \param vector Buffer to operate on.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & diff(RealVector<T> & vector) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & diff(RealVector<T, Allocator> & vector) {
     return vector.diff();
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::diff(T & previousVal) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::diff(T & previousVal) {
+	this->modified();
 	assert(this->size() > 0);
     T nextPreviousVal = this->vec[this->size()-1];
 	for (unsigned i=this->size()-1; i>0; i--) {
@@ -1404,52 +1502,44 @@ RealVector<T> & RealVector<T>::diff(T & previousVal) {
  *      previous vec.
  * \return Reference to "vector".
  */
-template <class T>
-RealVector<T> & diff(RealVector<T> & vector, T & previousVal) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & diff(RealVector<T, Allocator> & vector, T & previousVal) {
     return vector.diff(previousVal);
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::conv(RealVector<T> & data, bool trimTails) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::conv(RealVector<T, Allocator> & data, bool trimTails) {
     int resultIndex;
     int filterIndex;
     int dataIndex;
-    std::vector<T> scratch;
-    std::vector<T> *dataTmp;
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(data.scratchBuf, data.size());
     *dataTmp = data.vec;
     
     if (trimTails) {
         // Initial partial overlap
         int initialTrim = (this->size() - 1) / 2;
         for (resultIndex=0; resultIndex<((int)this->size()-1) - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=initialTrim + resultIndex; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (; resultIndex<(int)dataTmp->size() - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
                  filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
     }
@@ -1458,30 +1548,31 @@ RealVector<T> & RealVector<T>::conv(RealVector<T> & data, bool trimTails) {
         
         // Initial partial overlap
         for (resultIndex=0; resultIndex<(int)this->size()-1; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=resultIndex; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (; resultIndex<(int)dataTmp->size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex - (this->size()-1), filterIndex=this->size()-1;
                  filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex - (this->size()-1), filterIndex=this->size()-1;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
     }
+    data.modified();
     return data;
 }
 
@@ -1496,25 +1587,17 @@ RealVector<T> & RealVector<T>::conv(RealVector<T> & data, bool trimTails) {
  *      the convolution.
  * \return Reference to "data", which holds the result of the convolution.
  */
-template <class T>
-inline RealVector<T> & conv(RealVector<T> & data, RealVector<T> & filter, bool trimTails = false) {
+template <class T, template <class> class Allocator>
+inline RealVector<T, Allocator> & conv(RealVector<T, Allocator> & data, RealVector<T, Allocator> & filter, bool trimTails = false) {
     return filter.conv(data, trimTails);
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::decimate(RealVector<T> & data, int rate, bool trimTails) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::decimate(RealVector<T, Allocator> & data, int rate, bool trimTails) {
     int resultIndex;
     int filterIndex;
     int dataIndex;
-    std::vector<T> scratch;
-    std::vector<T> *dataTmp;
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(data.scratchBuf, data.size());
     *dataTmp = data.vec;
     
     if (trimTails) {
@@ -1523,27 +1606,27 @@ RealVector<T> & RealVector<T>::decimate(RealVector<T> & data, int rate, bool tri
         // Initial partial overlap
         int initialTrim = (this->size() - 1) / 2;
         for (resultIndex=0; resultIndex<(((int)this->size()-1) - initialTrim + rate - 1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=initialTrim + resultIndex*rate; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (; resultIndex<((int)dataTmp->size() - initialTrim + rate - 1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex*rate - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
                  filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex*rate - ((this->size()-1) - initialTrim), filterIndex=this->size()-1;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
     }
@@ -1552,30 +1635,31 @@ RealVector<T> & RealVector<T>::decimate(RealVector<T> & data, int rate, bool tri
         
         // Initial partial overlap
         for (resultIndex=0; resultIndex<((int)this->size()-1+rate-1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=resultIndex*rate; filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (; resultIndex<((int)dataTmp->size()+rate-1)/rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex*rate - (this->size()-1), filterIndex=this->size()-1;
                  filterIndex>=0; dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=resultIndex*rate - (this->size()-1), filterIndex=this->size()-1;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex--) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
     }
+    data.modified();
     return data;
 }
 
@@ -1593,26 +1677,18 @@ RealVector<T> & RealVector<T>::decimate(RealVector<T> & data, int rate, bool tri
  *      ends of the convolution.
  * \return Reference to "data", which holds the result of the decimation.
  */
-template <class T>
-inline RealVector<T> & decimate(RealVector<T> & data, int rate, RealVector<T> & filter, bool trimTails = false) {
+template <class T, template <class> class Allocator>
+inline RealVector<T, Allocator> & decimate(RealVector<T, Allocator> & data, int rate, RealVector<T, Allocator> & filter, bool trimTails = false) {
     return filter.decimate(data, rate, trimTails);
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::interp(RealVector<T> & data, int rate, bool trimTails) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::interp(RealVector<T, Allocator> & data, int rate, bool trimTails) {
     int resultIndex;
     int filterIndex;
     int dataIndex;
     int dataStart, filterStart;
-    std::vector<T> scratch;
-    std::vector<T> *dataTmp;
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(data.scratchBuf, data.size());
     *dataTmp = data.vec;
     
     if (trimTails) {
@@ -1621,18 +1697,18 @@ RealVector<T> & RealVector<T>::interp(RealVector<T> & data, int rate, bool trimT
         // Initial partial overlap
         int initialTrim = (this->size() - 1) / 2;
         for (resultIndex=0, dataStart=0; resultIndex<(int)this->size()-1 - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=initialTrim + resultIndex; filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
        
         // Middle full overlap
         for (dataStart=0, filterStart=(int)this->size()-1; resultIndex<(int)dataTmp->size()*rate - initialTrim; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             ++filterStart;
             if (filterStart >= (int)this->size()) {
@@ -1645,10 +1721,10 @@ RealVector<T> & RealVector<T>::interp(RealVector<T> & data, int rate, bool trimT
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             ++filterStart;
             if (filterStart >= (int)this->size()) {
@@ -1664,18 +1740,18 @@ RealVector<T> & RealVector<T>::interp(RealVector<T> & data, int rate, bool trimT
         
         // Initial partial overlap
         for (resultIndex=0, dataStart=0; resultIndex<(int)this->size()-1; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=resultIndex; filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
         }
         
         // Middle full overlap
         for (dataStart=0, filterStart=resultIndex; resultIndex<(int)dataTmp->size()*rate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  filterIndex>=0; dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             ++filterStart;
             if (filterStart >= (int)this->size()) {
@@ -1688,10 +1764,10 @@ RealVector<T> & RealVector<T>::interp(RealVector<T> & data, int rate, bool trimT
 
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=rate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             ++filterStart;
             if (filterStart >= (int) this->size()) {
@@ -1702,6 +1778,7 @@ RealVector<T> & RealVector<T>::interp(RealVector<T> & data, int rate, bool trimT
             }
         }
     }
+    data.modified();
     return data;
 }
 
@@ -1718,26 +1795,18 @@ RealVector<T> & RealVector<T>::interp(RealVector<T> & data, int rate, bool trimT
  *      ends of the convolution.
  * \return Reference to "data", which holds the result of the interpolation.
  */
-template <class T>
-inline RealVector<T> & interp(RealVector<T> & data, int rate, RealVector<T> & filter, bool trimTails = false) {
+template <class T, template <class> class Allocator>
+inline RealVector<T, Allocator> & interp(RealVector<T, Allocator> & data, int rate, RealVector<T, Allocator> & filter, bool trimTails = false) {
     return filter.interp(data, rate, trimTails);
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::resample(RealVector<T> & data, int interpRate, int decimateRate,  bool trimTails) {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::resample(RealVector<T, Allocator> & data, int interpRate, int decimateRate,  bool trimTails) {
     int resultIndex;
     int filterIndex;
     int dataIndex;
     int dataStart, filterStart;
-    std::vector<T> scratch;
-    std::vector<T> *dataTmp;
-    
-    if (data.scratchBuf == NULL) {
-        dataTmp = &scratch;
-    }
-    else {
-        dataTmp = data.scratchBuf;
-    }
+    ScratchBuffer< std::vector<T, Allocator<T> > > dataTmp(data.scratchBuf, data.size());
     *dataTmp = data.vec;
     
     if (trimTails) {
@@ -1749,9 +1818,9 @@ RealVector<T> & RealVector<T>::resample(RealVector<T> & data, int interpRate, in
         int initialTrim = (this->size() - 1) / 2;
         for (resultIndex=0, dataStart=0, filterStart=initialTrim;
              resultIndex<((int)this->size()-1 - initialTrim + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=filterStart; filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1764,10 +1833,10 @@ RealVector<T> & RealVector<T>::resample(RealVector<T> & data, int interpRate, in
         
         // Middle full overlap
         for (; resultIndex<((int)dataTmp->size()*interpRate - initialTrim + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1780,10 +1849,10 @@ RealVector<T> & RealVector<T>::resample(RealVector<T> & data, int interpRate, in
         
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1801,9 +1870,9 @@ RealVector<T> & RealVector<T>::resample(RealVector<T> & data, int interpRate, in
         
         // Initial partial overlap
         for (resultIndex=0, dataStart=0, filterStart=0; resultIndex<((int)this->size()-1+decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=0, filterIndex=filterStart; filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1816,10 +1885,10 @@ RealVector<T> & RealVector<T>::resample(RealVector<T> & data, int interpRate, in
         
         // Middle full overlap
         for (; resultIndex<((int)dataTmp->size()*interpRate + decimateRate-1)/decimateRate; resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  filterIndex>=0; dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1832,10 +1901,10 @@ RealVector<T> & RealVector<T>::resample(RealVector<T> & data, int interpRate, in
         
         // Final partial overlap
         for (; resultIndex<(int)data.size(); resultIndex++) {
-            data[resultIndex] = 0;
+            data.vec[resultIndex] = 0;
             for (dataIndex=dataStart, filterIndex=filterStart;
                  dataIndex<(int)dataTmp->size(); dataIndex++, filterIndex-=interpRate) {
-                data[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
+                data.vec[resultIndex] += (*dataTmp)[dataIndex] * this->vec[filterIndex];
             }
             filterStart += decimateRate;
             while (filterStart >= (int)this->size()) {
@@ -1846,6 +1915,7 @@ RealVector<T> & RealVector<T>::resample(RealVector<T> & data, int interpRate, in
             }
         }
     }
+    data.modified();
     return data;
 }
 
@@ -1864,25 +1934,27 @@ RealVector<T> & RealVector<T>::resample(RealVector<T> & data, int interpRate, in
  *      ends of the convolution.
  * \return Reference to "data", which holds the result of the resampling.
  */
-template <class T>
-inline RealVector<T> & resample(RealVector<T> & data, int interpRate, int decimateRate,
-            RealVector<T> & filter, bool trimTails = false) {
+template <class T, template <class> class Allocator>
+inline RealVector<T, Allocator> & resample(RealVector<T, Allocator> & data, int interpRate, int decimateRate,
+            RealVector<T, Allocator> & filter, bool trimTails = false) {
     return filter.resample(data, interpRate, decimateRate, trimTails);
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::operator-()
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator-()
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] = -this->vec[i];
     }
     return *this;
 }
 
-template <class T>
-template <class U>
-RealVector<T> & RealVector<T>::operator+=(const Vector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator+=(const Vector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] += rhs.vec[i];
@@ -1890,33 +1962,30 @@ RealVector<T> & RealVector<T>::operator+=(const Vector<U> &rhs)
     return *this;
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::operator+=(const T &rhs)
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator+=(const T &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] += rhs;
     }
     return *this;
 }
 
-template <class T, class U>
-inline RealVector<T> operator+(RealVector<T> lhs, const Vector<U>& rhs)
+template <class T, template <class> class Allocator>
+template <class E>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator+=(const VectorExpression<E> &rhs)
 {
-    lhs += rhs;
-    return lhs;
-}
-
-template <class T>
-inline RealVector<T> operator+(RealVector<T> lhs, const T& rhs)
-{
-    lhs += rhs;
-    return lhs;
+    this->modified();
+    evaluateExpression(this->vec, *this + rhs);
+    return *this;
 }
 
-template <class T>
-template <class U>
-RealVector<T> & RealVector<T>::operator-=(const Vector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator-=(const Vector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] -= rhs.vec[i];
@@ -1924,33 +1993,30 @@ RealVector<T> & RealVector<T>::operator-=(const Vector<U> &rhs)
     return *this;
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::operator-=(const T &rhs)
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator-=(const T &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] -= rhs;
     }
     return *this;
 }
 
-template <class T, class U>
-inline RealVector<T> operator-(RealVector<T> lhs, const Vector<U>& rhs)
+template <class T, template <class> class Allocator>
+template <class E>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator-=(const VectorExpression<E> &rhs)
 {
-    lhs -= rhs;
-    return lhs;
-}
-
-template <class T>
-inline RealVector<T> operator-(RealVector<T> lhs, const T& rhs)
-{
-    lhs -= rhs;
-    return lhs;
+    this->modified();
+    evaluateExpression(this->vec, *this - rhs);
+    return *this;
 }
 
-template <class T>
-template <class U>
-RealVector<T> & RealVector<T>::operator*=(const Vector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator*=(const Vector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] *= rhs.vec[i];
@@ -1958,33 +2024,30 @@ RealVector<T> & RealVector<T>::operator*=(const Vector<U> &rhs)
     return *this;
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::operator*=(const T &rhs)
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator*=(const T &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] *= rhs;
     }
     return *this;
 }
 
-template <class T, class U>
-inline RealVector<T> operator*(RealVector<T> lhs, const Vector<U>& rhs)
+template <class T, template <class> class Allocator>
+template <class E>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator*=(const VectorExpression<E> &rhs)
 {
-    lhs *= rhs;
-    return lhs;
-}
-
-template <class T>
-inline RealVector<T> operator*(RealVector<T> lhs, const T& rhs)
-{
-    lhs *= rhs;
-    return lhs;
+    this->modified();
+    evaluateExpression(this->vec, *this * rhs);
+    return *this;
 }
 
-template <class T>
-template <class U>
-RealVector<T> & RealVector<T>::operator/=(const Vector<U> &rhs)
+template <class T, template <class> class Allocator>
+template <class U, template <class> class UAllocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator/=(const Vector<U, UAllocator> &rhs)
 {
+    this->modified();
     assert(this->size() == rhs.size());
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] /= rhs.vec[i];
@@ -1992,31 +2055,28 @@ RealVector<T> & RealVector<T>::operator/=(const Vector<U> &rhs)
     return *this;
 }
 
-template <class T>
-RealVector<T> & RealVector<T>::operator/=(const T &rhs)
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator/=(const T &rhs)
 {
+    this->modified();
     for (unsigned i=0; i<this->size(); i++) {
         this->vec[i] /= rhs;
     }
     return *this;
 }
 
-template <class T, class U>
-inline RealVector<T> operator/(RealVector<T> lhs, const Vector<U>& rhs)
-{
-    lhs /= rhs;
-    return lhs;
-}
-
-template <class T>
-inline RealVector<T> operator/(RealVector<T> lhs, const T& rhs)
+template <class T, template <class> class Allocator>
+template <class E>
+RealVector<T, Allocator> & RealVector<T, Allocator>::operator/=(const VectorExpression<E> &rhs)
 {
-    lhs /= rhs;
-    return lhs;
+    this->modified();
+    evaluateExpression(this->vec, *this / rhs);
+    return *this;
 }
 
-template <class T>
-T RealVector<T>::tone(T freq, T sampleFreq, T phase, unsigned numSamples) {
+template <class T, template <class> class Allocator>
+T RealVector<T, Allocator>::tone(T freq, T sampleFreq, T phase, unsigned numSamples) {
+    this->modified();
     assert(sampleFreq > 0.0);
     
     if (numSamples && numSamples != this->size()) {
@@ -2042,13 +2102,14 @@ T RealVector<T>::tone(T freq, T sampleFreq, T phase, unsigned numSamples) {
  *      this->size() samples.  Defaults to 0.
  * \return Reference to "this".
  */
-template <class T>
-T tone(RealVector<T> & vec, T freq, T sampleFreq = 1.0, T phase = 0.0, unsigned numSamples = 0) {
+template <class T, template <class> class Allocator>
+T tone(RealVector<T, Allocator> & vec, T freq, T sampleFreq = 1.0, T phase = 0.0, unsigned numSamples = 0) {
     return vec.tone(freq, sampleFreq, phase, numSamples);
 }
 
-template <class T>
-T RealVector<T>::modulate(T freq, T sampleFreq, T phase) {
+template <class T, template <class> class Allocator>
+T RealVector<T, Allocator>::modulate(T freq, T sampleFreq, T phase) {
+    this->modified();
     assert(sampleFreq > 0.0);
     
     T phaseInc = (freq / sampleFreq) * 2 * M_PI;
@@ -2067,29 +2128,129 @@ T RealVector<T>::modulate(T freq, T sampleFreq, T phase) {
  * \param phase The modulating tone's starting phase, in radians.  Defaults to 0.
  * \return The next phase if the tone were to continue.
  */
- template <class T>
-T modulate(RealVector<T> &data, T freq, T sampleFreq, T phase) {
+ template <class T, template <class> class Allocator>
+T modulate(RealVector<T, Allocator> &data, T freq, T sampleFreq, T phase) {
     return data.modulate(freq, sampleFreq, phase);
 }
 
- template <class T>
- RealVector<T> & RealVector<T>::ceil() {
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::tone(Nco<T> & nco, unsigned numSamples) {
+    this->modified();
+    if (numSamples && numSamples != this->size()) {
+        this->resize(numSamples);
+    }
+    if (this->size() > 0)
+        nco.tone(VECTOR_TO_ARRAY(this->vec), this->size());
+    return *this;
+}
+
+/**
+ * \brief Generates a real tone, sin(phase), with an NCO.
+ *
+ * \param vec The vector to put the tone in.
+ * \param nco The oscillator.  The tone starts at its current phase, and it is left ready to continue the tone.
+ * \param numSamples The number of samples to generate.  "0" indicates to generate
+ *      vec.size() samples.  Defaults to 0.
+ * \return Reference to "vec".
+ */
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & tone(RealVector<T, Allocator> & vec, Nco<T> & nco, unsigned numSamples = 0) {
+    return vec.tone(nco, numSamples);
+}
+
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::modulate(Nco<T> & nco) {
+    this->modified();
+    if (this->size() > 0)
+        nco.modulate(VECTOR_TO_ARRAY(this->vec), this->size());
+    return *this;
+}
+
+/**
+ * \brief Modulates the data with a real sinusoid, sin(phase), from an NCO.
+ *
+ * \param data The data to modulate.
+ * \param nco The oscillator.  The tone starts at its current phase, and it is left ready to continue the tone.
+ * \return Reference to "data".
+ */
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & modulate(RealVector<T, Allocator> & data, Nco<T> & nco) {
+    return data.modulate(nco);
+}
+
+template <class T, template <class> class Allocator>
+ComplexVector<T, Allocator> & RealVector<T, Allocator>::fft(ComplexVector<T, Allocator> & results) {
+    assert(this->size() > 0);
+    
+    results.vec.resize(this->size() / 2 + 1);
+    getRealFftPlan<T>(this->size(), false).transform(VECTOR_TO_ARRAY(this->vec), VECTOR_TO_ARRAY(results.vec));
+    results.domain = FREQUENCY_DOMAIN;
+    results.modified();
+    return results;
+}
+
+/**
+ * \brief Calculates the FFT of the real data in "data".
+ *
+ * Only the data.size()/2 + 1 non-redundant bins are calculated.
+ * \param data Buffer to operate on.
+ * \param results Buffer to put the half spectrum in.
+ * \return Reference to "results".
+ */
+template <class T, template <class> class Allocator>
+inline ComplexVector<T, Allocator> & fft(RealVector<T, Allocator> & data, ComplexVector<T, Allocator> & results) {
+    return data.fft(results);
+}
+
+template <class T, template <class> class Allocator>
+RealVector<T, Allocator> & RealVector<T, Allocator>::ifft(const ComplexVector<T, Allocator> & halfSpectrum, unsigned len) {
+    this->modified();
+    assert(halfSpectrum.size() > 0);
+    
+    if (len == 0) {
+        len = 2 * (halfSpectrum.size() - 1);
+    }
+    assert(len > 0 && len / 2 + 1 == halfSpectrum.size());
+    
+    this->vec.resize(len);
+    getRealFftPlan<T>(len, true).transform(VECTOR_TO_ARRAY(halfSpectrum.vec), VECTOR_TO_ARRAY(this->vec));
+    return *this;
+}
+
+/**
+ * \brief Sets "results" equal to the inverse FFT of the half spectrum "halfSpectrum".
+ *
+ * \param halfSpectrum The half spectrum to transform.
+ * \param results Buffer to put the real results in.
+ * \param len Number of real points to produce.  "0" indicates 2*(halfSpectrum.size() - 1).  Defaults to 0.
+ * \return Reference to "results".
+ */
+template <class T, template <class> class Allocator>
+inline RealVector<T, Allocator> & ifft(const ComplexVector<T, Allocator> & halfSpectrum, RealVector<T, Allocator> & results, unsigned len = 0) {
+    return results.ifft(halfSpectrum, len);
+}
+
+ template <class T, template <class> class Allocator>
+ RealVector<T, Allocator> & RealVector<T, Allocator>::ceil() {
+    this->modified();
  	for (int index=0; index<this->size(); index++) {
  		this->vec[index] = std::ceil(this->vec[index]);
  	}
  	return *this;
  }
 
- template <class T>
- RealVector<T> & RealVector<T>::floor() {
+ template <class T, template <class> class Allocator>
+ RealVector<T, Allocator> & RealVector<T, Allocator>::floor() {
+    this->modified();
  	for (int index=0; index<this->size(); index++) {
  		this->vec[index] = std::floor(this->vec[index]);
  	}
  	return *this;
  }
 
- template <class T>
- RealVector<T> & RealVector<T>::round() {
+ template <class T, template <class> class Allocator>
+ RealVector<T, Allocator> & RealVector<T, Allocator>::round() {
+    this->modified();
  	for (int index=0; index<this->size(); index++) {
  		this->vec[index] = std::round(this->vec[index]);
  	}
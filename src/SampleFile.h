@@ -0,0 +1,865 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file SampleFile.h
+ *
+ * Definition of the SampleFileReader and SampleFileWriter classes, for raw files of real or complex samples with
+ * an optional SigMF-style metadata file.
+ */
+
+#ifndef NimbleDSP_SampleFile_h
+#define NimbleDSP_SampleFile_h
+
+#include <string>
+#include <vector>
+#include <complex>
+#include <limits>
+#include <cmath>
+#include <sstream>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <type_traits>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+#include "NimbleDspCommon.h"
+#include "RealVector.h"
+#include "ComplexVector.h"
+#include "VectorView.h"
+
+#if !defined(NIMBLEDSP_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define NIMBLEDSP_MMAP
+#endif
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief How far ahead of the read position SampleFileReader asks the kernel to fetch the file, in bytes.
+ */
+const unsigned SAMPLE_FILE_READAHEAD_BYTES = 4 << 20;
+
+/**
+ * \brief Default number of samples in each of SampleFileWriter's two buffers.
+ */
+const unsigned DEFAULT_SAMPLE_FILE_WRITER_BUFFER_LEN = 1 << 18;
+
+/**
+ * \brief Description of a sample file, as stored in its SigMF-style metadata file.
+ */
+struct SampleFileMetadata {
+    /**
+     * \brief Format of the samples.
+     */
+    SampleFormat format;
+    
+    /**
+     * \brief Sample rate in Hz.  0 if unknown.
+     */
+    double sampleRate;
+    
+    /**
+     * \brief Center frequency of the capture in Hz.  0 if unknown.
+     */
+    double centerFrequency;
+};
+
+/**
+ * \brief Number of values (1 for real, 2 for complex) in each sample of "format".
+ */
+inline unsigned sampleFormatComponents(SampleFormat format) {
+    return (format == SAMPLE_COMPLEX_INT8 || format == SAMPLE_COMPLEX_INT16 || format == SAMPLE_COMPLEX_FLOAT32) ? 2 : 1;
+}
+
+/**
+ * \brief Size in bytes of each value in "format".
+ */
+inline unsigned sampleFormatComponentSize(SampleFormat format) {
+    switch (format) {
+        case SAMPLE_INT8:
+        case SAMPLE_COMPLEX_INT8:
+            return 1;
+        case SAMPLE_INT16:
+        case SAMPLE_COMPLEX_INT16:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+/**
+ * \brief Size in bytes of each sample in "format".
+ */
+inline unsigned sampleFormatSize(SampleFormat format) {
+    return sampleFormatComponents(format) * sampleFormatComponentSize(format);
+}
+
+/**
+ * \brief SigMF name of "format", e.g. "ci16_le".  Samples are always stored in the host's byte order, which is
+ *      assumed to be little endian.
+ */
+inline std::string sampleFormatName(SampleFormat format) {
+    const char *names[] = {"ri8", "ri16_le", "rf32_le", "ci8", "ci16_le", "cf32_le"};
+    return names[format];
+}
+
+/**
+ * \brief Finds the format with SigMF name "name".
+ *
+ * \return True if "name" is one of the supported formats.
+ */
+inline bool sampleFormatFromName(const std::string & name, SampleFormat & format) {
+    for (int i=SAMPLE_INT8; i<=SAMPLE_COMPLEX_FLOAT32; i++) {
+        if (name == sampleFormatName((SampleFormat) i)) {
+            format = (SampleFormat) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * \brief Path of the metadata file for the data file "dataPath".
+ *
+ * Like SigMF, "capture.sigmf-data" goes with "capture.sigmf-meta".  Any other name just gets ".sigmf-meta" appended.
+ */
+inline std::string sampleFileMetadataPath(const std::string & dataPath) {
+    const std::string dataExtension = ".sigmf-data";
+    if (dataPath.size() >= dataExtension.size() &&
+            dataPath.compare(dataPath.size() - dataExtension.size(), dataExtension.size(), dataExtension) == 0) {
+        return dataPath.substr(0, dataPath.size() - dataExtension.size()) + ".sigmf-meta";
+    }
+    return dataPath + ".sigmf-meta";
+}
+
+/**
+ * \brief Writes the SigMF metadata file for the data file "dataPath".
+ *
+ * \return True on success.
+ */
+inline bool writeSampleFileMetadata(const std::string & dataPath, const SampleFileMetadata & metadata) {
+    std::ofstream file(sampleFileMetadataPath(dataPath).c_str());
+    file.precision(17);
+    file << "{\n"
+         << "    \"global\": {\n"
+         << "        \"core:datatype\": \"" << sampleFormatName(metadata.format) << "\",\n"
+         << "        \"core:sample_rate\": " << metadata.sampleRate << ",\n"
+         << "        \"core:version\": \"1.0.0\"\n"
+         << "    },\n"
+         << "    \"captures\": [\n"
+         << "        {\n"
+         << "            \"core:sample_start\": 0,\n"
+         << "            \"core:frequency\": " << metadata.centerFrequency << "\n"
+         << "        }\n"
+         << "    ],\n"
+         << "    \"annotations\": []\n"
+         << "}\n";
+    return file.good();
+}
+
+/**
+ * \brief Returns the text after "key"'s colon in "json", with leading whitespace and any quotes removed, or an
+ *      empty string if "key" isn't there.  Just enough JSON for the fields that the sample files use.
+ */
+inline std::string sampleFileMetadataValue(const std::string & json, const std::string & key) {
+    std::string quotedKey = "\"" + key + "\"";
+    size_t pos = json.find(quotedKey);
+    if (pos == std::string::npos)
+        return "";
+    pos = json.find(':', pos + quotedKey.size());
+    if (pos == std::string::npos)
+        return "";
+    pos = json.find_first_not_of(" \t\r\n", pos + 1);
+    if (pos == std::string::npos)
+        return "";
+    if (json[pos] == '"') {
+        size_t end = json.find('"', pos + 1);
+        return (end == std::string::npos) ? "" : json.substr(pos + 1, end - pos - 1);
+    }
+    size_t end = json.find_first_of(",}] \t\r\n", pos);
+    return json.substr(pos, end - pos);
+}
+
+/**
+ * \brief Reads the SigMF metadata file for the data file "dataPath".
+ *
+ * The sample rate and center frequency are optional and default to 0.
+ * \return True if the file was found and its datatype is one of the supported formats.
+ */
+inline bool readSampleFileMetadata(const std::string & dataPath, SampleFileMetadata & metadata) {
+    std::ifstream file(sampleFileMetadataPath(dataPath).c_str());
+    if (!file)
+        return false;
+    std::stringstream json;
+    json << file.rdbuf();
+    if (!sampleFormatFromName(sampleFileMetadataValue(json.str(), "core:datatype"), metadata.format))
+        return false;
+    metadata.sampleRate = atof(sampleFileMetadataValue(json.str(), "core:sample_rate").c_str());
+    metadata.centerFrequency = atof(sampleFileMetadataValue(json.str(), "core:frequency").c_str());
+    return true;
+}
+
+/**
+ * \brief The value type and number of values of a real or complex sample type.
+ */
+template <class T>
+struct SampleComponents {
+    typedef T type;
+    static const unsigned count = 1;
+};
+
+template <class T>
+struct SampleComponents< std::complex<T> > {
+    typedef T type;
+    static const unsigned count = 2;
+};
+
+/**
+ * \brief Returns true if "T" is the value type of "format".
+ */
+template <class T>
+bool sampleFormatComponentIs(SampleFormat format) {
+    switch (sampleFormatComponentSize(format)) {
+        case 1: return std::is_same<T, int8_t>::value;
+        case 2: return std::is_same<T, int16_t>::value;
+        default: return std::is_same<T, float>::value;
+    }
+}
+
+/**
+ * \brief Converts one value.  Floating point values are rounded when converted to integers, and integers saturate.
+ *
+ * NaN has no integer equivalent (and casting it is undefined), so it converts to 0.
+ */
+template <class Out, class In>
+Out convertSampleComponent(In value) {
+    if (!std::is_integral<Out>::value)
+        return (Out) value;
+    double rounded = std::is_integral<In>::value ? (double) value : floor((double) value + 0.5);
+    if (std::isnan(rounded))
+        return 0;
+    rounded = std::max(rounded, (double) std::numeric_limits<Out>::min());
+    rounded = std::min(rounded, (double) std::numeric_limits<Out>::max());
+    return (Out) rounded;
+}
+
+/**
+ * \brief Converts "len" samples with "inComponents" values each to "len" samples with "outComponents" values each.
+ *
+ * Real samples can be converted to complex ones, which get an imaginary part of 0, but not the other way around.
+ * \return False, with nothing written, if complex samples were to be converted to real ones.
+ */
+template <class Out, class In>
+bool convertSamples(const In *input, unsigned inComponents, Out *output, unsigned outComponents, unsigned len) {
+    if (inComponents > outComponents)
+        return false;
+    if (inComponents == outComponents) {
+        for (unsigned i=0; i<len*outComponents; i++) {
+            output[i] = convertSampleComponent<Out>(input[i]);
+        }
+    }
+    else {
+        for (unsigned i=0; i<len; i++) {
+            output[2*i] = convertSampleComponent<Out>(input[i]);
+            output[2*i + 1] = 0;
+        }
+    }
+    return true;
+}
+
+/**
+ * \brief Streams samples out of a raw sample file.
+ *
+ * The file is memory mapped, so \ref nextBlock can hand out blocks of the file as views without copying them, e.g.
+ * as the input to a filter's pointer/length conv, decimate or resample.  The kernel is told that the file will be
+ * read sequentially, and the next SAMPLE_FILE_READAHEAD_BYTES past the read position are requested ahead of time,
+ * so multi-gigabyte captures replay at disk speed.  \ref read copies and converts samples into a Vector of any type.
+ *
+ * Where mmap isn't available, or if NIMBLEDSP_NO_MMAP is defined, the whole file is read into memory instead.
+ */
+class SampleFileReader {
+ protected:
+    /**
+     * \brief The file's contents.
+     */
+    const char *data;
+    
+    /**
+     * \brief Size of the file in bytes.
+     */
+    size_t numBytes;
+    
+    /**
+     * \brief True if "data" is a mapping that has to be unmapped.
+     */
+    bool mapped;
+    
+    /**
+     * \brief Holds the file's contents when it isn't mapped.
+     */
+    std::vector<char> contents;
+    
+    /**
+     * \brief True if the file was opened.
+     */
+    bool opened;
+    
+    /**
+     * \brief The format of the samples, and where known the rate and frequency.
+     */
+    SampleFileMetadata metadata;
+    
+    /**
+     * \brief Bytes per sample.  1 if the metadata couldn't be read, so that an unopened reader is empty.
+     */
+    unsigned sampleSize;
+    
+    /**
+     * \brief Index of the next sample to read.
+     */
+    unsigned long long position;
+    
+    /**
+     * \brief End of the region that has been requested from the kernel, in bytes.
+     */
+    size_t readaheadEnd;
+    
+    /**
+     * \brief Opens the file.
+     */
+    void open(const std::string & path);
+    
+    /**
+     * \brief Asks the kernel to start reading the file past the read position.
+     */
+    void readAhead();
+    
+ public:
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Opens a file of samples in "format".  Check \ref isOpen afterwards.
+     *
+     * \param path The file.
+     * \param format The format of the samples.
+     */
+    SampleFileReader(const std::string & path, SampleFormat format) : data(NULL), numBytes(0), mapped(false),
+            opened(false), sampleSize(sampleFormatSize(format)), position(0), readaheadEnd(0) {
+        metadata.format = format;
+        metadata.sampleRate = 0;
+        metadata.centerFrequency = 0;
+        open(path);
+    }
+    
+    /**
+     * \brief Opens a file whose format is given by its metadata file.  Check \ref isOpen afterwards.
+     *
+     * \param path The file.  The metadata file's path is given by \ref sampleFileMetadataPath.
+     */
+    SampleFileReader(const std::string & path) : data(NULL), numBytes(0), mapped(false), opened(false), sampleSize(1),
+            position(0), readaheadEnd(0) {
+        if (readSampleFileMetadata(path, metadata))
+            open(path);
+    }
+    
+    ~SampleFileReader();
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns true if the file (and metadata file, if one was needed) was opened.
+     */
+    bool isOpen() const {return opened;}
+    
+    /**
+     * \brief Returns the file's format, sample rate and center frequency.
+     */
+    const SampleFileMetadata & getMetadata() const {return metadata;}
+    
+    /**
+     * \brief Returns the number of samples in the file.  A partial sample at the end is ignored.
+     */
+    unsigned long long size() const {return numBytes / sampleSize;}
+    
+    /**
+     * \brief Returns the index of the next sample to be read.
+     */
+    unsigned long long tell() const {return position;}
+    
+    /**
+     * \brief Returns the number of samples after the read position.
+     */
+    unsigned long long remaining() const {return size() - position;}
+    
+    /**
+     * \brief Moves the read position to sample "index", or the end of the file if that's sooner.
+     */
+    void seek(unsigned long long index) {
+        position = std::min(index, size());
+        readaheadEnd = position * sampleSize;
+        readAhead();
+    }
+    
+    /**
+     * \brief Returns a view of the next "maxLen" samples (fewer at the end of the file) and advances past them.
+     *
+     * The samples aren't copied.  The view stays valid for the life of the reader.  T must match the file's
+     * format exactly, e.g. std::complex<int16_t> for SAMPLE_COMPLEX_INT16, or float for SAMPLE_FLOAT32.  The view
+     * is empty if the file isn't open or T doesn't match.
+     */
+    template <class T>
+    VectorView<const T> nextBlock(unsigned maxLen);
+    
+    /**
+     * \brief Copies the next "len" samples (fewer at the end of the file) into "output", converting them to T.
+     *
+     * Floating point samples are rounded when T is an integer type, and values that don't fit in T saturate.  Real
+     * files can be read into complex samples, but complex files can't be read into real samples.
+     * \return The number of samples read.  0 if the file isn't open or T is real and the file is complex.
+     */
+    template <class T>
+    unsigned read(T *output, unsigned len);
+    
+    /**
+     * \brief Reads the next "len" samples (fewer at the end of the file) into "output" and resizes it to match.
+     *
+     * \return The number of samples read.
+     */
+    template <class T, template <class> class Allocator>
+    unsigned read(RealVector<T, Allocator> & output, unsigned len) {
+        output.resize((unsigned) std::min((unsigned long long) len, remaining()));
+        return output.size() ? read(VECTOR_TO_ARRAY(output.vec), output.size()) : 0;
+    }
+    
+    /**
+     * \brief Reads the next "len" samples (fewer at the end of the file) into "output" and resizes it to match.
+     *
+     * \return The number of samples read.
+     */
+    template <class T, template <class> class Allocator>
+    unsigned read(ComplexVector<T, Allocator> & output, unsigned len) {
+        output.resize((unsigned) std::min((unsigned long long) len, remaining()));
+        return output.size() ? read(VECTOR_TO_ARRAY(output.vec), output.size()) : 0;
+    }
+    
+ private:
+    SampleFileReader(const SampleFileReader &);
+    SampleFileReader & operator=(const SampleFileReader &);
+};
+
+
+inline void SampleFileReader::open(const std::string & path) {
+    sampleSize = sampleFormatSize(metadata.format);
+#ifdef NIMBLEDSP_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat status;
+    if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        close(fd);
+        return;
+    }
+    // numBytes is only set once the file is mapped, so a reader that failed to open is empty.
+    if (status.st_size > 0) {
+        void *mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            return;
+        }
+        data = (const char *) mapping;
+        numBytes = status.st_size;
+        mapped = true;
+        madvise(mapping, numBytes, MADV_SEQUENTIAL);
+    }
+    close(fd);
+#else
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return;
+    char chunk[65536];
+    size_t chunkLen;
+    while ((chunkLen = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        contents.insert(contents.end(), chunk, chunk + chunkLen);
+    }
+    bool readFailed = (ferror(file) != 0);
+    fclose(file);
+    if (readFailed) {
+        contents.clear();
+        return;
+    }
+    numBytes = contents.size();
+    data = contents.size() ? VECTOR_TO_ARRAY(contents) : NULL;
+#endif
+    opened = true;
+    readAhead();
+}
+
+inline void SampleFileReader::readAhead() {
+#ifdef NIMBLEDSP_MMAP
+    // Top the window up once it's half used, so that the kernel isn't asked for the same pages over and over.
+    size_t readPosition = position * sampleSize;
+    if (!mapped || readaheadEnd >= numBytes || readaheadEnd >= readPosition + SAMPLE_FILE_READAHEAD_BYTES / 2)
+        return;
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t start = std::max(readaheadEnd, readPosition) / pageSize * pageSize;
+    readaheadEnd = std::min(readPosition + SAMPLE_FILE_READAHEAD_BYTES, numBytes);
+    madvise((void *) (data + start), readaheadEnd - start, MADV_WILLNEED);
+#endif
+}
+
+inline SampleFileReader::~SampleFileReader() {
+#ifdef NIMBLEDSP_MMAP
+    if (mapped)
+        munmap((void *) data, numBytes);
+#endif
+}
+
+template <class T>
+VectorView<const T> SampleFileReader::nextBlock(unsigned maxLen) {
+    if (!opened || sizeof(T) != sampleSize || SampleComponents<T>::count != sampleFormatComponents(metadata.format) ||
+            !sampleFormatComponentIs<typename SampleComponents<T>::type>(metadata.format))
+        return VectorView<const T>();
+    unsigned len = (unsigned) std::min((unsigned long long) maxLen, remaining());
+    const T *block = (const T *) (data + position * sampleSize);
+    position += len;
+    readAhead();
+    return VectorView<const T>(block, len);
+}
+
+template <class T>
+unsigned SampleFileReader::read(T *output, unsigned len) {
+    typedef typename SampleComponents<T>::type Component;
+    unsigned inComponents = sampleFormatComponents(metadata.format);
+    if (!opened || inComponents > SampleComponents<T>::count)
+        return 0;
+    len = (unsigned) std::min((unsigned long long) len, remaining());
+    const char *input = data + position * sampleSize;
+    switch (sampleFormatComponentSize(metadata.format)) {
+        case 1:
+            convertSamples((const int8_t *) input, inComponents, (Component *) output, SampleComponents<T>::count, len);
+            break;
+        case 2:
+            convertSamples((const int16_t *) input, inComponents, (Component *) output, SampleComponents<T>::count, len);
+            break;
+        default:
+            convertSamples((const float *) input, inComponents, (Component *) output, SampleComponents<T>::count, len);
+            break;
+    }
+    position += len;
+    readAhead();
+    return len;
+}
+
+/**
+ * \brief Writes samples to a raw sample file from a background thread.
+ *
+ * Samples are converted to the file's format into one of two buffers.  When it fills up it's handed to the
+ * background thread to write, and the other buffer is filled in the meantime, so the caller only waits when the
+ * disk can't keep up.  Floating point samples are rounded and saturated when the file's format is an integer one.
+ * If \ref setMetadata is called, a SigMF-style metadata file is written when the writer is closed.
+ */
+class SampleFileWriter {
+ protected:
+    /**
+     * \brief The file.  NULL if it couldn't be opened.
+     */
+    FILE *file;
+    
+    /**
+     * \brief Path of the file, for the metadata file.
+     */
+    std::string path;
+    
+    /**
+     * \brief The format of the samples, and the rate and frequency for the metadata file.
+     */
+    SampleFileMetadata metadata;
+    
+    /**
+     * \brief True if a metadata file should be written.
+     */
+    bool writeMetadata;
+    
+    /**
+     * \brief Bytes per sample.
+     */
+    unsigned sampleSize;
+    
+    /**
+     * \brief The two buffers.
+     */
+    std::vector<char> buffers[2];
+    
+    /**
+     * \brief Index of the buffer that's being filled.
+     */
+    unsigned activeBuffer;
+    
+    /**
+     * \brief Number of bytes in the buffer that's being filled.
+     */
+    size_t activeBytes;
+    
+    /**
+     * \brief Number of bytes that the background thread has to write from the other buffer.  0 when it's idle.
+     */
+    size_t pendingBytes;
+    
+    /**
+     * \brief Set if a write failed.
+     */
+    bool writeFailed;
+    
+    /**
+     * \brief Set to tell the background thread to exit.
+     */
+    bool stopping;
+    
+    /**
+     * \brief Protects \ref pendingBytes, \ref writeFailed and \ref stopping.
+     */
+    std::mutex mutex;
+    
+    /**
+     * \brief Signalled when \ref pendingBytes or \ref stopping changes.
+     */
+    std::condition_variable changed;
+    
+    /**
+     * \brief The background thread.
+     */
+    std::thread writerThread;
+    
+    /**
+     * \brief Background thread function.
+     */
+    void writeBuffers();
+    
+    /**
+     * \brief Hands the active buffer to the background thread and switches to the other one.
+     */
+    void submit();
+    
+ public:
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Creates (or truncates) a sample file.  Check \ref isOpen afterwards.
+     *
+     * \param path The file.
+     * \param format The format to store the samples in.
+     * \param bufferLen Number of samples in each of the two buffers.
+     */
+    SampleFileWriter(const std::string & path, SampleFormat format,
+                     unsigned bufferLen = DEFAULT_SAMPLE_FILE_WRITER_BUFFER_LEN) : path(path), writeMetadata(false),
+            activeBuffer(0), activeBytes(0), pendingBytes(0), writeFailed(false), stopping(false) {
+        assert(bufferLen > 0);
+        metadata.format = format;
+        metadata.sampleRate = 0;
+        metadata.centerFrequency = 0;
+        sampleSize = sampleFormatSize(format);
+        file = fopen(path.c_str(), "wb");
+        if (file) {
+            buffers[0].resize((size_t) bufferLen * sampleSize);
+            buffers[1].resize((size_t) bufferLen * sampleSize);
+            writerThread = std::thread(&SampleFileWriter::writeBuffers, this);
+        }
+    }
+    
+    /**
+     * \brief Destructor.  Closes the file.
+     */
+    ~SampleFileWriter() {close();}
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns true if the file was opened and hasn't been closed.
+     */
+    bool isOpen() const {return file != NULL;}
+    
+    /**
+     * \brief Returns false if any write has failed.
+     */
+    bool good() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return !writeFailed;
+    }
+    
+    /**
+     * \brief Requests a metadata file with the given sample rate and center frequency, written when the file is closed.
+     */
+    void setMetadata(double sampleRate, double centerFrequency = 0) {
+        metadata.sampleRate = sampleRate;
+        metadata.centerFrequency = centerFrequency;
+        writeMetadata = true;
+    }
+    
+    /**
+     * \brief Converts "len" samples to the file's format and queues them to be written.
+     *
+     * Complex samples can't be written to a real file.  Real samples written to a complex file get an imaginary
+     * part of 0.
+     * \return The number of samples queued, which is "len" unless the file isn't open or T is complex and the file
+     *      is real, in which case it's 0.
+     */
+    template <class T>
+    unsigned write(const T *input, unsigned len);
+    
+    /**
+     * \brief Converts the samples in "input" to the file's format and queues them to be written.
+     */
+    template <class T, template <class> class Allocator>
+    unsigned write(const RealVector<T, Allocator> & input) {
+        return input.size() ? write(VECTOR_TO_ARRAY(input.vec), input.size()) : 0;
+    }
+    
+    /**
+     * \brief Converts the samples in "input" to the file's format and queues them to be written.
+     */
+    template <class T, template <class> class Allocator>
+    unsigned write(const ComplexVector<T, Allocator> & input) {
+        return input.size() ? write(VECTOR_TO_ARRAY(input.vec), input.size()) : 0;
+    }
+    
+    /**
+     * \brief Waits until every queued sample has been handed to the operating system.
+     */
+    void flush();
+    
+    /**
+     * \brief Flushes and closes the file, stops the background thread, and writes the metadata file if requested.
+     *
+     * \return False if any write failed.
+     */
+    bool close();
+    
+ private:
+    SampleFileWriter(const SampleFileWriter &);
+    SampleFileWriter & operator=(const SampleFileWriter &);
+};
+
+
+inline void SampleFileWriter::writeBuffers() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [this]() {return pendingBytes > 0 || stopping;});
+        if (pendingBytes == 0)
+            return;
+        
+        // The writing is done without the lock, so that the other buffer can be filled in the meantime.
+        const char *pending = VECTOR_TO_ARRAY(buffers[1 - activeBuffer]);
+        size_t len = pendingBytes;
+        lock.unlock();
+        bool written = (fwrite(pending, 1, len, file) == len);
+        lock.lock();
+        writeFailed = writeFailed || !written;
+        pendingBytes = 0;
+        changed.notify_all();
+    }
+}
+
+inline void SampleFileWriter::submit() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]() {return pendingBytes == 0;});
+    pendingBytes = activeBytes;
+    activeBuffer = 1 - activeBuffer;
+    activeBytes = 0;
+    changed.notify_all();
+}
+
+template <class T>
+unsigned SampleFileWriter::write(const T *input, unsigned len) {
+    typedef typename SampleComponents<T>::type Component;
+    unsigned outComponents = sampleFormatComponents(metadata.format);
+    if (!file || SampleComponents<T>::count > outComponents)
+        return 0;
+    
+    unsigned numWritten = 0;
+    while (numWritten < len) {
+        unsigned blockLen = std::min(len - numWritten, (unsigned) ((buffers[0].size() - activeBytes) / sampleSize));
+        char *output = VECTOR_TO_ARRAY(buffers[activeBuffer]) + activeBytes;
+        const Component *block = (const Component *) (input + numWritten);
+        switch (sampleFormatComponentSize(metadata.format)) {
+            case 1:
+                convertSamples(block, SampleComponents<T>::count, (int8_t *) output, outComponents, blockLen);
+                break;
+            case 2:
+                convertSamples(block, SampleComponents<T>::count, (int16_t *) output, outComponents, blockLen);
+                break;
+            default:
+                convertSamples(block, SampleComponents<T>::count, (float *) output, outComponents, blockLen);
+                break;
+        }
+        activeBytes += (size_t) blockLen * sampleSize;
+        numWritten += blockLen;
+        if (activeBytes == buffers[0].size())
+            submit();
+    }
+    return len;
+}
+
+inline void SampleFileWriter::flush() {
+    if (!file)
+        return;
+    if (activeBytes > 0)
+        submit();
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]() {return pendingBytes == 0;});
+    writeFailed = writeFailed || fflush(file) != 0;
+}
+
+inline bool SampleFileWriter::close() {
+    if (!file)
+        return !writeFailed;
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        changed.notify_all();
+    }
+    writerThread.join();
+    writeFailed = (fclose(file) != 0) || writeFailed;
+    file = NULL;
+    if (writeMetadata)
+        writeFailed = !writeSampleFileMetadata(path, metadata) || writeFailed;
+    return !writeFailed;
+}
+
+};
+
+#endif
@@ -0,0 +1,240 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file ScratchArena.h
+ *
+ * Definition of the ScratchArena and ScratchBuffer classes, which supply the working buffers that methods like
+ * conv, decimate and median need.
+ */
+
+#ifndef NimbleDSP_ScratchArena_h
+#define NimbleDSP_ScratchArena_h
+
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Maximum number of idle buffers of each type that a thread's arena holds on to.
+ */
+const unsigned MAX_FREE_SCRATCH_BUFFERS = 8;
+
+/**
+ * \brief Usage statistics for the calling thread's scratch arenas.  See \ref scratchArenaStats.
+ */
+struct ScratchArenaStats {
+    /**
+     * \brief Number of buffers handed out.
+     */
+    unsigned long long leases;
+    
+    /**
+     * \brief Number of leases where the buffer had to grow, i.e. allocate memory.  In steady state this stops increasing.
+     */
+    unsigned long long growths;
+    
+    /**
+     * \brief Bytes of storage in the buffers that are currently leased.
+     */
+    std::size_t bytesInUse;
+    
+    /**
+     * \brief Most bytes that have been leased at once.
+     *
+     * A buffer's growth is only seen when it's returned, so if nested leases both grow this can come out lower than
+     * the true peak.
+     */
+    std::size_t highWaterMark;
+};
+
+/**
+ * \brief Returns the scratch arena statistics of the calling thread, covering every buffer type.
+ */
+inline ScratchArenaStats & scratchArenaStats() {
+    static thread_local ScratchArenaStats stats = ScratchArenaStats();
+    return stats;
+}
+
+/**
+ * \brief Resets the calling thread's lease counters and sets the high-water mark to the bytes currently in use.
+ */
+inline void resetScratchArenaStats() {
+    ScratchArenaStats & stats = scratchArenaStats();
+    stats.leases = 0;
+    stats.growths = 0;
+    stats.highWaterMark = stats.bytesInUse;
+}
+
+/**
+ * \brief A thread's pool of idle scratch buffers of type "Buffer" (e.g. std::vector<float>).
+ *
+ * Each thread has its own arena for each buffer type, so no locking is needed and threads never share working
+ * memory.  Buffers keep their capacity while they're idle, so after the first few calls the methods that use
+ * them stop allocating.  Use \ref ScratchBuffer rather than calling the arena directly.
+ */
+template <class Buffer>
+class ScratchArena {
+ protected:
+    /**
+     * \brief Idle buffers, in the order they were returned.
+     */
+    std::vector<Buffer> freeBuffers;
+    
+    static std::size_t bytes(const Buffer & buf) {return buf.capacity() * sizeof(typename Buffer::value_type);}
+    
+ public:
+    /**
+     * \brief Returns the calling thread's arena.
+     */
+    static ScratchArena<Buffer> & threadArena() {
+        static thread_local ScratchArena<Buffer> arena;
+        return arena;
+    }
+    
+    /**
+     * \brief Moves an idle buffer into "buf", and returns the number of bytes it holds.
+     *
+     * \param buf Empty buffer to move the leased buffer into.
+     * \param sizeHint Number of elements the caller expects to need.  The smallest idle buffer that's big enough
+     *      is picked, or the biggest one if none of them are.  With no hint the most recently returned buffer is
+     *      picked.
+     */
+    std::size_t acquire(Buffer & buf, std::size_t sizeHint = 0);
+    
+    /**
+     * \brief Returns a buffer from \ref acquire.
+     *
+     * \param buf The buffer.  It's moved from.
+     * \param leasedBytes The value that \ref acquire returned.
+     */
+    void release(Buffer & buf, std::size_t leasedBytes);
+    
+    /**
+     * \brief Frees the idle buffers.
+     */
+    void clear() {freeBuffers.clear();}
+    
+    /**
+     * \brief Returns the number of idle buffers.
+     */
+    unsigned numFreeBuffers() const {return (unsigned) freeBuffers.size();}
+};
+
+template <class Buffer>
+std::size_t ScratchArena<Buffer>::acquire(Buffer & buf, std::size_t sizeHint) {
+    if (!freeBuffers.empty()) {
+        unsigned pick = (unsigned) freeBuffers.size() - 1;
+        if (sizeHint > 0) {
+            for (unsigned i=0; i<freeBuffers.size(); i++) {
+                std::size_t capacity = freeBuffers[i].capacity();
+                std::size_t pickCapacity = freeBuffers[pick].capacity();
+                if (pickCapacity < sizeHint ? capacity > pickCapacity : (capacity >= sizeHint && capacity < pickCapacity))
+                    pick = i;
+            }
+        }
+        buf = std::move(freeBuffers[pick]);
+        freeBuffers.erase(freeBuffers.begin() + pick);
+    }
+    
+    ScratchArenaStats & stats = scratchArenaStats();
+    std::size_t leasedBytes = bytes(buf);
+    stats.leases++;
+    stats.bytesInUse += leasedBytes;
+    stats.highWaterMark = std::max(stats.highWaterMark, stats.bytesInUse);
+    return leasedBytes;
+}
+
+template <class Buffer>
+void ScratchArena<Buffer>::release(Buffer & buf, std::size_t leasedBytes) {
+    ScratchArenaStats & stats = scratchArenaStats();
+    std::size_t returnedBytes = bytes(buf);
+    if (returnedBytes > leasedBytes) {
+        stats.growths++;
+        stats.highWaterMark = std::max(stats.highWaterMark, stats.bytesInUse + (returnedBytes - leasedBytes));
+    }
+    stats.bytesInUse -= leasedBytes;
+    
+    if (freeBuffers.size() >= MAX_FREE_SCRATCH_BUFFERS) {
+        // Make room by dropping the smallest idle buffer, unless this one is smaller still.
+        unsigned smallest = 0;
+        for (unsigned i=1; i<freeBuffers.size(); i++) {
+            if (freeBuffers[i].capacity() < freeBuffers[smallest].capacity())
+                smallest = i;
+        }
+        if (freeBuffers[smallest].capacity() >= buf.capacity())
+            return;
+        freeBuffers.erase(freeBuffers.begin() + smallest);
+    }
+    freeBuffers.push_back(std::move(buf));
+}
+
+/**
+ * \brief Scoped access to a scratch buffer.
+ *
+ * If the caller supplied a buffer (e.g. a Vector's scratchBuf) that one is used.  Otherwise a buffer is leased from
+ * the calling thread's \ref ScratchArena and given back when the ScratchBuffer goes out of scope.  It's used like a
+ * pointer to the buffer.
+ */
+template <class Buffer>
+class ScratchBuffer {
+ protected:
+    Buffer leased;
+    Buffer *buffer;
+    std::size_t leasedBytes;
+    
+ public:
+    /**
+     * \brief Constructor.
+     *
+     * \param userBuffer Buffer supplied by the caller, or NULL to lease one from the arena.  Defaults to NULL.
+     * \param sizeHint Number of elements the caller expects to need.  See ScratchArena::acquire.
+     */
+    explicit ScratchBuffer(Buffer *userBuffer = NULL, std::size_t sizeHint = 0) : buffer(userBuffer), leasedBytes(0) {
+        if (buffer == NULL) {
+            leasedBytes = ScratchArena<Buffer>::threadArena().acquire(leased, sizeHint);
+            buffer = &leased;
+        }
+    }
+    
+    ~ScratchBuffer() {
+        if (buffer == &leased)
+            ScratchArena<Buffer>::threadArena().release(leased, leasedBytes);
+    }
+    
+    Buffer & operator*() const {return *buffer;}
+    Buffer * operator->() const {return buffer;}
+    Buffer * get() const {return buffer;}
+    
+ private:
+    ScratchBuffer(const ScratchBuffer &);
+    ScratchBuffer & operator=(const ScratchBuffer &);
+};
+
+};
+
+#endif
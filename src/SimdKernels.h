@@ -0,0 +1,809 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file SimdKernels.h
+ *
+ * Dot product kernels used by the FIR filters and the biquad kernel used by the multichannel IIR filter, with SIMD
+ * versions for float and double.  The fixed point filters use the wide accumulator dot products, which have SIMD
+ * versions for int16_t data and taps with an int32_t accumulator.
+ *
+ * On x86 the SSE2, AVX2 (with FMA), or AVX-512 version is picked at run time based on what the
+ * CPU supports.  AVX2 and AVX-512 need GCC or Clang; other compilers get SSE2 on x86-64.  All
+ * other types and platforms use the portable scalar versions.  Define NIMBLEDSP_NO_SIMD to
+ * always use the scalar versions.
+ */
+
+#ifndef NimbleDSP_SimdKernels_h
+#define NimbleDSP_SimdKernels_h
+
+#include <complex>
+#include <stdint.h>
+
+#if !defined(NIMBLEDSP_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64) || \
+        (defined(__i386__) && defined(__SSE2__)))
+#define NIMBLEDSP_SIMD_X86
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define NIMBLEDSP_SIMD_X86_DISPATCH
+#endif
+#endif
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Instruction sets that the SIMD kernels are written for.
+ */
+enum SimdInstructionSet {SIMD_NONE, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512};
+
+/**
+ * \brief Returns sum(a[i] * b[i]) for i = 0 to n - 1.  Portable scalar version.
+ */
+template <class T>
+inline T dotProductScalar(const T *a, const T *b, unsigned n) {
+    T sum = 0;
+    for (unsigned i=0; i<n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+/**
+ * \brief Returns sum(a[i] * b[i]) for i = 0 to n - 1, for complex "a" and real "b".  Portable scalar version.
+ */
+template <class T>
+inline std::complex<T> dotProductScalar(const std::complex<T> *a, const T *b, unsigned n) {
+    std::complex<T> sum = 0;
+    for (unsigned i=0; i<n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+/**
+ * \brief Runs one biquad section over "numChannels" channels of sample interleaved data.  Portable scalar version.
+ *
+ * Each channel is filtered independently in transposed direct form II, with its own state in z1[channel] and
+ * z2[channel].
+ *
+ * \param coeffs The section's coefficients, in the order b0, b1, b2, a1, a2.
+ * \param z1 First state variable of each channel.  Updated on return.
+ * \param z2 Second state variable of each channel.  Updated on return.
+ * \param input Input data.  Sample "i" of channel "c" is at input[i*stride + c].
+ * \param output Output data, with the same layout as "input".  It may be the same buffer as "input".
+ * \param len Number of samples per channel.
+ * \param numChannels Number of channels.
+ * \param stride Distance between consecutive samples of a channel.  Must be at least "numChannels".
+ */
+template <class T>
+inline void biquadChannelsScalar(const T *coeffs, T *z1, T *z2, const T *input, T *output, unsigned len,
+                                 unsigned numChannels, unsigned stride) {
+    T b0 = coeffs[0], b1 = coeffs[1], b2 = coeffs[2], a1 = coeffs[3], a2 = coeffs[4];
+    for (unsigned i=0; i<len; i++) {
+        const T *in = input + i*stride;
+        T *out = output + i*stride;
+        for (unsigned channel=0; channel<numChannels; channel++) {
+            T x = in[channel];
+            T y = b0 * x + z1[channel];
+            z1[channel] = b1 * x - a1 * y + z2[channel];
+            z2[channel] = b2 * x - a2 * y;
+            out[channel] = y;
+        }
+    }
+}
+
+/**
+ * \brief Returns sum(a[i] * b[i]) for i = 0 to n - 1, with every product and the sum calculated in "AccumType".
+ *      Portable scalar version.
+ *
+ * Used by the fixed point filters, where the products of the data and the taps don't fit in the data type.
+ * "AccumType" must be wide enough for the sum.
+ */
+template <class AccumType, class T, class TapType>
+inline AccumType dotProductWideScalar(const T *a, const TapType *b, unsigned n) {
+    AccumType sum = 0;
+    for (unsigned i=0; i<n; i++) {
+        sum += (AccumType) a[i] * (AccumType) b[i];
+    }
+    return sum;
+}
+
+/**
+ * \brief Returns sum(a[i] * b[i]) for i = 0 to n - 1, for complex "a" and real "b", calculated in "AccumType".
+ *      Portable scalar version.
+ */
+template <class AccumType, class T, class TapType>
+inline std::complex<AccumType> dotProductWideScalar(const std::complex<T> *a, const TapType *b, unsigned n) {
+    AccumType sumReal = 0, sumImag = 0;
+    for (unsigned i=0; i<n; i++) {
+        sumReal += (AccumType) a[i].real() * (AccumType) b[i];
+        sumImag += (AccumType) a[i].imag() * (AccumType) b[i];
+    }
+    return std::complex<AccumType>(sumReal, sumImag);
+}
+
+/**
+ * \brief Table of the kernels for one type and instruction set.
+ */
+template <class T>
+struct SimdKernels {
+    /** \brief Real times real. */
+    T (*dot)(const T *a, const T *b, unsigned n);
+    /** \brief Complex times real. */
+    std::complex<T> (*dotComplexReal)(const std::complex<T> *a, const T *b, unsigned n);
+    /** \brief Complex times complex. */
+    std::complex<T> (*dotComplex)(const std::complex<T> *a, const std::complex<T> *b, unsigned n);
+    /** \brief One biquad section over many channels.  See \ref biquadChannelsScalar. */
+    void (*biquadChannels)(const T *coeffs, T *z1, T *z2, const T *input, T *output, unsigned len,
+                           unsigned numChannels, unsigned stride);
+};
+
+/**
+ * \brief Table of the int16_t data and taps, int32_t accumulator kernels for one instruction set.
+ */
+struct SimdInt16Kernels {
+    /** \brief Real times real. */
+    int32_t (*dot)(const int16_t *a, const int16_t *b, unsigned n);
+    /** \brief Complex times real. */
+    std::complex<int32_t> (*dotComplexReal)(const std::complex<int16_t> *a, const int16_t *b, unsigned n);
+};
+
+#ifdef NIMBLEDSP_SIMD_X86
+
+#ifdef NIMBLEDSP_SIMD_X86_DISPATCH
+#define NIMBLEDSP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define NIMBLEDSP_TARGET(isa)
+#endif
+
+/*
+ * Each instruction set has an "ops" struct per type that wraps the intrinsics the kernels need:
+ *      load/store   Unaligned load and store of a full register.
+ *      set1         Sets every lane to the same value.
+ *      mul          a * b
+ *      madd         a * b + c
+ *      loadDup      Loads width/2 values and duplicates each of them, i.e. {p0, p0, p1, p1, ...}
+ *      dupEven      {r0, r0, r2, r2, ...}
+ *      dupOdd       {r1, r1, r3, r3, ...}
+ */
+struct Sse2FloatOps {
+    typedef float Scalar;
+    typedef __m128 Reg;
+    static const unsigned width = 4;
+    NIMBLEDSP_TARGET("sse2") static inline Reg zero() {return _mm_setzero_ps();}
+    NIMBLEDSP_TARGET("sse2") static inline Reg load(const float *p) {return _mm_loadu_ps(p);}
+    NIMBLEDSP_TARGET("sse2") static inline void store(float *p, Reg a) {_mm_storeu_ps(p, a);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg set1(float a) {return _mm_set1_ps(a);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg add(Reg a, Reg b) {return _mm_add_ps(a, b);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg mul(Reg a, Reg b) {return _mm_mul_ps(a, b);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg madd(Reg a, Reg b, Reg c) {return _mm_add_ps(_mm_mul_ps(a, b), c);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg loadDup(const float *p) {return _mm_setr_ps(p[0], p[0], p[1], p[1]);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg dupEven(Reg a) {return _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 0, 0));}
+    NIMBLEDSP_TARGET("sse2") static inline Reg dupOdd(Reg a) {return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 1, 1));}
+};
+
+struct Sse2DoubleOps {
+    typedef double Scalar;
+    typedef __m128d Reg;
+    static const unsigned width = 2;
+    NIMBLEDSP_TARGET("sse2") static inline Reg zero() {return _mm_setzero_pd();}
+    NIMBLEDSP_TARGET("sse2") static inline Reg load(const double *p) {return _mm_loadu_pd(p);}
+    NIMBLEDSP_TARGET("sse2") static inline void store(double *p, Reg a) {_mm_storeu_pd(p, a);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg set1(double a) {return _mm_set1_pd(a);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg add(Reg a, Reg b) {return _mm_add_pd(a, b);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg mul(Reg a, Reg b) {return _mm_mul_pd(a, b);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg madd(Reg a, Reg b, Reg c) {return _mm_add_pd(_mm_mul_pd(a, b), c);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg loadDup(const double *p) {return _mm_set1_pd(p[0]);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg dupEven(Reg a) {return _mm_unpacklo_pd(a, a);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg dupOdd(Reg a) {return _mm_unpackhi_pd(a, a);}
+};
+
+/*
+ * The int16_t ops work on int16_t lanes in and int32_t lanes out:
+ *      madd         Multiplies the int16_t lanes and adds adjacent pairs of products into c's int32_t lanes (pmaddwd).
+ *      mulLo/mulHi  Low and high halves of the 32 bit products of the int16_t lanes.
+ *      unpackLo/Hi  Interleaves the int16_t lanes of the low or high halves (of each 128 bit lane) of a and b.
+ *      add          Adds the int32_t lanes.
+ *      store        Stores the int32_t lanes.
+ */
+struct Sse2Int16Ops {
+    typedef __m128i Reg;
+    static const unsigned width = 8;
+    NIMBLEDSP_TARGET("sse2") static inline Reg zero() {return _mm_setzero_si128();}
+    NIMBLEDSP_TARGET("sse2") static inline Reg load(const int16_t *p) {return _mm_loadu_si128((const __m128i *) p);}
+    NIMBLEDSP_TARGET("sse2") static inline void store(int32_t *p, Reg a) {_mm_storeu_si128((__m128i *) p, a);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg add(Reg a, Reg b) {return _mm_add_epi32(a, b);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg madd(Reg a, Reg b, Reg c) {return _mm_add_epi32(_mm_madd_epi16(a, b), c);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg mulLo(Reg a, Reg b) {return _mm_mullo_epi16(a, b);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg mulHi(Reg a, Reg b) {return _mm_mulhi_epi16(a, b);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg unpackLo(Reg a, Reg b) {return _mm_unpacklo_epi16(a, b);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg unpackHi(Reg a, Reg b) {return _mm_unpackhi_epi16(a, b);}
+    NIMBLEDSP_TARGET("sse2") static inline Reg loadDup(const int16_t *p) {
+        __m128i vals = _mm_loadl_epi64((const __m128i *) p);
+        return _mm_unpacklo_epi16(vals, vals);
+    }
+};
+
+#ifdef NIMBLEDSP_SIMD_X86_DISPATCH
+struct Avx2FloatOps {
+    typedef float Scalar;
+    typedef __m256 Reg;
+    static const unsigned width = 8;
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg zero() {return _mm256_setzero_ps();}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg load(const float *p) {return _mm256_loadu_ps(p);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline void store(float *p, Reg a) {_mm256_storeu_ps(p, a);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg set1(float a) {return _mm256_set1_ps(a);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg add(Reg a, Reg b) {return _mm256_add_ps(a, b);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg mul(Reg a, Reg b) {return _mm256_mul_ps(a, b);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg madd(Reg a, Reg b, Reg c) {return _mm256_fmadd_ps(a, b, c);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg loadDup(const float *p) {
+        __m128 vals = _mm_loadu_ps(p);
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_unpacklo_ps(vals, vals)), _mm_unpackhi_ps(vals, vals), 1);
+    }
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg dupEven(Reg a) {return _mm256_moveldup_ps(a);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg dupOdd(Reg a) {return _mm256_movehdup_ps(a);}
+};
+
+struct Avx2DoubleOps {
+    typedef double Scalar;
+    typedef __m256d Reg;
+    static const unsigned width = 4;
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg zero() {return _mm256_setzero_pd();}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg load(const double *p) {return _mm256_loadu_pd(p);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline void store(double *p, Reg a) {_mm256_storeu_pd(p, a);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg set1(double a) {return _mm256_set1_pd(a);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg add(Reg a, Reg b) {return _mm256_add_pd(a, b);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg mul(Reg a, Reg b) {return _mm256_mul_pd(a, b);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg madd(Reg a, Reg b, Reg c) {return _mm256_fmadd_pd(a, b, c);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg loadDup(const double *p) {return _mm256_setr_pd(p[0], p[0], p[1], p[1]);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg dupEven(Reg a) {return _mm256_movedup_pd(a);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg dupOdd(Reg a) {return _mm256_permute_pd(a, 0xF);}
+};
+
+struct Avx2Int16Ops {
+    typedef __m256i Reg;
+    static const unsigned width = 16;
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg zero() {return _mm256_setzero_si256();}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg load(const int16_t *p) {return _mm256_loadu_si256((const __m256i *) p);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline void store(int32_t *p, Reg a) {_mm256_storeu_si256((__m256i *) p, a);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg add(Reg a, Reg b) {return _mm256_add_epi32(a, b);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg madd(Reg a, Reg b, Reg c) {return _mm256_add_epi32(_mm256_madd_epi16(a, b), c);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg mulLo(Reg a, Reg b) {return _mm256_mullo_epi16(a, b);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg mulHi(Reg a, Reg b) {return _mm256_mulhi_epi16(a, b);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg unpackLo(Reg a, Reg b) {return _mm256_unpacklo_epi16(a, b);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg unpackHi(Reg a, Reg b) {return _mm256_unpackhi_epi16(a, b);}
+    NIMBLEDSP_TARGET("avx2,fma") static inline Reg loadDup(const int16_t *p) {
+        __m128i vals = _mm_loadu_si128((const __m128i *) p);
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(vals, vals)),
+                                       _mm_unpackhi_epi16(vals, vals), 1);
+    }
+};
+
+struct Avx512FloatOps {
+    typedef float Scalar;
+    typedef __m512 Reg;
+    static const unsigned width = 16;
+    // The unmasked shuffles, and the 256 to 512-bit casts, start from an undefined register, which GCC flags as
+    // maybe-uninitialized.  So the shuffles use the zero-masking forms with every lane selected (the same
+    // instructions), and loadDup does a masked load of the low half instead of a cast.
+    static const __mmask16 allLanes = 0xFFFF;
+    NIMBLEDSP_TARGET("avx512f") static inline Reg zero() {return _mm512_setzero_ps();}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg load(const float *p) {return _mm512_loadu_ps(p);}
+    NIMBLEDSP_TARGET("avx512f") static inline void store(float *p, Reg a) {_mm512_storeu_ps(p, a);}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg set1(float a) {return _mm512_set1_ps(a);}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg add(Reg a, Reg b) {return _mm512_add_ps(a, b);}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg mul(Reg a, Reg b) {return _mm512_mul_ps(a, b);}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg madd(Reg a, Reg b, Reg c) {return _mm512_fmadd_ps(a, b, c);}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg loadDup(const float *p) {
+        const __m512i index = _mm512_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7);
+        return _mm512_maskz_permutexvar_ps(allLanes, index, _mm512_maskz_loadu_ps(0x00FF, p));
+    }
+    NIMBLEDSP_TARGET("avx512f") static inline Reg dupEven(Reg a) {return _mm512_maskz_moveldup_ps(allLanes, a);}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg dupOdd(Reg a) {return _mm512_maskz_movehdup_ps(allLanes, a);}
+};
+
+struct Avx512DoubleOps {
+    typedef double Scalar;
+    typedef __m512d Reg;
+    static const unsigned width = 8;
+    static const __mmask8 allLanes = 0xFF;
+    NIMBLEDSP_TARGET("avx512f") static inline Reg zero() {return _mm512_setzero_pd();}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg load(const double *p) {return _mm512_loadu_pd(p);}
+    NIMBLEDSP_TARGET("avx512f") static inline void store(double *p, Reg a) {_mm512_storeu_pd(p, a);}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg set1(double a) {return _mm512_set1_pd(a);}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg add(Reg a, Reg b) {return _mm512_add_pd(a, b);}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg mul(Reg a, Reg b) {return _mm512_mul_pd(a, b);}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg madd(Reg a, Reg b, Reg c) {return _mm512_fmadd_pd(a, b, c);}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg loadDup(const double *p) {
+        const __m512i index = _mm512_setr_epi64(0, 0, 1, 1, 2, 2, 3, 3);
+        return _mm512_maskz_permutexvar_pd(allLanes, index, _mm512_maskz_loadu_pd(0x0F, p));
+    }
+    NIMBLEDSP_TARGET("avx512f") static inline Reg dupEven(Reg a) {return _mm512_maskz_movedup_pd(allLanes, a);}
+    NIMBLEDSP_TARGET("avx512f") static inline Reg dupOdd(Reg a) {return _mm512_maskz_permute_pd(allLanes, a, 0xFF);}
+};
+#endif
+
+/*
+ * The kernels are the same for every instruction set, but each copy has to be compiled with its own
+ * target attribute so that the compiler can inline the intrinsics.  This macro stamps them out.
+ */
+#define NIMBLEDSP_SIMD_KERNELS(isa) \
+template <class Ops> \
+NIMBLEDSP_TARGET(isa) typename Ops::Scalar dot(const typename Ops::Scalar *a, const typename Ops::Scalar *b, unsigned n) { \
+    typedef typename Ops::Scalar T; \
+    const unsigned width = Ops::width; \
+    typename Ops::Reg acc0 = Ops::zero(); \
+    typename Ops::Reg acc1 = Ops::zero(); \
+    unsigned i = 0; \
+    for (; i + 2*width <= n; i += 2*width) { \
+        acc0 = Ops::madd(Ops::load(a + i), Ops::load(b + i), acc0); \
+        acc1 = Ops::madd(Ops::load(a + i + width), Ops::load(b + i + width), acc1); \
+    } \
+    for (; i + width <= n; i += width) { \
+        acc0 = Ops::madd(Ops::load(a + i), Ops::load(b + i), acc0); \
+    } \
+    T lanes[width]; \
+    Ops::store(lanes, Ops::add(acc0, acc1)); \
+    T sum = 0; \
+    for (unsigned lane=0; lane<width; lane++) { \
+        sum += lanes[lane]; \
+    } \
+    for (; i<n; i++) { \
+        sum += a[i] * b[i]; \
+    } \
+    return sum; \
+} \
+\
+template <class Ops> \
+NIMBLEDSP_TARGET(isa) std::complex<typename Ops::Scalar> dotComplexReal(const std::complex<typename Ops::Scalar> *a, \
+        const typename Ops::Scalar *b, unsigned n) { \
+    typedef typename Ops::Scalar T; \
+    const unsigned width = Ops::width; \
+    const T *aScalar = (const T *) a; \
+    typename Ops::Reg acc = Ops::zero(); \
+    unsigned i = 0; \
+    for (; i + width/2 <= n; i += width/2) { \
+        acc = Ops::madd(Ops::load(aScalar + 2*i), Ops::loadDup(b + i), acc); \
+    } \
+    T lanes[width]; \
+    Ops::store(lanes, acc); \
+    std::complex<T> sum = 0; \
+    for (unsigned lane=0; lane<width; lane+=2) { \
+        sum += std::complex<T>(lanes[lane], lanes[lane + 1]); \
+    } \
+    for (; i<n; i++) { \
+        sum += a[i] * b[i]; \
+    } \
+    return sum; \
+} \
+\
+template <class Ops> \
+NIMBLEDSP_TARGET(isa) std::complex<typename Ops::Scalar> dotComplex(const std::complex<typename Ops::Scalar> *a, \
+        const std::complex<typename Ops::Scalar> *b, unsigned n) { \
+    typedef typename Ops::Scalar T; \
+    const unsigned width = Ops::width; \
+    const T *aScalar = (const T *) a; \
+    const T *bScalar = (const T *) b; \
+    typename Ops::Reg accReal = Ops::zero(); \
+    typename Ops::Reg accImag = Ops::zero(); \
+    unsigned i = 0; \
+    for (; i + width/2 <= n; i += width/2) { \
+        typename Ops::Reg aVals = Ops::load(aScalar + 2*i); \
+        typename Ops::Reg bVals = Ops::load(bScalar + 2*i); \
+        accReal = Ops::madd(aVals, Ops::dupEven(bVals), accReal); \
+        accImag = Ops::madd(aVals, Ops::dupOdd(bVals), accImag); \
+    } \
+    T realLanes[width]; \
+    T imagLanes[width]; \
+    Ops::store(realLanes, accReal); \
+    Ops::store(imagLanes, accImag); \
+    std::complex<T> sum = 0; \
+    for (unsigned lane=0; lane<width; lane+=2) { \
+        sum += std::complex<T>(realLanes[lane] - imagLanes[lane + 1], realLanes[lane + 1] + imagLanes[lane]); \
+    } \
+    for (; i<n; i++) { \
+        sum += a[i] * b[i]; \
+    } \
+    return sum; \
+} \
+\
+template <class Ops> \
+NIMBLEDSP_TARGET(isa) void biquadChannels(const typename Ops::Scalar *coeffs, typename Ops::Scalar *z1, \
+        typename Ops::Scalar *z2, const typename Ops::Scalar *input, typename Ops::Scalar *output, unsigned len, \
+        unsigned numChannels, unsigned stride) { \
+    typedef typename Ops::Scalar T; \
+    typedef typename Ops::Reg Reg; \
+    const unsigned width = Ops::width; \
+    Reg b0 = Ops::set1(coeffs[0]); \
+    Reg b1 = Ops::set1(coeffs[1]); \
+    Reg b2 = Ops::set1(coeffs[2]); \
+    Reg negA1 = Ops::set1(-coeffs[3]); \
+    Reg negA2 = Ops::set1(-coeffs[4]); \
+    unsigned channel = 0; \
+    /* The recursion is serial in time, so two groups of channels are run together to hide the latency. */ \
+    for (; channel + 2*width <= numChannels; channel += 2*width) { \
+        Reg s1a = Ops::load(z1 + channel), s2a = Ops::load(z2 + channel); \
+        Reg s1b = Ops::load(z1 + channel + width), s2b = Ops::load(z2 + channel + width); \
+        const T *in = input + channel; \
+        T *out = output + channel; \
+        for (unsigned i=0; i<len; i++, in += stride, out += stride) { \
+            Reg xa = Ops::load(in); \
+            Reg xb = Ops::load(in + width); \
+            Reg ya = Ops::madd(b0, xa, s1a); \
+            Reg yb = Ops::madd(b0, xb, s1b); \
+            s1a = Ops::madd(negA1, ya, Ops::madd(b1, xa, s2a)); \
+            s1b = Ops::madd(negA1, yb, Ops::madd(b1, xb, s2b)); \
+            s2a = Ops::madd(negA2, ya, Ops::mul(b2, xa)); \
+            s2b = Ops::madd(negA2, yb, Ops::mul(b2, xb)); \
+            Ops::store(out, ya); \
+            Ops::store(out + width, yb); \
+        } \
+        Ops::store(z1 + channel, s1a); \
+        Ops::store(z2 + channel, s2a); \
+        Ops::store(z1 + channel + width, s1b); \
+        Ops::store(z2 + channel + width, s2b); \
+    } \
+    for (; channel + width <= numChannels; channel += width) { \
+        Reg s1 = Ops::load(z1 + channel), s2 = Ops::load(z2 + channel); \
+        const T *in = input + channel; \
+        T *out = output + channel; \
+        for (unsigned i=0; i<len; i++, in += stride, out += stride) { \
+            Reg x = Ops::load(in); \
+            Reg y = Ops::madd(b0, x, s1); \
+            s1 = Ops::madd(negA1, y, Ops::madd(b1, x, s2)); \
+            s2 = Ops::madd(negA2, y, Ops::mul(b2, x)); \
+            Ops::store(out, y); \
+        } \
+        Ops::store(z1 + channel, s1); \
+        Ops::store(z2 + channel, s2); \
+    } \
+    if (channel < numChannels) { \
+        biquadChannelsScalar(coeffs, z1 + channel, z2 + channel, input + channel, output + channel, len, \
+                             numChannels - channel, stride); \
+    } \
+}
+
+/*
+ * The int16_t kernels.  The real one is built on pmaddwd, which does two multiplies and an add per int32_t lane.
+ * The complex one needs the real and imaginary products kept apart, so it builds full 32 bit products from the low
+ * and high halves instead.  The int32_t lanes wrap if the sum doesn't fit, where the scalar version would overflow.
+ */
+#define NIMBLEDSP_SIMD_INT16_KERNELS(isa) \
+template <class Ops> \
+NIMBLEDSP_TARGET(isa) int32_t dotInt16(const int16_t *a, const int16_t *b, unsigned n) { \
+    const unsigned width = Ops::width; \
+    typename Ops::Reg acc0 = Ops::zero(); \
+    typename Ops::Reg acc1 = Ops::zero(); \
+    unsigned i = 0; \
+    for (; i + 2*width <= n; i += 2*width) { \
+        acc0 = Ops::madd(Ops::load(a + i), Ops::load(b + i), acc0); \
+        acc1 = Ops::madd(Ops::load(a + i + width), Ops::load(b + i + width), acc1); \
+    } \
+    for (; i + width <= n; i += width) { \
+        acc0 = Ops::madd(Ops::load(a + i), Ops::load(b + i), acc0); \
+    } \
+    int32_t lanes[width/2]; \
+    Ops::store(lanes, Ops::add(acc0, acc1)); \
+    int32_t sum = 0; \
+    for (unsigned lane=0; lane<width/2; lane++) { \
+        sum += lanes[lane]; \
+    } \
+    for (; i<n; i++) { \
+        sum += (int32_t) a[i] * b[i]; \
+    } \
+    return sum; \
+} \
+\
+template <class Ops> \
+NIMBLEDSP_TARGET(isa) std::complex<int32_t> dotComplexInt16(const std::complex<int16_t> *a, const int16_t *b, \
+        unsigned n) { \
+    typedef typename Ops::Reg Reg; \
+    const unsigned width = Ops::width; \
+    const int16_t *aScalar = (const int16_t *) a; \
+    Reg acc0 = Ops::zero(); \
+    Reg acc1 = Ops::zero(); \
+    unsigned i = 0; \
+    for (; i + width/2 <= n; i += width/2) { \
+        Reg aVals = Ops::load(aScalar + 2*i); \
+        Reg bVals = Ops::loadDup(b + i); \
+        Reg lo = Ops::mulLo(aVals, bVals); \
+        Reg hi = Ops::mulHi(aVals, bVals); \
+        /* Even int32_t lanes hold real products and odd lanes hold imaginary products. */ \
+        acc0 = Ops::add(acc0, Ops::unpackLo(lo, hi)); \
+        acc1 = Ops::add(acc1, Ops::unpackHi(lo, hi)); \
+    } \
+    int32_t lanes[width/2]; \
+    Ops::store(lanes, Ops::add(acc0, acc1)); \
+    int32_t sumReal = 0, sumImag = 0; \
+    for (unsigned lane=0; lane<width/2; lane+=2) { \
+        sumReal += lanes[lane]; \
+        sumImag += lanes[lane + 1]; \
+    } \
+    for (; i<n; i++) { \
+        sumReal += (int32_t) a[i].real() * b[i]; \
+        sumImag += (int32_t) a[i].imag() * b[i]; \
+    } \
+    return std::complex<int32_t>(sumReal, sumImag); \
+}
+
+namespace sse2 {
+NIMBLEDSP_SIMD_KERNELS("sse2")
+NIMBLEDSP_SIMD_INT16_KERNELS("sse2")
+};
+
+#ifdef NIMBLEDSP_SIMD_X86_DISPATCH
+namespace avx2 {
+NIMBLEDSP_SIMD_KERNELS("avx2,fma")
+NIMBLEDSP_SIMD_INT16_KERNELS("avx2,fma")
+};
+
+namespace avx512 {
+NIMBLEDSP_SIMD_KERNELS("avx512f")
+};
+#endif
+
+#undef NIMBLEDSP_SIMD_KERNELS
+#undef NIMBLEDSP_SIMD_INT16_KERNELS
+
+/**
+ * \brief Returns the best instruction set that the CPU supports.
+ */
+inline SimdInstructionSet detectSimdInstructionSet() {
+#ifdef NIMBLEDSP_SIMD_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SIMD_AVX2;
+#endif
+    return SIMD_SSE2;
+}
+
+/**
+ * \brief Returns the kernels for type "T" and instruction set "isa".
+ *
+ * "isa" must be supported by the CPU.  Only float and double have SIMD kernels.
+ */
+template <class T>
+SimdKernels<T> getSimdKernels(SimdInstructionSet isa);
+
+template <>
+inline SimdKernels<float> getSimdKernels<float>(SimdInstructionSet isa) {
+    SimdKernels<float> kernels;
+    switch (isa) {
+#ifdef NIMBLEDSP_SIMD_X86_DISPATCH
+      case SIMD_AVX512:
+        kernels.dot = avx512::dot<Avx512FloatOps>;
+        kernels.dotComplexReal = avx512::dotComplexReal<Avx512FloatOps>;
+        kernels.dotComplex = avx512::dotComplex<Avx512FloatOps>;
+        kernels.biquadChannels = avx512::biquadChannels<Avx512FloatOps>;
+        break;
+      case SIMD_AVX2:
+        kernels.dot = avx2::dot<Avx2FloatOps>;
+        kernels.dotComplexReal = avx2::dotComplexReal<Avx2FloatOps>;
+        kernels.dotComplex = avx2::dotComplex<Avx2FloatOps>;
+        kernels.biquadChannels = avx2::biquadChannels<Avx2FloatOps>;
+        break;
+#endif
+      case SIMD_SSE2:
+        kernels.dot = sse2::dot<Sse2FloatOps>;
+        kernels.dotComplexReal = sse2::dotComplexReal<Sse2FloatOps>;
+        kernels.dotComplex = sse2::dotComplex<Sse2FloatOps>;
+        kernels.biquadChannels = sse2::biquadChannels<Sse2FloatOps>;
+        break;
+      default:
+        kernels.dot = dotProductScalar<float>;
+        kernels.dotComplexReal = dotProductScalar<float>;
+        kernels.dotComplex = dotProductScalar< std::complex<float> >;
+        kernels.biquadChannels = biquadChannelsScalar<float>;
+        break;
+    }
+    return kernels;
+}
+
+template <>
+inline SimdKernels<double> getSimdKernels<double>(SimdInstructionSet isa) {
+    SimdKernels<double> kernels;
+    switch (isa) {
+#ifdef NIMBLEDSP_SIMD_X86_DISPATCH
+      case SIMD_AVX512:
+        kernels.dot = avx512::dot<Avx512DoubleOps>;
+        kernels.dotComplexReal = avx512::dotComplexReal<Avx512DoubleOps>;
+        kernels.dotComplex = avx512::dotComplex<Avx512DoubleOps>;
+        kernels.biquadChannels = avx512::biquadChannels<Avx512DoubleOps>;
+        break;
+      case SIMD_AVX2:
+        kernels.dot = avx2::dot<Avx2DoubleOps>;
+        kernels.dotComplexReal = avx2::dotComplexReal<Avx2DoubleOps>;
+        kernels.dotComplex = avx2::dotComplex<Avx2DoubleOps>;
+        kernels.biquadChannels = avx2::biquadChannels<Avx2DoubleOps>;
+        break;
+#endif
+      case SIMD_SSE2:
+        kernels.dot = sse2::dot<Sse2DoubleOps>;
+        kernels.dotComplexReal = sse2::dotComplexReal<Sse2DoubleOps>;
+        kernels.dotComplex = sse2::dotComplex<Sse2DoubleOps>;
+        kernels.biquadChannels = sse2::biquadChannels<Sse2DoubleOps>;
+        break;
+      default:
+        kernels.dot = dotProductScalar<double>;
+        kernels.dotComplexReal = dotProductScalar<double>;
+        kernels.dotComplex = dotProductScalar< std::complex<double> >;
+        kernels.biquadChannels = biquadChannelsScalar<double>;
+        break;
+    }
+    return kernels;
+}
+
+/**
+ * \brief Returns the int16_t kernels for instruction set "isa", which must be supported by the CPU.
+ *
+ * There are no AVX-512 versions (they would need AVX512BW), so SIMD_AVX512 gets the AVX2 versions.
+ */
+inline SimdInt16Kernels getSimdInt16Kernels(SimdInstructionSet isa) {
+    SimdInt16Kernels kernels;
+    switch (isa) {
+#ifdef NIMBLEDSP_SIMD_X86_DISPATCH
+      case SIMD_AVX512:
+      case SIMD_AVX2:
+        kernels.dot = avx2::dotInt16<Avx2Int16Ops>;
+        kernels.dotComplexReal = avx2::dotComplexInt16<Avx2Int16Ops>;
+        break;
+#endif
+      case SIMD_SSE2:
+        kernels.dot = sse2::dotInt16<Sse2Int16Ops>;
+        kernels.dotComplexReal = sse2::dotComplexInt16<Sse2Int16Ops>;
+        break;
+      default:
+        kernels.dot = dotProductWideScalar<int32_t, int16_t, int16_t>;
+        kernels.dotComplexReal = dotProductWideScalar<int32_t, int16_t, int16_t>;
+        break;
+    }
+    return kernels;
+}
+
+/**
+ * \brief Returns the kernels for the best instruction set that the CPU supports.  Selected once, on first use.
+ */
+template <class T>
+const SimdKernels<T> & bestSimdKernels() {
+    static const SimdKernels<T> kernels = getSimdKernels<T>(detectSimdInstructionSet());
+    return kernels;
+}
+
+/**
+ * \brief Returns the int16_t kernels for the best instruction set that the CPU supports.  Selected once, on first use.
+ */
+inline const SimdInt16Kernels & bestSimdInt16Kernels() {
+    static const SimdInt16Kernels kernels = getSimdInt16Kernels(detectSimdInstructionSet());
+    return kernels;
+}
+
+#undef NIMBLEDSP_TARGET
+
+#else
+
+inline SimdInstructionSet detectSimdInstructionSet() {return SIMD_NONE;}
+
+#endif
+
+/**
+ * \brief Returns sum(a[i] * b[i]) for i = 0 to n - 1.
+ *
+ * float and double (and complex versions of them) use the fastest SIMD kernel that the CPU supports.
+ * Everything else uses the portable scalar version.
+ */
+template <class T>
+inline T dotProduct(const T *a, const T *b, unsigned n) {
+    return dotProductScalar(a, b, n);
+}
+
+/**
+ * \brief Returns sum(a[i] * b[i]) for i = 0 to n - 1, for complex "a" and real "b".
+ */
+template <class T>
+inline std::complex<T> dotProduct(const std::complex<T> *a, const T *b, unsigned n) {
+    return dotProductScalar(a, b, n);
+}
+
+/**
+ * \brief Runs one biquad section over "numChannels" channels of sample interleaved data.
+ *
+ * See \ref biquadChannelsScalar for the parameters.  float and double use the fastest SIMD kernel that the CPU
+ * supports, which filters a full register of channels per instruction.
+ */
+template <class T>
+inline void biquadChannels(const T *coeffs, T *z1, T *z2, const T *input, T *output, unsigned len,
+                           unsigned numChannels, unsigned stride) {
+    biquadChannelsScalar(coeffs, z1, z2, input, output, len, numChannels, stride);
+}
+
+/**
+ * \brief Returns sum(a[i] * b[i]) for i = 0 to n - 1, calculated in "AccumType".  See \ref dotProductWideScalar.
+ *
+ * int16_t data and taps with an int32_t accumulator use the fastest SIMD kernel that the CPU supports.
+ */
+template <class AccumType, class T, class TapType>
+inline AccumType dotProductWide(const T *a, const TapType *b, unsigned n) {
+    return dotProductWideScalar<AccumType>(a, b, n);
+}
+
+/**
+ * \brief Returns sum(a[i] * b[i]) for i = 0 to n - 1, for complex "a" and real "b", calculated in "AccumType".
+ */
+template <class AccumType, class T, class TapType>
+inline std::complex<AccumType> dotProductWide(const std::complex<T> *a, const TapType *b, unsigned n) {
+    return dotProductWideScalar<AccumType>(a, b, n);
+}
+
+#ifdef NIMBLEDSP_SIMD_X86
+inline float dotProduct(const float *a, const float *b, unsigned n) {
+    return bestSimdKernels<float>().dot(a, b, n);
+}
+
+inline double dotProduct(const double *a, const double *b, unsigned n) {
+    return bestSimdKernels<double>().dot(a, b, n);
+}
+
+inline std::complex<float> dotProduct(const std::complex<float> *a, const float *b, unsigned n) {
+    return bestSimdKernels<float>().dotComplexReal(a, b, n);
+}
+
+inline std::complex<double> dotProduct(const std::complex<double> *a, const double *b, unsigned n) {
+    return bestSimdKernels<double>().dotComplexReal(a, b, n);
+}
+
+inline std::complex<float> dotProduct(const std::complex<float> *a, const std::complex<float> *b, unsigned n) {
+    return bestSimdKernels<float>().dotComplex(a, b, n);
+}
+
+inline std::complex<double> dotProduct(const std::complex<double> *a, const std::complex<double> *b, unsigned n) {
+    return bestSimdKernels<double>().dotComplex(a, b, n);
+}
+
+inline void biquadChannels(const float *coeffs, float *z1, float *z2, const float *input, float *output,
+                           unsigned len, unsigned numChannels, unsigned stride) {
+    bestSimdKernels<float>().biquadChannels(coeffs, z1, z2, input, output, len, numChannels, stride);
+}
+
+inline void biquadChannels(const double *coeffs, double *z1, double *z2, const double *input, double *output,
+                           unsigned len, unsigned numChannels, unsigned stride) {
+    bestSimdKernels<double>().biquadChannels(coeffs, z1, z2, input, output, len, numChannels, stride);
+}
+
+template <>
+inline int32_t dotProductWide<int32_t, int16_t, int16_t>(const int16_t *a, const int16_t *b, unsigned n) {
+    return bestSimdInt16Kernels().dot(a, b, n);
+}
+
+template <>
+inline std::complex<int32_t> dotProductWide<int32_t, int16_t, int16_t>(const std::complex<int16_t> *a,
+                                                                       const int16_t *b, unsigned n) {
+    return bestSimdInt16Kernels().dotComplexReal(a, b, n);
+}
+#endif
+
+};
+
+#endif
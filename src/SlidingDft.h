@@ -0,0 +1,238 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file SlidingDft.h
+ *
+ * Definition of the template class SlidingDft.
+ */
+
+
+#ifndef NimbleDSP_SlidingDft_h
+#define NimbleDSP_SlidingDft_h
+
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <math.h>
+#include "Vector.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Calculates a handful of DFT bins of a window that slides along real or complex data one sample at a time.
+ *
+ * Every new sample updates each bin with one complex multiply-add, so the spectrum of the latest "windowLen"
+ * samples is available after every sample for O(bins) work, instead of O(windowLen*log(windowLen)) for an FFT.
+ * The window and the bins are kept between calls, like the FIR filters' STREAMING mode.  Before "windowLen"
+ * samples have been processed the window is padded with zeros at the start.
+ *
+ * Each update adds a little rounding error that is never removed, so for long runs with T = float call
+ * \ref recompute occasionally, or use double.
+ */
+template <class T>
+class SlidingDft {
+ protected:
+    /**
+     * \brief The last "windowLen" samples, as a circular buffer.
+     */
+    std::vector< std::complex<T> > history;
+    
+    /**
+     * \brief Index of the oldest sample in \ref history.
+     */
+    unsigned oldestIndex;
+    
+    /**
+     * \brief exp(j*w) for each bin, where w is the bin's frequency in radians per sample.
+     */
+    std::vector< std::complex<T> > rotations;
+    
+    /**
+     * \brief exp(-j*w*(windowLen - 1)) for each bin, i.e. the weight of the newest sample.
+     */
+    std::vector< std::complex<T> > newestWeights;
+    
+ public:
+    /**
+     * \brief The DFT bins to calculate.  Bin "k" is at k/windowLen cycles per sample.  They don't have to be integers.
+     */
+    std::vector<double> bins;
+    
+    /**
+     * \brief Number of samples in the window, i.e. the size of the DFT.
+     */
+    unsigned windowLen;
+    
+    /**
+     * \brief The DFT bins of the current window, in the same order as \ref bins.  The first sample of the DFT is
+     *      the oldest sample in the window.
+     */
+    std::vector< std::complex<T> > spectrum;
+    
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Constructor.
+     *
+     * \param windowLen Number of samples in the window.
+     * \param bins The DFT bins to calculate.
+     */
+    SlidingDft<T>(unsigned windowLen, const std::vector<double> & bins);
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns the number of bins.
+     */
+    unsigned numBins() const {return (unsigned) bins.size();}
+    
+    /**
+     * \brief Slides the window along "len" samples of "input".
+     *
+     * \param input The data to process.  It can be real or complex.
+     * \param len Number of samples in "input".
+     * \param output Optional buffer for the \ref spectrum after every sample.  The spectrum after input[i] is at
+     *      output[i*numBins()].  It must hold len*numBins() values.
+     * \return The number of samples processed.
+     */
+    template <class U>
+    unsigned process(const U *input, unsigned len, std::complex<T> *output = NULL);
+    
+    /**
+     * \brief Slides the window along the samples in "data".
+     *
+     * \param data The data to process.  It can be real or complex.
+     * \return The number of samples processed.  \ref spectrum holds the DFT bins of the final window.
+     */
+    template <class U, template <class> class UAllocator>
+    unsigned process(const Vector<U, UAllocator> & data);
+    
+    /**
+     * \brief Returns the power, i.e. the squared magnitude, of each bin of \ref spectrum.
+     */
+    std::vector<T> power() const;
+    
+    /**
+     * \brief Recalculates \ref spectrum directly from the window, which removes the rounding error that the
+     *      updates have accumulated.  Costs windowLen operations per bin.
+     */
+    void recompute();
+    
+    /**
+     * \brief Sets the window and \ref spectrum to zero.
+     */
+    void reset();
+};
+
+
+template <class T>
+SlidingDft<T>::SlidingDft(unsigned windowLen, const std::vector<double> & bins) : bins(bins), windowLen(windowLen) {
+    assert(windowLen > 0);
+    
+    rotations.resize(bins.size());
+    newestWeights.resize(bins.size());
+    for (unsigned bin=0; bin<bins.size(); bin++) {
+        double w = 2 * M_PI * bins[bin] / windowLen;
+        rotations[bin] = std::complex<T>((T) cos(w), (T) sin(w));
+        newestWeights[bin] = std::complex<T>((T) cos(w * (windowLen - 1)), (T) -sin(w * (windowLen - 1)));
+    }
+    reset();
+}
+
+template <class T>
+template <class U>
+unsigned SlidingDft<T>::process(const U *input, unsigned len, std::complex<T> *output) {
+    unsigned numBins = (unsigned) bins.size();
+    
+    for (unsigned i=0; i<len; i++) {
+        std::complex<T> newest(input[i]);
+        std::complex<T> oldest = history[oldestIndex];
+        history[oldestIndex] = newest;
+        if (++oldestIndex == windowLen)
+            oldestIndex = 0;
+        
+        // Remove the oldest sample, shift the remaining samples one place earlier and add the newest one.
+        for (unsigned bin=0; bin<numBins; bin++) {
+            spectrum[bin] = rotations[bin] * (spectrum[bin] - oldest) + newestWeights[bin] * newest;
+        }
+        if (output != NULL) {
+            std::copy(spectrum.begin(), spectrum.end(), output + i * numBins);
+        }
+    }
+    return len;
+}
+
+template <class T>
+template <class U, template <class> class UAllocator>
+unsigned SlidingDft<T>::process(const Vector<U, UAllocator> & data) {
+    return process(VECTOR_TO_ARRAY(data.vec), data.size());
+}
+
+/**
+ * \brief Slides the window of "sdft" along the samples in "data".
+ *
+ * \param data The data to process.
+ * \param sdft The sliding DFT to process it with.
+ * \return The number of samples processed.  sdft.spectrum holds the DFT bins of the final window.
+ */
+template <class T, class U, template <class> class UAllocator>
+unsigned process(const Vector<U, UAllocator> & data, SlidingDft<T> & sdft) {
+    return sdft.process(data);
+}
+
+template <class T>
+std::vector<T> SlidingDft<T>::power() const {
+    std::vector<T> binPower(spectrum.size());
+    for (unsigned bin=0; bin<spectrum.size(); bin++) {
+        binPower[bin] = std::norm(spectrum[bin]);
+    }
+    return binPower;
+}
+
+template <class T>
+void SlidingDft<T>::recompute() {
+    for (unsigned bin=0; bin<bins.size(); bin++) {
+        double w = 2 * M_PI * bins[bin] / windowLen;
+        std::complex<double> sum = 0;
+        for (unsigned n=0; n<windowLen; n++) {
+            std::complex<T> sample = history[(oldestIndex + n) % windowLen];
+            sum += std::complex<double>(sample.real(), sample.imag()) * std::polar(1.0, -w * n);
+        }
+        spectrum[bin] = std::complex<T>((T) sum.real(), (T) sum.imag());
+    }
+}
+
+template <class T>
+void SlidingDft<T>::reset() {
+    history.assign(windowLen, 0);
+    spectrum.assign(bins.size(), 0);
+    oldestIndex = 0;
+}
+
+};
+
+#endif
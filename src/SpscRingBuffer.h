@@ -0,0 +1,184 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file SpscRingBuffer.h
+ *
+ * Definition of the template class SpscRingBuffer, a lock-free queue of samples between two threads.
+ */
+
+#ifndef NimbleDSP_SpscRingBuffer_h
+#define NimbleDSP_SpscRingBuffer_h
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <assert.h>
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Assumed size of a cache line.  Indices that are written by different threads are kept this far apart.
+ */
+const unsigned RING_BUFFER_CACHE_LINE_SIZE = 64;
+
+/**
+ * \brief Lock-free single producer, single consumer ring buffer of samples.
+ *
+ * One thread calls \ref write and \ref close and one other thread calls \ref read.  Neither of them ever blocks or
+ * allocates: a write into a full buffer or a read from an empty one just transfers fewer samples than asked for.
+ * The read and write indices run freely and are masked into the buffer, so the capacity is a power of 2.
+ */
+template <class T>
+class SpscRingBuffer {
+ protected:
+    /**
+     * \brief The samples.
+     */
+    std::vector<T> buf;
+    
+    /**
+     * \brief buf.size() - 1.
+     */
+    unsigned mask;
+    
+    char padding0[RING_BUFFER_CACHE_LINE_SIZE];
+    
+    /**
+     * \brief Total number of samples written.  Only the producer changes it.
+     */
+    std::atomic<unsigned> writeIndex;
+    
+    char padding1[RING_BUFFER_CACHE_LINE_SIZE];
+    
+    /**
+     * \brief Total number of samples read.  Only the consumer changes it.
+     */
+    std::atomic<unsigned> readIndex;
+    
+    /**
+     * \brief Set by the producer once it won't write any more.
+     */
+    std::atomic<bool> closed;
+    
+ public:
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Constructor.
+     *
+     * \param capacity Minimum number of samples the buffer can hold.  It's rounded up to a power of 2.
+     */
+    SpscRingBuffer<T>(unsigned capacity) : writeIndex(0), readIndex(0), closed(false) {
+        assert(capacity > 0 && capacity <= (1u << 31));
+        unsigned size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        buf.resize(size);
+        mask = size - 1;
+    }
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns the number of samples the buffer can hold.
+     */
+    unsigned capacity() const {return mask + 1;}
+    
+    /**
+     * \brief Returns the number of samples waiting to be read.
+     *
+     * Only a snapshot when called from a thread other than the producer and consumer.
+     */
+    unsigned size() const {return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);}
+    
+    /**
+     * \brief Copies up to "len" samples into the buffer.  Producer only.
+     *
+     * \param data The samples to write.
+     * \param len Number of samples in "data".
+     * \return The number of samples written, which is less than "len" if the buffer fills up.
+     */
+    unsigned write(const T *data, unsigned len);
+    
+    /**
+     * \brief Copies up to "len" samples out of the buffer.  Consumer only.
+     *
+     * \param data Buffer for the samples.
+     * \param len Maximum number of samples to read.
+     * \return The number of samples read, which is less than "len" if the buffer runs out.
+     */
+    unsigned read(T *data, unsigned len);
+    
+    /**
+     * \brief Marks the end of the stream.  Producer only.
+     */
+    void close() {closed.store(true, std::memory_order_release);}
+    
+    /**
+     * \brief Returns true once the producer has closed the buffer.
+     *
+     * Every sample written before the close is visible to the consumer once this returns true, so a consumer that
+     * sees the buffer closed and then empty has read the whole stream.
+     */
+    bool isClosed() const {return closed.load(std::memory_order_acquire);}
+};
+
+
+template <class T>
+unsigned SpscRingBuffer<T>::write(const T *data, unsigned len) {
+    unsigned writeStart = writeIndex.load(std::memory_order_relaxed);
+    unsigned numFree = capacity() - (writeStart - readIndex.load(std::memory_order_acquire));
+    len = std::min(len, numFree);
+    
+    unsigned offset = writeStart & mask;
+    unsigned firstLen = std::min(len, capacity() - offset);
+    std::copy(data, data + firstLen, buf.begin() + offset);
+    std::copy(data + firstLen, data + len, buf.begin());
+    
+    writeIndex.store(writeStart + len, std::memory_order_release);
+    return len;
+}
+
+template <class T>
+unsigned SpscRingBuffer<T>::read(T *data, unsigned len) {
+    unsigned readStart = readIndex.load(std::memory_order_relaxed);
+    unsigned numAvailable = writeIndex.load(std::memory_order_acquire) - readStart;
+    len = std::min(len, numAvailable);
+    
+    unsigned offset = readStart & mask;
+    unsigned firstLen = std::min(len, capacity() - offset);
+    std::copy(buf.begin() + offset, buf.begin() + offset + firstLen, data);
+    std::copy(buf.begin(), buf.begin() + (len - firstLen), data + firstLen);
+    
+    readIndex.store(readStart + len, std::memory_order_release);
+    return len;
+}
+
+};
+
+#endif
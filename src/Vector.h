@@ -32,7 +32,9 @@ THE SOFTWARE.
 
 
 #include <vector>
+#include <memory>
 #include <algorithm>
+#include <utility>
 #include <cassert>
 #include <cstdlib>
 #include <cmath>
@@ -40,6 +42,8 @@ THE SOFTWARE.
 #include "kiss_fft.h"
 #include "kiss_fftr.h"
 #include "NimbleDspCommon.h"
+#include "Allocators.h"
+#include "ScratchArena.h"
 
 
 namespace NimbleDSP {
@@ -62,21 +66,35 @@ const unsigned DEFAULT_BUF_LEN = 0;
  * functionality in each class.
  *
  * Derived classes: RealVector and ComplexVector.
+ *
+ * "Allocator" is the allocator template used for \ref vec and the scratch buffer.  It defaults to
+ * std::allocator.  AlignedAllocator and PoolAllocator (see Allocators.h) give SIMD aligned storage and
+ * recycled storage, respectively.  It is passed on to related types, so e.g. RealVector<float, PoolAllocator>
+ * works with ComplexVector<float, PoolAllocator> and RealFirFilter<float, PoolAllocator>.
  */
-template <class T>
+template <class T, template <class> class Allocator = std::allocator>
 class Vector {
 
  public:
     /** 
      * \brief Buffer to store intermediate calculations when needed.
      */
-    std::vector<T> *scratchBuf;
+    std::vector<T, Allocator<T> > *scratchBuf;
 
  protected:
+    /**
+     * \brief Incremented whenever \ref vec may have changed.
+     *
+     * Lets derived classes, e.g. the FIR filters, tell that data they derived from \ref vec is stale without
+     *      comparing it against \ref vec.  Bumped by assignment, the non-const index operator, and every method
+     *      that modifies \ref vec.  Code that writes to \ref vec directly should call \ref modified.
+     */
+    unsigned long long generation;
+    
     /** 
      * \brief Initializes vec to a given size and fills it with zeros.
      */
-    void initSize(unsigned size) {vec = std::vector<T>(size);}
+    void initSize(unsigned size) {vec = std::vector<T, Allocator<T> >(size);}
     
     /** 
      * \brief Initializes vec with the size and contents of "array".
@@ -95,13 +113,13 @@ class Vector {
      * dynamic memory, have a rich set of support functions, are fast and efficient, and can
      * be accessed like a normal array when that is convenient.
      *****************************************************************************************/
-	std::vector<T> vec;
+	std::vector<T, Allocator<T> > vec;
     
-    template <class U> friend class Vector;
-    template <class U> friend class RealVector;
-    template <class U> friend class ComplexVector;
-    template <class U> friend class RealFirFilter;
-    template <class U> friend class ComplexFirFilter;
+    template <class U, template <class> class A> friend class Vector;
+    template <class U, template <class> class A> friend class RealVector;
+    template <class U, template <class> class A> friend class ComplexVector;
+    template <class U, template <class> class A> friend class RealFirFilter;
+    template <class U, template <class> class A> friend class ComplexFirFilter;
     
     /*****************************************************************************************
                                         Constructors
@@ -115,10 +133,10 @@ class Vector {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
-    Vector<T>(unsigned size = 0, std::vector<T> *scratch = NULL) {initSize(size); scratchBuf = scratch;}
+    Vector<T, Allocator>(unsigned size = 0, std::vector<T, Allocator<T> > *scratch = NULL) {initSize(size); scratchBuf = scratch; generation = 0;}
     
     /**
      * \brief Vector constructor.
@@ -130,11 +148,20 @@ class Vector {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
     template <typename U>
-    Vector<T>(std::vector<U> data, std::vector<T> *scratch = NULL) {initArray(VECTOR_TO_ARRAY(data), (unsigned) data.size()); scratchBuf = scratch;}
+    Vector<T, Allocator>(const std::vector<U> & data, std::vector<T, Allocator<T> > *scratch = NULL) {initArray(VECTOR_TO_ARRAY(data), (unsigned) data.size()); scratchBuf = scratch; generation = 0;}
+    
+    /**
+     * \brief Adopting vector constructor.
+     *
+     * Takes over the storage of "data" instead of copying it, e.g. "Vector<double> v(std::move(stdVector));".
+     * \param data Vector that \ref vec will take the place of.  It is left empty.
+     * \param scratch Pointer to a scratch buffer.  See the basic constructor.
+     */
+    Vector<T, Allocator>(std::vector<T, Allocator<T> > && data, std::vector<T, Allocator<T> > *scratch = NULL) : vec(std::move(data)) {scratchBuf = scratch; generation = 0;}
     
     /**
      * \brief Array constructor.
@@ -147,16 +174,22 @@ class Vector {
      *      objects (in fact, I recommend it), but if there are multiple threads then it should
      *      be shared only by objects that are accessed by a single thread.  Objects in other
      *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
+     *      then methods that need one borrow one from the calling thread's scratch arena
+     *      (see ScratchArena.h).
      */
     template <typename U>
-    Vector<T>(U *data, unsigned dataLen, std::vector<T> *scratch = NULL) {initArray(data, dataLen); scratchBuf = scratch;}
+    Vector<T, Allocator>(U *data, unsigned dataLen, std::vector<T, Allocator<T> > *scratch = NULL) {initArray(data, dataLen); scratchBuf = scratch; generation = 0;}
     
     /**
      * \brief Copy constructor.
      */
-    Vector<T>(const Vector<T>& other) {vec = other.vec; scratchBuf = other.scratchBuf;}
+    Vector<T, Allocator>(const Vector<T, Allocator>& other) {vec = other.vec; scratchBuf = other.scratchBuf; generation = other.generation;}
+    
+    /**
+     * \brief Move constructor.  Takes over the storage of "other", which is left empty.
+     */
+    Vector<T, Allocator>(Vector<T, Allocator>&& other) : vec(std::move(other.vec)) {scratchBuf = other.scratchBuf;
+            generation = other.generation; other.modified();}
 
 	/**
 	 * \brief Virtual destructor.
@@ -166,10 +199,25 @@ class Vector {
     /*****************************************************************************************
                                             Operators
     *****************************************************************************************/
+    /**
+     * \brief Assignment operator.
+     *
+     * \ref generation ends up newer than both objects' generations.  That way derived classes whose defaulted
+     *      assignment also copies their cached data (and the generation it was cached at) see it as stale.
+     */
+    Vector<T, Allocator>& operator=(const Vector<T, Allocator>& rhs) {vec = rhs.vec; scratchBuf = rhs.scratchBuf;
+            generation = std::max(generation, rhs.generation) + 1; return *this;}
+    
+    /**
+     * \brief Move assignment operator.  Takes over the storage of "rhs", which is left empty.
+     */
+    Vector<T, Allocator>& operator=(Vector<T, Allocator>&& rhs) {vec = std::move(rhs.vec); scratchBuf = rhs.scratchBuf;
+            generation = std::max(generation, rhs.generation) + 1; rhs.modified(); return *this;}
+    
     /**
      * \brief Index assignment operator.
      */
-    T& operator[](unsigned index) {return vec[index];};
+    T& operator[](unsigned index) {modified(); return vec[index];};
     
     /**
      * \brief Index operator.
@@ -179,6 +227,14 @@ class Vector {
     /*****************************************************************************************
                                             Methods
     *****************************************************************************************/
+    /**
+     * \brief Records that \ref vec has changed.
+     *
+     * Only needed after writing to \ref vec directly or through a VectorView.  E.g. a filter whose taps were
+     *      changed that way keeps using its cached copies of the old taps until this is called.
+     */
+    void modified() {++generation;}
+    
     /**
      * \brief Returns the size of \ref vec.
      */
@@ -201,17 +257,17 @@ class Vector {
 };
 
 
-template <class T>
+template <class T, template <class> class Allocator>
 template <class U>
-void Vector<T>::initArray(U *array, unsigned arrayLen) {
-    vec = std::vector<T>(arrayLen);
+void Vector<T, Allocator>::initArray(U *array, unsigned arrayLen) {
+    vec = std::vector<T, Allocator<T> >(arrayLen);
     for (unsigned i=0; i<arrayLen; i++) {
         vec[i] = (T) array[i];
     }
 }
 
-template <class T>
-inline bool operator==(const Vector<T>& lhs, const Vector<T>& rhs) {
+template <class T, template <class> class Allocator>
+inline bool operator==(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs) {
     if (lhs.size() != rhs.size())
         return false;
     
@@ -222,11 +278,11 @@ inline bool operator==(const Vector<T>& lhs, const Vector<T>& rhs) {
     return true;
 }
 
-template <class T>
-inline bool operator!=(const Vector<T>& lhs, const Vector<T>& rhs) {return !(lhs == rhs);}
+template <class T, template <class> class Allocator>
+inline bool operator!=(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs) {return !(lhs == rhs);}
 
-template <class T>
-const int Vector<T>::find(const T val) const {
+template <class T, template <class> class Allocator>
+const int Vector<T, Allocator>::find(const T val) const {
     for (unsigned i=0; i<size(); i++) {
         if (vec[i] == val) {
             return (int) i;
@@ -243,13 +299,13 @@ const int Vector<T>::find(const T val) const {
  * \return Index of first instance of "val".  If there aren't any elements equal to "val"
  *      it returns -1.
  */
-template <class T>
-const int find(Vector<T> & vector, const T val) {
+template <class T, template <class> class Allocator>
+const int find(Vector<T, Allocator> & vector, const T val) {
     return vector.find(val);
 }
 
-template <class T>
-T Vector<T>::sum() const {
+template <class T, template <class> class Allocator>
+T Vector<T, Allocator>::sum() const {
 	assert(vec.size() > 0);
 	T vectorSum = 0;
 	for (unsigned i=0; i<vec.size(); i++) {
@@ -263,8 +319,8 @@ T Vector<T>::sum() const {
  *
  * \param vector Buffer to operate on.
  */
-template <class T>
-T sum(const Vector<T> & vector) {
+template <class T, template <class> class Allocator>
+T sum(const Vector<T, Allocator> & vector) {
 	return vector.sum();
 }
 
@@ -0,0 +1,247 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file VectorExpression.h
+ *
+ * Expression templates for the element-wise vector operators (+, -, *, /).
+ *
+ * The operators don't compute anything.  They return a lightweight expression object that describes the
+ * computation, and the work is done in a single loop when the expression is assigned to a RealVector or
+ * ComplexVector.  So "d = a*b + c*2.0" makes one pass over the data and allocates nothing if "d" is already
+ * big enough.  Expressions hold pointers to their operands' data, so they shouldn't be kept around (e.g. with
+ * "auto") after an operand changes size or goes away.
+ */
+
+#ifndef NimbleDSP_VectorExpression_h
+#define NimbleDSP_VectorExpression_h
+
+#include <vector>
+#include <complex>
+#include <cassert>
+#include "Vector.h"
+
+
+namespace NimbleDSP {
+
+template <class T, template <class> class Allocator> class RealVector;
+template <class T, template <class> class Allocator> class ComplexVector;
+
+/**
+ * \brief The vector class that holds elements of type "T", i.e. what an expression evaluates to.
+ *
+ * Real elements give a RealVector and std::complex elements give a ComplexVector, just like the operators
+ * returned before they became expressions.
+ */
+template <class T, template <class> class Allocator = std::allocator>
+struct VectorResultType {
+    typedef RealVector<T, Allocator> type;
+};
+
+template <class T, template <class> class Allocator>
+struct VectorResultType<std::complex<T>, Allocator> {
+    typedef ComplexVector<T, Allocator> type;
+};
+
+/**
+ * \brief Base class of all vector expressions.
+ *
+ * Derived classes ("E") must have value_type and vector_type typedefs, a size() method, and an operator[] that
+ * returns element "index" of the result.
+ */
+template <class E>
+class VectorExpression {
+ public:
+    /**
+     * \brief Returns the expression as its derived type.
+     */
+    const E & derived() const {return static_cast<const E &>(*this);}
+    
+    /**
+     * \brief Returns the number of elements in the result.
+     */
+    unsigned size() const {return derived().size();}
+    
+    /**
+     * \brief Evaluates the expression into a new vector of the left operand's type.
+     *
+     * Use it to call a vector method on the result of an operator, e.g. "(a*b).eval().sum()", or to pass the
+     * result to a function that takes a vector.
+     */
+    template <class D = E>
+    typename D::vector_type eval() const {return typename D::vector_type(*this);}
+};
+
+/**
+ * \brief Expression leaf that refers to the data of a Vector.
+ */
+template <class T, template <class> class Allocator = std::allocator>
+class VectorOperand : public VectorExpression< VectorOperand<T, Allocator> > {
+ protected:
+    const T *data;
+    unsigned len;
+    
+ public:
+    typedef T value_type;
+    typedef typename VectorResultType<T, Allocator>::type vector_type;
+    
+    VectorOperand(const Vector<T, Allocator> & vector) : data(vector.size() ? VECTOR_TO_ARRAY(vector.vec) : NULL),
+            len(vector.size()) {}
+    
+    unsigned size() const {return len;}
+    T operator[](unsigned index) const {return data[index];}
+};
+
+/*
+ * The operations.  Like the compound assignment operators they mirror, the result has the type of the left
+ * operand.
+ */
+struct VectorAddOp {
+    template <class T, class U> static void apply(T & lhs, const U & rhs) {lhs += rhs;}
+};
+
+struct VectorSubtractOp {
+    template <class T, class U> static void apply(T & lhs, const U & rhs) {lhs -= rhs;}
+};
+
+struct VectorMultiplyOp {
+    template <class T, class U> static void apply(T & lhs, const U & rhs) {lhs *= rhs;}
+};
+
+struct VectorDivideOp {
+    template <class T, class U> static void apply(T & lhs, const U & rhs) {lhs /= rhs;}
+};
+
+/**
+ * \brief Element-wise operation between two vector expressions of the same size.
+ */
+template <class Op, class L, class R>
+class VectorBinaryExpression : public VectorExpression< VectorBinaryExpression<Op, L, R> > {
+ protected:
+    L lhs;
+    R rhs;
+    
+ public:
+    typedef typename L::value_type value_type;
+    typedef typename L::vector_type vector_type;
+    
+    VectorBinaryExpression(const L & left, const R & right) : lhs(left), rhs(right)
+            {assert(lhs.size() == rhs.size());}
+    
+    unsigned size() const {return lhs.size();}
+    value_type operator[](unsigned index) const {
+        value_type result = lhs[index];
+        Op::apply(result, rhs[index]);
+        return result;
+    }
+};
+
+/**
+ * \brief Element-wise operation between a vector expression and a scalar.
+ */
+template <class Op, class L>
+class VectorScalarExpression : public VectorExpression< VectorScalarExpression<Op, L> > {
+ protected:
+    L lhs;
+    typename L::value_type rhs;
+    
+ public:
+    typedef typename L::value_type value_type;
+    typedef typename L::vector_type vector_type;
+    
+    VectorScalarExpression(const L & left, const value_type & right) : lhs(left), rhs(right) {}
+    
+    unsigned size() const {return lhs.size();}
+    value_type operator[](unsigned index) const {
+        value_type result = lhs[index];
+        Op::apply(result, rhs);
+        return result;
+    }
+};
+
+/**
+ * \brief Evaluates "expr" into "dest", resizing "dest" to fit.
+ *
+ * The operations are element-wise, so "dest" may also be one of the operands.
+ */
+template <class T, class Allocator, class E>
+void evaluateExpression(std::vector<T, Allocator> & dest, const VectorExpression<E> & expr) {
+    const E & source = expr.derived();
+    unsigned len = source.size();
+    dest.resize(len);
+    for (unsigned i=0; i<len; i++) {
+        dest[i] = (T) source[i];
+    }
+}
+
+/*
+ * Stamps out an operator for every combination of Vector, expression, and scalar operands.  The scalar's
+ * type isn't deduced, so e.g. "floatVector * 2.0" works.
+ */
+#define NIMBLEDSP_VECTOR_OPERATOR(op, Op) \
+template <class T, template <class> class A, class U, template <class> class B> \
+inline VectorBinaryExpression<Op, VectorOperand<T, A>, VectorOperand<U, B> > \
+operator op(const Vector<T, A> & lhs, const Vector<U, B> & rhs) { \
+    return VectorBinaryExpression<Op, VectorOperand<T, A>, VectorOperand<U, B> >(VectorOperand<T, A>(lhs), VectorOperand<U, B>(rhs)); \
+} \
+\
+template <class T, template <class> class A, class E> \
+inline VectorBinaryExpression<Op, VectorOperand<T, A>, E> \
+operator op(const Vector<T, A> & lhs, const VectorExpression<E> & rhs) { \
+    return VectorBinaryExpression<Op, VectorOperand<T, A>, E>(VectorOperand<T, A>(lhs), rhs.derived()); \
+} \
+\
+template <class E, class U, template <class> class B> \
+inline VectorBinaryExpression<Op, E, VectorOperand<U, B> > \
+operator op(const VectorExpression<E> & lhs, const Vector<U, B> & rhs) { \
+    return VectorBinaryExpression<Op, E, VectorOperand<U, B> >(lhs.derived(), VectorOperand<U, B>(rhs)); \
+} \
+\
+template <class E1, class E2> \
+inline VectorBinaryExpression<Op, E1, E2> \
+operator op(const VectorExpression<E1> & lhs, const VectorExpression<E2> & rhs) { \
+    return VectorBinaryExpression<Op, E1, E2>(lhs.derived(), rhs.derived()); \
+} \
+\
+template <class T, template <class> class A> \
+inline VectorScalarExpression<Op, VectorOperand<T, A> > \
+operator op(const Vector<T, A> & lhs, const typename VectorOperand<T, A>::value_type & rhs) { \
+    return VectorScalarExpression<Op, VectorOperand<T, A> >(VectorOperand<T, A>(lhs), rhs); \
+} \
+\
+template <class E> \
+inline VectorScalarExpression<Op, E> \
+operator op(const VectorExpression<E> & lhs, const typename E::value_type & rhs) { \
+    return VectorScalarExpression<Op, E>(lhs.derived(), rhs); \
+}
+
+NIMBLEDSP_VECTOR_OPERATOR(+, VectorAddOp)
+NIMBLEDSP_VECTOR_OPERATOR(-, VectorSubtractOp)
+NIMBLEDSP_VECTOR_OPERATOR(*, VectorMultiplyOp)
+NIMBLEDSP_VECTOR_OPERATOR(/, VectorDivideOp)
+
+#undef NIMBLEDSP_VECTOR_OPERATOR
+
+};
+
+#endif
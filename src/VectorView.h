@@ -0,0 +1,414 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file VectorView.h
+ *
+ * Definition of the VectorView class, a non-owning view of samples in memory that NimbleDSP doesn't manage.
+ */
+
+#ifndef NimbleDSP_VectorView_h
+#define NimbleDSP_VectorView_h
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include "Vector.h"
+#include "VectorExpression.h"
+#include "ScratchArena.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief A non-owning view of "len" samples that are "stride" elements apart, starting at "data".
+ *
+ * Views let the math, stats and filter methods work on memory that doesn't belong to a Vector, e.g. an mmap'd
+ * file, a DMA buffer, or one channel of a larger interleaved capture, without copying it first.  A view is
+ * just a pointer, a length and a stride, so pass it by value.  It never allocates or resizes, and the memory
+ * it refers to has to outlive it.
+ *
+ * Views are vector expressions, so they can be used with the element-wise operators alongside Vectors and
+ * other expressions, and a RealVector or ComplexVector can be constructed from (i.e. copy) a view.  Like a
+ * reference, copy constructing a view refers to the same memory, but assigning to a view copies elements into
+ * the memory that it refers to.  Use VectorView<const T> for read-only data.
+ */
+template <class T>
+class VectorView : public VectorExpression< VectorView<T> > {
+ public:
+    typedef typename std::remove_const<T>::type value_type;
+    typedef typename VectorResultType<value_type>::type vector_type;
+    
+    /**
+     * \brief Pointer to the first sample.
+     */
+    T *data;
+    
+    /**
+     * \brief Number of samples in the view.
+     */
+    unsigned len;
+    
+    /**
+     * \brief Distance between consecutive samples, in elements.  1 for contiguous data.
+     */
+    unsigned stride;
+    
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Array constructor.
+     *
+     * \param data Pointer to the first sample.
+     * \param len Number of samples in the view.
+     * \param stride Distance between consecutive samples, in elements.  Defaults to 1.
+     */
+    VectorView<T>(T *data = NULL, unsigned len = 0, unsigned stride = 1) : data(data), len(len), stride(stride) {}
+    
+    /**
+     * \brief Views all of the data in "vector".  The view is invalidated if "vector" is resized.
+     */
+    template <template <class> class Allocator>
+    VectorView<T>(Vector<value_type, Allocator> & vector) : data(vector.size() ? VECTOR_TO_ARRAY(vector.vec) : NULL),
+            len(vector.size()), stride(1) {}
+    
+    /**
+     * \brief Read-only view of all of the data in "vector".  Only compiles for VectorView<const T>.
+     */
+    template <template <class> class Allocator>
+    VectorView<T>(const Vector<value_type, Allocator> & vector) : data(vector.size() ? VECTOR_TO_ARRAY(vector.vec) : NULL),
+            len(vector.size()), stride(1) {}
+    
+    /**
+     * \brief Copy constructor.  The new view refers to the same memory as "other".
+     */
+    VectorView<T>(const VectorView<T> & other) : data(other.data), len(other.len), stride(other.stride) {}
+    
+    /**
+     * \brief Converts a VectorView<T> into a VectorView<const T>.
+     */
+    template <class U>
+    VectorView<T>(const VectorView<U> & other) : data(other.data), len(other.len), stride(other.stride) {}
+    
+    /*****************************************************************************************
+                                            Operators
+    *****************************************************************************************/
+    /**
+     * \brief Copies the elements of "rhs" into the view.  The sizes must match.
+     */
+    VectorView<T> & operator=(const VectorView<T> & rhs) {return assign(rhs);}
+    
+    /**
+     * \brief Evaluates "rhs" into the view.  The sizes must match.
+     */
+    template <class E>
+    VectorView<T> & operator=(const VectorExpression<E> & rhs) {return assign(rhs);}
+    
+    /**
+     * \brief Copies the data of "rhs" into the view.  The sizes must match.
+     */
+    template <class U, template <class> class Allocator>
+    VectorView<T> & operator=(const Vector<U, Allocator> & rhs) {return assign(VectorOperand<U, Allocator>(rhs));}
+    
+    /**
+     * \brief Element-wise operators.  "rhs" may be a scalar, a Vector, a view or an expression.
+     */
+    template <class R> VectorView<T> & operator+=(const R & rhs) {return assign(*this + rhs);}
+    template <class R> VectorView<T> & operator-=(const R & rhs) {return assign(*this - rhs);}
+    template <class R> VectorView<T> & operator*=(const R & rhs) {return assign(*this * rhs);}
+    template <class R> VectorView<T> & operator/=(const R & rhs) {return assign(*this / rhs);}
+    
+    /**
+     * \brief Index operator.
+     */
+    T & operator[](unsigned index) const {return data[index * stride];}
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns the number of samples in the view.
+     */
+    unsigned size() const {return len;}
+    
+    /**
+     * \brief Returns true if the samples are next to each other in memory.
+     */
+    bool isContiguous() const {return stride == 1 || len <= 1;}
+    
+    /**
+     * \brief Returns a view of "subLen" samples starting at sample "begin", taking every "step"th sample.
+     *
+     * E.g. interleaved.subView(1, interleaved.size() / 2, 2) is the second channel of two channel interleaved data.
+     */
+    VectorView<T> subView(unsigned begin, unsigned subLen, unsigned step = 1) const {
+        assert(subLen == 0 || begin + (subLen - 1) * step < len);
+        return VectorView<T>(data + begin * stride, subLen, stride * step);
+    }
+    
+    /**
+     * \brief Returns the sum of the samples.
+     */
+    value_type sum() const;
+    
+    /**
+     * \brief Returns the mean (average) of the samples.
+     */
+    const SLICKDSP_FLOAT_TYPE mean() const;
+    
+    /**
+     * \brief Returns the variance of the samples.
+     */
+    const SLICKDSP_FLOAT_TYPE var() const;
+    
+    /**
+     * \brief Returns the standard deviation of the samples.
+     */
+    const SLICKDSP_FLOAT_TYPE stdDev() const {return std::sqrt(this->var());}
+    
+    /**
+     * \brief Returns the median sample.
+     */
+    const value_type median() const;
+    
+    /**
+     * \brief Returns the maximum sample.
+     *
+     * \param maxLoc If it isn't equal to NULL the index of the maximum sample will be returned via this pointer.
+     *      If more than one sample is equal to the maximum value the index of the first will be returned.
+     */
+    const value_type max(unsigned *maxLoc = NULL) const;
+    
+    /**
+     * \brief Returns the minimum sample.
+     *
+     * \param minLoc If it isn't equal to NULL the index of the minimum sample will be returned via this pointer.
+     *      If more than one sample is equal to the minimum value the index of the first will be returned.
+     */
+    const value_type min(unsigned *minLoc = NULL) const;
+    
+    /**
+     * \brief Limits the samples to the range [-val, val].
+     */
+    VectorView<T> & saturate(value_type val);
+    
+ protected:
+    /**
+     * \brief Evaluates "expr" element by element into the view.
+     */
+    template <class E>
+    VectorView<T> & assign(const VectorExpression<E> & expr) {
+        const E & source = expr.derived();
+        assert(source.size() == len);
+        for (unsigned i=0; i<len; i++) {
+            data[i * stride] = (value_type) source[i];
+        }
+        return *this;
+    }
+};
+
+template <class T>
+typename VectorView<T>::value_type VectorView<T>::sum() const {
+    assert(len > 0);
+    value_type viewSum = 0;
+    for (unsigned i=0; i<len; i++) {
+        viewSum += (*this)[i];
+    }
+    return viewSum;
+}
+
+template <class T>
+const SLICKDSP_FLOAT_TYPE VectorView<T>::mean() const {
+    assert(len > 0);
+    SLICKDSP_FLOAT_TYPE sum = 0;
+    for (unsigned i=0; i<len; i++) {
+        sum += (*this)[i];
+    }
+    return sum / len;
+}
+
+/**
+ * \brief Returns the mean (average) of the samples in "view".
+ */
+template <class T>
+const SLICKDSP_FLOAT_TYPE mean(const VectorView<T> & view) {
+    return view.mean();
+}
+
+template <class T>
+const SLICKDSP_FLOAT_TYPE VectorView<T>::var() const {
+    assert(len > 1);
+    SLICKDSP_FLOAT_TYPE meanVal = mean();
+    SLICKDSP_FLOAT_TYPE sum = 0;
+    for (unsigned i=0; i<len; i++) {
+        SLICKDSP_FLOAT_TYPE varDiff = ((SLICKDSP_FLOAT_TYPE) (*this)[i]) - meanVal;
+        sum += varDiff * varDiff;
+    }
+    return sum / (len - 1);
+}
+
+/**
+ * \brief Returns the variance of the samples in "view".
+ */
+template <class T>
+const SLICKDSP_FLOAT_TYPE var(const VectorView<T> & view) {
+    return view.var();
+}
+
+/**
+ * \brief Returns the standard deviation of the samples in "view".
+ */
+template <class T>
+const SLICKDSP_FLOAT_TYPE stdDev(const VectorView<T> & view) {
+    return view.stdDev();
+}
+
+template <class T>
+const typename VectorView<T>::value_type VectorView<T>::median() const {
+    assert(len > 0);
+    ScratchBuffer< std::vector<value_type> > sorted(NULL, len);
+    sorted->resize(len);
+    for (unsigned i=0; i<len; i++) {
+        (*sorted)[i] = (*this)[i];
+    }
+    std::sort(sorted->begin(), sorted->end());
+    if (len & 1) {
+        return (*sorted)[len/2];
+    }
+    else {
+        return ((*sorted)[len/2] + (*sorted)[len/2 - 1]) / ((value_type) 2);
+    }
+}
+
+/**
+ * \brief Returns the median sample of "view".
+ */
+template <class T>
+const typename VectorView<T>::value_type median(const VectorView<T> & view) {
+    return view.median();
+}
+
+template <class T>
+const typename VectorView<T>::value_type VectorView<T>::max(unsigned *maxLoc) const {
+    assert(len > 0);
+    value_type maxVal = (*this)[0];
+    unsigned maxIndex = 0;
+    
+    for (unsigned i=1; i<len; i++) {
+        if (maxVal < (*this)[i]) {
+            maxVal = (*this)[i];
+            maxIndex = i;
+        }
+    }
+    if (maxLoc != NULL) {
+        *maxLoc = maxIndex;
+    }
+    return maxVal;
+}
+
+/**
+ * \brief Returns the maximum sample in "view".  See VectorView::max.
+ */
+template <class T>
+const typename VectorView<T>::value_type max(const VectorView<T> & view, unsigned *maxLoc = NULL) {
+    return view.max(maxLoc);
+}
+
+template <class T>
+const typename VectorView<T>::value_type VectorView<T>::min(unsigned *minLoc) const {
+    assert(len > 0);
+    value_type minVal = (*this)[0];
+    unsigned minIndex = 0;
+    
+    for (unsigned i=1; i<len; i++) {
+        if ((*this)[i] < minVal) {
+            minVal = (*this)[i];
+            minIndex = i;
+        }
+    }
+    if (minLoc != NULL) {
+        *minLoc = minIndex;
+    }
+    return minVal;
+}
+
+/**
+ * \brief Returns the minimum sample in "view".  See VectorView::min.
+ */
+template <class T>
+const typename VectorView<T>::value_type min(const VectorView<T> & view, unsigned *minLoc = NULL) {
+    return view.min(minLoc);
+}
+
+template <class T>
+VectorView<T> & VectorView<T>::saturate(value_type val) {
+    for (unsigned i=0; i<len; i++) {
+        if ((*this)[i] > val)
+            (*this)[i] = val;
+        else if ((*this)[i] < -val)
+            (*this)[i] = -val;
+    }
+    return *this;
+}
+
+/**
+ * \brief Limits the samples in "view" to the range [-val, val].
+ */
+template <class T>
+VectorView<T> saturate(VectorView<T> view, typename VectorView<T>::value_type val) {
+    view.saturate(val);
+    return view;
+}
+
+/**
+ * \brief Calls func(samples, len) on the data of "view", which is modified in place.
+ *
+ * Contiguous views are passed straight through.  Strided views are gathered into a scratch buffer, processed,
+ * and scattered back.  The filter classes use this to run their pointer based methods on views.
+ */
+template <class T, class Func>
+void processContiguous(VectorView<T> view, Func func) {
+    if (view.size() == 0)
+        return;
+    if (view.isContiguous()) {
+        func(view.data, view.size());
+        return;
+    }
+    
+    ScratchBuffer< std::vector<T> > buf(NULL, view.size());
+    buf->resize(view.size());
+    for (unsigned i=0; i<view.size(); i++) {
+        (*buf)[i] = view[i];
+    }
+    func(VECTOR_TO_ARRAY(*buf), view.size());
+    for (unsigned i=0; i<view.size(); i++) {
+        view[i] = (*buf)[i];
+    }
+}
+
+};
+
+#endif
@@ -0,0 +1,374 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/**
+ * @file WelchPsd.h
+ *
+ * Definition of the template class WelchPsd.
+ */
+
+
+#ifndef NimbleDSP_WelchPsd_h
+#define NimbleDSP_WelchPsd_h
+
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <math.h>
+#include "NimbleDspCommon.h"
+#include "Vector.h"
+#include "FftPlanCache.h"
+
+
+namespace NimbleDSP {
+
+/**
+ * \brief Streaming Welch power spectral density estimator and spectrogram.
+ *
+ * The data is split into overlapping frames of window.size() samples.  Each frame is multiplied by the window,
+ * FFT'd and turned into a power spectral density in one pass, and the frames' PSDs are averaged into \ref psd.
+ * The per-frame PSDs can also be written to a caller supplied buffer, one row per frame, to make a spectrogram.
+ * Like the FIR filters' STREAMING mode, the data can be passed in blocks of any size and frames may span blocks.
+ *
+ * Real data produces the one-sided PSD, with window.size()/2 + 1 bins, and complex data produces the two-sided PSD,
+ * with window.size() bins in FFT order.  The PSD is scaled by 1/(sampleFreq * sum(window^2)), so that it has units
+ * of power per Hz and summing it over the bins and multiplying by sampleFreq/window.size() gives the mean power.
+ */
+template <class T>
+class WelchPsd {
+ protected:
+    /**
+     * \brief The window.
+     */
+    std::vector<T> window;
+    
+    /**
+     * \brief PSD scale factor for each bin, including the doubling of the one-sided bins.
+     */
+    std::vector<T> binScales;
+    
+    /**
+     * \brief Samples that haven't been used by a complete frame yet, for real data.
+     */
+    std::vector<T> savedRealData;
+    
+    /**
+     * \brief Samples that haven't been used by a complete frame yet, for complex data.
+     */
+    std::vector< std::complex<T> > savedComplexData;
+    
+    /**
+     * \brief Windowed frame of real data.
+     */
+    std::vector<T> realFrame;
+    
+    /**
+     * \brief Windowed frame of complex data.
+     */
+    std::vector< std::complex<T> > complexFrame;
+    
+    /**
+     * \brief The FFT of the current frame.
+     */
+    std::vector< std::complex<T> > spectrum;
+    
+    /**
+     * \brief Calculates the PSD of the frame starting at "data", adds it to the average, and writes it to "row"
+     *      if it isn't NULL.
+     */
+    void processFrame(const T *data, T *row);
+    
+    /**
+     * \brief Complex data version of processFrame.
+     */
+    void processFrame(const std::complex<T> *data, T *row);
+    
+    /**
+     * \brief Turns \ref spectrum into the frame's PSD and averages it in.
+     */
+    void averageFrame(T *row);
+    
+    /**
+     * \brief Splits the saved data plus "input" into frames.
+     */
+    template <class U>
+    unsigned processData(std::vector<U> & savedData, const U *input, unsigned inputLen, T *frames,
+                         unsigned frameCapacity);
+    
+ public:
+    /**
+     * \brief Number of samples that consecutive frames have in common.
+     */
+    unsigned overlap;
+    
+    /**
+     * \brief True if the data is complex.
+     */
+    bool complexData;
+    
+    /**
+     * \brief How the frames are averaged.
+     */
+    SpectrumAveragingType averaging;
+    
+    /**
+     * \brief Weight of the newest frame for EXPONENTIAL_AVERAGE.
+     */
+    T alpha;
+    
+    /**
+     * \brief The averaged PSD.
+     */
+    std::vector<T> psd;
+    
+    /**
+     * \brief Number of frames that have been averaged into \ref psd.
+     */
+    unsigned numFrames;
+    
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Constructor.
+     *
+     * \param window The window, e.g. generated with RealFirFilter::hann.  Its size is the FFT size.
+     * \param overlap Number of samples that consecutive frames have in common.  Must be less than the FFT size.
+     *      Defaults to 0.
+     * \param complexData Set to true for complex data.  Defaults to false.
+     * \param averaging How the frames are averaged.  Defaults to MEAN_AVERAGE.
+     * \param alpha Weight of the newest frame for EXPONENTIAL_AVERAGE.  Defaults to 0.1.
+     * \param sampleFreq The sample frequency of the data.  Defaults to 1.
+     */
+    template <class U>
+    WelchPsd<T>(const std::vector<U> & window, unsigned overlap = 0, bool complexData = false,
+                SpectrumAveragingType averaging = MEAN_AVERAGE, double alpha = 0.1, double sampleFreq = 1.0);
+    
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns the FFT size.
+     */
+    unsigned fftLen() const {return (unsigned) window.size();}
+    
+    /**
+     * \brief Returns the number of samples between the starts of consecutive frames.
+     */
+    unsigned hop() const {return fftLen() - overlap;}
+    
+    /**
+     * \brief Returns the number of PSD bins.
+     */
+    unsigned numBins() const {return (unsigned) psd.size();}
+    
+    /**
+     * \brief Returns the number of frames that processing "inputLen" more samples will complete.
+     */
+    unsigned outputLength(unsigned inputLen) const;
+    
+    /**
+     * \brief Processes real data.
+     *
+     * \param input The data.
+     * \param inputLen Number of samples in "input".
+     * \param frames Optional buffer for the PSD of each completed frame.  The PSD of the "n"th frame completed by
+     *      this call is put at frames[n*numBins()].
+     * \param frameCapacity Number of frames that "frames" can hold.  See \ref outputLength.
+     * \return The number of frames completed.
+     */
+    unsigned process(const T *input, unsigned inputLen, T *frames = NULL, unsigned frameCapacity = 0)
+            {assert(!complexData); return processData(savedRealData, input, inputLen, frames, frameCapacity);}
+    
+    /**
+     * \brief Processes complex data.  See the real data version.
+     */
+    unsigned process(const std::complex<T> *input, unsigned inputLen, T *frames = NULL, unsigned frameCapacity = 0)
+            {assert(complexData); return processData(savedComplexData, input, inputLen, frames, frameCapacity);}
+    
+    /**
+     * \brief Processes the real or complex data in "data".
+     *
+     * \param data The data.
+     * \return The number of frames completed.
+     */
+    template <class U, template <class> class Allocator>
+    unsigned process(const Vector<U, Allocator> & data) {return process(VECTOR_TO_ARRAY(data.vec), data.size());}
+    
+    /**
+     * \brief Returns \ref psd in dB, i.e. 10*log10(psd).
+     */
+    std::vector<T> psdDb() const;
+    
+    /**
+     * \brief Discards the saved data and clears the average.
+     */
+    void reset();
+};
+
+
+template <class T>
+template <class U>
+WelchPsd<T>::WelchPsd(const std::vector<U> & window, unsigned overlap, bool complexData,
+                      SpectrumAveragingType averaging, double alpha, double sampleFreq) :
+        window(window.begin(), window.end()), overlap(overlap), complexData(complexData), averaging(averaging),
+        alpha((T) alpha) {
+    unsigned len = (unsigned) window.size();
+    assert(len > 0 && overlap < len && sampleFreq > 0);
+    
+    double windowPower = 0;
+    for (unsigned i=0; i<len; i++) {
+        windowPower += (double) this->window[i] * this->window[i];
+    }
+    if (complexData) {
+        binScales.assign(len, (T) (1 / (sampleFreq * windowPower)));
+        complexFrame.resize(len);
+        spectrum.resize(len);
+    }
+    else {
+        // The negative frequency bins are folded into the positive ones, except for DC and Nyquist.
+        binScales.assign(len / 2 + 1, (T) (2 / (sampleFreq * windowPower)));
+        binScales[0] /= 2;
+        if (len % 2 == 0)
+            binScales[len / 2] /= 2;
+        realFrame.resize(len);
+        spectrum.resize(len / 2 + 1);
+    }
+    reset();
+}
+
+template <class T>
+unsigned WelchPsd<T>::outputLength(unsigned inputLen) const {
+    unsigned availableLen = (unsigned) (complexData ? savedComplexData.size() : savedRealData.size()) + inputLen;
+    if (availableLen < fftLen())
+        return 0;
+    return (availableLen - fftLen()) / hop() + 1;
+}
+
+template <class T>
+void WelchPsd<T>::processFrame(const T *data, T *row) {
+    unsigned len = fftLen();
+    for (unsigned i=0; i<len; i++) {
+        realFrame[i] = data[i] * window[i];
+    }
+    getRealFftPlan<T>(len, false).transform(VECTOR_TO_ARRAY(realFrame), VECTOR_TO_ARRAY(spectrum));
+    averageFrame(row);
+}
+
+template <class T>
+void WelchPsd<T>::processFrame(const std::complex<T> *data, T *row) {
+    unsigned len = fftLen();
+    for (unsigned i=0; i<len; i++) {
+        complexFrame[i] = data[i] * window[i];
+    }
+    getFftPlan<T>(len, false).transform(VECTOR_TO_ARRAY(complexFrame), VECTOR_TO_ARRAY(spectrum));
+    averageFrame(row);
+}
+
+template <class T>
+void WelchPsd<T>::averageFrame(T *row) {
+    unsigned bins = numBins();
+    const std::complex<T> *spectrumArray = VECTOR_TO_ARRAY(spectrum);
+    const T *scales = VECTOR_TO_ARRAY(binScales);
+    T *average = VECTOR_TO_ARRAY(psd);
+    
+    ++numFrames;
+    
+    // The first frame starts every kind of average.
+    SpectrumAveragingType method = (numFrames == 1) ? EXPONENTIAL_AVERAGE : averaging;
+    T weight = (numFrames == 1) ? 1 : ((averaging == MEAN_AVERAGE) ? (T) 1 / numFrames : alpha);
+    switch (method) {
+    case MEAN_AVERAGE:
+    case EXPONENTIAL_AVERAGE:
+        for (unsigned bin=0; bin<bins; bin++) {
+            T binPsd = std::norm(spectrumArray[bin]) * scales[bin];
+            average[bin] += weight * (binPsd - average[bin]);
+            if (row != NULL)
+                row[bin] = binPsd;
+        }
+        break;
+    case MAX_HOLD:
+        for (unsigned bin=0; bin<bins; bin++) {
+            T binPsd = std::norm(spectrumArray[bin]) * scales[bin];
+            average[bin] = std::max(average[bin], binPsd);
+            if (row != NULL)
+                row[bin] = binPsd;
+        }
+        break;
+    }
+}
+
+template <class T>
+template <class U>
+unsigned WelchPsd<T>::processData(std::vector<U> & savedData, const U *input, unsigned inputLen, T *frames,
+                                  unsigned frameCapacity) {
+    unsigned outputLen = outputLength(inputLen);
+    assert(frames == NULL || frameCapacity >= outputLen);
+    
+    // Frames that are entirely within "input" are windowed straight from it.  The rest are put together in a
+    // scratch buffer first.
+    ScratchBuffer< std::vector<U> > dataTmp(NULL, savedData.size() + inputLen);
+    std::vector<U> & data = *dataTmp;
+    data.assign(savedData.begin(), savedData.end());
+    unsigned frame = 0;
+    unsigned frameStart = 0;
+    for (; frame<outputLen && frameStart<savedData.size(); frame++, frameStart+=hop()) {
+        data.insert(data.end(), input + (data.size() - savedData.size()),
+                    input + (frameStart + fftLen() - savedData.size()));
+        processFrame(VECTOR_TO_ARRAY(data) + frameStart, frames ? frames + frame * numBins() : NULL);
+    }
+    for (; frame<outputLen; frame++, frameStart+=hop()) {
+        processFrame(input + (frameStart - savedData.size()), frames ? frames + frame * numBins() : NULL);
+    }
+    
+    // Keep everything from the start of the next frame.
+    if (frameStart < savedData.size()) {
+        savedData.erase(savedData.begin(), savedData.begin() + frameStart);
+        savedData.insert(savedData.end(), input, input + inputLen);
+    }
+    else {
+        savedData.assign(input + (frameStart - savedData.size()), input + inputLen);
+    }
+    return outputLen;
+}
+
+template <class T>
+std::vector<T> WelchPsd<T>::psdDb() const {
+    std::vector<T> psdDecibels(psd.size());
+    for (unsigned bin=0; bin<psd.size(); bin++) {
+        psdDecibels[bin] = (T) (10 * std::log10(psd[bin]));
+    }
+    return psdDecibels;
+}
+
+template <class T>
+void WelchPsd<T>::reset() {
+    savedRealData.clear();
+    savedComplexData.clear();
+    psd.assign(binScales.size(), 0);
+    numFrames = 0;
+}
+
+};
+
+#endif
@@ -0,0 +1,115 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Allocators.h"
+#include "RealVector.h"
+#include "ComplexVector.h"
+#include "RealFirFilter.h"
+#include <vector>
+#include <stdint.h>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+
+
+TEST(Allocators, Aligned) {
+    for (unsigned size=1; size<100; size+=7) {
+        std::vector<float, AlignedAllocator<float> > buf(size);
+        EXPECT_EQ(0u, ((uintptr_t) &buf[0]) % ALLOCATOR_ALIGNMENT);
+        
+        std::vector<char, PoolAllocator<char> > poolBuf(size);
+        EXPECT_EQ(0u, ((uintptr_t) &poolBuf[0]) % ALLOCATOR_ALIGNMENT);
+    }
+}
+
+TEST(Allocators, PoolReuse) {
+    PoolAllocator<double> allocator;
+    double *first = allocator.allocate(100);
+    allocator.deallocate(first, 100);
+    
+    // Anything that rounds up to the same block size should get the same block back.
+    double *second = allocator.allocate(120);
+    EXPECT_EQ(first, second);
+    allocator.deallocate(second, 120);
+    
+    // Blocks too big to pool still work.
+    std::size_t bigLen = POOL_ALLOCATOR_MAX_BLOCK_SIZE / sizeof(double) + 1;
+    double *big = allocator.allocate(bigLen);
+    big[bigLen - 1] = 1;
+    allocator.deallocate(big, bigLen);
+}
+
+TEST(Allocators, RealVector) {
+    double inputData[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    RealVector<double, AlignedAllocator> buf1(inputData, 10);
+    RealVector<double, AlignedAllocator> buf2(inputData, 10);
+    RealVector<double> buf3(inputData, 10);
+    
+    EXPECT_EQ(0u, ((uintptr_t) VECTOR_TO_ARRAY(buf1.vec)) % ALLOCATOR_ALIGNMENT);
+    RealVector<double, AlignedAllocator> result = buf1 * buf2 + buf3;
+    EXPECT_EQ(10u, result.size());
+    for (unsigned i=0; i<result.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(inputData[i] * inputData[i] + inputData[i], result[i]));
+    }
+    
+    result += buf3;
+    result -= 1.0;
+    for (unsigned i=0; i<result.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(inputData[i] * inputData[i] + 2 * inputData[i] - 1, result[i]));
+    }
+    
+    ComplexVector<double, AlignedAllocator> spectrum;
+    buf1.fft(spectrum);
+    RealVector<double, AlignedAllocator> roundTrip;
+    roundTrip.ifft(spectrum, buf1.size());
+    EXPECT_EQ(buf1.size(), roundTrip.size());
+    for (unsigned i=0; i<buf1.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(buf1[i] * buf1.size(), roundTrip[i]));
+    }
+    
+    ComplexVector<double, AlignedAllocator> complexBuf(inputData, 10);
+    complexBuf.fft();
+    complexBuf.ifft();
+    for (unsigned i=0; i<complexBuf.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(inputData[i] * complexBuf.size(), complexBuf[i].real()));
+    }
+}
+
+TEST(Allocators, PoolFilter) {
+    double inputData[] = {1, 0, 0, 0, 2, 0, 0, 0, 0, 1, 1, 1};
+    double filterTaps[] = {1, 2, 3, 2, 1};
+    
+    RealFirFilter<double> filter(filterTaps, 5);
+    RealFirFilter<double, PoolAllocator> poolFilter(filterTaps, 5);
+    for (unsigned block=0; block<3; block++) {
+        RealVector<double> expected(inputData + 4 * block, 4);
+        RealVector<double, PoolAllocator> buf(inputData + 4 * block, 4);
+        filter.conv(expected);
+        poolFilter.conv(buf);
+        EXPECT_EQ(expected.size(), buf.size());
+        for (unsigned i=0; i<buf.size(); i++) {
+            EXPECT_TRUE(FloatsEqual(expected[i], buf[i]));
+        }
+    }
+}
@@ -20,6 +20,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 */
 
+#include <atomic>
 #include "ComplexFirFilter.h"
 #include "RealFirFilter.h"
 #include "gtest/gtest.h"
@@ -27,6 +28,8 @@ THE SOFTWARE.
 using namespace NimbleDSP;
 
 extern bool FloatsEqual(double float1, double float2);
+extern bool ComplexEqual(std::complex<double> c1, std::complex<double> c2);
+extern std::atomic<unsigned long> allocationCount;
 
 
 TEST(ComplexFirFilter, ConvComplexOneShot) {
@@ -441,3 +444,204 @@ TEST(ComplexFirFilter, CorrComplexOneShot) {
     }
 }
 
+TEST(ComplexFirFilter, StreamingNoAllocations) {
+    unsigned blockLen = 160;
+    std::vector< std::complex<float> > taps(101);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = std::complex<float>(1.0f / (1 + i), -0.5f / (1 + i));
+    }
+    NimbleDSP::ComplexFirFilter<float> convFilter(&taps[0], taps.size()), decimateFilter(&taps[0], taps.size());
+    NimbleDSP::ComplexFirFilter<float> interpFilter(&taps[0], taps.size()), resampleFilter(&taps[0], taps.size());
+    
+    // The buffer needs enough capacity for the interpolated results.
+    NimbleDSP::ComplexVector<float> buf(blockLen);
+    buf.vec.reserve(blockLen * 8);
+    
+    // The first pass grows the filters' working buffers.  After that there should be no allocations.
+    for (int pass=0; pass<3; pass++) {
+        unsigned long allocationsBefore = allocationCount;
+        
+        buf.resize(blockLen, 1.0f);
+        conv(buf, convFilter);
+        buf.resize(blockLen, 1.0f);
+        decimate(buf, 3, decimateFilter);
+        buf.resize(blockLen, 1.0f);
+        interp(buf, 4, interpFilter);
+        buf.resize(blockLen, 1.0f);
+        resample(buf, 3, 2, resampleFilter);
+        
+        if (pass > 0) {
+            EXPECT_EQ(allocationsBefore, allocationCount.load());
+        }
+    }
+}
+
+TEST(ComplexFirFilter, OutOfPlace) {
+    std::vector< std::complex<double> > taps(23);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = std::complex<double>(1.0 / (1 + i), -0.5 / (1 + i));
+    }
+    std::vector< std::complex<double> > input(100);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = std::complex<double>(sin(0.05 * i), 0.25 * cos(1.3 * i));
+    }
+    
+    // Stream in uneven blocks.  The out-of-place results should match the in-place results.
+    unsigned blockLens[] = {17, 1, 60, 22};
+    for (int operation=0; operation<4; operation++) {
+        NimbleDSP::ComplexFirFilter<double> inPlaceFilter(&taps[0], taps.size()), outOfPlaceFilter(&taps[0], taps.size());
+        std::vector< std::complex<double> > output(1000);
+        unsigned inputIndex = 0;
+        for (unsigned block=0; block<sizeof(blockLens)/sizeof(blockLens[0]); block++) {
+            NimbleDSP::ComplexVector<double> expected(&input[inputIndex], blockLens[block]);
+            unsigned numOutputs;
+            switch (operation) {
+            case 0:
+                conv(expected, inPlaceFilter);
+                numOutputs = outOfPlaceFilter.conv(&input[inputIndex], blockLens[block], &output[0], output.size());
+                break;
+            case 1:
+                decimate(expected, 3, inPlaceFilter);
+                numOutputs = outOfPlaceFilter.decimate(&input[inputIndex], blockLens[block], &output[0], output.size(), 3);
+                break;
+            case 2:
+                interp(expected, 4, inPlaceFilter);
+                numOutputs = outOfPlaceFilter.interp(&input[inputIndex], blockLens[block], &output[0], output.size(), 4);
+                break;
+            default:
+                resample(expected, 3, 2, inPlaceFilter);
+                numOutputs = outOfPlaceFilter.resample(&input[inputIndex], blockLens[block], &output[0], output.size(), 3, 2);
+                break;
+            }
+            inputIndex += blockLens[block];
+            
+            EXPECT_EQ(expected.size(), numOutputs);
+            for (unsigned i=0; i<expected.size(); i++) {
+                EXPECT_TRUE(FloatsEqual(expected[i].real(), output[i].real()));
+                EXPECT_TRUE(FloatsEqual(expected[i].imag(), output[i].imag()));
+            }
+        }
+    }
+}
+
+TEST(ComplexFirFilter, ParallelOneShot) {
+    std::vector< std::complex<double> > taps(23);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = std::complex<double>(1.0 / (1 + i), -0.5 / (1 + i));
+    }
+    NimbleDSP::ComplexVector<double> input(30000);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = std::complex<double>(sin(0.05 * i), 0.25 * cos(1.3 * i));
+    }
+    
+    // The multithreaded results should be exactly the same as the single threaded ones.
+    FilterOperationType operations[] = {ONE_SHOT_RETURN_ALL_RESULTS, ONE_SHOT_TRIM_TAILS};
+    for (unsigned op=0; op<2; op++) {
+        NimbleDSP::ComplexFirFilter<double> serialFilter(&taps[0], taps.size(), operations[op]);
+        NimbleDSP::ComplexFirFilter<double> parallelFilter(&taps[0], taps.size(), operations[op]);
+        parallelFilter.numThreads = 4;
+        
+        NimbleDSP::ComplexVector<double> expected = input;
+        NimbleDSP::ComplexVector<double> buf = input;
+        conv(expected, serialFilter);
+        conv(buf, parallelFilter);
+        EXPECT_EQ(expected.vec, buf.vec);
+        
+        expected = input;
+        buf = input;
+        resample(expected, 3, 2, serialFilter);
+        resample(buf, 3, 2, parallelFilter);
+        EXPECT_EQ(expected.vec, buf.vec);
+    }
+}
+
+TEST(ComplexFirFilter, ResamplePolyphase) {
+    int interpRate = 7;
+    int decimateRate = 3;
+    std::vector< std::complex<double> > taps(45);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = std::complex<double>(1.0 / (1 + i) - 0.002 * i, 0.3 / (2 + i));
+    }
+    NimbleDSP::ComplexVector<double> input(100);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = std::complex<double>(sin(0.05 * i), 0.25 * cos(1.3 * i));
+    }
+    
+    // Reference: zero-stuff, filter, and then throw away samples.
+    NimbleDSP::ComplexVector<double> expected = input;
+    NimbleDSP::ComplexVector<double> tapsVector(taps);
+    upsample(expected, interpRate);
+    conv(expected, tapsVector);
+    downsample(expected, decimateRate);
+    
+    NimbleDSP::ComplexFirFilter<double> filter(taps, ONE_SHOT_RETURN_ALL_RESULTS);
+    NimbleDSP::ComplexVector<double> buf = input;
+    resample(buf, interpRate, decimateRate, filter);
+    for (unsigned i=0; i<std::min(buf.size(), expected.size()); i++) {
+        EXPECT_TRUE(ComplexEqual(expected[i], buf[i]));
+    }
+    
+    // Streaming in uneven blocks should give the same results.
+    NimbleDSP::ComplexFirFilter<double> streamFilter(taps);
+    unsigned blockLens[] = {17, 1, 60, 22};
+    unsigned inputIndex = 0, outputIndex = 0;
+    for (unsigned block=0; block<sizeof(blockLens)/sizeof(blockLens[0]); block++) {
+        NimbleDSP::ComplexVector<double> streamBuf(&input.vec[inputIndex], blockLens[block]);
+        inputIndex += blockLens[block];
+        resample(streamBuf, interpRate, decimateRate, streamFilter);
+        for (unsigned i=0; i<streamBuf.size(); i++, outputIndex++) {
+            EXPECT_TRUE(ComplexEqual(expected[outputIndex], streamBuf[i]));
+        }
+    }
+    EXPECT_NEAR(input.size() * interpRate / decimateRate, outputIndex, 1);
+    
+    // Changing the taps should rebuild the cached polyphase taps.
+    for (unsigned i=0; i<filter.size(); i++) {
+        filter[i] *= 2.0;
+    }
+    buf = input;
+    resample(buf, interpRate, decimateRate, filter);
+    for (unsigned i=0; i<std::min(buf.size(), expected.size()); i++) {
+        EXPECT_TRUE(ComplexEqual(expected[i] * 2.0, buf[i]));
+    }
+}
+
+TEST(ComplexFirFilter, ResampleStreamDownsample) {
+    std::vector< std::complex<double> > taps(7);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = std::complex<double>(1.0 / (1 + i), -0.5 / (1 + i));
+    }
+    NimbleDSP::ComplexVector<double> input(60);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = std::complex<double>(sin(0.05 * i), 0.25 * cos(1.3 * i));
+    }
+    NimbleDSP::ComplexVector<double> tapsVector(taps);
+    
+    // Decimation rates bigger than the interpolation rate skip over data samples.  Streaming in blocks should
+    // match the one-shot results and never write more than resampleOutputLength() results.
+    int rates[][2] = {{2, 3}, {1, 2}};
+    for (unsigned r=0; r<sizeof(rates)/sizeof(rates[0]); r++) {
+        int interpRate = rates[r][0];
+        int decimateRate = rates[r][1];
+        NimbleDSP::ComplexVector<double> expected = input;
+        upsample(expected, interpRate);
+        conv(expected, tapsVector);
+        downsample(expected, decimateRate);
+        
+        NimbleDSP::ComplexFirFilter<double> filter(taps);
+        const unsigned blockLen = 10;
+        unsigned outputIndex = 0;
+        for (unsigned inputIndex=0; inputIndex<input.size(); inputIndex+=blockLen) {
+            unsigned capacity = filter.resampleOutputLength(blockLen, interpRate, decimateRate);
+            std::vector< std::complex<double> > output(capacity + 1, std::complex<double>(12345.0));
+            unsigned numOutputs = filter.resample(&input.vec[inputIndex], blockLen, &output[0], capacity, interpRate,
+                                                  decimateRate);
+            EXPECT_LE(numOutputs, capacity);
+            EXPECT_EQ(std::complex<double>(12345.0), output[capacity]);
+            for (unsigned i=0; i<numOutputs; i++, outputIndex++) {
+                EXPECT_TRUE(ComplexEqual(expected[outputIndex], output[i]));
+            }
+        }
+        EXPECT_EQ((input.size() * interpRate + decimateRate - 1) / decimateRate, outputIndex);
+    }
+}
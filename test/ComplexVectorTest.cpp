@@ -64,6 +64,29 @@ TEST(ComplexVectorInit, Vector) {
     }
 }
 
+TEST(ComplexVectorInit, Move) {
+    std::complex<double> array[] = {std::complex<double>(2.094776, 2.603959), std::complex<double>(1.072411, 1.546441), std::complex<double>(1.458795, -0.646638)};
+    std::vector< std::complex<double> > inputData (array, array + sizeof(array) / sizeof(array[0]) );
+    const std::complex<double> *data = VECTOR_TO_ARRAY(inputData);
+    
+	NimbleDSP::ComplexVector<double> buf(std::move(inputData), NimbleDSP::FREQUENCY_DOMAIN);
+    EXPECT_EQ(data, VECTOR_TO_ARRAY(buf.vec));
+    EXPECT_EQ(NimbleDSP::FREQUENCY_DOMAIN, buf.domain);
+    
+	NimbleDSP::ComplexVector<double> buf2(std::move(buf));
+    EXPECT_EQ(data, VECTOR_TO_ARRAY(buf2.vec));
+    EXPECT_EQ(NimbleDSP::FREQUENCY_DOMAIN, buf2.domain);
+    
+	NimbleDSP::ComplexVector<double> buf3;
+    buf3 = std::move(buf2);
+    EXPECT_EQ(data, VECTOR_TO_ARRAY(buf3.vec));
+    EXPECT_EQ(NimbleDSP::FREQUENCY_DOMAIN, buf3.domain);
+    EXPECT_EQ((unsigned) 0, buf2.size());
+    for (unsigned i=0; i<buf3.size(); i++) {
+        EXPECT_EQ(array[i], buf3[i]);
+    }
+}
+
 // Operator tests
 TEST(ComplexVectorOperators, PlusEqualsBuf) {
     std::complex<double> inputData[] = {std::complex<double>(2.094776, 2.603959), std::complex<double>(1.072411, 1.546441), std::complex<double>(1.458795, -0.646638), std::complex<double>(0.932867, -1.972880), std::complex<double>(1.236277, -2.809003), std::complex<double>(-1.338462, -2.722972), std::complex<double>(-2.417209, 1.940747), std::complex<double>(1.168972, -1.097403), std::complex<double>(2.701332, -2.793324)};
@@ -126,6 +149,62 @@ TEST(ComplexVectorOperators, PlusScalar) {
     }
 }
 
+TEST(ComplexVectorOperators, Expression) {
+    std::complex<double> inputData[] = {std::complex<double>(2.094776, 2.603959), std::complex<double>(1.072411, 1.546441), std::complex<double>(1.458795, -0.646638), std::complex<double>(0.932867, -1.972880), std::complex<double>(1.236277, -2.809003), std::complex<double>(-1.338462, -2.722972), std::complex<double>(-2.417209, 1.940747), std::complex<double>(1.168972, -1.097403), std::complex<double>(2.701332, -2.793324)};
+    double realData[] = {1, -2, 0.5, 3, 4, -1.5, 2, 7, -3};
+    unsigned numElements = sizeof(inputData)/sizeof(inputData[0]);
+	NimbleDSP::ComplexVector<double> a(inputData, numElements);
+	NimbleDSP::RealVector<double> r(realData, numElements);
+    std::complex<double> operand(1.1, 3.5);
+    
+    NimbleDSP::ComplexVector<double> c = a*a + a*r - operand;
+    EXPECT_EQ(numElements, c.size());
+    for (unsigned i=0; i<numElements; i++) {
+        EXPECT_TRUE(ComplexEqual(inputData[i]*inputData[i] + inputData[i]*realData[i] - operand, c[i]));
+    }
+    
+    const std::complex<double> *data = VECTOR_TO_ARRAY(c.vec);
+    c.domain = NimbleDSP::FREQUENCY_DOMAIN;
+    c = a / operand;
+    EXPECT_EQ(data, VECTOR_TO_ARRAY(c.vec));
+    EXPECT_EQ(NimbleDSP::FREQUENCY_DOMAIN, c.domain);
+    for (unsigned i=0; i<numElements; i++) {
+        EXPECT_TRUE(ComplexEqual(inputData[i] / operand, c[i]));
+    }
+    
+    c *= a - r;
+    for (unsigned i=0; i<numElements; i++) {
+        EXPECT_TRUE(ComplexEqual(inputData[i] / operand * (inputData[i] - realData[i]), c[i]));
+    }
+    
+    // A real expression can be assigned to a complex vector.
+    NimbleDSP::ComplexVector<double> fromReal = r * r;
+    for (unsigned i=0; i<numElements; i++) {
+        EXPECT_EQ(std::complex<double>(realData[i] * realData[i]), fromReal[i]);
+    }
+}
+
+TEST(ComplexVectorOperators, ExpressionEval) {
+    std::complex<double> inputData[] = {std::complex<double>(2.094776, 2.603959), std::complex<double>(1.072411, 1.546441), std::complex<double>(1.458795, -0.646638), std::complex<double>(0.932867, -1.972880), std::complex<double>(1.236277, -2.809003), std::complex<double>(-1.338462, -2.722972), std::complex<double>(-2.417209, 1.940747), std::complex<double>(1.168972, -1.097403), std::complex<double>(2.701332, -2.793324)};
+    double realData[] = {1, -2, 0.5, 3, 4, -1.5, 2, 7, -3};
+    unsigned numElements = sizeof(inputData)/sizeof(inputData[0]);
+	NimbleDSP::ComplexVector<double> a(inputData, numElements);
+	NimbleDSP::RealVector<double> r(realData, numElements);
+    
+    // A complex left operand evaluates to a ComplexVector, so complex methods can be chained on the result.
+    NimbleDSP::ComplexVector<double> c = (a * r).eval().conj();
+    EXPECT_EQ(numElements, c.size());
+    for (unsigned i=0; i<numElements; i++) {
+        EXPECT_TRUE(ComplexEqual(std::conj(inputData[i] * realData[i]), c[i]));
+    }
+    
+    std::complex<double> expectedSum = 0;
+    for (unsigned i=0; i<numElements; i++) {
+        expectedSum += inputData[i] + inputData[i];
+    }
+    EXPECT_TRUE(ComplexEqual(expectedSum, (a + a).eval().sum()));
+}
+
 TEST(ComplexVectorOperators, MinusEqualsBuf) {
     std::complex<double> inputData[] = {std::complex<double>(2.094776, 2.603959), std::complex<double>(1.072411, 1.546441), std::complex<double>(1.458795, -0.646638), std::complex<double>(0.932867, -1.972880), std::complex<double>(1.236277, -2.809003), std::complex<double>(-1.338462, -2.722972), std::complex<double>(-2.417209, 1.940747), std::complex<double>(1.168972, -1.097403), std::complex<double>(2.701332, -2.793324)};
     std::complex<double> inputData2[] = {std::complex<double>(-2.168253, -2.104236), std::complex<double>(-1.454950, 2.044304), std::complex<double>(-1.474307, 1.885709), std::complex<double>(-1.538850, 2.575582), std::complex<double>(-0.900097, -1.820428), std::complex<double>(-1.493497, 0.696268), std::complex<double>(-0.160267, -0.890043), std::complex<double>(1.984972, 0.511585), std::complex<double>(0.298342, 2.503162)};
@@ -562,6 +641,32 @@ TEST(ComplexVectorMethods, IFFT) {
     }
 }
 
+TEST(ComplexVectorMethods, FFTRepeated) {
+    std::complex<double> inputData[] = {std::complex<double>(2.094776, 2.603959), std::complex<double>(1.072411, 1.546441), std::complex<double>(1.458795, -0.646638), std::complex<double>(0.932867, -1.972880), std::complex<double>(1.236277, -2.809003), std::complex<double>(-1.338462, -2.722972), std::complex<double>(-2.417209, 1.940747), std::complex<double>(1.168972, -1.097403), std::complex<double>(2.701332, -2.793324)};
+    std::complex<double>  expectedData[] = {std::complex<double>(6.9097590000, -5.9510730000), std::complex<double>(6.0948705961, 3.5401310272), std::complex<double>(8.8172840764, 5.8659402629), std::complex<double>(0.7542392638, 6.2651671652), std::complex<double>(-0.8240048974, 1.8728723957), std::complex<double>(3.3960661360, 1.1172915239), std::complex<double>(-5.8326962638, 7.4013838348), std::complex<double>(-6.9279259075, -6.2566796847), std::complex<double>(6.4653919964, 9.5805974749)};
+    unsigned numElements = sizeof(inputData)/sizeof(inputData[0]);
+    
+    // The second and third passes reuse the cached plans.
+    for (int pass=0; pass<3; pass++) {
+        NimbleDSP::ComplexVector<double> buf(inputData, numElements);
+        // The transforms keep the vector's storage, so views of it stay valid.
+        NimbleDSP::VectorView< std::complex<double> > view(buf);
+        fft(buf);
+        EXPECT_EQ(VECTOR_TO_ARRAY(buf.vec), view.data);
+        for (unsigned i=0; i<numElements; i++) {
+            EXPECT_TRUE(ComplexEqual(expectedData[i], buf[i]));
+            EXPECT_EQ(buf[i], view[i]);
+        }
+        ifft(buf);
+        EXPECT_EQ(VECTOR_TO_ARRAY(buf.vec), view.data);
+        for (unsigned i=0; i<numElements; i++) {
+            EXPECT_TRUE(ComplexEqual(inputData[i] * (double) numElements, buf[i]));
+        }
+    }
+    EXPECT_EQ(&NimbleDSP::getFftPlan<double>(numElements, false), &NimbleDSP::getFftPlan<double>(numElements, false));
+    EXPECT_NE(&NimbleDSP::getFftPlan<double>(numElements, false), &NimbleDSP::getFftPlan<double>(numElements, true));
+}
+
 TEST(ComplexVectorMethods, Conj) {
     std::complex<double> inputData[] = {std::complex<double>(2.094776, 2.603959), std::complex<double>(1.072411, 1.546441), std::complex<double>(1.458795, -0.646638), std::complex<double>(0.932867, -1.972880), std::complex<double>(1.236277, -2.809003), std::complex<double>(-1.338462, -2.722972), std::complex<double>(-2.417209, 1.940747), std::complex<double>(1.168972, -1.097403), std::complex<double>(2.701332, -2.793324)};
     std::complex<double> expectedData[] = {std::complex<double>(2.094776, -2.603959), std::complex<double>(1.072411, -1.546441), std::complex<double>(1.458795, 0.646638), std::complex<double>(0.932867, 1.972880), std::complex<double>(1.236277, 2.809003), std::complex<double>(-1.338462, 2.722972), std::complex<double>(-2.417209, -1.940747), std::complex<double>(1.168972, 1.097403), std::complex<double>(2.701332, 2.793324)};
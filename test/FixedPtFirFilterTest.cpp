@@ -0,0 +1,347 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <stdint.h>
+#include "FixedPtFirFilter.h"
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+// Full convolution of "data" (upsampled by "rate") with "taps", calculated in 64 bits.
+static std::vector<int64_t> FixedPtFullConv(const std::vector<int64_t> & data, const std::vector<int64_t> & taps, int rate = 1) {
+    std::vector<int64_t> upsampled(data.size() * rate, 0);
+    for (unsigned i=0; i<data.size(); i++) {
+        upsampled[i * rate] = data[i];
+    }
+    std::vector<int64_t> result(upsampled.size() + taps.size() - 1, 0);
+    for (unsigned i=0; i<upsampled.size(); i++) {
+        for (unsigned j=0; j<taps.size(); j++) {
+            result[i + j] += upsampled[i] * taps[j];
+        }
+    }
+    return result;
+}
+
+// Scales an accumulated result the way the filter should, with arithmetic that can't overflow.
+static int64_t FixedPtScale(int64_t acc, unsigned shift, bool rounding, int64_t minVal, int64_t maxVal) {
+    double scaled = acc / (double) (1LL << shift);
+    int64_t result = (int64_t) (rounding ? floor(scaled + 0.5) : floor(scaled));
+    return std::min(std::max(result, minVal), maxVal);
+}
+
+// Full scale int16_t test data.
+static std::vector<int16_t> FixedPtTestData(unsigned len) {
+    std::vector<int16_t> data(len);
+    for (unsigned i=0; i<len; i++) {
+        data[i] = (int16_t) floor(32767 * (0.7 * sin(0.21 * i) + 0.3 * cos(2.3 * i)) + 0.5);
+    }
+    return data;
+}
+
+// Q15 lowpass taps, plus one that is well over half scale so that int16_t accumulation would overflow.
+static std::vector<int16_t> FixedPtTestTaps(unsigned numTaps) {
+    std::vector<int16_t> taps(numTaps);
+    for (unsigned i=0; i<numTaps; i++) {
+        double x = i - (numTaps - 1) / 2.0;
+        taps[i] = (int16_t) floor(32767 * (x == 0 ? 0.8 : 0.8 * sin(0.8 * M_PI * x) / (0.8 * M_PI * x)) + 0.5);
+    }
+    return taps;
+}
+
+TEST(FixedPtFirFilter, ConvStreamInt16) {
+    std::vector<int16_t> data = FixedPtTestData(300);
+    std::vector<int16_t> taps = FixedPtTestTaps(21);
+    std::vector<int64_t> expected = FixedPtFullConv(std::vector<int64_t>(data.begin(), data.end()),
+                                                    std::vector<int64_t>(taps.begin(), taps.end()));
+    
+    FixedPtFirFilter<int16_t, int16_t, int32_t> filter(taps, 15);
+    std::vector<int16_t> result(data.size());
+    unsigned blockLens[] = {1, 7, 20, 33, 100};
+    unsigned start = 0;
+    for (unsigned block=0; start<data.size(); block++) {
+        unsigned len = std::min(blockLens[block % 5], (unsigned) data.size() - start);
+        EXPECT_EQ(len, filter.convOutputLength(len));
+        EXPECT_EQ(len, filter.conv(&data[start], len, &result[start], len));
+        start += len;
+    }
+    for (unsigned i=0; i<data.size(); i++) {
+        EXPECT_EQ(FixedPtScale(expected[i], 15, true, -32768, 32767), result[i]);
+    }
+}
+
+TEST(FixedPtFirFilter, ConvVector) {
+    std::vector<int16_t> data = FixedPtTestData(100);
+    std::vector<int16_t> taps = FixedPtTestTaps(9);
+    std::vector<int64_t> expected = FixedPtFullConv(std::vector<int64_t>(data.begin(), data.end()),
+                                                    std::vector<int64_t>(taps.begin(), taps.end()));
+    
+    FixedPtFirFilter<int16_t, int16_t, int32_t> filter(taps, 15);
+    RealFixedPtVector<int16_t> buf(data);
+    conv(buf, filter);
+    EXPECT_EQ(data.size(), buf.size());
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_EQ(FixedPtScale(expected[i], 15, true, -32768, 32767), buf[i]);
+    }
+}
+
+TEST(FixedPtFirFilter, ConvOneShot) {
+    std::vector<int16_t> data = FixedPtTestData(50);
+    std::vector<int16_t> taps = FixedPtTestTaps(8);
+    std::vector<int64_t> expected = FixedPtFullConv(std::vector<int64_t>(data.begin(), data.end()),
+                                                    std::vector<int64_t>(taps.begin(), taps.end()));
+    
+    FixedPtFirFilter<int16_t, int16_t, int32_t> filter(taps, 15, ONE_SHOT_RETURN_ALL_RESULTS);
+    std::vector<int16_t> result(filter.convOutputLength((unsigned) data.size()));
+    EXPECT_EQ(expected.size(), result.size());
+    filter.conv(&data[0], (unsigned) data.size(), &result[0], (unsigned) result.size());
+    for (unsigned i=0; i<result.size(); i++) {
+        EXPECT_EQ(FixedPtScale(expected[i], 15, true, -32768, 32767), result[i]);
+    }
+    
+    filter.filtOperation = ONE_SHOT_TRIM_TAILS;
+    result.resize(filter.convOutputLength((unsigned) data.size()));
+    EXPECT_EQ(data.size(), result.size());
+    filter.conv(&data[0], (unsigned) data.size(), &result[0], (unsigned) result.size());
+    for (unsigned i=0; i<result.size(); i++) {
+        EXPECT_EQ(FixedPtScale(expected[i + 3], 15, true, -32768, 32767), result[i]);
+    }
+}
+
+TEST(FixedPtFirFilter, RoundingAndSaturation) {
+    int16_t taps[] = {1};
+    int16_t input[] = {3, -3, 5, -5};
+    int16_t result[4];
+    
+    FixedPtFirFilter<int16_t, int16_t, int32_t> filter(taps, 1, 1);
+    filter.conv(input, 4, result, 4);
+    EXPECT_EQ(2, result[0]);
+    EXPECT_EQ(-1, result[1]);
+    EXPECT_EQ(3, result[2]);
+    EXPECT_EQ(-2, result[3]);
+    
+    filter.rounding = false;
+    filter.conv(input, 4, result, 4);
+    EXPECT_EQ(1, result[0]);
+    EXPECT_EQ(-2, result[1]);
+    EXPECT_EQ(2, result[2]);
+    EXPECT_EQ(-3, result[3]);
+    
+    int16_t bigTaps[] = {32767, 32767};
+    int16_t bigInput[] = {30000, 30000, -30000, -30000};
+    FixedPtFirFilter<int16_t, int16_t, int32_t> bigFilter(bigTaps, 2, 15);
+    bigFilter.conv(bigInput, 4, result, 4);
+    EXPECT_EQ(29999, result[0]);
+    EXPECT_EQ(32767, result[1]);
+    EXPECT_EQ(0, result[2]);
+    EXPECT_EQ(-32768, result[3]);
+    
+    // Without saturation the results wrap.
+    bigFilter.reset();
+    bigFilter.saturation = false;
+    bigFilter.conv(bigInput, 4, result, 4);
+    EXPECT_EQ(29999, result[0]);
+    EXPECT_EQ((int16_t) 59998, result[1]);
+    EXPECT_EQ(0, result[2]);
+    EXPECT_EQ((int16_t) -59998, result[3]);
+}
+
+TEST(FixedPtFirFilter, DecimateStream) {
+    std::vector<int16_t> data = FixedPtTestData(200);
+    std::vector<int64_t> data64(data.begin(), data.end());
+    
+    // Includes rates larger than the number of taps, where the stream has to skip samples between results.
+    int rates[] = {2, 3, 7};
+    unsigned tapCounts[] = {16, 5, 4};
+    for (unsigned test=0; test<3; test++) {
+        int rate = rates[test];
+        std::vector<int16_t> taps = FixedPtTestTaps(tapCounts[test]);
+        std::vector<int64_t> expected = FixedPtFullConv(data64, std::vector<int64_t>(taps.begin(), taps.end()));
+        
+        FixedPtFirFilter<int16_t, int16_t, int32_t> filter(taps, 15);
+        std::vector<int16_t> result;
+        unsigned blockLens[] = {1, 5, 13, 2, 40};
+        unsigned start = 0;
+        for (unsigned block=0; start<data.size(); block++) {
+            unsigned len = std::min(blockLens[block % 5], (unsigned) data.size() - start);
+            std::vector<int16_t> output(filter.decimateOutputLength(len, rate));
+            EXPECT_EQ(output.size(), filter.decimate(&data[start], len, output.data(), (unsigned) output.size(), rate));
+            result.insert(result.end(), output.begin(), output.end());
+            start += len;
+        }
+        EXPECT_EQ((data.size() + rate - 1) / rate, result.size());
+        for (unsigned i=0; i<result.size(); i++) {
+            EXPECT_EQ(FixedPtScale(expected[i * rate], 15, true, -32768, 32767), result[i]);
+        }
+    }
+}
+
+TEST(FixedPtFirFilter, DecimateOneShotVector) {
+    std::vector<int16_t> data = FixedPtTestData(61);
+    std::vector<int16_t> taps = FixedPtTestTaps(11);
+    std::vector<int64_t> expected = FixedPtFullConv(std::vector<int64_t>(data.begin(), data.end()),
+                                                    std::vector<int64_t>(taps.begin(), taps.end()));
+    int rate = 4;
+    
+    FixedPtFirFilter<int16_t, int16_t, int32_t> filter(taps, 15, ONE_SHOT_RETURN_ALL_RESULTS);
+    RealFixedPtVector<int16_t> buf(data);
+    decimate(buf, rate, filter);
+    EXPECT_EQ((expected.size() + rate - 1) / rate, buf.size());
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_EQ(FixedPtScale(expected[i * rate], 15, true, -32768, 32767), buf[i]);
+    }
+    
+    filter.filtOperation = ONE_SHOT_TRIM_TAILS;
+    buf = RealFixedPtVector<int16_t>(data);
+    decimate(buf, rate, filter);
+    EXPECT_EQ((data.size() + rate - 1) / rate, buf.size());
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_EQ(FixedPtScale(expected[i * rate + 5], 15, true, -32768, 32767), buf[i]);
+    }
+}
+
+TEST(FixedPtFirFilter, InterpStream) {
+    std::vector<int16_t> data = FixedPtTestData(80);
+    std::vector<int16_t> taps = FixedPtTestTaps(14);
+    int rate = 3;
+    std::vector<int64_t> expected = FixedPtFullConv(std::vector<int64_t>(data.begin(), data.end()),
+                                                    std::vector<int64_t>(taps.begin(), taps.end()), rate);
+    
+    FixedPtFirFilter<int16_t, int16_t, int32_t> filter(taps, 15);
+    std::vector<int16_t> result;
+    unsigned blockLens[] = {1, 9, 3, 25};
+    unsigned start = 0;
+    for (unsigned block=0; start<data.size(); block++) {
+        unsigned len = std::min(blockLens[block % 4], (unsigned) data.size() - start);
+        std::vector<int16_t> output(filter.interpOutputLength(len, rate));
+        EXPECT_EQ(len * rate, filter.interp(&data[start], len, VECTOR_TO_ARRAY(output), (unsigned) output.size(), rate));
+        result.insert(result.end(), output.begin(), output.end());
+        start += len;
+    }
+    EXPECT_EQ(data.size() * rate, result.size());
+    for (unsigned i=0; i<result.size(); i++) {
+        EXPECT_EQ(FixedPtScale(expected[i], 15, true, -32768, 32767), result[i]);
+    }
+}
+
+TEST(FixedPtFirFilter, InterpOneShotVector) {
+    std::vector<int16_t> data = FixedPtTestData(40);
+    std::vector<int16_t> taps = FixedPtTestTaps(10);
+    int rate = 4;
+    std::vector<int64_t> expected = FixedPtFullConv(std::vector<int64_t>(data.begin(), data.end()),
+                                                    std::vector<int64_t>(taps.begin(), taps.end()), rate);
+    
+    FixedPtFirFilter<int16_t, int16_t, int32_t> filter(taps, 15, ONE_SHOT_RETURN_ALL_RESULTS);
+    RealFixedPtVector<int16_t> buf(data);
+    interp(buf, rate, filter);
+    EXPECT_EQ(expected.size() - (rate - 1), buf.size());
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_EQ(FixedPtScale(expected[i], 15, true, -32768, 32767), buf[i]);
+    }
+    
+    filter.filtOperation = ONE_SHOT_TRIM_TAILS;
+    buf = RealFixedPtVector<int16_t>(data);
+    interp(buf, rate, filter);
+    EXPECT_EQ(data.size() * rate, buf.size());
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_EQ(FixedPtScale(expected[i + 4], 15, true, -32768, 32767), buf[i]);
+    }
+}
+
+TEST(FixedPtFirFilter, ComplexIq) {
+    std::vector<int16_t> dataI = FixedPtTestData(150);
+    std::vector<int16_t> dataQ = FixedPtTestData(170);
+    std::vector< std::complex<int16_t> > data(dataI.size());
+    for (unsigned i=0; i<data.size(); i++) {
+        data[i] = std::complex<int16_t>(dataI[i], dataQ[data.size() + 19 - i]);
+    }
+    std::vector<int16_t> taps = FixedPtTestTaps(17);
+    std::vector<int64_t> taps64(taps.begin(), taps.end());
+    int rate = 2;
+    
+    std::vector<int64_t> reals(data.size()), imags(data.size());
+    for (unsigned i=0; i<data.size(); i++) {
+        reals[i] = data[i].real();
+        imags[i] = data[i].imag();
+    }
+    std::vector<int64_t> expectedReal = FixedPtFullConv(reals, taps64);
+    std::vector<int64_t> expectedImag = FixedPtFullConv(imags, taps64);
+    
+    FixedPtFirFilter<int16_t, int16_t, int32_t> filter(taps, 15);
+    std::vector< std::complex<int16_t> > result;
+    unsigned blockLens[] = {3, 30, 11};
+    unsigned start = 0;
+    for (unsigned block=0; start<data.size(); block++) {
+        unsigned len = std::min(blockLens[block % 3], (unsigned) data.size() - start);
+        std::vector< std::complex<int16_t> > output(data.begin() + start, data.begin() + start + len);
+        // Decimates in place.
+        output.resize(filter.decimate(VECTOR_TO_ARRAY(output), len, VECTOR_TO_ARRAY(output), len, rate));
+        result.insert(result.end(), output.begin(), output.end());
+        start += len;
+    }
+    EXPECT_EQ(data.size() / rate, result.size());
+    for (unsigned i=0; i<result.size(); i++) {
+        EXPECT_EQ(FixedPtScale(expectedReal[i * rate], 15, true, -32768, 32767), result[i].real());
+        EXPECT_EQ(FixedPtScale(expectedImag[i * rate], 15, true, -32768, 32767), result[i].imag());
+    }
+}
+
+TEST(FixedPtFirFilter, WideTapsInt64Accumulator) {
+    // int32_t data and taps whose products only fit in 64 bits.
+    std::vector<int16_t> data16 = FixedPtTestData(90);
+    std::vector<int32_t> data(data16.size());
+    for (unsigned i=0; i<data.size(); i++) {
+        data[i] = data16[i] * 65536;
+    }
+    std::vector<double> floatTaps(13);
+    for (unsigned i=0; i<floatTaps.size(); i++) {
+        floatTaps[i] = 0.4 * cos(0.3 * i) - 0.1;
+    }
+    
+    FixedPtFirFilter<int32_t, int32_t, int64_t> filter(1, 0);
+    filter.quantizeTaps(floatTaps, 30);
+    EXPECT_EQ(30u, filter.outputShift);
+    EXPECT_EQ(floatTaps.size(), filter.size());
+    std::vector<int64_t> taps64(floatTaps.size());
+    for (unsigned i=0; i<floatTaps.size(); i++) {
+        taps64[i] = (int64_t) floor(floatTaps[i] * (1 << 30) + 0.5);
+        EXPECT_EQ(taps64[i], filter[i]);
+    }
+    
+    std::vector<int64_t> expected = FixedPtFullConv(std::vector<int64_t>(data.begin(), data.end()), taps64);
+    std::vector<int32_t> result(data.size());
+    filter.conv(VECTOR_TO_ARRAY(data), 40, VECTOR_TO_ARRAY(result), 40);
+    filter.conv(VECTOR_TO_ARRAY(data) + 40, 50, VECTOR_TO_ARRAY(result) + 40, 50);
+    for (unsigned i=0; i<result.size(); i++) {
+        EXPECT_EQ(FixedPtScale(expected[i], 30, true, INT32_MIN, INT32_MAX), result[i]);
+    }
+}
+
+TEST(FixedPtFirFilter, QuantizeTapsSaturates) {
+    std::vector<double> floatTaps = {0.5, -1.0, 1.0, -0.25};
+    FixedPtFirFilter<int16_t, int16_t, int32_t> filter;
+    filter.quantizeTaps(floatTaps, 15);
+    EXPECT_EQ(4u, filter.size());
+    EXPECT_EQ(16384, filter[0]);
+    EXPECT_EQ(-32768, filter[1]);
+    EXPECT_EQ(32767, filter[2]);
+    EXPECT_EQ(-8192, filter[3]);
+}
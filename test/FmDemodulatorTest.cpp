@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "FmDemodulator.h"
+#include "FmModulator.h"
+#include "RealVector.h"
+#include "ComplexVector.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+
+
+TEST(FmDemodulator, RoundTrip) {
+    const float maxDeviation = 2500, sampleFreq = 44100;
+    const unsigned len = 4000;
+    RealVector<float> input(len);
+    for (unsigned i=0; i<len; i++) {
+        input[i] = (float) (0.9 * sin(2 * M_PI * 0.002 * i) + 0.1 * sin(2 * M_PI * 0.013 * i));
+    }
+    
+    // Modulate and demodulate in uneven blocks so the state is carried across block boundaries.
+    FmModulator<float> modulator(maxDeviation, sampleFreq, 1.0);
+    FmDemodulator<float> demodulator(maxDeviation, sampleFreq);
+    std::vector< std::complex<float> > fm(len);
+    std::vector<float> output(len);
+    unsigned blockLens[] = {1, 17, 300, 1000};
+    for (unsigned start=0, block=0; start<len; block++) {
+        unsigned blockLen = std::min(blockLens[block % 4], len - start);
+        modulator.modulate(VECTOR_TO_ARRAY(input.vec) + start, blockLen, VECTOR_TO_ARRAY(fm) + start);
+        EXPECT_EQ(blockLen, demodulator.demodulate(VECTOR_TO_ARRAY(fm) + start, blockLen,
+                                                   VECTOR_TO_ARRAY(output) + start));
+        start += blockLen;
+    }
+    
+    // The first output also sees the modulator's starting phase, since the demodulator assumes it starts at 0.
+    for (unsigned i=1; i<len; i++) {
+        EXPECT_NEAR(input[i], output[i], 1e-3);
+    }
+}
+
+TEST(FmDemodulator, NoUnwrapNeeded) {
+    // Steps of nearly +/- pi cross the +/- pi boundary on almost every sample.
+    const unsigned len = 200;
+    ComplexVector<double> input(len);
+    std::vector<double> expected(len);
+    double phase = 0;
+    for (unsigned i=0; i<len; i++) {
+        expected[i] = (i % 3 == 0) ? 0.45 : -0.48;
+        phase += 2 * M_PI * expected[i];
+        input[i] = std::polar(2.0, phase);
+    }
+    
+    FmDemodulator<double> demodulator(1.0);
+    RealVector<double> output;
+    demodulate(input, output, demodulator);
+    EXPECT_EQ(len, output.size());
+    for (unsigned i=0; i<len; i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], output[i]));
+    }
+}
+
+TEST(FmDemodulator, Reset) {
+    std::complex<double> input[] = {std::complex<double>(0, 1), std::complex<double>(-1, 0)};
+    double output[2];
+    FmDemodulator<double> demodulator(0.25);
+    
+    demodulator.demodulate(input, 2, output);
+    EXPECT_TRUE(FloatsEqual(1.0, output[0]));
+    EXPECT_TRUE(FloatsEqual(1.0, output[1]));
+    
+    demodulator.demodulate(input, 1, output);
+    EXPECT_TRUE(FloatsEqual(-1.0, output[0]));
+    
+    demodulator.reset();
+    demodulator.demodulate(input + 1, 1, output);
+    EXPECT_TRUE(FloatsEqual(2.0, output[0]));
+}
@@ -0,0 +1,101 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "FmModulator.h"
+#include "RealVector.h"
+#include "ComplexVector.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+
+
+TEST(FmModulator, MatchesCumsumExp) {
+    const double maxDeviation = 2500, sampleFreq = 44100, startPhase = 0.3;
+    const unsigned len = 3000;
+    std::vector<double> input(len);
+    for (unsigned i=0; i<len; i++) {
+        input[i] = 0.9 * sin(2 * M_PI * 0.003 * i) + 0.05 * cos(2 * M_PI * 0.071 * i);
+    }
+    
+    // The unfused chain from the NarrowbandFM example, in double precision.
+    std::vector< std::complex<double> > expected(len);
+    double phase = startPhase;
+    for (unsigned i=0; i<len; i++) {
+        phase += 2 * M_PI * maxDeviation / sampleFreq * input[i];
+        expected[i] = std::exp(std::complex<double>(0, phase));
+    }
+    
+    FmModulator<double> modulator(maxDeviation, sampleFreq, startPhase);
+    std::vector< std::complex<double> > output(len);
+    unsigned blockLens[] = {1, 17, 300, 1000};
+    for (unsigned start=0, block=0; start<len; block++) {
+        unsigned blockLen = std::min(blockLens[block % 4], len - start);
+        EXPECT_EQ(blockLen, modulator.modulate(VECTOR_TO_ARRAY(input) + start, blockLen,
+                                               VECTOR_TO_ARRAY(output) + start));
+        start += blockLen;
+    }
+    
+    double maxError = 0;
+    for (unsigned i=0; i<len; i++) {
+        maxError = std::max(maxError, std::abs(expected[i] - output[i]));
+    }
+    // The phase accumulator rounds each increment to 2^-32 of a cycle.
+    EXPECT_GT(1e-5, maxError);
+    
+    double cycles = phase / (2 * M_PI);
+    EXPECT_NEAR(2 * M_PI * (cycles - floor(cycles)), modulator.getPhase(), 1e-5);
+}
+
+TEST(FmModulator, ConstantInputIsTone) {
+    RealVector<float> input(1000);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = -0.5;
+    }
+    ComplexVector<float> output;
+    FmModulator<float> modulator(0.2f);
+    modulate(input, output, modulator);
+    EXPECT_EQ(input.size(), output.size());
+    
+    // -0.5 * 0.2 is a frequency of -0.1 cycles per sample.
+    for (unsigned i=0; i<output.size(); i++) {
+        std::complex<double> expected = std::polar(1.0, -2 * M_PI * 0.1 * (i + 1));
+        EXPECT_NEAR(expected.real(), output[i].real(), 1e-4);
+        EXPECT_NEAR(expected.imag(), output[i].imag(), 1e-4);
+    }
+}
+
+TEST(FmModulator, Phase) {
+    FmModulator<double> modulator(0.1, 1.0, -M_PI / 2);
+    EXPECT_NEAR(3 * M_PI / 2, modulator.getPhase(), 1e-8);
+    
+    modulator.setPhase(7 * M_PI);
+    EXPECT_NEAR(M_PI, modulator.getPhase(), 1e-8);
+    
+    double input = 0;
+    std::complex<double> output;
+    modulator.modulate(&input, 1, &output);
+    EXPECT_NEAR(-1, output.real(), 1e-6);
+    EXPECT_NEAR(0, output.imag(), 1e-6);
+}
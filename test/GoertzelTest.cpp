@@ -0,0 +1,134 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Goertzel.h"
+#include "RealVector.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+extern bool ComplexEqual(std::complex<double> c1, std::complex<double> c2);
+
+// Direct DFT of data[start] to data[start + len - 1] at bin "k".
+static std::complex<double> dftBin(const std::vector<double> & data, unsigned start, unsigned len, double k) {
+    std::complex<double> sum = 0;
+    for (unsigned n=0; n<len; n++) {
+        sum += data[start + n] * std::polar(1.0, -2 * M_PI * k * n / len);
+    }
+    return sum;
+}
+
+static std::vector<double> testSignal(unsigned len) {
+    std::vector<double> data(len);
+    for (unsigned i=0; i<len; i++) {
+        data[i] = sin(0.3 * i) + 0.5 * cos(1.1 * i + 0.2) + 0.01 * (i % 7);
+    }
+    return data;
+}
+
+TEST(Goertzel, MatchesDft) {
+    std::vector<double> bins = {0, 3, 5.5, 17, 31};
+    unsigned blockLen = 64;
+    std::vector<double> data = testSignal(blockLen);
+    Goertzel<double> detector(blockLen, bins);
+    
+    EXPECT_EQ(5u, detector.numBins());
+    EXPECT_EQ(1u, detector.process(VECTOR_TO_ARRAY(data), blockLen));
+    for (unsigned bin=0; bin<bins.size(); bin++) {
+        EXPECT_TRUE(ComplexEqual(dftBin(data, 0, blockLen, bins[bin]), detector.spectrum[bin]));
+    }
+    
+    std::vector<double> binPower = detector.power();
+    for (unsigned bin=0; bin<bins.size(); bin++) {
+        EXPECT_TRUE(FloatsEqual(std::norm(detector.spectrum[bin]), binPower[bin]));
+    }
+}
+
+TEST(Goertzel, Streaming) {
+    std::vector<double> bins = {1, 4, 9};
+    unsigned blockLen = 50;
+    unsigned numBlocks = 4;
+    std::vector<double> data = testSignal(blockLen * numBlocks);
+    Goertzel<double> detector(blockLen, bins);
+    
+    // Chunks that don't line up with the blocks.
+    std::vector< std::complex<double> > output(numBlocks * bins.size());
+    unsigned chunkLens[] = {7, 60, 1, 93, 39};
+    unsigned start = 0, completed = 0;
+    for (unsigned chunk=0; chunk<5; chunk++) {
+        completed += detector.process(VECTOR_TO_ARRAY(data) + start, chunkLens[chunk],
+                                      VECTOR_TO_ARRAY(output) + completed * bins.size());
+        start += chunkLens[chunk];
+    }
+    EXPECT_EQ(blockLen * numBlocks, start);
+    EXPECT_EQ(numBlocks, completed);
+    
+    for (unsigned block=0; block<numBlocks; block++) {
+        for (unsigned bin=0; bin<bins.size(); bin++) {
+            EXPECT_TRUE(ComplexEqual(dftBin(data, block * blockLen, blockLen, bins[bin]),
+                                     output[block * bins.size() + bin]));
+        }
+    }
+    for (unsigned bin=0; bin<bins.size(); bin++) {
+        EXPECT_TRUE(ComplexEqual(output[(numBlocks - 1) * bins.size() + bin], detector.spectrum[bin]));
+    }
+}
+
+TEST(Goertzel, VectorAndReset) {
+    std::vector<double> bins = {2, 6};
+    unsigned blockLen = 32;
+    std::vector<double> data = testSignal(blockLen + 10);
+    RealVector<double> buf(data);
+    Goertzel<double> detector(blockLen, bins);
+    
+    EXPECT_EQ(1u, process(buf, detector));
+    for (unsigned bin=0; bin<bins.size(); bin++) {
+        EXPECT_TRUE(ComplexEqual(dftBin(data, 0, blockLen, bins[bin]), detector.spectrum[bin]));
+    }
+    
+    // The 10 left over samples are discarded by the reset.
+    detector.reset();
+    EXPECT_TRUE(ComplexEqual(0, detector.spectrum[0]));
+    EXPECT_EQ(1u, detector.process(VECTOR_TO_ARRAY(data), blockLen));
+    for (unsigned bin=0; bin<bins.size(); bin++) {
+        EXPECT_TRUE(ComplexEqual(dftBin(data, 0, blockLen, bins[bin]), detector.spectrum[bin]));
+    }
+}
+
+TEST(Goertzel, FloatToneDetection) {
+    unsigned blockLen = 205;
+    std::vector<double> bins = {18, 20, 22, 24};
+    std::vector<float> data(blockLen);
+    for (unsigned i=0; i<blockLen; i++) {
+        data[i] = (float) cos(2 * M_PI * 20 * i / blockLen);
+    }
+    Goertzel<float> detector(blockLen, bins);
+    
+    detector.process(VECTOR_TO_ARRAY(data), blockLen);
+    std::vector<float> binPower = detector.power();
+    EXPECT_NEAR(blockLen * blockLen / 4.0, binPower[1], 0.5);
+    EXPECT_NEAR(0, binPower[0], 0.5);
+    EXPECT_NEAR(0, binPower[2], 0.5);
+    EXPECT_NEAR(0, binPower[3], 0.5);
+}
@@ -0,0 +1,254 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MirroredRingBuffer.h"
+#include "RealFirFilter.h"
+#include <vector>
+#include <thread>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+
+
+static void checkMirror(bool allowDoubleMapping) {
+    MirroredMemory<float> memory(1000, allowDoubleMapping);
+    unsigned capacity = memory.capacity();
+    EXPECT_LE(1024u, capacity);
+    EXPECT_EQ(0u, capacity & (capacity - 1));
+    
+    // Write a run that wraps past the end of the first half.
+    float *data = memory.data();
+    unsigned start = capacity - 10;
+    for (unsigned i=0; i<30; i++) {
+        data[start + i] = (float) i;
+    }
+    memory.mirror(start, 30);
+    for (unsigned i=0; i<10; i++) {
+        EXPECT_EQ((float) i, data[start + i + capacity]);
+    }
+    for (unsigned i=10; i<30; i++) {
+        EXPECT_EQ((float) i, data[start + i - capacity]);
+    }
+}
+
+TEST(MirroredMemory, DoubleMapped) {
+    checkMirror(true);
+#if defined(__linux__) && !defined(NIMBLEDSP_NO_MIRRORED_MEMORY)
+    MirroredMemory< std::complex<float> > memory(16);
+    EXPECT_TRUE(memory.isDoubleMapped());
+    memory.data()[3] = std::complex<float>(1, 2);
+    EXPECT_EQ(std::complex<float>(1, 2), memory.data()[3 + memory.capacity()]);
+#endif
+}
+
+TEST(MirroredMemory, Fallback) {
+    checkMirror(false);
+    MirroredMemory<double> memory(100, false);
+    EXPECT_FALSE(memory.isDoubleMapped());
+    EXPECT_EQ(128u, memory.capacity());
+}
+
+static void checkSpscSpans(bool allowDoubleMapping) {
+    MirroredSpscRingBuffer<double> buf(1000, allowDoubleMapping);
+    unsigned capacity = buf.capacity();
+    std::vector<double> data(capacity);
+    for (unsigned i=0; i<capacity; i++) {
+        data[i] = sin(0.05 * i);
+    }
+    
+    // Leave the read and write positions 100 samples from the end, so the next block wraps.
+    EXPECT_EQ(capacity - 100, buf.write(VECTOR_TO_ARRAY(data), capacity - 100));
+    EXPECT_EQ(capacity - 100, buf.readSpan().len);
+    buf.consume(capacity - 100);
+    EXPECT_EQ(0u, buf.size());
+    
+    VectorView<double> span = buf.writeSpan();
+    EXPECT_EQ(capacity, span.len);
+    for (unsigned i=0; i<300; i++) {
+        span[i] = data[i];
+    }
+    buf.commitWrite(300);
+    EXPECT_EQ(300u, buf.size());
+    
+    // Filtering the wrapped span in place matches filtering a copy.
+    double taps[] = {1, -2, 3, 0.5};
+    RealFirFilter<double> spanFilter(taps, 4), copyFilter(taps, 4);
+    RealVector<double> expected(VECTOR_TO_ARRAY(data), 300);
+    copyFilter.conv(expected);
+    VectorView<double> readSpan = buf.readSpan();
+    ASSERT_EQ(300u, readSpan.len);
+    spanFilter.conv(readSpan);
+    for (unsigned i=0; i<300; i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], readSpan[i]));
+    }
+    buf.consume(300);
+    
+    EXPECT_EQ(0u, buf.readSpan().len);
+    EXPECT_EQ(capacity, buf.writeSpan().len);
+}
+
+TEST(MirroredSpscRingBuffer, Spans) {
+    checkSpscSpans(true);
+    checkSpscSpans(false);
+}
+
+static void checkSpscThreads(bool allowDoubleMapping) {
+    const unsigned len = 300000;
+    MirroredSpscRingBuffer<unsigned> buf(100, allowDoubleMapping);
+    
+    std::thread producer([&buf, len]() {
+        unsigned next = 0;
+        while (next < len) {
+            VectorView<unsigned> span = buf.writeSpan();
+            unsigned blockLen = std::min(std::min(span.len, 37u), len - next);
+            for (unsigned i=0; i<blockLen; i++) {
+                span[i] = next + i;
+            }
+            buf.commitWrite(blockLen);
+            next += blockLen;
+            if (blockLen == 0)
+                std::this_thread::yield();
+        }
+        buf.close();
+    });
+    
+    unsigned numRead = 0;
+    bool inOrder = true;
+    while (true) {
+        bool closed = buf.isClosed();
+        VectorView<unsigned> span = buf.readSpan(53);
+        for (unsigned i=0; i<span.len; i++) {
+            inOrder = inOrder && span[i] == numRead + i;
+        }
+        buf.consume(span.len);
+        numRead += span.len;
+        if (closed && buf.size() == 0)
+            break;
+        if (span.len == 0)
+            std::this_thread::yield();
+    }
+    producer.join();
+    
+    EXPECT_EQ(len, numRead);
+    EXPECT_TRUE(inOrder);
+}
+
+TEST(MirroredSpscRingBuffer, Threads) {
+    checkSpscThreads(true);
+    checkSpscThreads(false);
+}
+
+TEST(MirroredMpmcRingBuffer, Claims) {
+    MirroredMpmcRingBuffer<int> buf(1024);
+    int data[3000];
+    for (int i=0; i<3000; i++) {
+        data[i] = i;
+    }
+    
+    // Commits are published in claim order.
+    RingBufferClaim<int> write1 = buf.claimWrite(1000);
+    RingBufferClaim<int> write2 = buf.claimWrite(1000);
+    EXPECT_EQ(1000u, write1.samples.len);
+    EXPECT_EQ(24u, write2.samples.len);
+    EXPECT_EQ(0u, buf.claimWrite(1).samples.len);
+    std::copy(data + 1000, data + 1024, write2.samples.data);
+    std::thread committer([&buf, &write2]() {buf.commitWrite(write2);});
+    std::copy(data, data + 1000, write1.samples.data);
+    EXPECT_EQ(0u, buf.size());
+    buf.commitWrite(write1);
+    committer.join();
+    EXPECT_EQ(1024u, buf.size());
+    
+    RingBufferClaim<int> read1 = buf.claimRead(1000);
+    EXPECT_EQ(0u, read1.position);
+    buf.commitRead(read1);
+    EXPECT_EQ(1000u, buf.write(data + 1024, 1000));
+    
+    // This read wraps around the end of the buffer.
+    int output[1024];
+    EXPECT_EQ(1024u, buf.read(output, 1024));
+    for (int i=0; i<1024; i++) {
+        EXPECT_EQ(i + 1000, output[i]);
+    }
+    EXPECT_EQ(0u, buf.read(output, 1));
+}
+
+TEST(MirroredMpmcRingBuffer, Threads) {
+    const unsigned numProducers = 3, numConsumers = 3, lenPerProducer = 50000;
+    MirroredMpmcRingBuffer<unsigned> buf(256);
+    std::atomic<unsigned> numProducersDone(0);
+    
+    std::vector<std::thread> threads;
+    for (unsigned producer=0; producer<numProducers; producer++) {
+        threads.push_back(std::thread([&, producer]() {
+            unsigned next = 0;
+            while (next < lenPerProducer) {
+                RingBufferClaim<unsigned> claim = buf.claimWrite(std::min(29u, lenPerProducer - next));
+                for (unsigned i=0; i<claim.samples.len; i++) {
+                    claim.samples[i] = producer * lenPerProducer + next + i;
+                }
+                buf.commitWrite(claim);
+                next += claim.samples.len;
+                if (claim.samples.len == 0)
+                    std::this_thread::yield();
+            }
+            if (numProducersDone.fetch_add(1) == numProducers - 1)
+                buf.close();
+        }));
+    }
+    
+    std::vector< std::vector<unsigned> > received(numConsumers);
+    for (unsigned consumer=0; consumer<numConsumers; consumer++) {
+        threads.push_back(std::thread([&, consumer]() {
+            while (true) {
+                bool closed = buf.isClosed();
+                RingBufferClaim<unsigned> claim = buf.claimRead(41);
+                for (unsigned i=0; i<claim.samples.len; i++) {
+                    received[consumer].push_back(claim.samples[i]);
+                }
+                buf.commitRead(claim);
+                if (closed && claim.samples.len == 0 && buf.size() == 0)
+                    break;
+                if (claim.samples.len == 0)
+                    std::this_thread::yield();
+            }
+        }));
+    }
+    for (unsigned i=0; i<threads.size(); i++) {
+        threads[i].join();
+    }
+    
+    // Every sample arrives exactly once.
+    std::vector<unsigned> counts(numProducers * lenPerProducer, 0);
+    for (unsigned consumer=0; consumer<numConsumers; consumer++) {
+        for (unsigned i=0; i<received[consumer].size(); i++) {
+            counts[received[consumer][i]]++;
+        }
+    }
+    unsigned numWrong = 0;
+    for (unsigned i=0; i<counts.size(); i++) {
+        numWrong += (counts[i] != 1);
+    }
+    EXPECT_EQ(0u, numWrong);
+}
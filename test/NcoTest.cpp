@@ -0,0 +1,132 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Nco.h"
+#include "RealVector.h"
+#include "ComplexVector.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+
+// Generates "len" samples in uneven blocks and checks them against exp(j*phase), calculated in double precision
+// from the NCO's rounded frequency.
+template <class T>
+static void checkComplexTone(NcoType type, double freq, double phase, unsigned len, double tolerance) {
+    Nco<T> nco((T) freq, 1.0, (T) phase, type);
+    double startPhase = nco.getPhase();
+    double cyclesPerSample = nco.getFrequency();
+    std::vector< std::complex<T> > output(len);
+    unsigned blockLens[] = {1, 17, 300, 1000};
+    for (unsigned start=0, block=0; start<len; block++) {
+        unsigned blockLen = std::min(blockLens[block % 4], len - start);
+        nco.tone(VECTOR_TO_ARRAY(output) + start, blockLen);
+        start += blockLen;
+    }
+    
+    double maxError = 0;
+    for (unsigned i=0; i<len; i++) {
+        double cycles = startPhase / (2 * M_PI) + cyclesPerSample * i;
+        cycles -= floor(cycles);
+        std::complex<double> expected = std::polar(1.0, 2 * M_PI * cycles);
+        maxError = std::max(maxError, std::abs(expected - std::complex<double>(output[i].real(), output[i].imag())));
+    }
+    EXPECT_GT(tolerance, maxError);
+}
+
+TEST(Nco, ComplexTone) {
+    checkComplexTone<double>(NCO_LOOKUP_TABLE, 0.0123, 0.5, 5000, 1e-6);
+    checkComplexTone<double>(NCO_ROTATOR, 0.0123, 0.5, 5000, 1e-12);
+    checkComplexTone<double>(NCO_POLYNOMIAL, 0.0123, 0.5, 5000, 1e-8);
+    checkComplexTone<double>(NCO_LOOKUP_TABLE, -0.37, -2.0, 5000, 1e-6);
+    checkComplexTone<double>(NCO_ROTATOR, -0.37, -2.0, 5000, 1e-12);
+    checkComplexTone<double>(NCO_POLYNOMIAL, -0.37, -2.0, 5000, 1e-8);
+    checkComplexTone<float>(NCO_LOOKUP_TABLE, 0.21, 1.0, 5000, 2e-6);
+    checkComplexTone<float>(NCO_POLYNOMIAL, 0.21, 1.0, 5000, 2e-6);
+}
+
+TEST(Nco, NoDrift) {
+    // A float rotator that was never resynced would be well off by the end.
+    checkComplexTone<float>(NCO_ROTATOR, 0.0123, 0.0, 1000000, 1e-4);
+    checkComplexTone<float>(NCO_LOOKUP_TABLE, 0.0123, 0.0, 1000000, 2e-6);
+}
+
+TEST(Nco, FrequencyAndPhase) {
+    Nco<double> nco(-100.0, 1000.0, -M_PI / 2);
+    EXPECT_NEAR(-100.0, nco.getFrequency(1000.0), 1e-6);
+    EXPECT_NEAR(-0.1, nco.getFrequency(), 1e-9);
+    EXPECT_NEAR(3 * M_PI / 2, nco.getPhase(), 1e-9);
+    
+    std::vector< std::complex<double> > output(10);
+    // Ten samples at -0.1 cycles per sample is one full cycle.
+    nco.tone(VECTOR_TO_ARRAY(output), 10);
+    EXPECT_NEAR(3 * M_PI / 2, nco.getPhase(), 1e-8);
+    EXPECT_NEAR(-1.0, output[0].imag(), 1e-6);
+    
+    // Changing the frequency doesn't change the phase.
+    nco.setFrequency(0.25);
+    EXPECT_NEAR(3 * M_PI / 2, nco.getPhase(), 1e-8);
+    nco.tone(VECTOR_TO_ARRAY(output), 4);
+    EXPECT_NEAR(-1.0, output[0].imag(), 1e-6);
+    EXPECT_NEAR(1.0, output[1].real(), 1e-6);
+    EXPECT_NEAR(1.0, output[2].imag(), 1e-6);
+    EXPECT_NEAR(-1.0, output[3].real(), 1e-6);
+}
+
+TEST(Nco, Vectors) {
+    NcoType types[] = {NCO_LOOKUP_TABLE, NCO_ROTATOR, NCO_POLYNOMIAL};
+    for (unsigned t=0; t<3; t++) {
+        Nco<double> complexNco(0.03, 1.0, 0.2, types[t]);
+        ComplexVector<double> expected;
+        expected.tone(complexNco, 100);
+        
+        // The real tone is the imaginary part of the complex one, and stays continuous across calls.
+        Nco<double> realNco(0.03, 1.0, 0.2, types[t]);
+        RealVector<double> first, second;
+        tone(first, realNco, 60);
+        tone(second, realNco, 40);
+        EXPECT_EQ(60u, first.size());
+        for (unsigned i=0; i<100; i++) {
+            double value = (i < 60) ? first[i] : second[i - 60];
+            EXPECT_TRUE(FloatsEqual(expected[i].imag(), value));
+        }
+        
+        RealVector<double> realData(100);
+        ComplexVector<double> complexData(100);
+        for (unsigned i=0; i<100; i++) {
+            realData[i] = 1.0 + 0.01 * i;
+            complexData[i] = std::complex<double>(1.0 + 0.01 * i, -0.5);
+        }
+        Nco<double> realModNco(0.03, 1.0, 0.2, types[t]);
+        Nco<double> complexModNco(0.03, 1.0, 0.2, types[t]);
+        modulate(realData, realModNco);
+        modulate(complexData, complexModNco);
+        for (unsigned i=0; i<100; i++) {
+            EXPECT_TRUE(FloatsEqual((1.0 + 0.01 * i) * expected[i].imag(), realData[i]));
+            std::complex<double> product = std::complex<double>(1.0 + 0.01 * i, -0.5) * expected[i];
+            EXPECT_TRUE(FloatsEqual(product.real(), complexData[i].real()));
+            EXPECT_TRUE(FloatsEqual(product.imag(), complexData[i].imag()));
+        }
+    }
+}
@@ -0,0 +1,174 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Pipeline.h"
+#include "RealVector.h"
+#include "ComplexVector.h"
+#include "RealFirFilter.h"
+#include "FmModulator.h"
+#include "FmDemodulator.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+
+
+static std::vector<double> pipelineTestSignal(unsigned len) {
+    std::vector<double> signal(len);
+    for (unsigned i=0; i<len; i++) {
+        signal[i] = sin(0.01 * i) + 0.25 * cos(0.37 * i);
+    }
+    return signal;
+}
+
+// Filters and interpolates in a pipeline with small queues, and checks against doing it in one go.
+static void checkFilterChain(PipelineScheduling scheduling, unsigned numThreads) {
+    const unsigned len = 20000;
+    std::vector<double> signal = pipelineTestSignal(len);
+    double taps[] = {0.1, -0.2, 0.3, 0.5, 0.3, -0.2, 0.1};
+    unsigned numTaps = sizeof(taps)/sizeof(taps[0]);
+    
+    RealVector<double> expected(signal);
+    RealFirFilter<double> expectedConvFilter(taps, numTaps), expectedInterpFilter(taps, numTaps);
+    expectedConvFilter.conv(expected);
+    expectedInterpFilter.interp(expected, 3);
+    
+    RealFirFilter<double> convFilter(taps, numTaps), interpFilter(taps, numTaps);
+    unsigned numGenerated = 0;
+    std::vector<double> output;
+    Pipeline pipeline;
+    auto & source = pipeline.addSource< RealVector<double> >([&](RealVector<double> & block) {
+        unsigned blockLen = std::min(777u, len - numGenerated);
+        block.resize(blockLen);
+        for (unsigned i=0; i<blockLen; i++) {
+            block[i] = signal[numGenerated + i];
+        }
+        numGenerated += blockLen;
+        return numGenerated < len;
+    });
+    auto & conv = pipeline.addInPlaceStage< RealVector<double> >([&](RealVector<double> & block) {
+        convFilter.conv(block);
+    }, 1000);
+    auto & interp = pipeline.addInPlaceStage< RealVector<double> >([&](RealVector<double> & block) {
+        interpFilter.interp(block, 3);
+    }, 512);
+    auto & sink = pipeline.addSink< RealVector<double> >([&](RealVector<double> & block) {
+        output.insert(output.end(), block.vec.begin(), block.vec.end());
+    }, 300);
+    pipeline.connect(source, conv, 1024);
+    pipeline.connect(conv, interp, 1024);
+    pipeline.connect(interp, sink, 1024);
+    pipeline.run(scheduling, numThreads);
+    
+    EXPECT_TRUE(pipeline.finished());
+    ASSERT_EQ(expected.size(), output.size());
+    for (unsigned i=0; i<output.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], output[i]));
+    }
+}
+
+TEST(Pipeline, ThreadPerStage) {
+    checkFilterChain(THREAD_PER_STAGE, 0);
+}
+
+TEST(Pipeline, WorkStealingPool) {
+    checkFilterChain(WORK_STEALING_POOL, 2);
+    checkFilterChain(WORK_STEALING_POOL, 1);
+}
+
+TEST(Pipeline, FanOutAndStats) {
+    const unsigned len = 5000;
+    std::vector<double> signal = pipelineTestSignal(len);
+    unsigned numGenerated = 0;
+    std::vector<double> output1, output2;
+    Pipeline pipeline;
+    auto & source = pipeline.addSource< RealVector<double> >([&](RealVector<double> & block) {
+        unsigned blockLen = std::min(100u, len - numGenerated);
+        block = RealVector<double>(VECTOR_TO_ARRAY(signal) + numGenerated, blockLen);
+        numGenerated += blockLen;
+        return numGenerated < len;
+    });
+    auto & sink1 = pipeline.addSink< RealVector<double> >([&](RealVector<double> & block) {
+        output1.insert(output1.end(), block.vec.begin(), block.vec.end());
+    }, 250);
+    auto & sink2 = pipeline.addSink< RealVector<double> >([&](RealVector<double> & block) {
+        output2.insert(output2.end(), block.vec.begin(), block.vec.end());
+    }, 64);
+    pipeline.connect(source, sink1, 256);
+    pipeline.connect(source, sink2, 64);
+    pipeline.run(WORK_STEALING_POOL, 3, true);
+    
+    ASSERT_EQ(len, output1.size());
+    ASSERT_EQ(len, output2.size());
+    for (unsigned i=0; i<len; i++) {
+        EXPECT_EQ(signal[i], output1[i]);
+        EXPECT_EQ(signal[i], output2[i]);
+    }
+    
+    std::vector<PipelineStageStats> stats = pipeline.getStats();
+    ASSERT_EQ(3u, stats.size());
+    EXPECT_EQ(50u, stats[0].blocks);
+    EXPECT_EQ(0u, stats[0].samplesIn);
+    EXPECT_EQ(len, stats[0].samplesOut);
+    EXPECT_EQ(0u, stats[0].queueCapacity);
+    EXPECT_EQ(20u, stats[1].blocks);
+    EXPECT_EQ(len, stats[1].samplesIn);
+    EXPECT_EQ(256u, stats[1].queueCapacity);
+    EXPECT_EQ(0u, stats[1].queueDepth);
+    EXPECT_EQ((len + 63) / 64, stats[2].blocks);
+    EXPECT_EQ(len, stats[2].samplesIn);
+    EXPECT_EQ(64u, stats[2].queueCapacity);
+}
+
+TEST(Pipeline, ChangeSampleType) {
+    const unsigned len = 8000;
+    std::vector<double> signal = pipelineTestSignal(len);
+    unsigned numGenerated = 0;
+    FmModulator<double> modulator(0.05);
+    FmDemodulator<double> demodulator(0.05);
+    std::vector<double> output;
+    Pipeline pipeline;
+    auto & source = pipeline.addSource< RealVector<double> >([&](RealVector<double> & block) {
+        unsigned blockLen = std::min(1000u, len - numGenerated);
+        block = RealVector<double>(VECTOR_TO_ARRAY(signal) + numGenerated, blockLen);
+        numGenerated += blockLen;
+        return numGenerated < len;
+    });
+    auto & modulate = pipeline.addStage< RealVector<double>, ComplexVector<double> >(
+            [&](RealVector<double> & input, ComplexVector<double> & fm) {modulator.modulate(input, fm);}, 300);
+    auto & demodulate = pipeline.addStage< ComplexVector<double>, RealVector<double> >(
+            [&](ComplexVector<double> & fm, RealVector<double> & result) {demodulator.demodulate(fm, result);}, 700);
+    auto & sink = pipeline.addSink< RealVector<double> >([&](RealVector<double> & block) {
+        output.insert(output.end(), block.vec.begin(), block.vec.end());
+    }, 1000);
+    pipeline.connect(source, modulate);
+    pipeline.connect(modulate, demodulate);
+    pipeline.connect(demodulate, sink);
+    pipeline.run();
+    
+    ASSERT_EQ(len, output.size());
+    for (unsigned i=0; i<len; i++) {
+        EXPECT_NEAR(signal[i], output[i], 1e-6);
+    }
+}
@@ -0,0 +1,111 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "PolyphaseChannelizer.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool ComplexEqual(std::complex<double> c1, std::complex<double> c2);
+
+TEST(PolyphaseChannelizer, MatchesModulateAndDecimate) {
+    // The number of taps isn't a multiple of the number of channels.
+    unsigned numChannels = 8;
+    std::vector<double> taps(29);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = 0.1 + 0.03 * i - 0.002 * i * i;
+    }
+    unsigned len = 403;
+    std::vector< std::complex<double> > data(len);
+    for (unsigned i=0; i<len; i++) {
+        data[i] = std::complex<double>(sin(0.37 * i) + 0.1 * (i % 11), cos(1.3 * i));
+    }
+    
+    // Blocks that don't line up with the decimation rate.
+    PolyphaseChannelizer<double> channelizer(taps, numChannels);
+    EXPECT_EQ(4u, channelizer.tapsPerBranch());
+    std::vector< std::complex<double> > output(((len + numChannels - 1) / numChannels) * numChannels);
+    unsigned blockLens[] = {1, 5, 16, 100, 3, 278};
+    unsigned start = 0, numSets = 0;
+    for (unsigned block=0; block<6; block++) {
+        unsigned expectedSets = channelizer.outputLength(blockLens[block]);
+        unsigned sets = channelizer.channelize(VECTOR_TO_ARRAY(data) + start, blockLens[block],
+                                               VECTOR_TO_ARRAY(output) + numSets * numChannels,
+                                               (unsigned) output.size() / numChannels - numSets);
+        EXPECT_EQ(expectedSets, sets);
+        numSets += sets;
+        start += blockLens[block];
+    }
+    EXPECT_EQ(len, start);
+    EXPECT_EQ((len + numChannels - 1) / numChannels, numSets);
+    
+    for (unsigned k=0; k<numChannels; k++) {
+        ComplexVector<double> shifted(data);
+        shifted.modulate(-(double) k / numChannels);
+        RealFirFilter<double> filter(taps);
+        std::vector< std::complex<double> > expected(filter.decimateOutputLength(len, numChannels));
+        EXPECT_EQ(numSets, filter.decimate(VECTOR_TO_ARRAY(shifted.vec), len, VECTOR_TO_ARRAY(expected),
+                                           (unsigned) expected.size(), numChannels));
+        for (unsigned m=0; m<numSets; m++) {
+            EXPECT_TRUE(ComplexEqual(expected[m], output[m * numChannels + k]));
+        }
+    }
+}
+
+TEST(PolyphaseChannelizer, SeparatesTones) {
+    unsigned numChannels = 4;
+    RealFirFilter<double> prototype;
+    double edge[] = {.0, .2, .3, 1.0};
+    double fx[] = {1.0, 0};
+    double wtx[] = {1.0, 1.0};
+    EXPECT_TRUE(prototype.firpm(63, 2, edge, fx, wtx));
+    PolyphaseChannelizer<double> channelizer(prototype, numChannels);
+    
+    // A real tone at the center of channel 1 also shows up in channel 3, its negative frequency.
+    unsigned len = 4096;
+    RealVector<double> data(len);
+    for (unsigned i=0; i<len; i++) {
+        data[i] = cos(2 * M_PI * i / numChannels + 0.3);
+    }
+    std::vector< ComplexVector<double> > channels;
+    channelize(data, channels, channelizer);
+    EXPECT_EQ(numChannels, channels.size());
+    
+    std::vector<double> channelPower(numChannels, 0);
+    for (unsigned k=0; k<numChannels; k++) {
+        EXPECT_EQ(len / numChannels, channels[k].size());
+        // Skip the filter's transient.
+        for (unsigned m=32; m<channels[k].size(); m++) {
+            channelPower[k] += std::norm(channels[k][m]);
+        }
+    }
+    EXPECT_GT(channelPower[1], 1e4 * channelPower[0]);
+    EXPECT_GT(channelPower[1], 1e4 * channelPower[2]);
+    EXPECT_NEAR(channelPower[1], channelPower[3], 1e-6 * channelPower[1]);
+    
+    // After a reset the first sample completes an output sample set again.
+    channelizer.reset();
+    EXPECT_EQ(1u, channelizer.outputLength(1));
+    EXPECT_EQ(1u, channelizer.outputLength(numChannels));
+    EXPECT_EQ(2u, channelizer.outputLength(numChannels + 1));
+}
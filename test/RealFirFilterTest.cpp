@@ -20,6 +20,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 */
 
+#include <atomic>
 #include "RealFirFilter.h"
 #include "gtest/gtest.h"
 
@@ -27,6 +28,8 @@ using namespace NimbleDSP;
 
 extern bool FloatsEqual(double float1, double float2);
 
+extern std::atomic<unsigned long> allocationCount;
+
 TEST(RealFirFilter, ConvStream1) {
     double inputData[] = {1, 0, -1, -2, -3, -4, -5, -6, -7};
     double inputData2[] = {-8, -9, -10, -11, -12, -13, -14};
@@ -121,6 +124,77 @@ TEST(RealFirFilter, ConvOneShotTrim) {
     }
 }
 
+TEST(RealFirFilter, ConvFastStream) {
+    unsigned blockLens[] = {37, 300, 1, 129, 500};
+    std::vector<double> taps(101);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = 1.0 / (1 + i) - 0.01 * i;
+    }
+    NimbleDSP::RealFirFilter<double> fastFilter(taps), directFilter(taps);
+    directFilter.fastConvThreshold = 0;
+    
+    double phase = 0;
+    for (unsigned block=0; block<sizeof(blockLens)/sizeof(blockLens[0]); block++) {
+        NimbleDSP::RealVector<double> buf(blockLens[block]);
+        for (unsigned i=0; i<buf.size(); i++, phase+=1) {
+            buf[i] = sin(0.05 * phase) + 0.25 * cos(1.3 * phase);
+        }
+        NimbleDSP::RealVector<double> expected = buf;
+        conv(buf, fastFilter);
+        conv(expected, directFilter);
+        EXPECT_EQ(expected.size(), buf.size());
+        for (unsigned i=0; i<buf.size(); i++) {
+            EXPECT_TRUE(FloatsEqual(expected[i], buf[i]));
+        }
+    }
+}
+
+TEST(RealFirFilter, ConvFastOneShot) {
+    std::vector<double> taps(101);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = 1.0 / (1 + i) - 0.01 * i;
+    }
+    NimbleDSP::RealFirFilter<double> fastFilter(taps), directFilter(taps);
+    fastFilter.filtOperation = directFilter.filtOperation = ONE_SHOT_RETURN_ALL_RESULTS;
+    directFilter.fastConvThreshold = 0;
+    
+    NimbleDSP::RealVector<double> buf(450);
+    for (unsigned i=0; i<buf.size(); i++) {
+        buf[i] = sin(0.05 * i) + 0.25 * cos(1.3 * i);
+    }
+    NimbleDSP::RealVector<double> expected = buf;
+    conv(buf, fastFilter);
+    conv(expected, directFilter);
+    EXPECT_EQ(450 + fastFilter.size() - 1, buf.size());
+    EXPECT_EQ(expected.size(), buf.size());
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], buf[i]));
+    }
+}
+
+TEST(RealFirFilter, ConvFastOneShotTrim) {
+    std::vector<double> taps(100);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = 1.0 / (1 + i) - 0.01 * i;
+    }
+    NimbleDSP::RealFirFilter<double> fastFilter(taps), directFilter(taps);
+    fastFilter.filtOperation = directFilter.filtOperation = ONE_SHOT_TRIM_TAILS;
+    directFilter.fastConvThreshold = 0;
+    
+    NimbleDSP::RealVector<double> buf(450);
+    for (unsigned i=0; i<buf.size(); i++) {
+        buf[i] = sin(0.05 * i) + 0.25 * cos(1.3 * i);
+    }
+    NimbleDSP::RealVector<double> expected = buf;
+    conv(buf, fastFilter);
+    conv(expected, directFilter);
+    EXPECT_EQ(450, buf.size());
+    EXPECT_EQ(expected.size(), buf.size());
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], buf[i]));
+    }
+}
+
 TEST(RealFirFilter, ConvComplexOneShot) {
     std::complex<double> inputData[] = {std::complex<double>(1, 2), std::complex<double>(0, 3), std::complex<double>(-1, 4), std::complex<double>(-2, 5), std::complex<double>(-3, 6), std::complex<double>(-4, 7), std::complex<double>(-5, 8), std::complex<double>(-6, 9), std::complex<double>(-7, 10)};
     double filterTaps[] = {1, 2, 3, 4, 5};
@@ -623,6 +697,88 @@ TEST(RealFirFilter, ResampleStream2) {
     EXPECT_LE(18*interpRate / decimateRate, numResults);
 }
 
+TEST(RealFirFilter, ResamplePolyphase) {
+    int interpRate = 147;
+    int decimateRate = 160;
+    std::vector<double> taps(301);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = 1.0 / (1 + i) - 0.002 * i;
+    }
+    NimbleDSP::RealVector<double> input(100);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = sin(0.05 * i) + 0.25 * cos(1.3 * i);
+    }
+    
+    // Reference: zero-stuff, filter, and then throw away samples.
+    NimbleDSP::RealVector<double> expected = input;
+    NimbleDSP::RealVector<double> tapsVector(taps);
+    upsample(expected, interpRate);
+    conv(expected, tapsVector);
+    downsample(expected, decimateRate);
+    
+    NimbleDSP::RealFirFilter<double> filter(taps, ONE_SHOT_RETURN_ALL_RESULTS);
+    NimbleDSP::RealVector<double> buf = input;
+    resample(buf, interpRate, decimateRate, filter);
+    for (unsigned i=0; i<std::min(buf.size(), expected.size()); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], buf[i]));
+    }
+    
+    // Streaming in uneven blocks should give the same results.
+    NimbleDSP::RealFirFilter<double> streamFilter(taps);
+    unsigned blockLens[] = {17, 1, 60, 22};
+    unsigned inputIndex = 0, outputIndex = 0;
+    for (unsigned block=0; block<sizeof(blockLens)/sizeof(blockLens[0]); block++) {
+        NimbleDSP::RealVector<double> streamBuf(&input.vec[inputIndex], blockLens[block]);
+        inputIndex += blockLens[block];
+        resample(streamBuf, interpRate, decimateRate, streamFilter);
+        for (unsigned i=0; i<streamBuf.size(); i++, outputIndex++) {
+            EXPECT_TRUE(FloatsEqual(expected[outputIndex], streamBuf[i]));
+        }
+    }
+    EXPECT_GE(outputIndex, input.size() * interpRate / decimateRate);
+}
+
+TEST(RealFirFilter, ResampleStreamDownsample) {
+    std::vector<double> taps(7);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = 1.0 / (1 + i);
+    }
+    NimbleDSP::RealVector<double> input(60);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = sin(0.05 * i) + 0.25 * cos(1.3 * i);
+    }
+    NimbleDSP::RealVector<double> tapsVector(taps);
+    
+    // Decimation rates bigger than the interpolation rate skip over data samples.  Streaming in blocks should
+    // match the one-shot results and never write more than resampleOutputLength() results.
+    int rates[][2] = {{2, 3}, {1, 2}, {3, 7}};
+    for (unsigned r=0; r<sizeof(rates)/sizeof(rates[0]); r++) {
+        int interpRate = rates[r][0];
+        int decimateRate = rates[r][1];
+        NimbleDSP::RealVector<double> expected = input;
+        upsample(expected, interpRate);
+        conv(expected, tapsVector);
+        downsample(expected, decimateRate);
+        
+        NimbleDSP::RealFirFilter<double> filter(taps);
+        const unsigned blockLen = 10;
+        unsigned outputIndex = 0;
+        for (unsigned inputIndex=0; inputIndex<input.size(); inputIndex+=blockLen) {
+            unsigned capacity = filter.resampleOutputLength(blockLen, interpRate, decimateRate);
+            std::vector<double> output(capacity + 1, 12345.0);
+            unsigned numOutputs = filter.resample(&input.vec[inputIndex], blockLen, &output[0], capacity, interpRate,
+                                                  decimateRate);
+            EXPECT_LE(numOutputs, capacity);
+            EXPECT_EQ(12345.0, output[capacity]);
+            for (unsigned i=0; i<numOutputs; i++, outputIndex++) {
+                EXPECT_TRUE(FloatsEqual(expected[outputIndex], output[i]));
+            }
+        }
+        // Every result whose newest input sample has arrived has been produced.
+        EXPECT_EQ((input.size() * interpRate + decimateRate - 1) / decimateRate, outputIndex);
+    }
+}
+
 TEST(RealFirFilter, ResampleComplex1) {
     std::complex<double> inputData[] = {std::complex<double>(1, 2), std::complex<double>(0, 3), std::complex<double>(-1, 4), std::complex<double>(-2, 5), std::complex<double>(-3, 6), std::complex<double>(-4, 7), std::complex<double>(-5, 8), std::complex<double>(-6, 9), std::complex<double>(-7, 10), std::complex<double>(-8, 11), std::complex<double>(-9, 12), std::complex<double>(-10, 13), std::complex<double>(-11, 14), std::complex<double>(-12, 15), std::complex<double>(-13, 16), std::complex<double>(-14, 17), std::complex<double>(-15, 18), std::complex<double>(-16, 19), std::complex<double>(-17, 20), std::complex<double>(-18, 21), std::complex<double>(-19, 22), std::complex<double>(-20, 23), std::complex<double>(-21, 24), std::complex<double>(-22, 25), std::complex<double>(-23, 26), std::complex<double>(-24, 27), std::complex<double>(-25, 28)};
     int filterTaps[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14};
@@ -935,3 +1091,290 @@ TEST(RealFirFilter, BlackmanHarris) {
         EXPECT_TRUE(FloatsEqual(expectedData[i], window[i]));
     }
 }
+
+TEST(RealFirFilter, StreamingNoAllocations) {
+    unsigned blockLen = 160;
+    std::vector<float> taps(101);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = 1.0f / (1 + i);
+    }
+    NimbleDSP::RealFirFilter<float> convFilter(taps), fastConvFilter(taps), decimateFilter(taps), interpFilter(taps);
+    NimbleDSP::RealFirFilter<float> resampleFilter(taps), complexConvFilter(taps), complexDecimateFilter(taps);
+    NimbleDSP::RealFirFilter<float> complexInterpFilter(taps), complexResampleFilter(taps);
+    convFilter.fastConvThreshold = 0;
+    
+    // The buffers need enough capacity for the interpolated results.
+    NimbleDSP::RealVector<float> buf(blockLen);
+    NimbleDSP::ComplexVector<float> complexBuf(blockLen);
+    buf.vec.reserve(blockLen * 8);
+    complexBuf.vec.reserve(blockLen * 8);
+    
+    // The first pass grows the filters' working buffers.  After that there should be no allocations.
+    for (int pass=0; pass<3; pass++) {
+        unsigned long allocationsBefore = allocationCount;
+        
+        buf.resize(blockLen, 1.0f);
+        conv(buf, convFilter);
+        buf.resize(blockLen, 1.0f);
+        conv(buf, fastConvFilter);
+        buf.resize(blockLen, 1.0f);
+        decimate(buf, 3, decimateFilter);
+        buf.resize(blockLen, 1.0f);
+        interp(buf, 4, interpFilter);
+        buf.resize(blockLen, 1.0f);
+        resample(buf, 3, 2, resampleFilter);
+        
+        complexBuf.resize(blockLen, 1.0f);
+        conv(complexBuf, complexConvFilter);
+        complexBuf.resize(blockLen, 1.0f);
+        decimate(complexBuf, 3, complexDecimateFilter);
+        complexBuf.resize(blockLen, 1.0f);
+        interp(complexBuf, 4, complexInterpFilter);
+        complexBuf.resize(blockLen, 1.0f);
+        resample(complexBuf, 3, 2, complexResampleFilter);
+        
+        if (pass > 0) {
+            EXPECT_EQ(allocationsBefore, allocationCount.load());
+        }
+    }
+}
+
+TEST(RealFirFilter, OutOfPlaceStream) {
+    std::vector<double> taps(101);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = 1.0 / (1 + i) - 0.002 * i;
+    }
+    NimbleDSP::RealVector<double> input(200);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = sin(0.05 * i) + 0.25 * cos(1.3 * i);
+    }
+    
+    // Stream both ways in uneven blocks.  The out-of-place results should match the in-place results.
+    unsigned blockLens[] = {17, 1, 60, 22, 100};
+    for (int operation=0; operation<4; operation++) {
+        NimbleDSP::RealFirFilter<double> inPlaceFilter(taps), outOfPlaceFilter(taps);
+        std::vector<double> output(2000);
+        unsigned inputIndex = 0;
+        for (unsigned block=0; block<sizeof(blockLens)/sizeof(blockLens[0]); block++) {
+            NimbleDSP::RealVector<double> expected(&input.vec[inputIndex], blockLens[block]);
+            unsigned numOutputs;
+            switch (operation) {
+            case 0:
+                conv(expected, inPlaceFilter);
+                numOutputs = outOfPlaceFilter.conv(&input.vec[inputIndex], blockLens[block], &output[0], output.size());
+                break;
+            case 1:
+                decimate(expected, 3, inPlaceFilter);
+                numOutputs = outOfPlaceFilter.decimate(&input.vec[inputIndex], blockLens[block], &output[0], output.size(), 3);
+                break;
+            case 2:
+                interp(expected, 4, inPlaceFilter);
+                numOutputs = outOfPlaceFilter.interp(&input.vec[inputIndex], blockLens[block], &output[0], output.size(), 4);
+                break;
+            default:
+                resample(expected, 3, 2, inPlaceFilter);
+                numOutputs = outOfPlaceFilter.resample(&input.vec[inputIndex], blockLens[block], &output[0], output.size(), 3, 2);
+                break;
+            }
+            inputIndex += blockLens[block];
+            
+            EXPECT_EQ(expected.size(), numOutputs);
+            for (unsigned i=0; i<expected.size(); i++) {
+                EXPECT_TRUE(FloatsEqual(expected[i], output[i]));
+            }
+        }
+    }
+}
+
+TEST(RealFirFilter, OutOfPlaceOneShot) {
+    std::vector<double> taps(23);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = 1.0 / (1 + i) - 0.002 * i;
+    }
+    std::vector<double> input(50);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = sin(0.05 * i) + 0.25 * cos(1.3 * i);
+    }
+    
+    FilterOperationType operations[] = {ONE_SHOT_RETURN_ALL_RESULTS, ONE_SHOT_TRIM_TAILS};
+    for (unsigned op=0; op<2; op++) {
+        NimbleDSP::RealFirFilter<double> filter(taps, operations[op]);
+        
+        NimbleDSP::RealVector<double> expected(input);
+        resample(expected, 5, 3, filter);
+        EXPECT_EQ(expected.size(), filter.resampleOutputLength((unsigned) input.size(), 5, 3));
+        
+        // The output buffer can be the input buffer.
+        std::vector<double> buf(input);
+        buf.resize(filter.resampleOutputLength((unsigned) input.size(), 5, 3));
+        unsigned numOutputs = filter.resample(&buf[0], (unsigned) input.size(), &buf[0], (unsigned) buf.size(), 5, 3);
+        EXPECT_EQ(expected.size(), numOutputs);
+        for (unsigned i=0; i<expected.size(); i++) {
+            EXPECT_TRUE(FloatsEqual(expected[i], buf[i]));
+        }
+    }
+}
+
+TEST(RealFirFilter, OutOfPlaceComplex) {
+    std::vector<double> taps(23);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = 1.0 / (1 + i) - 0.002 * i;
+    }
+    std::vector< std::complex<double> > input(50);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = std::complex<double>(sin(0.05 * i), 0.25 * cos(1.3 * i));
+    }
+    
+    NimbleDSP::RealFirFilter<double> inPlaceFilter(taps), outOfPlaceFilter(taps);
+    std::vector< std::complex<double> > output(outOfPlaceFilter.decimateOutputLength((unsigned) input.size(), 2));
+    NimbleDSP::ComplexVector<double> expected(input);
+    decimate(expected, 2, inPlaceFilter);
+    unsigned numOutputs = outOfPlaceFilter.decimate(&input[0], (unsigned) input.size(), &output[0], (unsigned) output.size(), 2);
+    EXPECT_EQ(expected.size(), numOutputs);
+    for (unsigned i=0; i<expected.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i].real(), output[i].real()));
+        EXPECT_TRUE(FloatsEqual(expected[i].imag(), output[i].imag()));
+    }
+}
+
+TEST(RealFirFilter, ParallelOneShot) {
+    std::vector<double> shortTaps(23), longTaps(101);
+    for (unsigned i=0; i<longTaps.size(); i++) {
+        longTaps[i] = 1.0 / (1 + i) - 0.002 * i;
+        if (i < shortTaps.size())
+            shortTaps[i] = longTaps[i];
+    }
+    NimbleDSP::RealVector<double> input(30000);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = sin(0.05 * i) + 0.25 * cos(1.3 * i);
+    }
+    
+    // The multithreaded results should be exactly the same as the single threaded ones.
+    FilterOperationType operations[] = {ONE_SHOT_RETURN_ALL_RESULTS, ONE_SHOT_TRIM_TAILS};
+    for (unsigned op=0; op<2; op++) {
+        for (int operation=0; operation<3; operation++) {
+            NimbleDSP::RealFirFilter<double> serialFilter((operation == 0) ? longTaps : shortTaps, operations[op]);
+            NimbleDSP::RealFirFilter<double> parallelFilter((operation == 0) ? longTaps : shortTaps, operations[op]);
+            parallelFilter.numThreads = 4;
+            NimbleDSP::RealVector<double> expected = input;
+            NimbleDSP::RealVector<double> buf = input;
+            switch (operation) {
+            case 0:
+                conv(expected, serialFilter);
+                conv(buf, parallelFilter);
+                break;
+            case 1:
+                decimate(expected, 3, serialFilter);
+                decimate(buf, 3, parallelFilter);
+                break;
+            default:
+                resample(expected, 3, 2, serialFilter);
+                resample(buf, 3, 2, parallelFilter);
+                break;
+            }
+            EXPECT_EQ(expected.vec, buf.vec);
+        }
+    }
+}
+
+TEST(RealFirFilter, Move) {
+    std::vector<double> taps(101);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = 1.0 / (1 + i);
+    }
+    NimbleDSP::RealVector<double> input(300);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = sin(0.05 * i);
+    }
+    
+    // Filter the first half, move the filter, and filter the second half.  The state should move with it.
+    NimbleDSP::RealFirFilter<double> expectedFilter(taps);
+    NimbleDSP::RealVector<double> expected = input;
+    conv(expected, expectedFilter);
+    
+    std::vector<double> tapsCopy = taps;
+    const double *data = VECTOR_TO_ARRAY(tapsCopy);
+    NimbleDSP::RealFirFilter<double> filter(std::move(tapsCopy));
+    EXPECT_EQ(data, VECTOR_TO_ARRAY(filter.vec));
+    
+    NimbleDSP::RealVector<double> firstHalf(VECTOR_TO_ARRAY(input.vec), 150);
+    NimbleDSP::RealVector<double> secondHalf(VECTOR_TO_ARRAY(input.vec) + 150, 150);
+    conv(firstHalf, filter);
+    NimbleDSP::RealFirFilter<double> moved(std::move(filter));
+    EXPECT_EQ(data, VECTOR_TO_ARRAY(moved.vec));
+    conv(secondHalf, moved);
+    
+    NimbleDSP::RealFirFilter<double> assigned;
+    assigned = std::move(moved);
+    EXPECT_EQ(data, VECTOR_TO_ARRAY(assigned.vec));
+    
+    for (unsigned i=0; i<150; i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], firstHalf[i]));
+        EXPECT_TRUE(FloatsEqual(expected[i + 150], secondHalf[i]));
+    }
+}
+
+// Checks a filter with cached FFT and polyphase taps against a fresh filter with the same taps.
+static void ExpectMatchesFreshFilter(NimbleDSP::RealFirFilter<double> & filter, const NimbleDSP::RealVector<double> & input) {
+    NimbleDSP::RealFirFilter<double> fresh(filter.vec, ONE_SHOT_RETURN_ALL_RESULTS);
+    
+    NimbleDSP::RealVector<double> buf = input, expected = input;
+    conv(buf, filter);
+    conv(expected, fresh);
+    ASSERT_EQ(expected.size(), buf.size());
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], buf[i]));
+    }
+    
+    buf = input;
+    expected = input;
+    resample(buf, 3, 2, filter);
+    resample(expected, 3, 2, fresh);
+    ASSERT_EQ(expected.size(), buf.size());
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], buf[i]));
+    }
+}
+
+TEST(RealFirFilter, TapChanges) {
+    std::vector<double> taps(101);
+    for (unsigned i=0; i<taps.size(); i++) {
+        taps[i] = 1.0 / (1 + i) - 0.01 * i;
+    }
+    NimbleDSP::RealVector<double> input(450);
+    for (unsigned i=0; i<input.size(); i++) {
+        input[i] = sin(0.05 * i) + 0.25 * cos(1.3 * i);
+    }
+    
+    // The taps are long enough for FFT filtering, so both the FFT and the polyphase versions of them get cached.
+    NimbleDSP::RealFirFilter<double> filter(taps, ONE_SHOT_RETURN_ALL_RESULTS);
+    ExpectMatchesFreshFilter(filter, input);
+    
+    filter[10] = 3.0;
+    ExpectMatchesFreshFilter(filter, input);
+    
+    filter *= 0.5;
+    ExpectMatchesFreshFilter(filter, input);
+    
+    filter.reverse();
+    ExpectMatchesFreshFilter(filter, input);
+    
+    filter.hamming(101);
+    ExpectMatchesFreshFilter(filter, input);
+    
+    NimbleDSP::RealVector<double> newTaps(taps);
+    newTaps[0] = -2.0;
+    filter = newTaps;
+    filter.filtOperation = ONE_SHOT_RETURN_ALL_RESULTS;
+    ExpectMatchesFreshFilter(filter, input);
+    
+    NimbleDSP::RealFirFilter<double> other(taps, ONE_SHOT_RETURN_ALL_RESULTS);
+    ExpectMatchesFreshFilter(other, input);
+    filter = other;
+    ExpectMatchesFreshFilter(filter, input);
+    
+    // Writing to vec directly needs modified().
+    filter.vec[5] = 4.0;
+    filter.modified();
+    ExpectMatchesFreshFilter(filter, input);
+}
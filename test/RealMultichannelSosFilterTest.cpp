@@ -0,0 +1,158 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "RealMultichannelSosFilter.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+
+// Two sections with poles near the unit circle.
+static std::vector< BiquadSection<double> > multichannelTestSections() {
+    BiquadSection<double> first = {0.05, 0.1, 0.05, -1.8 * cos(0.1), 0.81};
+    BiquadSection<double> second = {1, -2 * cos(0.9), 1, -1.9 * cos(0.2), 0.9025};
+    std::vector< BiquadSection<double> > sections;
+    sections.push_back(first);
+    sections.push_back(second);
+    return sections;
+}
+
+// Sample "i" of channel "c", in interleaved order.
+static std::vector<double> multichannelTestSignal(unsigned numChannels, unsigned numSamples) {
+    std::vector<double> signal(numChannels * numSamples);
+    for (unsigned i=0; i<numSamples; i++) {
+        for (unsigned channel=0; channel<numChannels; channel++) {
+            signal[i*numChannels + channel] = sin(0.07 * i * (channel + 1)) + 0.1 * channel;
+        }
+    }
+    return signal;
+}
+
+TEST(RealMultichannelSosFilter, Interleaved) {
+    unsigned numChannels = 37;
+    unsigned numSamples = 600;
+    std::vector< BiquadSection<double> > sections = multichannelTestSections();
+    std::vector<double> input = multichannelTestSignal(numChannels, numSamples);
+    std::vector<double> output(input.size());
+    
+    RealMultichannelSosFilter<double> multichannel(numChannels, sections);
+    EXPECT_EQ(numChannels, multichannel.getNumChannels());
+    EXPECT_EQ(numSamples, multichannel.filterInterleaved(VECTOR_TO_ARRAY(input), numSamples, VECTOR_TO_ARRAY(output)));
+    
+    for (unsigned channel=0; channel<numChannels; channel++) {
+        RealSosFilter<double> single(sections);
+        std::vector<double> expected(numSamples);
+        for (unsigned i=0; i<numSamples; i++) {
+            expected[i] = input[i*numChannels + channel];
+        }
+        single.filter(VECTOR_TO_ARRAY(expected), numSamples, VECTOR_TO_ARRAY(expected));
+        for (unsigned i=0; i<numSamples; i++) {
+            EXPECT_TRUE(FloatsEqual(expected[i], output[i*numChannels + channel]));
+        }
+    }
+}
+
+TEST(RealMultichannelSosFilter, Planar) {
+    unsigned numChannels = 21;
+    unsigned numSamples = 300;
+    std::vector< BiquadSection<double> > sections = multichannelTestSections();
+    std::vector<double> interleaved = multichannelTestSignal(numChannels, numSamples);
+    std::vector<double> planar(interleaved.size());
+    for (unsigned i=0; i<numSamples; i++) {
+        for (unsigned channel=0; channel<numChannels; channel++) {
+            planar[channel*numSamples + i] = interleaved[i*numChannels + channel];
+        }
+    }
+    
+    RealMultichannelSosFilter<double> interleavedFilter(numChannels, sections);
+    RealMultichannelSosFilter<double> planarFilter(numChannels, sections);
+    interleavedFilter.filterInterleaved(VECTOR_TO_ARRAY(interleaved), numSamples, VECTOR_TO_ARRAY(interleaved));
+    EXPECT_EQ(numSamples, planarFilter.filterPlanar(VECTOR_TO_ARRAY(planar), numSamples, VECTOR_TO_ARRAY(planar)));
+    for (unsigned i=0; i<numSamples; i++) {
+        for (unsigned channel=0; channel<numChannels; channel++) {
+            EXPECT_EQ(interleaved[i*numChannels + channel], planar[channel*numSamples + i]);
+        }
+    }
+}
+
+TEST(RealMultichannelSosFilter, Streaming) {
+    unsigned numChannels = 64;
+    unsigned numSamples = 500;
+    std::vector<double> num(3), den(3);
+    num[0] = 0.02; num[1] = 0.04; num[2] = 0.02;
+    den[0] = 1; den[1] = -1.56; den[2] = 0.64;
+    std::vector<double> signal = multichannelTestSignal(numChannels, numSamples);
+    
+    RealMultichannelSosFilter<float> filt(numChannels, num, den);
+    std::vector<float> oneShot(signal.begin(), signal.end());
+    filt.filterInterleaved(VECTOR_TO_ARRAY(oneShot), numSamples, VECTOR_TO_ARRAY(oneShot));
+    
+    filt.reset();
+    Vector<float> streamed(0);
+    unsigned blockLens[] = {1, 77, 300, 122};
+    unsigned start = 0;
+    for (unsigned block=0; block<sizeof(blockLens)/sizeof(blockLens[0]); block++) {
+        Vector<float> data(blockLens[block] * numChannels);
+        for (unsigned i=0; i<data.size(); i++) {
+            data[i] = (float) signal[start*numChannels + i];
+        }
+        filter(data, filt);
+        streamed.vec.insert(streamed.vec.end(), data.vec.begin(), data.vec.end());
+        start += blockLens[block];
+    }
+    
+    ASSERT_EQ(oneShot.size(), streamed.size());
+    for (unsigned i=0; i<oneShot.size(); i++) {
+        EXPECT_EQ(oneShot[i], streamed[i]);
+    }
+    
+    // Every channel should match a single channel filter, up to float rounding.
+    RealSosFilter<double> single(num, den);
+    std::vector<double> expected(numSamples);
+    unsigned channel = 13;
+    for (unsigned i=0; i<numSamples; i++) {
+        expected[i] = signal[i*numChannels + channel];
+    }
+    single.filter(VECTOR_TO_ARRAY(expected), numSamples, VECTOR_TO_ARRAY(expected));
+    for (unsigned i=0; i<numSamples; i++) {
+        EXPECT_NEAR(expected[i], oneShot[i*numChannels + channel], 1e-4);
+    }
+}
+
+TEST(RealMultichannelSosFilter, FromSingleChannel) {
+    RealSosFilter<double> single(multichannelTestSections());
+    RealMultichannelSosFilter<float> filt(5, single);
+    
+    EXPECT_EQ((unsigned) 2, (unsigned) filt.sections.size());
+    EXPECT_EQ((float) single.sections[1].a1, filt.sections[1].a1);
+    EXPECT_EQ((float) single.sections[0].b0, filt.sections[0].b0);
+    
+    // No sections means no filtering.
+    RealMultichannelSosFilter<float> passThrough(3);
+    float data[] = {1, 2, 3, 4, 5, 6};
+    passThrough.filterPlanar(data, 2, data);
+    for (unsigned i=0; i<6; i++) {
+        EXPECT_EQ(i + 1, data[i]);
+    }
+}
@@ -0,0 +1,208 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "RealSosFilter.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+
+// Multiplies two polynomials.
+static std::vector<double> polyMult(const std::vector<double> & a, const std::vector<double> & b) {
+    std::vector<double> result(a.size() + b.size() - 1, 0);
+    for (unsigned i=0; i<a.size(); i++) {
+        for (unsigned j=0; j<b.size(); j++) {
+            result[i + j] += a[i] * b[j];
+        }
+    }
+    return result;
+}
+
+// Builds sections with poles at radius "r" and zeros on the unit circle, and the equivalent transfer function.
+static void makeTestFilter(unsigned numSections, double r, std::vector< BiquadSection<double> > & sections,
+                           std::vector<double> & num, std::vector<double> & den) {
+    sections.resize(numSections);
+    num.assign(1, 0.05);
+    den.assign(1, 1);
+    for (unsigned i=0; i<numSections; i++) {
+        double poleAngle = 0.1 + 0.05 * i;
+        double zeroAngle = 0.6 + 0.3 * i;
+        BiquadSection<double> section = {1, -2 * cos(zeroAngle), 1, -2 * r * cos(poleAngle), r * r};
+        if (i == 0) {
+            section.b0 *= 0.05;
+            section.b1 *= 0.05;
+            section.b2 *= 0.05;
+        }
+        sections[i] = section;
+        
+        double sectionNum[] = {1, -2 * cos(zeroAngle), 1};
+        double sectionDen[] = {1, section.a1, section.a2};
+        num = polyMult(num, std::vector<double>(sectionNum, sectionNum + 3));
+        den = polyMult(den, std::vector<double>(sectionDen, sectionDen + 3));
+    }
+}
+
+static std::vector<double> testSignal(unsigned len) {
+    std::vector<double> signal(len);
+    signal[0] = 1;
+    for (unsigned i=1; i<len; i++) {
+        signal[i] = sin(0.07 * i) + 0.5 * cos(1.9 * i);
+    }
+    return signal;
+}
+
+TEST(RealSosFilter, ConstructorSections) {
+    std::vector< BiquadSection<double> > sections;
+    std::vector<double> num, den;
+    makeTestFilter(3, 0.9, sections, num, den);
+    
+    RealSosFilter<double> filt(sections);
+    EXPECT_EQ(3, filt.sections.size());
+    EXPECT_EQ(sections[1].a1, filt.sections[1].a1);
+}
+
+TEST(RealSosFilter, MatchesDirectForm) {
+    std::vector< BiquadSection<double> > sections;
+    std::vector<double> num, den;
+    makeTestFilter(2, 0.9, sections, num, den);
+    std::vector<double> signal = testSignal(200);
+    
+    RealIirFilter<double> directForm(num, den);
+    RealSosFilter<double> sos(sections);
+    Vector<double> expected(signal);
+    Vector<double> buf(signal);
+    filter(expected, directForm);
+    filter(buf, sos);
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], buf[i]));
+    }
+}
+
+TEST(RealSosFilter, FromTransferFunction) {
+    std::vector< BiquadSection<double> > sections;
+    std::vector<double> num, den;
+    makeTestFilter(3, 0.95, sections, num, den);
+    std::vector<double> signal = testSignal(300);
+    
+    RealSosFilter<double> expectedFilt(sections);
+    RealSosFilter<double> filt(num, den);
+    EXPECT_EQ(3, filt.sections.size());
+    Vector<double> expected(signal);
+    Vector<double> buf(signal);
+    filter(expected, expectedFilt);
+    filter(buf, filt);
+    
+    // Clustered poles can only be recovered from the transfer function to about 1e-11, and the filter gain
+    // near them magnifies the error, so only expect close agreement.
+    double maxExpected = 0;
+    for (unsigned i=0; i<expected.size(); i++) {
+        maxExpected = std::max(maxExpected, fabs(expected[i]));
+    }
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_NEAR(expected[i], buf[i], 1e-7 * maxExpected);
+    }
+    
+    // Same thing, from a direct form filter.
+    RealIirFilter<double> directForm(num, den);
+    RealSosFilter<double> converted(directForm);
+    buf = Vector<double>(signal);
+    filter(buf, converted);
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_NEAR(expected[i], buf[i], 1e-7 * maxExpected);
+    }
+}
+
+TEST(RealSosFilter, OddOrder) {
+    // Third order, so one of the sections is first order.  Real poles at 0.5, -0.3 and 0.8.
+    double num[] = {0.2, 0.1, -0.05, 0.01};
+    double p1[] = {1, -0.5}, p2[] = {1, 0.3}, p3[] = {1, -0.8};
+    std::vector<double> den = polyMult(polyMult(std::vector<double>(p1, p1 + 2), std::vector<double>(p2, p2 + 2)), std::vector<double>(p3, p3 + 2));
+    std::vector<double> signal = testSignal(100);
+    
+    RealIirFilter<double> directForm(num, 4, &den[0], (unsigned) den.size());
+    RealSosFilter<double> sos(num, 4, &den[0], (unsigned) den.size());
+    EXPECT_EQ(2, sos.sections.size());
+    Vector<double> expected(signal);
+    Vector<double> buf(signal);
+    filter(expected, directForm);
+    filter(buf, sos);
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], buf[i]));
+    }
+}
+
+TEST(RealSosFilter, Streaming) {
+    std::vector< BiquadSection<double> > sections;
+    std::vector<double> num, den;
+    makeTestFilter(3, 0.95, sections, num, den);
+    std::vector<double> signal = testSignal(300);
+    
+    RealSosFilter<double> oneShot(sections), streaming(sections);
+    Vector<double> expected(signal);
+    filter(expected, oneShot);
+    
+    unsigned blockLens[] = {1, 17, 100, 82, 100};
+    std::vector<double> output(signal.size());
+    unsigned index = 0;
+    for (unsigned block=0; block<sizeof(blockLens)/sizeof(blockLens[0]); block++) {
+        EXPECT_EQ(blockLens[block], streaming.filter(&signal[index], blockLens[block], &output[index]));
+        index += blockLens[block];
+    }
+    for (unsigned i=0; i<output.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], output[i]));
+    }
+    
+    // After a reset the filter should start over.
+    streaming.reset();
+    Vector<double> buf(signal);
+    filter(buf, streaming);
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], buf[i]));
+    }
+}
+
+TEST(RealSosFilter, HighOrderFloat) {
+    // 10th order with poles close to the unit circle.  In single precision the direct form version of this
+    // filter is unstable, but the sections should stay close to the double precision results.
+    std::vector< BiquadSection<double> > sections;
+    std::vector<double> num, den;
+    makeTestFilter(5, 0.99, sections, num, den);
+    std::vector<double> signal = testSignal(2000);
+    
+    RealSosFilter<double> reference(num, den);
+    RealSosFilter<float> filt(num, den);
+    EXPECT_EQ(5, filt.sections.size());
+    Vector<double> expected(signal);
+    filter(expected, reference);
+    std::vector<float> buf(signal.begin(), signal.end());
+    filt.filter(&buf[0], (unsigned) buf.size(), &buf[0]);
+    
+    double maxExpected = 0;
+    for (unsigned i=0; i<expected.size(); i++) {
+        maxExpected = std::max(maxExpected, fabs(expected[i]));
+    }
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_NEAR(expected[i], buf[i], 1e-3 * maxExpected);
+    }
+}
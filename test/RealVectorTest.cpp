@@ -55,6 +55,36 @@ TEST(RealVectorInit, Vector) {
     }
 }
 
+TEST(RealVectorInit, Move) {
+    double array[] = {1, 3, 5, 7.12, 2, 4, 6, 8};
+    std::vector<double> inputData (array, array + sizeof(array) / sizeof(array[0]) );
+    const double *data = VECTOR_TO_ARRAY(inputData);
+    
+    // None of these should copy the data.
+	NimbleDSP::RealVector<double> buf(std::move(inputData));
+    EXPECT_EQ(data, VECTOR_TO_ARRAY(buf.vec));
+    EXPECT_EQ((unsigned) 0, inputData.size());
+    
+	NimbleDSP::RealVector<double> buf2(std::move(buf));
+    EXPECT_EQ(data, VECTOR_TO_ARRAY(buf2.vec));
+    EXPECT_EQ((unsigned) 0, buf.size());
+    
+	NimbleDSP::RealVector<double> buf3(3);
+    buf3 = std::move(buf2);
+    EXPECT_EQ(data, VECTOR_TO_ARRAY(buf3.vec));
+    EXPECT_EQ((unsigned) 0, buf2.size());
+    
+    EXPECT_EQ(sizeof(array)/sizeof(array[0]), buf3.size());
+    for (unsigned i=0; i<buf3.size(); i++) {
+        EXPECT_EQ(array[i], buf3[i]);
+    }
+    
+    // Copies still copy.
+    buf2 = buf3;
+    EXPECT_NE(VECTOR_TO_ARRAY(buf3.vec), VECTOR_TO_ARRAY(buf2.vec));
+    EXPECT_EQ(buf3.vec, buf2.vec);
+}
+
 // Operator tests
 TEST(RealVectorOperators, PlusEqualsBuf) {
     double inputData[] = {1, 3, 5, 7.12, 2, 4, 6, 8};
@@ -286,6 +316,65 @@ TEST(RealVectorOperators, DivideScalar) {
     }
 }
 
+TEST(RealVectorOperators, Expression) {
+    double inputData[] = {1, 3, 5, 7.12, 2, 4, 6, 8};
+    double inputData2[] = {-2, 0.5, 3, 1, -4, 2.5, 7, 1.5};
+    unsigned numElements = sizeof(inputData)/sizeof(inputData[0]);
+	NimbleDSP::RealVector<double> a(inputData, numElements);
+	NimbleDSP::RealVector<double> b(inputData2, numElements);
+    
+    NimbleDSP::RealVector<double> c = a*b + a/2.0 - b;
+    EXPECT_EQ(numElements, c.size());
+    for (unsigned i=0; i<numElements; i++) {
+        EXPECT_EQ(inputData[i]*inputData2[i] + inputData[i]/2.0 - inputData2[i], c[i]);
+    }
+    
+    // Assigning into a vector that's big enough shouldn't reallocate, even when it's one of the operands.
+    const double *data = VECTOR_TO_ARRAY(c.vec);
+    c = c * a - b;
+    EXPECT_EQ(data, VECTOR_TO_ARRAY(c.vec));
+    for (unsigned i=0; i<numElements; i++) {
+        EXPECT_EQ((inputData[i]*inputData2[i] + inputData[i]/2.0 - inputData2[i]) * inputData[i] - inputData2[i], c[i]);
+    }
+    
+    c = a;
+    c += a * b;
+    c -= (a + b) * 3.0;
+    for (unsigned i=0; i<numElements; i++) {
+        EXPECT_EQ(inputData[i] + inputData[i]*inputData2[i] - (inputData[i] + inputData2[i]) * 3.0, c[i]);
+    }
+    
+    // The scalar's type isn't deduced, so it doesn't have to match the vector's type exactly.
+    NimbleDSP::RealVector<float> f(inputData, numElements);
+    NimbleDSP::RealVector<float> g = f * 2.0 + 1;
+    for (unsigned i=0; i<numElements; i++) {
+        EXPECT_EQ((float) inputData[i] * 2.0f + 1.0f, g[i]);
+    }
+}
+
+TEST(RealVectorOperators, ExpressionEval) {
+    double inputData[] = {1, 3, 5, 7.12, 2, 4, 6, 8};
+    double inputData2[] = {-2, 0.5, 3, 1, -4, 2.5, 7, 1.5};
+    unsigned numElements = sizeof(inputData)/sizeof(inputData[0]);
+	NimbleDSP::RealVector<double> a(inputData, numElements);
+	NimbleDSP::RealVector<double> b(inputData2, numElements);
+    
+    double expectedSum = 0;
+    for (unsigned i=0; i<numElements; i++) {
+        expectedSum += inputData[i]*inputData2[i];
+    }
+    EXPECT_DOUBLE_EQ(expectedSum, (a*b).eval().sum());
+    
+    NimbleDSP::RealVector<double> c = (a - b*2.0).eval().abs();
+    EXPECT_EQ(numElements, c.size());
+    for (unsigned i=0; i<numElements; i++) {
+        EXPECT_EQ(std::abs(inputData[i] - inputData2[i]*2.0), c[i]);
+    }
+    
+    // eval() gives a vector, so the result can be passed to functions that take one.
+    EXPECT_DOUBLE_EQ(expectedSum, NimbleDSP::sum((a*b).eval()));
+}
+
 TEST(RealVectorOperators, UnaryMinus) {
     double inputData[] = {1, 3, 5, 7.12, 2, 4, 6, 8};
     unsigned numElements = sizeof(inputData)/sizeof(inputData[0]);
@@ -892,3 +981,48 @@ TEST(RealVectorMethods, Modulate) {
     }
 }
 
+
+TEST(RealVectorMethods, FFTEven) {
+    double inputData[] = {1, 0, -1, -2, -3, -4, -5, -6, -7, 2.5, 3.25, -0.5};
+    unsigned numElements = sizeof(inputData)/sizeof(inputData[0]);
+	NimbleDSP::RealVector<double> buf(inputData, numElements);
+    NimbleDSP::ComplexVector<double> expected(inputData, numElements);
+    NimbleDSP::ComplexVector<double> results;
+    
+    fft(expected);
+    fft(buf, results);
+    EXPECT_EQ(numElements/2 + 1, results.size());
+    EXPECT_EQ(NimbleDSP::FREQUENCY_DOMAIN, results.domain);
+    for (unsigned i=0; i<results.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i].real(), results[i].real()));
+        EXPECT_TRUE(FloatsEqual(expected[i].imag(), results[i].imag()));
+    }
+    
+    ifft(results, buf);
+    EXPECT_EQ(numElements, buf.size());
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(inputData[i] * numElements, buf[i]));
+    }
+}
+
+TEST(RealVectorMethods, FFTOdd) {
+    double inputData[] = {1, 0, -1, -2, -3, -4, -5, -6, -7};
+    unsigned numElements = sizeof(inputData)/sizeof(inputData[0]);
+	NimbleDSP::RealVector<double> buf(inputData, numElements);
+    NimbleDSP::ComplexVector<double> expected(inputData, numElements);
+    NimbleDSP::ComplexVector<double> results;
+    
+    fft(expected);
+    fft(buf, results);
+    EXPECT_EQ(numElements/2 + 1, results.size());
+    for (unsigned i=0; i<results.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i].real(), results[i].real()));
+        EXPECT_TRUE(FloatsEqual(expected[i].imag(), results[i].imag()));
+    }
+    
+    ifft(results, buf, numElements);
+    EXPECT_EQ(numElements, buf.size());
+    for (unsigned i=0; i<buf.size(); i++) {
+        EXPECT_TRUE(FloatsEqual(inputData[i] * numElements, buf[i]));
+    }
+}
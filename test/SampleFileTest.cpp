@@ -0,0 +1,217 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "SampleFile.h"
+#include "RealVector.h"
+#include "ComplexVector.h"
+#include "RealFirFilter.h"
+#include <stdio.h>
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+
+
+TEST(SampleFile, Formats) {
+    EXPECT_EQ(1u, sampleFormatSize(SAMPLE_INT8));
+    EXPECT_EQ(2u, sampleFormatSize(SAMPLE_INT16));
+    EXPECT_EQ(4u, sampleFormatSize(SAMPLE_FLOAT32));
+    EXPECT_EQ(2u, sampleFormatSize(SAMPLE_COMPLEX_INT8));
+    EXPECT_EQ(4u, sampleFormatSize(SAMPLE_COMPLEX_INT16));
+    EXPECT_EQ(8u, sampleFormatSize(SAMPLE_COMPLEX_FLOAT32));
+    
+    for (int i=SAMPLE_INT8; i<=SAMPLE_COMPLEX_FLOAT32; i++) {
+        SampleFormat format;
+        EXPECT_TRUE(sampleFormatFromName(sampleFormatName((SampleFormat) i), format));
+        EXPECT_EQ(i, format);
+    }
+    SampleFormat format;
+    EXPECT_FALSE(sampleFormatFromName("cu16_le", format));
+    
+    EXPECT_EQ("capture.sigmf-meta", sampleFileMetadataPath("capture.sigmf-data"));
+    EXPECT_EQ("capture.bin.sigmf-meta", sampleFileMetadataPath("capture.bin"));
+}
+
+TEST(SampleFile, Float32ZeroCopy) {
+    const char *path = "SampleFileTest_rf32.bin";
+    const unsigned len = 10000;
+    RealVector<float> signal(len);
+    for (unsigned i=0; i<len; i++) {
+        signal[i] = (float) sin(0.01 * i);
+    }
+    
+    // Small buffers, so the background thread writes many times.
+    SampleFileWriter writer(path, SAMPLE_FLOAT32, 300);
+    ASSERT_TRUE(writer.isOpen());
+    EXPECT_EQ(1234u, writer.write(VECTOR_TO_ARRAY(signal.vec), 1234));
+    EXPECT_EQ(len - 1234, writer.write(VECTOR_TO_ARRAY(signal.vec) + 1234, len - 1234));
+    EXPECT_TRUE(writer.close());
+    EXPECT_FALSE(writer.isOpen());
+    
+    SampleFileReader reader(path, SAMPLE_FLOAT32);
+    ASSERT_TRUE(reader.isOpen());
+    EXPECT_EQ(len, reader.size());
+    
+    // Blocks of the file go straight into a filter.
+    float taps[] = {0.25, 0.5, 0.25};
+    RealFirFilter<float> fileFilter(taps, 3), vectorFilter(taps, 3);
+    RealVector<float> expected(signal);
+    vectorFilter.conv(expected);
+    std::vector<float> output(len);
+    unsigned numRead = 0;
+    while (reader.remaining() > 0) {
+        VectorView<const float> block = reader.nextBlock<float>(999);
+        EXPECT_EQ(numRead + block.len, reader.tell());
+        fileFilter.conv(block.data, block.len, VECTOR_TO_ARRAY(output) + numRead, block.len);
+        numRead += block.len;
+    }
+    EXPECT_EQ(len, numRead);
+    for (unsigned i=0; i<len; i++) {
+        EXPECT_EQ(expected[i], output[i]);
+    }
+    EXPECT_EQ(0u, reader.nextBlock<float>(10).len);
+    
+    reader.seek(len - 5);
+    EXPECT_EQ(5u, reader.remaining());
+    RealVector<double> tail;
+    EXPECT_EQ(5u, reader.read(tail, 100));
+    EXPECT_EQ(5u, tail.size());
+    for (unsigned i=0; i<5; i++) {
+        EXPECT_EQ(signal[len - 5 + i], tail[i]);
+    }
+    remove(path);
+}
+
+TEST(SampleFile, ComplexInt16) {
+    const char *path = "SampleFileTest_ci16.sigmf-data";
+    std::complex<double> input[] = {std::complex<double>(1.4, -1.6), std::complex<double>(40000, -40000),
+                                    std::complex<double>(-2.5, 2.5), std::complex<double>(0, 100)};
+    std::complex<int16_t> expected[] = {std::complex<int16_t>(1, -2), std::complex<int16_t>(32767, -32768),
+                                        std::complex<int16_t>(-2, 3), std::complex<int16_t>(0, 100)};
+    
+    SampleFileWriter writer(path, SAMPLE_COMPLEX_INT16);
+    writer.setMetadata(2.4e6, 915e6);
+    EXPECT_EQ(4u, writer.write(input, 4));
+    EXPECT_TRUE(writer.close());
+    
+    // The format comes from the metadata file.
+    SampleFileReader reader(path);
+    ASSERT_TRUE(reader.isOpen());
+    EXPECT_EQ(SAMPLE_COMPLEX_INT16, reader.getMetadata().format);
+    EXPECT_EQ(2.4e6, reader.getMetadata().sampleRate);
+    EXPECT_EQ(915e6, reader.getMetadata().centerFrequency);
+    EXPECT_EQ(4u, reader.size());
+    
+    VectorView< const std::complex<int16_t> > block = reader.nextBlock< std::complex<int16_t> >(4);
+    ASSERT_EQ(4u, block.len);
+    for (unsigned i=0; i<4; i++) {
+        EXPECT_EQ(expected[i], block[i]);
+    }
+    
+    reader.seek(0);
+    ComplexVector<float> converted;
+    EXPECT_EQ(4u, reader.read(converted, 4));
+    for (unsigned i=0; i<4; i++) {
+        EXPECT_EQ(std::complex<float>(expected[i].real(), expected[i].imag()), converted[i]);
+    }
+    remove(path);
+    remove(sampleFileMetadataPath(path).c_str());
+}
+
+TEST(SampleFile, Int8RealToComplex) {
+    const char *path = "SampleFileTest_ri8.bin";
+    RealVector<float> input(5);
+    input[0] = -200;
+    input[1] = -1.2f;
+    input[2] = 7.5f;
+    input[3] = 127.4f;
+    input[4] = std::numeric_limits<float>::quiet_NaN();
+    int8_t expected[] = {-128, -1, 8, 127, 0};
+    
+    SampleFileWriter writer(path, SAMPLE_INT8);
+    writer.write(input);
+    writer.flush();
+    
+    // Flushed samples are visible before the writer is closed.
+    SampleFileReader reader(path, SAMPLE_INT8);
+    ASSERT_TRUE(reader.isOpen());
+    EXPECT_EQ(5u, reader.size());
+    ComplexVector<double> output;
+    reader.read(output, 10);
+    ASSERT_EQ(5u, output.size());
+    for (unsigned i=0; i<5; i++) {
+        EXPECT_EQ(std::complex<double>(expected[i], 0), output[i]);
+    }
+    writer.close();
+    remove(path);
+}
+
+TEST(SampleFile, MissingFiles) {
+    SampleFileReader reader1("SampleFileTest_missing.bin", SAMPLE_FLOAT32);
+    EXPECT_FALSE(reader1.isOpen());
+    EXPECT_EQ(0u, reader1.size());
+    SampleFileReader reader2("SampleFileTest_missing.bin");
+    EXPECT_FALSE(reader2.isOpen());
+    EXPECT_EQ(0u, reader2.size());
+    EXPECT_EQ(0u, reader2.remaining());
+    
+    // A directory can't be read, and an unopened reader is empty.
+    SampleFileReader reader3(".", SAMPLE_FLOAT32);
+    EXPECT_FALSE(reader3.isOpen());
+    EXPECT_EQ(0u, reader3.size());
+    EXPECT_EQ(0u, reader3.nextBlock<float>(10).len);
+    float samples[10];
+    EXPECT_EQ(0u, reader3.read(samples, 10));
+    
+    SampleFileWriter writer("SampleFileTest_missing_dir/file.bin", SAMPLE_FLOAT32);
+    EXPECT_FALSE(writer.isOpen());
+    float sample = 0;
+    EXPECT_EQ(0u, writer.write(&sample, 1));
+}
+
+TEST(SampleFile, ComplexToRealRejected) {
+    const char *path = "SampleFileTest_rf32.bin";
+    std::complex<float> complexSamples[] = {std::complex<float>(1, 2), std::complex<float>(3, 4)};
+    float realSamples[] = {5, 6};
+    
+    // Complex samples can't be written to a real file.
+    SampleFileWriter writer(path, SAMPLE_FLOAT32);
+    EXPECT_EQ(0u, writer.write(complexSamples, 2));
+    EXPECT_EQ(2u, writer.write(realSamples, 2));
+    EXPECT_TRUE(writer.close());
+    
+    SampleFileReader realReader(path, SAMPLE_FLOAT32);
+    ASSERT_TRUE(realReader.isOpen());
+    EXPECT_EQ(2u, realReader.size());
+    
+    // Or read from a complex file into real samples.
+    SampleFileReader complexReader(path, SAMPLE_COMPLEX_FLOAT32);
+    ASSERT_TRUE(complexReader.isOpen());
+    float output[4] = {0, 0, 0, 0};
+    EXPECT_EQ(0u, complexReader.read(output, 1));
+    EXPECT_EQ(0u, complexReader.tell());
+    EXPECT_EQ(0.0f, output[0]);
+    EXPECT_EQ(0u, complexReader.nextBlock<float>(1).len);
+    remove(path);
+}
@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "ScratchArena.h"
+#include "RealVector.h"
+#include "RealFirFilter.h"
+#include <vector>
+#include <thread>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+
+
+TEST(ScratchArena, Reuse) {
+    typedef std::vector<double> Buffer;
+    ScratchArena<Buffer>::threadArena().clear();
+    resetScratchArenaStats();
+    
+    double *first;
+    {
+        ScratchBuffer<Buffer> buf(NULL, 100);
+        buf->resize(100);
+        first = &(*buf)[0];
+        
+        // Nested leases get different buffers.
+        ScratchBuffer<Buffer> nested;
+        nested->resize(10);
+        EXPECT_NE(first, &(*nested)[0]);
+    }
+    EXPECT_EQ(800u, scratchArenaStats().highWaterMark);
+    EXPECT_EQ(2u, ScratchArena<Buffer>::threadArena().numFreeBuffers());
+    EXPECT_EQ(0u, scratchArenaStats().bytesInUse);
+    EXPECT_EQ(2u, scratchArenaStats().growths);
+    
+    // The smallest buffer that's big enough is picked.
+    {
+        ScratchBuffer<Buffer> buf(NULL, 50);
+        EXPECT_EQ(first, &(*buf)[0]);
+        buf->resize(100);
+        EXPECT_EQ(800u, scratchArenaStats().bytesInUse);
+    }
+    EXPECT_EQ(3u, scratchArenaStats().leases);
+    EXPECT_EQ(2u, scratchArenaStats().growths);
+    
+    // A caller supplied buffer is used directly.
+    Buffer userBuf;
+    {
+        ScratchBuffer<Buffer> buf(&userBuf);
+        EXPECT_EQ(&userBuf, buf.get());
+    }
+    EXPECT_EQ(3u, scratchArenaStats().leases);
+    
+    // The arena only keeps the biggest few buffers.
+    {
+        std::vector< ScratchBuffer<Buffer> * > bufs;
+        for (unsigned i=0; i<MAX_FREE_SCRATCH_BUFFERS + 4; i++) {
+            bufs.push_back(new ScratchBuffer<Buffer>);
+            bufs.back()->get()->resize(i + 1);
+        }
+        for (unsigned i=0; i<bufs.size(); i++) {
+            delete bufs[i];
+        }
+    }
+    EXPECT_EQ(MAX_FREE_SCRATCH_BUFFERS, ScratchArena<Buffer>::threadArena().numFreeBuffers());
+}
+
+TEST(ScratchArena, SteadyState) {
+    double taps[] = {1, 2, 3, 2, 1};
+    RealVector<double> filter(taps, 5);
+    RealFirFilter<double> firFilter(taps, 5);
+    RealFirFilter<double> decimator(taps, 5);
+    
+    // Once the buffers have grown, further calls don't allocate any scratch memory.
+    for (unsigned i=0; i<3; i++) {
+        RealVector<double> buf(200);
+        buf[0] = 1;
+        conv(buf, filter);
+        EXPECT_TRUE(FloatsEqual(3, buf[2]));
+        firFilter.conv(buf);
+        decimator.decimate(buf, 2);
+        buf.median();
+        if (i == 0)
+            resetScratchArenaStats();
+    }
+    EXPECT_EQ(8u, scratchArenaStats().leases);
+    EXPECT_EQ(0u, scratchArenaStats().growths);
+    EXPECT_EQ(0u, scratchArenaStats().bytesInUse);
+}
+
+TEST(ScratchArena, PerThread) {
+    double taps[] = {1, 2, 3, 2, 1};
+    RealVector<double> filter(taps, 5);
+    resetScratchArenaStats();
+    
+    // Each thread gets its own arena and statistics, so the same filter can be used from several threads at once.
+    unsigned long long threadLeases[2];
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<2; t++) {
+        threads.push_back(std::thread([&filter, &threadLeases, t]() {
+            for (unsigned i=0; i<10; i++) {
+                RealVector<double> buf(100);
+                buf[0] = 1;
+                filter.conv(buf);
+                EXPECT_TRUE(FloatsEqual(3, buf[2]));
+            }
+            threadLeases[t] = scratchArenaStats().leases;
+        }));
+    }
+    for (unsigned t=0; t<threads.size(); t++) {
+        threads[t].join();
+    }
+    EXPECT_EQ(10u, threadLeases[0]);
+    EXPECT_EQ(10u, threadLeases[1]);
+    EXPECT_EQ(0u, scratchArenaStats().leases);
+}
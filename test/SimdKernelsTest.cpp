@@ -0,0 +1,149 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Vector.h"
+#include "SimdKernels.h"
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+
+#ifdef NIMBLEDSP_SIMD_X86
+
+// Checks every kernel that the CPU supports against the scalar versions, for lengths that exercise the
+// full-register loops and the scalar tails.
+template <class T>
+void CheckSimdKernels(double tolerance) {
+    std::vector<T> a(100), b(100);
+    std::vector< std::complex<T> > ca(100), cb(100);
+    for (unsigned i=0; i<a.size(); i++) {
+        a[i] = (T) std::sin(0.3 * i);
+        b[i] = (T) std::cos(0.17 * i) - (T) 0.25;
+        ca[i] = std::complex<T>(a[i], (T) std::cos(0.41 * i));
+        cb[i] = std::complex<T>(b[i], (T) std::sin(0.07 * i));
+    }
+    
+    for (int isa=SIMD_SSE2; isa<=detectSimdInstructionSet(); isa++) {
+        SimdKernels<T> kernels = getSimdKernels<T>((SimdInstructionSet) isa);
+        for (unsigned n=0; n<=a.size(); n++) {
+            EXPECT_NEAR(dotProductScalar(VECTOR_TO_ARRAY(a), VECTOR_TO_ARRAY(b), n),
+                        kernels.dot(VECTOR_TO_ARRAY(a), VECTOR_TO_ARRAY(b), n), tolerance);
+            
+            std::complex<T> expected = dotProductScalar(VECTOR_TO_ARRAY(ca), VECTOR_TO_ARRAY(b), n);
+            std::complex<T> result = kernels.dotComplexReal(VECTOR_TO_ARRAY(ca), VECTOR_TO_ARRAY(b), n);
+            EXPECT_NEAR(expected.real(), result.real(), tolerance);
+            EXPECT_NEAR(expected.imag(), result.imag(), tolerance);
+            
+            expected = dotProductScalar(VECTOR_TO_ARRAY(ca), VECTOR_TO_ARRAY(cb), n);
+            result = kernels.dotComplex(VECTOR_TO_ARRAY(ca), VECTOR_TO_ARRAY(cb), n);
+            EXPECT_NEAR(expected.real(), result.real(), tolerance);
+            EXPECT_NEAR(expected.imag(), result.imag(), tolerance);
+        }
+        
+        // The biquad kernel, for channel counts that use the paired groups, single groups, and scalar tail.
+        T coeffs[] = {(T) 0.2, (T) -0.1, (T) 0.3, (T) -1.2, (T) 0.5};
+        for (unsigned numChannels=1; numChannels<=40; numChannels+=3) {
+            unsigned len = (unsigned) a.size() / numChannels;
+            std::vector<T> expected(len * numChannels), result(len * numChannels);
+            std::vector<T> expectedZ(2 * numChannels, (T) 0.1), resultZ(2 * numChannels, (T) 0.1);
+            biquadChannelsScalar(coeffs, VECTOR_TO_ARRAY(expectedZ), VECTOR_TO_ARRAY(expectedZ) + numChannels,
+                                 VECTOR_TO_ARRAY(a), VECTOR_TO_ARRAY(expected), len, numChannels, numChannels);
+            kernels.biquadChannels(coeffs, VECTOR_TO_ARRAY(resultZ), VECTOR_TO_ARRAY(resultZ) + numChannels,
+                                   VECTOR_TO_ARRAY(a), VECTOR_TO_ARRAY(result), len, numChannels, numChannels);
+            for (unsigned i=0; i<expected.size(); i++) {
+                EXPECT_NEAR(expected[i], result[i], tolerance);
+            }
+            for (unsigned i=0; i<expectedZ.size(); i++) {
+                EXPECT_NEAR(expectedZ[i], resultZ[i], tolerance);
+            }
+        }
+    }
+}
+
+TEST(SimdKernels, Float) {
+    CheckSimdKernels<float>(.0001);
+}
+
+TEST(SimdKernels, Double) {
+    CheckSimdKernels<double>(.00000001);
+}
+
+// The int16_t kernels have to match the scalar versions exactly.  A few of the values are full scale, but not so many
+// that the sums overflow.
+TEST(SimdKernels, Int16) {
+    std::vector<int16_t> a(100), b(100);
+    std::vector< std::complex<int16_t> > ca(100);
+    for (unsigned i=0; i<a.size(); i++) {
+        a[i] = (int16_t) (i % 13 == 0 ? -32768 : 1000 * std::sin(0.3 * i));
+        b[i] = (int16_t) (i % 9 == 0 ? -32768 : 1000 * std::cos(0.17 * i));
+        ca[i] = std::complex<int16_t>(a[i], (int16_t) (i % 7 == 3 ? 32767 : 1000 * std::cos(0.41 * i)));
+    }
+    
+    for (int isa=SIMD_SSE2; isa<=detectSimdInstructionSet(); isa++) {
+        SimdInt16Kernels kernels = getSimdInt16Kernels((SimdInstructionSet) isa);
+        for (unsigned n=0; n<=24; n++) {
+            EXPECT_EQ((dotProductWideScalar<int32_t>(VECTOR_TO_ARRAY(a), VECTOR_TO_ARRAY(b), n)),
+                      kernels.dot(VECTOR_TO_ARRAY(a), VECTOR_TO_ARRAY(b), n));
+            
+            std::complex<int32_t> expected = dotProductWideScalar<int32_t>(VECTOR_TO_ARRAY(ca), VECTOR_TO_ARRAY(b), n);
+            std::complex<int32_t> result = kernels.dotComplexReal(VECTOR_TO_ARRAY(ca), VECTOR_TO_ARRAY(b), n);
+            EXPECT_EQ(expected.real(), result.real());
+            EXPECT_EQ(expected.imag(), result.imag());
+        }
+        // Longer lengths, at offsets that leave the loads unaligned.
+        for (unsigned n=40; n<=a.size()-3; n+=19) {
+            EXPECT_EQ((dotProductWideScalar<int32_t>(VECTOR_TO_ARRAY(a) + 3, VECTOR_TO_ARRAY(b) + 1, n)),
+                      kernels.dot(VECTOR_TO_ARRAY(a) + 3, VECTOR_TO_ARRAY(b) + 1, n));
+        }
+    }
+}
+
+#endif
+
+TEST(SimdKernels, DotProduct) {
+    double a[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    double b[] = {-1, 0.5, 2, -3, 4, 1, 0, -2, 3, 1, -1};
+    int intA[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    int intB[] = {-1, 0, 2, -3, 4, 1, 0, -2, 3, 1, -1};
+    unsigned numElements = sizeof(a)/sizeof(a[0]);
+    
+    EXPECT_TRUE(FloatsEqual(30, dotProduct(a, b, numElements)));
+    EXPECT_EQ(29, dotProduct(intA, intB, numElements));
+    
+    int16_t shortA[] = {30000, -30000, 30000, 30000, 30000, 30000, 30000, 30000, 30000, 30000, 30000};
+    int16_t shortB[] = {-1, 0, 2, -3, 4, 1, 0, -2, 3, 1, -1};
+    EXPECT_EQ(30000 * 4, dotProductWide<int32_t>(shortA, shortB, numElements));
+    EXPECT_EQ((int64_t) 30000 * 4, dotProductWide<int64_t>(shortA, shortB, numElements));
+    
+    std::complex<double> ca[] = {std::complex<double>(1, 2), std::complex<double>(-3, 1), std::complex<double>(0.5, -2)};
+    std::complex<double> expected = ca[0] * b[0] + ca[1] * b[1] + ca[2] * b[2];
+    std::complex<double> result = dotProduct(ca, b, 3);
+    EXPECT_TRUE(FloatsEqual(expected.real(), result.real()));
+    EXPECT_TRUE(FloatsEqual(expected.imag(), result.imag()));
+    
+    expected = ca[0] * ca[2] + ca[1] * ca[1] + ca[2] * ca[0];
+    std::complex<double> reversed[] = {ca[2], ca[1], ca[0]};
+    result = dotProduct(ca, reversed, 3);
+    EXPECT_TRUE(FloatsEqual(expected.real(), result.real()));
+    EXPECT_TRUE(FloatsEqual(expected.imag(), result.imag()));
+}
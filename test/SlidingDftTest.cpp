@@ -0,0 +1,116 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "SlidingDft.h"
+#include "RealVector.h"
+#include "ComplexVector.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool ComplexEqual(std::complex<double> c1, std::complex<double> c2);
+
+// Direct DFT at bin "k" of the "windowLen" samples ending with data[end], with zeros before data[0].
+template <class U>
+static std::complex<double> windowDftBin(const std::vector<U> & data, int end, unsigned windowLen, double k) {
+    std::complex<double> sum = 0;
+    for (unsigned n=0; n<windowLen; n++) {
+        int index = end - (int) windowLen + 1 + (int) n;
+        if (index >= 0)
+            sum += std::complex<double>(data[index]) * std::polar(1.0, -2 * M_PI * k * n / windowLen);
+    }
+    return sum;
+}
+
+TEST(SlidingDft, RealData) {
+    std::vector<double> bins = {0, 2, 3.25, 7};
+    unsigned windowLen = 16;
+    unsigned len = 100;
+    std::vector<double> data(len);
+    for (unsigned i=0; i<len; i++) {
+        data[i] = sin(0.4 * i) + 0.25 * (i % 5);
+    }
+    SlidingDft<double> sdft(windowLen, bins);
+    
+    // Check every sample, including the ones before the window fills up.
+    std::vector< std::complex<double> > output(len * bins.size());
+    EXPECT_EQ(40u, sdft.process(VECTOR_TO_ARRAY(data), 40, VECTOR_TO_ARRAY(output)));
+    EXPECT_EQ(60u, sdft.process(VECTOR_TO_ARRAY(data) + 40, 60, VECTOR_TO_ARRAY(output) + 40 * bins.size()));
+    for (unsigned i=0; i<len; i++) {
+        for (unsigned bin=0; bin<bins.size(); bin++) {
+            EXPECT_TRUE(ComplexEqual(windowDftBin(data, i, windowLen, bins[bin]), output[i * bins.size() + bin]));
+        }
+    }
+    for (unsigned bin=0; bin<bins.size(); bin++) {
+        EXPECT_TRUE(ComplexEqual(output[(len - 1) * bins.size() + bin], sdft.spectrum[bin]));
+        EXPECT_NEAR(std::norm(sdft.spectrum[bin]), sdft.power()[bin], 1e-9);
+    }
+}
+
+TEST(SlidingDft, ComplexData) {
+    std::vector<double> bins = {1, 5};
+    unsigned windowLen = 12;
+    std::vector< std::complex<double> > data(70);
+    for (unsigned i=0; i<data.size(); i++) {
+        data[i] = std::polar(1.0 + 0.1 * (i % 3), 0.9 * i);
+    }
+    ComplexVector<double> buf(data);
+    SlidingDft<double> sdft(windowLen, bins);
+    
+    EXPECT_EQ(70u, process(buf, sdft));
+    for (unsigned bin=0; bin<bins.size(); bin++) {
+        EXPECT_TRUE(ComplexEqual(windowDftBin(data, 69, windowLen, bins[bin]), sdft.spectrum[bin]));
+    }
+}
+
+TEST(SlidingDft, RecomputeAndReset) {
+    std::vector<double> bins = {3, 10};
+    unsigned windowLen = 64;
+    unsigned len = 20000;
+    std::vector<float> data(len);
+    for (unsigned i=0; i<len; i++) {
+        data[i] = (float) cos(2 * M_PI * 3 * i / windowLen + 0.1) + (float) ((i * 7919) % 13) / 13;
+    }
+    SlidingDft<float> sdft(windowLen, bins);
+    sdft.process(VECTOR_TO_ARRAY(data), len);
+    
+    // Recomputing gets rid of the accumulated rounding error.
+    std::vector< std::complex<float> > drifted = sdft.spectrum;
+    sdft.recompute();
+    for (unsigned bin=0; bin<bins.size(); bin++) {
+        std::complex<double> expected = windowDftBin(data, len - 1, windowLen, bins[bin]);
+        EXPECT_NEAR(expected.real(), sdft.spectrum[bin].real(), 1e-4);
+        EXPECT_NEAR(expected.imag(), sdft.spectrum[bin].imag(), 1e-4);
+        EXPECT_NEAR(expected.real(), drifted[bin].real(), 1e-1);
+        EXPECT_NEAR(expected.imag(), drifted[bin].imag(), 1e-1);
+    }
+    
+    sdft.reset();
+    EXPECT_EQ(0.0f, std::abs(sdft.spectrum[0]));
+    sdft.process(VECTOR_TO_ARRAY(data), 5);
+    for (unsigned bin=0; bin<bins.size(); bin++) {
+        std::complex<double> expected = windowDftBin(data, 4, windowLen, bins[bin]);
+        EXPECT_NEAR(expected.real(), sdft.spectrum[bin].real(), 1e-4);
+        EXPECT_NEAR(expected.imag(), sdft.spectrum[bin].imag(), 1e-4);
+    }
+}
@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "SpscRingBuffer.h"
+#include <vector>
+#include <thread>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+
+TEST(SpscRingBuffer, Capacity) {
+    SpscRingBuffer<float> buf1(1);
+    EXPECT_EQ(1u, buf1.capacity());
+    SpscRingBuffer<float> buf2(100);
+    EXPECT_EQ(128u, buf2.capacity());
+    SpscRingBuffer<float> buf3(128);
+    EXPECT_EQ(128u, buf3.capacity());
+}
+
+TEST(SpscRingBuffer, FullAndEmpty) {
+    SpscRingBuffer<int> buf(8);
+    int input[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    int output[10];
+    
+    EXPECT_EQ(0u, buf.read(output, 10));
+    EXPECT_EQ(8u, buf.write(input, 10));
+    EXPECT_EQ(8u, buf.size());
+    EXPECT_EQ(0u, buf.write(input, 1));
+    
+    EXPECT_EQ(3u, buf.read(output, 3));
+    for (int i=0; i<3; i++) {
+        EXPECT_EQ(i, output[i]);
+    }
+    
+    // Wraps around the end of the buffer.
+    EXPECT_EQ(3u, buf.write(input + 8, 2) + buf.write(input, 1));
+    EXPECT_EQ(8u, buf.read(output, 10));
+    int expected[] = {3, 4, 5, 6, 7, 8, 9, 0};
+    for (int i=0; i<8; i++) {
+        EXPECT_EQ(expected[i], output[i]);
+    }
+    EXPECT_EQ(0u, buf.size());
+}
+
+TEST(SpscRingBuffer, Close) {
+    SpscRingBuffer<double> buf(4);
+    double data[] = {1, 2};
+    buf.write(data, 2);
+    EXPECT_FALSE(buf.isClosed());
+    buf.close();
+    EXPECT_TRUE(buf.isClosed());
+    EXPECT_EQ(2u, buf.read(data, 2));
+}
+
+TEST(SpscRingBuffer, Threads) {
+    const unsigned len = 200000;
+    SpscRingBuffer<unsigned> buf(100);
+    
+    std::thread producer([&buf, len]() {
+        std::vector<unsigned> block(37);
+        unsigned next = 0;
+        while (next < len) {
+            unsigned blockLen = std::min((unsigned) block.size(), len - next);
+            for (unsigned i=0; i<blockLen; i++) {
+                block[i] = next + i;
+            }
+            unsigned numWritten = 0;
+            while (numWritten < blockLen) {
+                unsigned n = buf.write(&block[0] + numWritten, blockLen - numWritten);
+                if (n == 0)
+                    std::this_thread::yield();
+                numWritten += n;
+            }
+            next += blockLen;
+        }
+        buf.close();
+    });
+    
+    std::vector<unsigned> output(len);
+    unsigned numRead = 0;
+    while (true) {
+        bool closed = buf.isClosed();
+        unsigned n = buf.read(&output[0] + numRead, std::min(53u, len - numRead));
+        numRead += n;
+        if (closed && buf.size() == 0)
+            break;
+        if (n == 0)
+            std::this_thread::yield();
+    }
+    producer.join();
+    
+    EXPECT_EQ(len, numRead);
+    for (unsigned i=0; i<len; i++) {
+        if (output[i] != i) {
+            EXPECT_EQ(i, output[i]);
+            break;
+        }
+    }
+}
@@ -0,0 +1,211 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "VectorView.h"
+#include "RealVector.h"
+#include "ComplexVector.h"
+#include "RealFirFilter.h"
+#include "ComplexFirFilter.h"
+#include "RealSosFilter.h"
+#include "RealMultichannelSosFilter.h"
+#include <vector>
+#include <cmath>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+extern bool ComplexEqual(std::complex<double> c1, std::complex<double> c2);
+
+
+TEST(VectorView, Construction) {
+    double data[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    VectorView<double> view(data, 10);
+    EXPECT_EQ(10u, view.size());
+    EXPECT_TRUE(view.isContiguous());
+    for (unsigned i=0; i<view.size(); i++) {
+        EXPECT_EQ(data[i], view[i]);
+    }
+    
+    // Every other sample starting with the second, i.e. the second channel of stereo data.
+    VectorView<double> odd = view.subView(1, 5, 2);
+    EXPECT_EQ(5u, odd.size());
+    EXPECT_FALSE(odd.isContiguous());
+    for (unsigned i=0; i<odd.size(); i++) {
+        EXPECT_EQ(data[2*i + 1], odd[i]);
+    }
+    VectorView<double> sub = odd.subView(1, 2, 2);
+    EXPECT_EQ(4, sub[0]);
+    EXPECT_EQ(8, sub[1]);
+    
+    // Views refer to the memory rather than copying it.
+    odd[0] = 20;
+    EXPECT_EQ(20, data[1]);
+    
+    RealVector<double> buf(data, 10);
+    VectorView<double> bufView(buf);
+    bufView[3] = -1;
+    EXPECT_EQ(-1, buf[3]);
+    
+    const RealVector<double> & constBuf = buf;
+    VectorView<const double> constView(constBuf);
+    EXPECT_EQ(-1, constView[3]);
+    VectorView<const double> fromView = odd;
+    EXPECT_EQ(20, fromView[0]);
+}
+
+TEST(VectorView, Operators) {
+    double data[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    double other[] = {2, 2, 2, 2, 2};
+    VectorView<double> even = VectorView<double>(data, 10).subView(0, 5, 2);
+    VectorView<double> odd = VectorView<double>(data, 10).subView(1, 5, 2);
+    
+    // Copy constructed views alias, assigned views copy elements.
+    VectorView<double> alias = even;
+    EXPECT_EQ(data, alias.data);
+    
+    RealVector<double> sum = even + odd;
+    EXPECT_EQ(5u, sum.size());
+    for (unsigned i=0; i<sum.size(); i++) {
+        EXPECT_EQ(4*i + 3, sum[i]);
+    }
+    
+    RealVector<double> otherBuf(other, 5);
+    even *= otherBuf;
+    even += 1.0;
+    odd -= VectorView<double>(other, 5) * 0.5;
+    for (unsigned i=0; i<5; i++) {
+        EXPECT_EQ(2 * (2*i + 1) + 1, data[2*i]);
+        EXPECT_EQ(2*i + 2 - 1, data[2*i + 1]);
+    }
+    
+    odd = even;
+    for (unsigned i=0; i<5; i++) {
+        EXPECT_EQ(data[2*i], data[2*i + 1]);
+    }
+    odd = otherBuf;
+    for (unsigned i=0; i<5; i++) {
+        EXPECT_EQ(2, data[2*i + 1]);
+    }
+    
+    otherBuf += even;
+    otherBuf = even / 2.0;
+    for (unsigned i=0; i<5; i++) {
+        EXPECT_EQ(data[2*i] / 2, otherBuf[i]);
+    }
+    
+    std::complex<double> complexData[] = {std::complex<double>(1, 1), std::complex<double>(2, -1)};
+    VectorView< std::complex<double> > complexView(complexData, 2);
+    complexView *= std::complex<double>(0, 1);
+    EXPECT_TRUE(ComplexEqual(std::complex<double>(-1, 1), complexData[0]));
+    EXPECT_TRUE(ComplexEqual(std::complex<double>(1, 2), complexData[1]));
+    ComplexVector<double> complexBuf = complexView + complexView;
+    EXPECT_TRUE(ComplexEqual(std::complex<double>(2, 4), complexBuf[1]));
+}
+
+TEST(VectorView, Stats) {
+    double data[] = {3, 100, -2, 100, 8, 100, 1, 100, 5, 100};
+    double evenData[] = {3, -2, 8, 1, 5};
+    RealVector<double> expected(evenData, 5);
+    VectorView<double> view = VectorView<double>(data, 10).subView(0, 5, 2);
+    
+    EXPECT_TRUE(FloatsEqual(expected.sum(), view.sum()));
+    EXPECT_TRUE(FloatsEqual(expected.mean(), mean(view)));
+    EXPECT_TRUE(FloatsEqual(expected.var(), var(view)));
+    EXPECT_TRUE(FloatsEqual(expected.stdDev(), stdDev(view)));
+    EXPECT_TRUE(FloatsEqual(expected.median(), median(view)));
+    
+    unsigned loc;
+    EXPECT_EQ(8, max(view, &loc));
+    EXPECT_EQ(2u, loc);
+    EXPECT_EQ(-2, min(view, &loc));
+    EXPECT_EQ(1u, loc);
+    
+    saturate(view, 4.0);
+    EXPECT_EQ(4, data[4]);
+    EXPECT_EQ(3, data[0]);
+    EXPECT_EQ(100, data[1]);
+}
+
+TEST(VectorView, Filters) {
+    const unsigned len = 400;
+    double taps[] = {0.1, 0.2, 0.4, 0.2, 0.1, -0.05, 0.02};
+    std::vector<double> signal(len);
+    std::vector<double> interleaved(2 * len);
+    for (unsigned i=0; i<len; i++) {
+        signal[i] = sin(0.07 * i) + 0.5 * cos(1.9 * i);
+        interleaved[2*i] = signal[i];
+        interleaved[2*i + 1] = 1000;
+    }
+    
+    std::vector<double> original(interleaved);
+    
+    // Streaming FIR filtering of a strided view, in chunks, should match filtering a whole vector.
+    RealFirFilter<double> vectorFilt(taps, 7);
+    RealFirFilter<double> viewFilt(taps, 7);
+    RealVector<double> expected(signal);
+    vectorFilt.conv(expected);
+    VectorView<double> channel = VectorView<double>(VECTOR_TO_ARRAY(interleaved), 2 * len).subView(0, len, 2);
+    conv(channel.subView(0, 150), viewFilt);
+    viewFilt.conv(channel.subView(150, len - 150));
+    for (unsigned i=0; i<len; i++) {
+        EXPECT_TRUE(FloatsEqual(expected[i], interleaved[2*i]));
+        EXPECT_EQ(1000, interleaved[2*i + 1]);
+    }
+    
+    // Contiguous views go straight to the pointer methods.
+    std::vector< std::complex<double> > complexSignal(len);
+    for (unsigned i=0; i<len; i++) {
+        complexSignal[i] = std::complex<double>(signal[i], -signal[i]);
+    }
+    ComplexFirFilter<double> complexVectorFilt(taps, 7);
+    ComplexFirFilter<double> complexViewFilt(taps, 7);
+    ComplexVector<double> complexExpected(complexSignal);
+    complexVectorFilt.conv(complexExpected);
+    complexViewFilt.conv(VectorView< std::complex<double> >(VECTOR_TO_ARRAY(complexSignal), len));
+    for (unsigned i=0; i<len; i++) {
+        EXPECT_TRUE(ComplexEqual(complexExpected[i], complexSignal[i]));
+    }
+    
+    // IIR filters
+    double num[] = {0.05, 0.1, 0.05};
+    double den[] = {1, -1.6, 0.7};
+    RealSosFilter<double> sosVectorFilt(std::vector<double>(num, num + 3), std::vector<double>(den, den + 3));
+    RealSosFilter<double> sosViewFilt(std::vector<double>(num, num + 3), std::vector<double>(den, den + 3));
+    RealIirFilter<double> iirViewFilt(num, 3, den, 3);
+    RealVector<double> sosExpected(signal);
+    sosVectorFilt.filter(sosExpected);
+    std::vector<double> sosData(original);
+    std::vector<double> iirData(original);
+    filter(VectorView<double>(VECTOR_TO_ARRAY(sosData), 2 * len).subView(0, len, 2), sosViewFilt);
+    iirViewFilt.filter(VectorView<double>(VECTOR_TO_ARRAY(iirData), 2 * len).subView(0, len, 2));
+    for (unsigned i=0; i<len; i++) {
+        EXPECT_TRUE(FloatsEqual(sosExpected[i], sosData[2*i]));
+        EXPECT_NEAR(sosExpected[i], iirData[2*i], 1e-6);
+    }
+    
+    RealMultichannelSosFilter<double> multiFilt(2, sosViewFilt);
+    multiFilt.filter(VectorView<double>(VECTOR_TO_ARRAY(original), 2 * len));
+    for (unsigned i=0; i<len; i++) {
+        EXPECT_TRUE(FloatsEqual(sosExpected[i], original[2*i]));
+    }
+}
@@ -0,0 +1,157 @@
+/*
+Copyright (c) 2014, James Clay
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "WelchPsd.h"
+#include "RealFirFilter.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace NimbleDSP;
+
+extern bool FloatsEqual(double float1, double float2);
+
+// Direct calculation of the unscaled periodogram of data[start] to data[start + window.size() - 1].
+template <class U>
+static std::vector<double> periodogram(const std::vector<U> & data, unsigned start, const std::vector<double> & window,
+                                       unsigned numBins) {
+    unsigned len = (unsigned) window.size();
+    std::vector<double> result(numBins);
+    for (unsigned k=0; k<numBins; k++) {
+        std::complex<double> sum = 0;
+        for (unsigned n=0; n<len; n++) {
+            sum += std::complex<double>(data[start + n]) * window[n] * std::polar(1.0, -2 * M_PI * k * n / len);
+        }
+        result[k] = std::norm(sum);
+    }
+    return result;
+}
+
+TEST(WelchPsd, RealMean) {
+    RealFirFilter<double> window;
+    window.hann(64);
+    double windowPower = 0;
+    for (unsigned i=0; i<window.size(); i++) {
+        windowPower += window[i] * window[i];
+    }
+    
+    unsigned len = 1000;
+    std::vector<double> data(len);
+    for (unsigned i=0; i<len; i++) {
+        data[i] = sin(0.8 * i) + 0.2 * cos(0.05 * i * i);
+    }
+    WelchPsd<double> psd(window.vec, 32, false, MEAN_AVERAGE, 0.1, 2.0);
+    EXPECT_EQ(64u, psd.fftLen());
+    EXPECT_EQ(32u, psd.hop());
+    EXPECT_EQ(33u, psd.numBins());
+    
+    // Blocks that don't line up with the frames.
+    unsigned numFrames = (len - 64) / 32 + 1;
+    std::vector<double> frames(numFrames * psd.numBins());
+    unsigned blockLens[] = {5, 300, 1, 694};
+    unsigned start = 0, frame = 0;
+    for (unsigned block=0; block<4; block++) {
+        unsigned expectedFrames = psd.outputLength(blockLens[block]);
+        unsigned completed = psd.process(VECTOR_TO_ARRAY(data) + start, blockLens[block],
+                                         VECTOR_TO_ARRAY(frames) + frame * psd.numBins(), numFrames - frame);
+        EXPECT_EQ(expectedFrames, completed);
+        frame += completed;
+        start += blockLens[block];
+    }
+    EXPECT_EQ(numFrames, frame);
+    EXPECT_EQ(numFrames, psd.numFrames);
+    
+    std::vector<double> mean(psd.numBins(), 0);
+    for (frame=0; frame<numFrames; frame++) {
+        std::vector<double> expected = periodogram(data, frame * 32, window.vec, psd.numBins());
+        for (unsigned bin=0; bin<psd.numBins(); bin++) {
+            double scale = (bin == 0 || bin == 32) ? 1 / (2.0 * windowPower) : 2 / (2.0 * windowPower);
+            EXPECT_TRUE(FloatsEqual(expected[bin] * scale, frames[frame * psd.numBins() + bin]));
+            mean[bin] += expected[bin] * scale / numFrames;
+        }
+    }
+    for (unsigned bin=0; bin<psd.numBins(); bin++) {
+        EXPECT_TRUE(FloatsEqual(mean[bin], psd.psd[bin]));
+    }
+}
+
+TEST(WelchPsd, ComplexAveraging) {
+    std::vector<double> window(16, 1.0);
+    std::vector< std::complex<double> > data(200);
+    for (unsigned i=0; i<data.size(); i++) {
+        data[i] = std::polar(1.0 + 0.5 * sin(0.1 * i), 0.7 * i);
+    }
+    WelchPsd<double> expPsd(window, 4, true, EXPONENTIAL_AVERAGE, 0.25);
+    WelchPsd<double> maxPsd(window, 4, true, MAX_HOLD);
+    WelchPsd<double> meanPsd(window, 0, true);
+    EXPECT_EQ(16u, expPsd.numBins());
+    
+    ComplexVector<double> buf(data);
+    unsigned numFrames = (200 - 16) / 12 + 1;
+    EXPECT_EQ(numFrames, expPsd.process(buf));
+    EXPECT_EQ(numFrames, maxPsd.process(VECTOR_TO_ARRAY(data), (unsigned) data.size()));
+    
+    std::vector<double> expected(16, 0), maxHold(16, 0);
+    for (unsigned frame=0; frame<numFrames; frame++) {
+        std::vector<double> framePsd = periodogram(data, frame * 12, window, 16);
+        for (unsigned bin=0; bin<16; bin++) {
+            framePsd[bin] /= 16;
+            expected[bin] = (frame == 0) ? framePsd[bin] : expected[bin] + 0.25 * (framePsd[bin] - expected[bin]);
+            maxHold[bin] = std::max(maxHold[bin], framePsd[bin]);
+        }
+    }
+    for (unsigned bin=0; bin<16; bin++) {
+        EXPECT_TRUE(FloatsEqual(expected[bin], expPsd.psd[bin]));
+        EXPECT_TRUE(FloatsEqual(maxHold[bin], maxPsd.psd[bin]));
+    }
+    
+    // With a rectangular window, no overlap and a sample frequency of 1, the PSD's mean is the data's mean power.
+    EXPECT_EQ(12u, meanPsd.process(VECTOR_TO_ARRAY(data), 192));
+    double power = 0, psdSum = 0;
+    for (unsigned i=0; i<192; i++) {
+        power += std::norm(data[i]) / 192;
+    }
+    for (unsigned bin=0; bin<16; bin++) {
+        psdSum += meanPsd.psd[bin] / 16;
+    }
+    EXPECT_TRUE(FloatsEqual(power, psdSum));
+}
+
+TEST(WelchPsd, DbAndReset) {
+    std::vector<float> window(8, 1.0f);
+    WelchPsd<float> psd(window);
+    std::vector<float> data(20, 2.0f);
+    
+    EXPECT_EQ(2u, psd.outputLength(20));
+    EXPECT_EQ(2u, psd.process(VECTOR_TO_ARRAY(data), 20));
+    EXPECT_EQ(1u, psd.outputLength(4));
+    
+    // A constant only has power at DC: 8*8*4 / 8 = 32, i.e. about 15.05 dB.
+    std::vector<float> psdDb = psd.psdDb();
+    EXPECT_NEAR(32, psd.psd[0], 1e-4);
+    EXPECT_NEAR(15.0515, psdDb[0], 1e-3);
+    EXPECT_NEAR(0, psd.psd[1], 1e-4);
+    
+    psd.reset();
+    EXPECT_EQ(0u, psd.numFrames);
+    EXPECT_EQ(0.0f, psd.psd[0]);
+    EXPECT_EQ(0u, psd.outputLength(4));
+}